@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @file bench_api.h
+ * @brief On-target benchmark registry and runner with percentile reporting.
+ *
+ * Subsystems register static bench_case_t descriptors; a run executes every
+ * case whose name matches the filter (warmup, then timed repetitions) and
+ * keeps min/p50/p90/p99/max/mean per case. bench_render_json() prints the
+ * last run together with build identity and tags, so results from different
+ * firmware builds or settings can be diffed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_MAX_CASES 32U
+#define BENCH_MAX_REPS 200U
+#define BENCH_MAX_TAGS 4U
+#define BENCH_MAX_PROBES 4U
+#define BENCH_DEFAULT_WARMUP 2U
+#define BENCH_DEFAULT_REPS 20U
+
+/** @brief Case hook; ctx is bench_case_t.ctx. */
+typedef esp_err_t (*bench_fn_t)(void *ctx);
+
+/**
+ * @brief One benchmark case. Must stay valid while registered.
+ *
+ * Names are dotted ("display.blit.rows_20") so a filter prefix selects a group.
+ * One timed repetition calls run() batch times; stats are per call.
+ */
+typedef struct {
+    const char *name;
+    bench_fn_t setup;    /* optional, before warmup; failure skips the case */
+    bench_fn_t run;
+    bench_fn_t teardown; /* optional, called whenever setup succeeded */
+    void *ctx;
+    uint16_t warmup;     /* 0 = BENCH_DEFAULT_WARMUP */
+    uint16_t reps;       /* 0 = BENCH_DEFAULT_REPS, capped at BENCH_MAX_REPS */
+    uint16_t batch;      /* calls per timed repetition, 0 = 1 (for sub-microsecond work) */
+    uint32_t work;       /* units processed per call, for rate_per_s (0 = none) */
+    const char *unit;    /* e.g. "px", "B"; NULL = "op" */
+} bench_case_t;
+
+typedef struct {
+    const char *filter; /* comma-separated name prefixes; NULL or "" = all */
+    uint16_t reps;      /* 0 = per-case default */
+    uint16_t warmup;    /* 0 = per-case default */
+} bench_run_cfg_t;
+
+/** @brief Text sink for bench_render_json(). */
+typedef esp_err_t (*bench_write_fn_t)(const char *text, size_t len, void *user_ctx);
+/** @brief Read monotonic counters (e.g. bus transfers) into values[], one per probe name. */
+typedef void (*bench_probe_fn_t)(uint32_t *values, void *user_ctx);
+/** @brief Called on the runner after each completed run (e.g. to repaint a display the cases drew on). */
+typedef void (*bench_done_cb_t)(void *user_ctx);
+
+/** @brief Add a case; ESP_ERR_INVALID_STATE for a duplicate name, ESP_ERR_NO_MEM when full. */
+esp_err_t bench_register(const bench_case_t *bench_case);
+/** @brief Attach a numeric tag (e.g. "spi_clock_hz") to every report; key must be a static string. */
+esp_err_t bench_set_tag(const char *key, int64_t value);
+void bench_set_done_cb(bench_done_cb_t cb, void *user_ctx);
+/**
+ * @brief Sample counters around the timed repetitions of every case and report the delta per call.
+ *
+ * Unlike timings, counter deltas are exact, so a report diff flags an operation
+ * that starts doing more work (e.g. more bus transfers) even on a noisy target.
+ * @param names count static strings, count <= BENCH_MAX_PROBES; read == NULL removes the probe.
+ * @return ESP_ERR_INVALID_STATE while a run is active.
+ */
+esp_err_t bench_set_probe(const char *const *names, size_t count, bench_probe_fn_t read, void *user_ctx);
+/** @brief Run matching cases on the calling task; ESP_ERR_INVALID_STATE while another run is active. */
+esp_err_t bench_run(const bench_run_cfg_t *cfg);
+/** @brief Same as bench_run() on a short-lived background task. */
+esp_err_t bench_start(const bench_run_cfg_t *cfg);
+bool bench_busy(void);
+/** @brief Print the last (or in-progress) run as one JSON object; stops at the first write error. */
+esp_err_t bench_render_json(bench_write_fn_t write, void *user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
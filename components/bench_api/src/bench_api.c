@@ -0,0 +1,474 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "bench_api.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_app_desc.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define BENCH_LINE_MAX 192
+#define BENCH_FILTER_MAX 64U
+#define BENCH_TASK_STACK 4096U
+#define BENCH_TASK_PRIO (tskIDLE_PRIORITY + 1U)
+
+static const char *TAG = "bench_api";
+
+typedef struct {
+    const bench_case_t *bench_case;
+    esp_err_t err;
+    uint16_t reps; /* completed timed repetitions */
+    uint16_t batch;
+    uint32_t min_ns;
+    uint32_t p50_ns;
+    uint32_t p90_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+    uint32_t mean_ns;
+    uint32_t calls; /* timed run() calls the probe deltas cover */
+    uint8_t probe_count;
+    const char *const *probe_names;
+    uint32_t probe_delta[BENCH_MAX_PROBES];
+} bench_result_t;
+
+typedef struct {
+    const char *key;
+    int64_t value;
+} bench_tag_t;
+
+static portMUX_TYPE s_registry_mux = portMUX_INITIALIZER_UNLOCKED;
+static const bench_case_t *s_cases[BENCH_MAX_CASES];
+static uint32_t s_case_count;
+static bench_tag_t s_tags[BENCH_MAX_TAGS];
+static uint32_t s_tag_count;
+static bench_done_cb_t s_done_cb;
+static void *s_done_ctx;
+static const char *const *s_probe_names;
+static uint32_t s_probe_count;
+static bench_probe_fn_t s_probe_fn;
+static void *s_probe_ctx;
+
+/*
+ * Results of the current/last run. The runner bumps s_gen before touching
+ * any slot and publishes slot i by storing s_result_count = i + 1, so a
+ * reader copies slots below the count and discards them if s_gen moved.
+ */
+static bench_result_t s_results[BENCH_MAX_CASES];
+static uint32_t s_result_count;
+static uint32_t s_selected;
+static uint32_t s_gen;
+static int64_t s_run_start_us;
+static int64_t s_run_end_us;
+static uint32_t s_busy;
+
+/* Runner-only scratch; s_busy makes it exclusive. */
+static uint32_t s_samples_ns[BENCH_MAX_REPS];
+static char s_async_filter[BENCH_FILTER_MAX];
+static bench_run_cfg_t s_async_cfg;
+
+esp_err_t bench_register(const bench_case_t *bench_case)
+{
+    ESP_RETURN_ON_FALSE(bench_case != NULL && bench_case->name != NULL && bench_case->run != NULL, ESP_ERR_INVALID_ARG,
+                        TAG, "case needs a name and run()");
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&s_registry_mux);
+    for (uint32_t i = 0; i < s_case_count; i++) {
+        if (strcmp(s_cases[i]->name, bench_case->name) == 0) {
+            err = ESP_ERR_INVALID_STATE;
+            break;
+        }
+    }
+    if (err == ESP_OK && s_case_count >= BENCH_MAX_CASES) {
+        err = ESP_ERR_NO_MEM;
+    }
+    if (err == ESP_OK) {
+        s_cases[s_case_count] = bench_case;
+        __atomic_store_n(&s_case_count, s_case_count + 1U, __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&s_registry_mux);
+
+    ESP_RETURN_ON_ERROR(err, TAG, "register %s failed", bench_case->name);
+    return ESP_OK;
+}
+
+esp_err_t bench_set_tag(const char *key, int64_t value)
+{
+    ESP_RETURN_ON_FALSE(key != NULL, ESP_ERR_INVALID_ARG, TAG, "key is null");
+
+    esp_err_t err = ESP_ERR_NO_MEM;
+    portENTER_CRITICAL(&s_registry_mux);
+    for (uint32_t i = 0; i < s_tag_count; i++) {
+        if (strcmp(s_tags[i].key, key) == 0) {
+            s_tags[i].value = value;
+            err = ESP_OK;
+            break;
+        }
+    }
+    if (err != ESP_OK && s_tag_count < BENCH_MAX_TAGS) {
+        s_tags[s_tag_count] = (bench_tag_t){.key = key, .value = value};
+        s_tag_count++;
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_registry_mux);
+    return err;
+}
+
+void bench_set_done_cb(bench_done_cb_t cb, void *user_ctx)
+{
+    s_done_ctx = user_ctx;
+    s_done_cb = cb;
+}
+
+bool bench_busy(void)
+{
+    return __atomic_load_n(&s_busy, __ATOMIC_ACQUIRE) != 0U;
+}
+
+esp_err_t bench_set_probe(const char *const *names, size_t count, bench_probe_fn_t read, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(read == NULL || (names != NULL && count > 0U && count <= BENCH_MAX_PROBES), ESP_ERR_INVALID_ARG,
+                        TAG, "probe needs 1..%u names", (unsigned)BENCH_MAX_PROBES);
+    ESP_RETURN_ON_FALSE(!bench_busy(), ESP_ERR_INVALID_STATE, TAG, "a run is active");
+
+    s_probe_names = names;
+    s_probe_count = (read != NULL) ? (uint32_t)count : 0U;
+    s_probe_ctx = user_ctx;
+    s_probe_fn = read;
+    return ESP_OK;
+}
+
+static bool bench_try_acquire(void)
+{
+    return __atomic_exchange_n(&s_busy, 1U, __ATOMIC_ACQ_REL) == 0U;
+}
+
+static void bench_release(void)
+{
+    __atomic_store_n(&s_busy, 0U, __ATOMIC_RELEASE);
+}
+
+/* Filter is a comma-separated list of name prefixes; an empty list selects everything. */
+static bool bench_filter_match(const char *filter, const char *name)
+{
+    if (filter == NULL) {
+        return true;
+    }
+
+    bool any_token = false;
+    const char *tok = filter;
+    while (*tok != '\0') {
+        const char *end = strchr(tok, ',');
+        const size_t len = (end != NULL) ? (size_t)(end - tok) : strlen(tok);
+        if (len > 0U) {
+            any_token = true;
+            if (strncmp(name, tok, len) == 0) {
+                return true;
+            }
+        }
+        if (end == NULL) {
+            break;
+        }
+        tok = end + 1;
+    }
+    return !any_token;
+}
+
+static uint32_t bench_count_matches(const char *filter)
+{
+    const uint32_t count = __atomic_load_n(&s_case_count, __ATOMIC_ACQUIRE);
+    uint32_t matches = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (bench_filter_match(filter, s_cases[i]->name)) {
+            matches++;
+        }
+    }
+    return matches;
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile over sorted samples. */
+static uint32_t bench_percentile(const uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = ((pct * n) + 99U) / 100U;
+    if (rank == 0U) {
+        rank = 1U;
+    }
+    return sorted[rank - 1U];
+}
+
+static esp_err_t bench_call(const bench_case_t *c, uint16_t batch)
+{
+    for (uint16_t i = 0; i < batch; i++) {
+        const esp_err_t err = c->run(c->ctx);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static void bench_run_case(const bench_case_t *c, const bench_run_cfg_t *cfg, bench_result_t *r)
+{
+    const uint16_t warmup = (cfg->warmup != 0U) ? cfg->warmup : ((c->warmup != 0U) ? c->warmup : BENCH_DEFAULT_WARMUP);
+    uint32_t reps = (cfg->reps != 0U) ? cfg->reps : ((c->reps != 0U) ? c->reps : BENCH_DEFAULT_REPS);
+    if (reps > BENCH_MAX_REPS) {
+        reps = BENCH_MAX_REPS;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->bench_case = c;
+    r->batch = (c->batch != 0U) ? c->batch : 1U;
+
+    if (c->setup != NULL) {
+        r->err = c->setup(c->ctx);
+        if (r->err != ESP_OK) {
+            return;
+        }
+    }
+
+    esp_err_t err = ESP_OK;
+    for (uint16_t i = 0; i < warmup && err == ESP_OK; i++) {
+        err = bench_call(c, r->batch);
+    }
+    uint32_t probe_start[BENCH_MAX_PROBES] = {0};
+    const bench_probe_fn_t probe = s_probe_fn;
+    if (probe != NULL) {
+        probe(probe_start, s_probe_ctx);
+    }
+    uint64_t sum_ns = 0;
+    while (r->reps < reps && err == ESP_OK) {
+        const int64_t t0 = esp_timer_get_time();
+        err = bench_call(c, r->batch);
+        if (err != ESP_OK) {
+            break;
+        }
+        const uint64_t ns = ((uint64_t)(esp_timer_get_time() - t0) * 1000ULL) / r->batch;
+        s_samples_ns[r->reps] = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+        sum_ns += s_samples_ns[r->reps];
+        r->reps++;
+    }
+    r->err = err;
+    if (probe != NULL) {
+        uint32_t probe_end[BENCH_MAX_PROBES] = {0};
+        probe(probe_end, s_probe_ctx);
+        r->probe_count = (uint8_t)s_probe_count;
+        r->probe_names = s_probe_names;
+        for (uint32_t i = 0; i < s_probe_count; i++) {
+            r->probe_delta[i] = probe_end[i] - probe_start[i];
+        }
+        r->calls = (uint32_t)r->reps * r->batch;
+    }
+
+    if (c->teardown != NULL) {
+        const esp_err_t td_err = c->teardown(c->ctx);
+        if (r->err == ESP_OK) {
+            r->err = td_err;
+        }
+    }
+
+    if (r->reps == 0U) {
+        return;
+    }
+    qsort(s_samples_ns, r->reps, sizeof(s_samples_ns[0]), bench_cmp_u32);
+    r->min_ns = s_samples_ns[0];
+    r->p50_ns = bench_percentile(s_samples_ns, r->reps, 50U);
+    r->p90_ns = bench_percentile(s_samples_ns, r->reps, 90U);
+    r->p99_ns = bench_percentile(s_samples_ns, r->reps, 99U);
+    r->max_ns = s_samples_ns[r->reps - 1U];
+    r->mean_ns = (uint32_t)(sum_ns / r->reps);
+}
+
+/* Caller owns s_busy. */
+static void bench_run_owned(const bench_run_cfg_t *cfg)
+{
+    const uint32_t count = __atomic_load_n(&s_case_count, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&s_result_count, 0U, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&s_gen, 1U, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    s_selected = bench_count_matches(cfg->filter);
+    s_run_start_us = esp_timer_get_time();
+    s_run_end_us = 0;
+    ESP_LOGI(TAG, "run %" PRIu32 ": %" PRIu32 " case(s), filter=\"%s\"", s_gen, s_selected,
+             (cfg->filter != NULL) ? cfg->filter : "");
+
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < count && slot < BENCH_MAX_CASES; i++) {
+        const bench_case_t *c = s_cases[i];
+        if (!bench_filter_match(cfg->filter, c->name)) {
+            continue;
+        }
+
+        bench_result_t *r = &s_results[slot];
+        bench_run_case(c, cfg, r);
+        __atomic_store_n(&s_result_count, slot + 1U, __ATOMIC_RELEASE);
+        slot++;
+        ESP_LOGI(TAG, "%-24s p50=%" PRIu32 " p99=%" PRIu32 " ns (n=%u) %s", c->name, r->p50_ns, r->p99_ns,
+                 (unsigned)r->reps, esp_err_to_name(r->err));
+        /* Cases may be CPU-bound; let the idle task feed the watchdog between them. */
+        vTaskDelay(1);
+    }
+
+    s_run_end_us = esp_timer_get_time();
+    if (s_done_cb != NULL) {
+        s_done_cb(s_done_ctx);
+    }
+}
+
+esp_err_t bench_run(const bench_run_cfg_t *cfg)
+{
+    const bench_run_cfg_t defaults = {0};
+    const bench_run_cfg_t *use_cfg = (cfg != NULL) ? cfg : &defaults;
+
+    ESP_RETURN_ON_FALSE(bench_try_acquire(), ESP_ERR_INVALID_STATE, TAG, "a run is already active");
+    if (bench_count_matches(use_cfg->filter) == 0U) {
+        bench_release();
+        return ESP_ERR_NOT_FOUND;
+    }
+    bench_run_owned(use_cfg);
+    bench_release();
+    return ESP_OK;
+}
+
+static void bench_task(void *arg)
+{
+    (void)arg;
+    bench_run_owned(&s_async_cfg);
+    bench_release();
+    vTaskDelete(NULL);
+}
+
+esp_err_t bench_start(const bench_run_cfg_t *cfg)
+{
+    const bench_run_cfg_t defaults = {0};
+    const bench_run_cfg_t *use_cfg = (cfg != NULL) ? cfg : &defaults;
+    const char *filter = (use_cfg->filter != NULL) ? use_cfg->filter : "";
+
+    ESP_RETURN_ON_FALSE(strlen(filter) < sizeof(s_async_filter), ESP_ERR_INVALID_ARG, TAG, "filter too long");
+    ESP_RETURN_ON_FALSE(bench_try_acquire(), ESP_ERR_INVALID_STATE, TAG, "a run is already active");
+    if (bench_count_matches(filter) == 0U) {
+        bench_release();
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(s_async_filter, filter, strlen(filter) + 1U);
+    s_async_cfg = *use_cfg;
+    s_async_cfg.filter = s_async_filter;
+    if (xTaskCreate(bench_task, "bench", BENCH_TASK_STACK, NULL, BENCH_TASK_PRIO, NULL) != pdPASS) {
+        bench_release();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* Render state; the first write error latches and silences the rest. */
+typedef struct {
+    bench_write_fn_t write;
+    void *user_ctx;
+    esp_err_t err;
+} bench_out_t;
+
+static void bench_printf(bench_out_t *out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void bench_printf(bench_out_t *out, const char *fmt, ...)
+{
+    if (out->err != ESP_OK) {
+        return;
+    }
+
+    char line[BENCH_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out->err = out->write(line, ((size_t)n < sizeof(line)) ? (size_t)n : (sizeof(line) - 1U), out->user_ctx);
+    }
+}
+
+static void bench_render_result(bench_out_t *out, const bench_result_t *r, bool first)
+{
+    const bench_case_t *c = r->bench_case;
+    bench_printf(out,
+                 "%s{\"name\":\"%s\",\"err\":\"%s\",\"reps\":%u,\"batch\":%u,\"min_ns\":%" PRIu32 ",\"p50_ns\":%" PRIu32
+                 ",\"p90_ns\":%" PRIu32,
+                 first ? "" : ",", c->name, esp_err_to_name(r->err), (unsigned)r->reps, (unsigned)r->batch, r->min_ns,
+                 r->p50_ns, r->p90_ns);
+    bench_printf(out, ",\"p99_ns\":%" PRIu32 ",\"max_ns\":%" PRIu32 ",\"mean_ns\":%" PRIu32, r->p99_ns, r->max_ns,
+                 r->mean_ns);
+    const uint64_t ops_per_s = (r->mean_ns != 0U) ? (1000000000ULL / r->mean_ns) : 0U;
+    bench_printf(out, ",\"ops_per_s\":%" PRIu64, ops_per_s);
+    if (c->work != 0U) {
+        const uint64_t rate = (r->mean_ns != 0U) ? (((uint64_t)c->work * 1000000000ULL) / r->mean_ns) : 0U;
+        bench_printf(out, ",\"work\":%" PRIu32 ",\"unit\":\"%s\",\"rate_per_s\":%" PRIu64, c->work,
+                     (c->unit != NULL) ? c->unit : "op", rate);
+    }
+    if (r->probe_count > 0U && r->calls > 0U && r->err == ESP_OK) {
+        /* Per call, two decimals. A failing rep's partial work is in the delta but not in calls. */
+        bench_printf(out, ",\"probes\":{");
+        for (uint32_t i = 0; i < r->probe_count; i++) {
+            const uint64_t x100 = (((uint64_t)r->probe_delta[i] * 100ULL) + (r->calls / 2U)) / r->calls;
+            bench_printf(out, "%s\"%s\":%" PRIu64 ".%02u", (i == 0U) ? "" : ",", r->probe_names[i], x100 / 100U,
+                         (unsigned)(x100 % 100U));
+        }
+        bench_printf(out, "}");
+    }
+    bench_printf(out, "}");
+}
+
+esp_err_t bench_render_json(bench_write_fn_t write, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(write != NULL, ESP_ERR_INVALID_ARG, TAG, "write is null");
+    bench_out_t out = {.write = write, .user_ctx = user_ctx, .err = ESP_OK};
+
+    const uint32_t gen = __atomic_load_n(&s_gen, __ATOMIC_ACQUIRE);
+    const int64_t end_us = (s_run_end_us != 0) ? s_run_end_us : esp_timer_get_time();
+    const esp_app_desc_t *app = esp_app_get_description();
+    char elf_sha[17];
+    (void)esp_app_get_elf_sha256(elf_sha, sizeof(elf_sha));
+
+    bench_printf(&out, "{\"running\":%s,\"run\":%" PRIu32 ",\"selected\":%" PRIu32 ",\"elapsed_ms\":%" PRId64,
+                 bench_busy() ? "true" : "false", gen, s_selected, (gen != 0U) ? (int64_t)((end_us - s_run_start_us) / 1000) : (int64_t)0);
+    bench_printf(&out, ",\"build\":{\"project\":\"%s\",\"version\":\"%s\",\"idf\":\"%s\",\"date\":\"%s %s\",\"elf_sha256\":\"%s\"}",
+                 app->project_name, app->version, app->idf_ver, app->date, app->time, elf_sha);
+
+    bench_printf(&out, ",\"tags\":{");
+    portENTER_CRITICAL(&s_registry_mux);
+    bench_tag_t tags[BENCH_MAX_TAGS];
+    const uint32_t tag_count = s_tag_count;
+    memcpy(tags, s_tags, sizeof(tags));
+    portEXIT_CRITICAL(&s_registry_mux);
+    for (uint32_t i = 0; i < tag_count; i++) {
+        bench_printf(&out, "%s\"%s\":%" PRId64, (i == 0U) ? "" : ",", tags[i].key, tags[i].value);
+    }
+
+    bench_printf(&out, "},\"cases\":[");
+    const uint32_t count = __atomic_load_n(&s_result_count, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < count; i++) {
+        const bench_result_t r = s_results[i];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s_gen, __ATOMIC_RELAXED) != gen) {
+            break; /* a new run started and is overwriting slots */
+        }
+        bench_render_result(&out, &r, i == 0U);
+    }
+    bench_printf(&out, "]}");
+    return out.err;
+}
@@ -7,12 +7,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "driver/i2c.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "i2c_bus_api.h"
 
 /**
  * @file dht20_api.h
  * @brief Reusable DHT20 sensor API over I2C.
+ *
+ * The sensor is one device on an i2c_bus_api bus, so other sensors can share
+ * the wires; its timeouts and failures stay with its own device handle.
  */
 
 #ifdef __cplusplus
@@ -21,9 +25,7 @@ extern "C" {
 
 /** @brief DHT20 device descriptor. */
 typedef struct {
-    i2c_port_t i2c_port;
-    uint8_t i2c_addr;
-    uint32_t i2c_timeout_ms;
+    i2c_bus_dev_t i2c;
 } dht20_t;
 
 /** @brief One decoded DHT20 sample. */
@@ -43,22 +45,55 @@ typedef struct {
     float temperature_c;
 } dht20_filter_t;
 
+/**
+ * @brief Async acquisition result callback (runs on the i2c_bus worker task;
+ * on the esp_timer task when the bus queue was full).
+ * @param status ESP_OK, or the I2C/CRC/timeout error of this conversion (sample is then zeroed).
+ */
+typedef void (*dht20_sample_cb_t)(const dht20_sample_t *sample, esp_err_t status, void *user_ctx);
+
+/** @brief Async acquisition state; treat as opaque. */
+typedef struct {
+    dht20_t *dev;
+    esp_timer_handle_t timer;
+    dht20_sample_cb_t cb;
+    void *user_ctx;
+    uint32_t period_ms;
+    int64_t trigger_us;
+    uint8_t busy_retries;
+    bool converting;
+    bool running;
+    i2c_bus_txn_t txn;
+    uint8_t frame[7]; /* status, 5 data bytes, CRC */
+} dht20_async_t;
+
 #define DHT20_I2C_ADDR_DEFAULT 0x38
+#define DHT20_I2C_SCL_HZ_MAX 400000U
 
-/** @brief Initialize DHT20, including optional calibration command sequence. */
-esp_err_t dht20_init(dht20_t *dev, i2c_port_t i2c_port, uint8_t i2c_addr, uint32_t i2c_timeout_ms);
+/** @brief Attach DHT20 to bus and run the power-on reset / calibration sequence. */
+esp_err_t dht20_init(dht20_t *dev, i2c_bus_t *bus, uint8_t i2c_addr, uint32_t scl_hz, uint32_t i2c_timeout_ms);
+/** @brief Detach from the bus; stop async acquisition first. */
+esp_err_t dht20_deinit(dht20_t *dev);
 /** @brief Trigger DHT20 software reset. */
-esp_err_t dht20_soft_reset(const dht20_t *dev);
+esp_err_t dht20_soft_reset(dht20_t *dev);
 /** @brief Start one measurement conversion. */
-esp_err_t dht20_start_measurement(const dht20_t *dev);
+esp_err_t dht20_start_measurement(dht20_t *dev);
 /** @brief Read one completed measurement frame. */
-esp_err_t dht20_read_measurement(const dht20_t *dev, dht20_sample_t *sample);
+esp_err_t dht20_read_measurement(dht20_t *dev, dht20_sample_t *sample);
 /** @brief Poll until conversion completes or timeout is reached. */
-esp_err_t dht20_read_measurement_wait(const dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms);
+esp_err_t dht20_read_measurement_wait(dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms);
 /** @brief Start and wait for one conversion in a single call. */
-esp_err_t dht20_read_oneshot(const dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms);
+esp_err_t dht20_read_oneshot(dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms);
 /** @brief Legacy helper: start conversion, delay fixed time, then read. */
-esp_err_t dht20_read(const dht20_t *dev, dht20_sample_t *sample, uint32_t conversion_wait_ms);
+esp_err_t dht20_read(dht20_t *dev, dht20_sample_t *sample, uint32_t conversion_wait_ms);
+/**
+ * @brief Start timer-driven acquisition: trigger, wait the ~80 ms conversion
+ * without touching the bus, read the frame once, deliver it via cb.
+ * @param period_ms Trigger-to-trigger period; clamped to at least one conversion time.
+ */
+esp_err_t dht20_async_start(dht20_async_t *ctx, dht20_t *dev, uint32_t period_ms, dht20_sample_cb_t cb, void *user_ctx);
+/** @brief Stop async acquisition, wait out a queued bus transaction and release the timer. */
+void dht20_async_stop(dht20_async_t *ctx);
 /** @brief Apply post-processing offsets to a sample. */
 esp_err_t dht20_sample_apply_offset(dht20_sample_t *sample, float temperature_offset_c, float humidity_offset_rh);
 /** @brief Initialize EMA filter state. */
@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+/**
+ * @file dht20_flashlog.h
+ * @brief Append-only sensor log on a raw data partition, 4 bytes per sample.
+ *
+ * Each 4 KiB sector starts with a 16-byte header holding an absolute sample;
+ * following records hold deltas (seconds, centi-degC, centi-%RH). A sample
+ * the deltas cannot express (gap over 254 s, clock step back, large jump)
+ * is stored as a 12-byte absolute record in the same sector, so a new
+ * sector is only started when the current one is full. Sectors are used
+ * round-robin, so wear is spread evenly and the oldest sector is recycled
+ * when the partition is full. Records are buffered in RAM and programmed
+ * one 256-byte flash page at a time; queries see them too.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT20_FLASHLOG_PARTITION_LABEL "history"
+#define DHT20_FLASHLOG_PAGE_SIZE 256U
+
+/**
+ * @brief Log state. One task appends; queries may run from other tasks and
+ * snapshot the head position under state_seq (odd while the writer updates).
+ */
+typedef struct {
+    const esp_partition_t *part;
+    const uint8_t *map;
+    esp_partition_mmap_handle_t map_handle;
+    uint32_t sector_size;
+    uint32_t sector_count;
+    uint32_t head_sector;
+    uint32_t head_seq;
+    uint32_t write_off;   /* next record offset in the head sector */
+    uint32_t flushed_off; /* bytes of the head sector already programmed */
+    uint32_t page_off;    /* head-sector offset of page_buf */
+    uint32_t last_time_s;
+    int32_t last_t_centi;
+    int32_t last_rh_centi;
+    uint32_t state_seq;
+    bool sector_open;
+    bool initialized;
+    uint8_t page_buf[DHT20_FLASHLOG_PAGE_SIZE];
+} dht20_flashlog_t;
+
+/** @brief Called per logged sample in log order (time order unless the clock stepped back); return false to stop. */
+typedef bool (*dht20_flashlog_visit_fn_t)(uint32_t time_s, float temperature_c, float humidity_rh, void *user_ctx);
+
+/** @brief Map the partition and recover the write position. */
+esp_err_t dht20_flashlog_init(dht20_flashlog_t *log, const char *partition_label);
+/** @brief Unmap the partition (pending records are flushed first). */
+void dht20_flashlog_deinit(dht20_flashlog_t *log);
+/** @brief Append one sample; flash is programmed when a page fills up. */
+esp_err_t dht20_flashlog_append(dht20_flashlog_t *log, uint32_t time_s, float temperature_c, float humidity_rh);
+/** @brief Program records still buffered in RAM (e.g. before restart). */
+esp_err_t dht20_flashlog_flush(dht20_flashlog_t *log);
+/**
+ * @brief Stream samples with from_s <= time_s <= to_s, oldest first, straight
+ * from the memory-mapped partition plus a stack copy of the unflushed page.
+ */
+esp_err_t dht20_flashlog_query(const dht20_flashlog_t *log,
+                               uint32_t from_s,
+                               uint32_t to_s,
+                               dht20_flashlog_visit_fn_t visit,
+                               void *user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dht20_api.h"
+#include "esp_err.h"
+
+/**
+ * @file dht20_history.h
+ * @brief Single-writer sample ring with windowed statistics, readable without a mutex.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT20_HISTORY_CAPACITY 256U /* raw samples kept, power of two */
+#define DHT20_HISTORY_WINDOWS 3U
+#define DHT20_HISTORY_BUCKETS 12U   /* per window; stats granularity = window / buckets */
+
+#define DHT20_HISTORY_DEFAULT_WINDOWS_MS {10000U, 60000U, 3600000U}
+
+/** @brief Running sums of one channel in one bucket (centi-units, integer only). */
+typedef struct {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    int64_t sum_sq;
+} dht20_bucket_acc_t;
+
+/** @brief One statistics window split into time buckets (ring indexed by bucket number). */
+typedef struct {
+    uint32_t span_ms;
+    uint32_t bucket_ms;
+    uint32_t bucket_id[DHT20_HISTORY_BUCKETS];
+    dht20_bucket_acc_t temperature[DHT20_HISTORY_BUCKETS];
+    dht20_bucket_acc_t humidity[DHT20_HISTORY_BUCKETS];
+} dht20_history_window_t;
+
+/**
+ * @brief History state. One task pushes; any number of tasks read concurrently.
+ *
+ * Readers copy and validate against the write counters (seqlock style) and
+ * retry on overlap, so the writer never waits.
+ */
+typedef struct {
+    uint32_t head;      /* samples ever pushed */
+    uint32_t stats_seq; /* odd while the writer updates windows */
+    uint32_t errors;
+    dht20_sample_t ring[DHT20_HISTORY_CAPACITY];
+    dht20_history_window_t windows[DHT20_HISTORY_WINDOWS];
+} dht20_history_t;
+
+/** @brief Channel statistics over one window. */
+typedef struct {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev;
+} dht20_channel_stats_t;
+
+/** @brief Both channels over one window. */
+typedef struct {
+    uint32_t span_ms;
+    dht20_channel_stats_t temperature_c;
+    dht20_channel_stats_t humidity_rh;
+} dht20_window_stats_t;
+
+/**
+ * @brief Reset history and set window spans.
+ * @param windows_ms DHT20_HISTORY_WINDOWS spans, or NULL for 10 s / 1 min / 1 h.
+ */
+esp_err_t dht20_history_init(dht20_history_t *hist, const uint32_t *windows_ms);
+/** @brief Append one sample and update all windows in O(1). Single writer only. */
+void dht20_history_push(dht20_history_t *hist, const dht20_sample_t *sample);
+/** @brief Count one failed acquisition. Single writer only. */
+void dht20_history_push_error(dht20_history_t *hist);
+/** @brief Total failed acquisitions recorded. */
+uint32_t dht20_history_get_errors(const dht20_history_t *hist);
+/** @brief Copy up to max_samples most recent samples, oldest first; returns the number copied. */
+size_t dht20_history_read_latest(const dht20_history_t *hist, dht20_sample_t *out, size_t max_samples);
+/** @brief Statistics of window `index` ending now (bucket granularity). */
+esp_err_t dht20_history_get_stats(const dht20_history_t *hist, size_t index, dht20_window_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,11 +6,13 @@
 
 #include <math.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "esp_check.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "perf_api.h"
 
 #define DHT20_CMD_SOFT_RESET 0xBA
 #define DHT20_CMD_STATUS 0x71
@@ -29,6 +31,16 @@
 #define DHT20_STATUS_READY_DELAY_MS 10
 #define DHT20_SOFT_RESET_DELAY_MS 20
 #define DHT20_POWER_ON_DELAY_MS 100
+#define DHT20_CONVERSION_TIME_MS 80U
+#define DHT20_BUSY_RETRY_MS 10U
+#define DHT20_ASYNC_MAX_BUSY_RETRIES 4U
+#define DHT20_ASYNC_STOP_WAIT_MS 100U
+
+static perf_metric_t s_perf_crc_errors = PERF_COUNTER_INIT("dht20_crc_errors_total", "DHT20 frames with a bad CRC", NULL);
+static perf_metric_t s_perf_conversion = PERF_HISTOGRAM_INIT("dht20_conversion_us", "Trigger to valid sample", NULL);
+
+/* Queued by the async sampler, so it must outlive the call. */
+static const uint8_t s_trigger_cmd[] = {DHT20_CMD_TRIGGER, DHT20_ARG_TRIGGER_1, DHT20_ARG_TRIGGER_2};
 
 static uint8_t dht20_crc8(const uint8_t *data, size_t len)
 {
@@ -46,25 +58,24 @@ static uint8_t dht20_crc8(const uint8_t *data, size_t len)
     return crc;
 }
 
-static esp_err_t dht20_write(const dht20_t *dev, const uint8_t *tx, size_t tx_len)
+/*
+ * The i2c_master driver holds its own APB lock per transfer, so the 80 ms
+ * conversion in between may still run in light sleep.
+ */
+static esp_err_t dht20_write(dht20_t *dev, const uint8_t *tx, size_t tx_len)
 {
-    TickType_t timeout_ticks = pdMS_TO_TICKS(dev->i2c_timeout_ms);
-    return i2c_master_write_to_device(dev->i2c_port, dev->i2c_addr, tx, tx_len, timeout_ticks);
+    return i2c_bus_write(&dev->i2c, tx, tx_len);
 }
 
-static esp_err_t dht20_read_raw(const dht20_t *dev, uint8_t *rx, size_t rx_len)
+static esp_err_t dht20_read_raw(dht20_t *dev, uint8_t *rx, size_t rx_len)
 {
-    TickType_t timeout_ticks = pdMS_TO_TICKS(dev->i2c_timeout_ms);
-    return i2c_master_read_from_device(dev->i2c_port, dev->i2c_addr, rx, rx_len, timeout_ticks);
+    return i2c_bus_read(&dev->i2c, rx, rx_len);
 }
 
-static esp_err_t dht20_read_status(const dht20_t *dev, uint8_t *status)
+/* Status command and its read in one transaction (repeated start, no second address phase). */
+static esp_err_t dht20_read_status(dht20_t *dev, uint8_t *status)
 {
-    esp_err_t ret = dht20_write(dev, (const uint8_t[]){DHT20_CMD_STATUS}, 1);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-    return dht20_read_raw(dev, status, 1);
+    return i2c_bus_write_read(&dev->i2c, (const uint8_t[]){DHT20_CMD_STATUS}, 1, status, 1);
 }
 
 static esp_err_t dht20_parse_sample(const uint8_t raw[DHT20_DATA_LEN], dht20_sample_t *sample)
@@ -74,6 +85,7 @@ static esp_err_t dht20_parse_sample(const uint8_t raw[DHT20_DATA_LEN], dht20_sam
     }
 
     if (dht20_crc8(raw, DHT20_DATA_LEN - 1) != raw[DHT20_DATA_LEN - 1]) {
+        perf_count(&s_perf_crc_errors, 1U);
         return ESP_ERR_INVALID_CRC;
     }
 
@@ -101,7 +113,7 @@ static float dht20_clampf(float value, float min_v, float max_v)
     return value;
 }
 
-esp_err_t dht20_soft_reset(const dht20_t *dev)
+esp_err_t dht20_soft_reset(dht20_t *dev)
 {
     ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
 
@@ -114,52 +126,53 @@ esp_err_t dht20_soft_reset(const dht20_t *dev)
     return ESP_OK;
 }
 
-esp_err_t dht20_init(dht20_t *dev, i2c_port_t i2c_port, uint8_t i2c_addr, uint32_t i2c_timeout_ms)
+esp_err_t dht20_init(dht20_t *dev, i2c_bus_t *bus, uint8_t i2c_addr, uint32_t scl_hz, uint32_t i2c_timeout_ms)
 {
     ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
+    ESP_RETURN_ON_FALSE(scl_hz > 0U && scl_hz <= DHT20_I2C_SCL_HZ_MAX, ESP_ERR_INVALID_ARG, "dht20", "scl_hz out of range");
 
-    dev->i2c_port = i2c_port;
-    dev->i2c_addr = i2c_addr;
-    dev->i2c_timeout_ms = i2c_timeout_ms;
+    ESP_RETURN_ON_ERROR(i2c_bus_add_device(bus, &dev->i2c, i2c_addr, scl_hz, i2c_timeout_ms), "dht20",
+                        "i2c_bus_add_device failed");
 
     vTaskDelay(pdMS_TO_TICKS(DHT20_POWER_ON_DELAY_MS));
 
     esp_err_t ret = dht20_soft_reset(dev);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-
     uint8_t status = 0;
-    ret = dht20_read_status(dev, &status);
-    if (ret != ESP_OK) {
-        return ret;
+    if (ret == ESP_OK) {
+        ret = dht20_read_status(dev, &status);
     }
-
-    if ((status & DHT20_STATUS_CAL_MASK) == 0) {
+    if (ret == ESP_OK && (status & DHT20_STATUS_CAL_MASK) == 0) {
         const uint8_t init_cmd[] = {DHT20_CMD_INIT, DHT20_ARG_INIT_1, DHT20_ARG_INIT_2};
         ret = dht20_write(dev, init_cmd, sizeof(init_cmd));
-        if (ret != ESP_OK) {
-            return ret;
+        if (ret == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(DHT20_STATUS_READY_DELAY_MS));
         }
-        vTaskDelay(pdMS_TO_TICKS(DHT20_STATUS_READY_DELAY_MS));
     }
+    if (ret != ESP_OK) {
+        (void)i2c_bus_remove_device(&dev->i2c);
+    }
+    return ret;
+}
 
-    return ESP_OK;
+esp_err_t dht20_deinit(dht20_t *dev)
+{
+    ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
+    return i2c_bus_remove_device(&dev->i2c);
 }
 
-esp_err_t dht20_start_measurement(const dht20_t *dev)
+esp_err_t dht20_start_measurement(dht20_t *dev)
 {
     ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
 
-    const uint8_t trigger_cmd[] = {DHT20_CMD_TRIGGER, DHT20_ARG_TRIGGER_1, DHT20_ARG_TRIGGER_2};
-    return dht20_write(dev, trigger_cmd, sizeof(trigger_cmd));
+    return dht20_write(dev, s_trigger_cmd, sizeof(s_trigger_cmd));
 }
 
-esp_err_t dht20_read_measurement(const dht20_t *dev, dht20_sample_t *sample)
+esp_err_t dht20_read_measurement(dht20_t *dev, dht20_sample_t *sample)
 {
     ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
     ESP_RETURN_ON_FALSE(sample != NULL, ESP_ERR_INVALID_ARG, "dht20", "sample is null");
 
+    /* The frame starts with the status byte: one read is both the ready check and the data. */
     uint8_t raw[DHT20_DATA_LEN] = {0};
     esp_err_t ret = dht20_read_raw(dev, raw, sizeof(raw));
     if (ret != ESP_OK) {
@@ -169,7 +182,7 @@ esp_err_t dht20_read_measurement(const dht20_t *dev, dht20_sample_t *sample)
     return dht20_parse_sample(raw, sample);
 }
 
-esp_err_t dht20_read_measurement_wait(const dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms)
+esp_err_t dht20_read_measurement_wait(dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms)
 {
     ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
     ESP_RETURN_ON_FALSE(sample != NULL, ESP_ERR_INVALID_ARG, "dht20", "sample is null");
@@ -196,13 +209,18 @@ esp_err_t dht20_read_measurement_wait(const dht20_t *dev, dht20_sample_t *sample
     }
 }
 
-esp_err_t dht20_read_oneshot(const dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms)
+esp_err_t dht20_read_oneshot(dht20_t *dev, dht20_sample_t *sample, uint32_t timeout_ms, uint32_t poll_interval_ms)
 {
+    const int64_t start_us = esp_timer_get_time();
     ESP_RETURN_ON_ERROR(dht20_start_measurement(dev), "dht20", "start_measurement failed");
-    return dht20_read_measurement_wait(dev, sample, timeout_ms, poll_interval_ms);
+    const esp_err_t err = dht20_read_measurement_wait(dev, sample, timeout_ms, poll_interval_ms);
+    if (err == ESP_OK) {
+        perf_observe_since(&s_perf_conversion, start_us);
+    }
+    return err;
 }
 
-esp_err_t dht20_read(const dht20_t *dev, dht20_sample_t *sample, uint32_t conversion_wait_ms)
+esp_err_t dht20_read(dht20_t *dev, dht20_sample_t *sample, uint32_t conversion_wait_ms)
 {
     ESP_RETURN_ON_ERROR(dht20_start_measurement(dev), "dht20", "start_measurement failed");
 
@@ -213,6 +231,153 @@ esp_err_t dht20_read(const dht20_t *dev, dht20_sample_t *sample, uint32_t conver
     return dht20_read_measurement(dev, sample);
 }
 
+static void dht20_async_arm(dht20_async_t *ctx, uint32_t delay_ms)
+{
+    (void)esp_timer_start_once(ctx->timer, (uint64_t)delay_ms * 1000ULL);
+}
+
+/* Schedule the next trigger one period after the previous one. */
+static void dht20_async_schedule_next(dht20_async_t *ctx)
+{
+    const int64_t elapsed_ms = (esp_timer_get_time() - ctx->trigger_us) / 1000LL;
+    const int64_t wait_ms = (int64_t)ctx->period_ms - elapsed_ms;
+    dht20_async_arm(ctx, (wait_ms > 0) ? (uint32_t)wait_ms : 0U);
+}
+
+static void dht20_async_deliver(dht20_async_t *ctx, const dht20_sample_t *sample, esp_err_t status)
+{
+    const dht20_sample_t empty = {0};
+    ctx->cb((status == ESP_OK) ? sample : &empty, status, ctx->user_ctx);
+}
+
+static void dht20_async_trigger_done(esp_err_t status, void *arg);
+static void dht20_async_frame_done(esp_err_t status, void *arg);
+
+/* Queue one op for the bus worker; a full queue counts as this cycle's error. */
+static void dht20_async_submit(dht20_async_t *ctx, const i2c_bus_op_t *op, i2c_bus_done_cb_t done_cb)
+{
+    ctx->txn.dev = &ctx->dev->i2c;
+    ctx->txn.ops[0] = *op;
+    ctx->txn.op_count = 1U;
+    ctx->txn.done_cb = done_cb;
+    ctx->txn.user_ctx = ctx;
+
+    const esp_err_t err = i2c_bus_submit(&ctx->txn);
+    if (err != ESP_OK) {
+        ctx->converting = false;
+        dht20_async_deliver(ctx, NULL, err);
+        dht20_async_schedule_next(ctx);
+    }
+}
+
+/*
+ * Two-state machine on one one-shot timer, with the bus work queued to the
+ * i2c_bus worker so the esp_timer task never waits on the wire:
+ * idle -> queue the trigger; once written, arm for the datasheet conversion time;
+ * converting -> queue one 7-byte read; busy re-arms a short retry, otherwise deliver.
+ */
+static void dht20_async_timer_cb(void *arg)
+{
+    dht20_async_t *ctx = (dht20_async_t *)arg;
+    if (!ctx->running) {
+        return;
+    }
+
+    if (!ctx->converting) {
+        ctx->trigger_us = esp_timer_get_time();
+        const i2c_bus_op_t op = {.kind = I2C_BUS_OP_WRITE, .tx = s_trigger_cmd, .tx_len = sizeof(s_trigger_cmd)};
+        dht20_async_submit(ctx, &op, dht20_async_trigger_done);
+        return;
+    }
+
+    const i2c_bus_op_t op = {.kind = I2C_BUS_OP_READ, .rx = ctx->frame, .rx_len = sizeof(ctx->frame)};
+    dht20_async_submit(ctx, &op, dht20_async_frame_done);
+}
+
+static void dht20_async_trigger_done(esp_err_t status, void *arg)
+{
+    dht20_async_t *ctx = (dht20_async_t *)arg;
+    if (!ctx->running) {
+        return;
+    }
+    if (status != ESP_OK) {
+        dht20_async_deliver(ctx, NULL, status);
+        dht20_async_schedule_next(ctx);
+        return;
+    }
+    ctx->converting = true;
+    ctx->busy_retries = 0;
+    dht20_async_arm(ctx, DHT20_CONVERSION_TIME_MS);
+}
+
+static void dht20_async_frame_done(esp_err_t status, void *arg)
+{
+    dht20_async_t *ctx = (dht20_async_t *)arg;
+    if (!ctx->running) {
+        return;
+    }
+
+    dht20_sample_t sample = {0};
+    esp_err_t err = (status == ESP_OK) ? dht20_parse_sample(ctx->frame, &sample) : status;
+    if (err == ESP_ERR_INVALID_STATE && ctx->busy_retries < DHT20_ASYNC_MAX_BUSY_RETRIES) {
+        ctx->busy_retries++;
+        dht20_async_arm(ctx, DHT20_BUSY_RETRY_MS);
+        return;
+    }
+
+    ctx->converting = false;
+    if (err == ESP_OK) {
+        perf_observe_since(&s_perf_conversion, ctx->trigger_us);
+    }
+    dht20_async_deliver(ctx, &sample, (err == ESP_ERR_INVALID_STATE) ? ESP_ERR_TIMEOUT : err);
+    dht20_async_schedule_next(ctx);
+}
+
+esp_err_t dht20_async_start(dht20_async_t *ctx, dht20_t *dev, uint32_t period_ms, dht20_sample_cb_t cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(ctx != NULL, ESP_ERR_INVALID_ARG, "dht20", "ctx is null");
+    ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, "dht20", "dev is null");
+    ESP_RETURN_ON_FALSE(cb != NULL, ESP_ERR_INVALID_ARG, "dht20", "cb is null");
+    ESP_RETURN_ON_FALSE(!ctx->running, ESP_ERR_INVALID_STATE, "dht20", "async already running");
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->dev = dev;
+    ctx->cb = cb;
+    ctx->user_ctx = user_ctx;
+    ctx->period_ms = (period_ms < DHT20_CONVERSION_TIME_MS) ? DHT20_CONVERSION_TIME_MS : period_ms;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = dht20_async_timer_cb,
+        .arg = ctx,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "dht20",
+        .skip_unhandled_events = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &ctx->timer), "dht20", "timer create failed");
+
+    ctx->running = true;
+    dht20_async_arm(ctx, 0U);
+    return ESP_OK;
+}
+
+void dht20_async_stop(dht20_async_t *ctx)
+{
+    if (ctx == NULL || ctx->timer == NULL) {
+        return;
+    }
+    ctx->running = false;
+    (void)esp_timer_stop(ctx->timer);
+    /* A queued txn points into ctx; pending drops only after its callback returned. */
+    for (uint32_t waited = 0; __atomic_load_n(&ctx->txn.pending, __ATOMIC_ACQUIRE) && waited < DHT20_ASYNC_STOP_WAIT_MS;
+         waited += 10U) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    (void)esp_timer_stop(ctx->timer);
+    (void)esp_timer_delete(ctx->timer);
+    ctx->timer = NULL;
+    ctx->converting = false;
+}
+
 esp_err_t dht20_sample_apply_offset(dht20_sample_t *sample, float temperature_offset_c, float humidity_offset_rh)
 {
     ESP_RETURN_ON_FALSE(sample != NULL, ESP_ERR_INVALID_ARG, "dht20", "sample is null");
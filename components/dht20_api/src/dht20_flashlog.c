@@ -0,0 +1,434 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "dht20_flashlog.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#define DHT20_FLASHLOG_MAGIC 0x4C544844U /* "DHTL" */
+#define DHT20_FLASHLOG_ERASED 0xFFFFFFFFU
+#define DHT20_FLASHLOG_RECORD_SIZE 4U
+/* dt 255 marks a control word (and with both deltas -1 would read back as erased flash). */
+#define DHT20_FLASHLOG_DT_MAX 254U
+#define DHT20_FLASHLOG_REC_NOP 0x000000FFU /* padding up to the next page */
+#define DHT20_FLASHLOG_REC_ABS 0x000001FFU /* + time_s word + (t, rh) int16 word: new delta base */
+#define DHT20_FLASHLOG_ABS_SIZE 12U
+#define DHT20_FLASHLOG_DELTA_MIN (-2048)
+#define DHT20_FLASHLOG_DELTA_MAX 2047
+#define DHT20_FLASHLOG_SNAPSHOT_RETRIES 8
+
+static const char *TAG = "dht20_flashlog";
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t base_time_s;
+    int16_t base_t_centi;
+    int16_t base_rh_centi;
+} dht20_flashlog_header_t;
+
+_Static_assert(sizeof(dht20_flashlog_header_t) == 16U, "header must stay 16 bytes");
+
+/* Record: bits 0..7 dt seconds, 8..19 temperature delta, 20..31 humidity delta (centi, signed). */
+static uint32_t record_pack(uint32_t dt, int32_t dt_centi, int32_t drh_centi)
+{
+    return (dt & 0xFFU) | (((uint32_t)dt_centi & 0xFFFU) << 8) | (((uint32_t)drh_centi & 0xFFFU) << 20);
+}
+
+static int32_t sign_extend12(uint32_t v)
+{
+    return ((v & 0x800U) != 0U) ? (int32_t)(v | 0xFFFFF000U) : (int32_t)v;
+}
+
+static void record_unpack(uint32_t rec, uint32_t *dt, int32_t *dt_centi, int32_t *drh_centi)
+{
+    *dt = rec & 0xFFU;
+    *dt_centi = sign_extend12((rec >> 8) & 0xFFFU);
+    *drh_centi = sign_extend12((rec >> 20) & 0xFFFU);
+}
+
+static uint32_t abs_pack(int32_t t_centi, int32_t rh_centi)
+{
+    return (uint32_t)(uint16_t)(int16_t)t_centi | ((uint32_t)(uint16_t)(int16_t)rh_centi << 16);
+}
+
+/* Running sample while decoding a sector. */
+typedef struct {
+    uint32_t time_s;
+    int32_t t_centi;
+    int32_t rh_centi;
+} dht20_flashlog_point_t;
+
+/* Head position as seen by a reader, consistent with the pending page copy. */
+typedef struct {
+    uint32_t head_sector;
+    uint32_t head_seq;
+    uint32_t flushed_off;
+    uint32_t write_off;
+    uint8_t pending[DHT20_FLASHLOG_PAGE_SIZE];
+} dht20_flashlog_snapshot_t;
+
+static void state_write_begin(dht20_flashlog_t *log)
+{
+    __atomic_store_n(&log->state_seq, log->state_seq + 1U, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void state_write_end(dht20_flashlog_t *log)
+{
+    __atomic_store_n(&log->state_seq, log->state_seq + 1U, __ATOMIC_RELEASE);
+}
+
+static const dht20_flashlog_header_t *sector_header(const dht20_flashlog_t *log, uint32_t sector)
+{
+    return (const dht20_flashlog_header_t *)(log->map + ((size_t)sector * log->sector_size));
+}
+
+static bool header_valid(const dht20_flashlog_header_t *hdr)
+{
+    return hdr->magic == DHT20_FLASHLOG_MAGIC && hdr->seq != DHT20_FLASHLOG_ERASED;
+}
+
+/* Word at off; snap (NULL = everything is flushed) supplies the unflushed tail of the head sector. */
+static bool word_at(const dht20_flashlog_t *log,
+                    const dht20_flashlog_snapshot_t *snap,
+                    uint32_t sector,
+                    uint32_t off,
+                    uint32_t *word)
+{
+    if ((off + sizeof(*word)) > log->sector_size) {
+        return false;
+    }
+    if (snap != NULL && sector == snap->head_sector) {
+        if (off >= snap->write_off) {
+            return false;
+        }
+        if (off >= snap->flushed_off) {
+            memcpy(word, &snap->pending[off - snap->flushed_off], sizeof(*word));
+            return true;
+        }
+    }
+    memcpy(word, log->map + ((size_t)sector * log->sector_size) + off, sizeof(*word));
+    return true;
+}
+
+/*
+ * Apply the entry at off to *pt. Returns its size in bytes, 0 at the end of
+ * the sector's data; *is_sample is false for padding.
+ */
+static uint32_t entry_decode(const dht20_flashlog_t *log,
+                             const dht20_flashlog_snapshot_t *snap,
+                             uint32_t sector,
+                             uint32_t off,
+                             dht20_flashlog_point_t *pt,
+                             bool *is_sample)
+{
+    uint32_t rec = 0;
+    if (!word_at(log, snap, sector, off, &rec) || rec == DHT20_FLASHLOG_ERASED) {
+        return 0;
+    }
+    *is_sample = true;
+    if (rec == DHT20_FLASHLOG_REC_NOP) {
+        *is_sample = false;
+        return DHT20_FLASHLOG_RECORD_SIZE;
+    }
+    if (rec == DHT20_FLASHLOG_REC_ABS) {
+        uint32_t time_s = 0;
+        uint32_t values = 0;
+        if (!word_at(log, snap, sector, off + 4U, &time_s) || !word_at(log, snap, sector, off + 8U, &values)) {
+            return 0;
+        }
+        pt->time_s = time_s;
+        pt->t_centi = (int16_t)(values & 0xFFFFU);
+        pt->rh_centi = (int16_t)(values >> 16);
+        return DHT20_FLASHLOG_ABS_SIZE;
+    }
+    if ((rec & 0xFFU) > DHT20_FLASHLOG_DT_MAX) {
+        return 0; /* unknown control word */
+    }
+
+    uint32_t dt = 0;
+    int32_t d_t = 0;
+    int32_t d_rh = 0;
+    record_unpack(rec, &dt, &d_t, &d_rh);
+    pt->time_s += dt;
+    pt->t_centi += d_t;
+    pt->rh_centi += d_rh;
+    return DHT20_FLASHLOG_RECORD_SIZE;
+}
+
+/* Start a fresh sector whose header carries this sample as the delta base. */
+static esp_err_t open_sector(dht20_flashlog_t *log, uint32_t time_s, int32_t t_centi, int32_t rh_centi)
+{
+    const uint32_t sector = log->sector_open ? ((log->head_sector + 1U) % log->sector_count) : log->head_sector;
+    const size_t base = (size_t)sector * log->sector_size;
+
+    ESP_RETURN_ON_ERROR(esp_partition_erase_range(log->part, base, log->sector_size), TAG, "sector erase failed");
+    const dht20_flashlog_header_t hdr = {
+        .magic = DHT20_FLASHLOG_MAGIC,
+        .seq = log->head_seq + 1U,
+        .base_time_s = time_s,
+        .base_t_centi = (int16_t)t_centi,
+        .base_rh_centi = (int16_t)rh_centi,
+    };
+    ESP_RETURN_ON_ERROR(esp_partition_write(log->part, base, &hdr, sizeof(hdr)), TAG, "header write failed");
+
+    state_write_begin(log);
+    log->head_sector = sector;
+    log->head_seq = hdr.seq;
+    log->write_off = sizeof(hdr);
+    log->flushed_off = sizeof(hdr);
+    log->page_off = 0;
+    memset(log->page_buf, 0xFF, sizeof(log->page_buf));
+    log->sector_open = true;
+    log->last_time_s = time_s;
+    log->last_t_centi = t_centi;
+    log->last_rh_centi = rh_centi;
+    state_write_end(log);
+    return ESP_OK;
+}
+
+esp_err_t dht20_flashlog_flush(dht20_flashlog_t *log)
+{
+    ESP_RETURN_ON_FALSE(log != NULL && log->initialized, ESP_ERR_INVALID_STATE, TAG, "log not initialized");
+    if (log->write_off == log->flushed_off) {
+        return ESP_OK;
+    }
+
+    const size_t base = (size_t)log->head_sector * log->sector_size;
+    const uint32_t len = log->write_off - log->flushed_off;
+    ESP_RETURN_ON_ERROR(esp_partition_write(log->part, base + log->flushed_off,
+                                            &log->page_buf[log->flushed_off - log->page_off], len),
+                        TAG, "page write failed");
+    state_write_begin(log);
+    log->flushed_off = log->write_off;
+    if ((log->write_off - log->page_off) >= DHT20_FLASHLOG_PAGE_SIZE) {
+        log->page_off = log->write_off;
+        memset(log->page_buf, 0xFF, sizeof(log->page_buf));
+    }
+    state_write_end(log);
+    return ESP_OK;
+}
+
+esp_err_t dht20_flashlog_append(dht20_flashlog_t *log, uint32_t time_s, float temperature_c, float humidity_rh)
+{
+    ESP_RETURN_ON_FALSE(log != NULL && log->initialized, ESP_ERR_INVALID_STATE, TAG, "log not initialized");
+
+    const int32_t t_centi = (int32_t)lroundf(temperature_c * 100.0f);
+    const int32_t rh_centi = (int32_t)lroundf(humidity_rh * 100.0f);
+    if (!log->sector_open) {
+        return open_sector(log, time_s, t_centi, rh_centi);
+    }
+    if ((log->write_off - log->page_off) >= DHT20_FLASHLOG_PAGE_SIZE) {
+        /* A full page whose program failed before; it has to go out first. */
+        ESP_RETURN_ON_ERROR(dht20_flashlog_flush(log), TAG, "pending page flush failed");
+    }
+
+    /*
+     * A gap, a clock step or a jump the delta fields cannot hold gets an
+     * absolute record instead; only a full sector starts the next one.
+     */
+    const int32_t d_t = t_centi - log->last_t_centi;
+    const int32_t d_rh = rh_centi - log->last_rh_centi;
+    const bool encodable = time_s >= log->last_time_s && (time_s - log->last_time_s) <= DHT20_FLASHLOG_DT_MAX
+                           && d_t >= DHT20_FLASHLOG_DELTA_MIN && d_t <= DHT20_FLASHLOG_DELTA_MAX
+                           && d_rh >= DHT20_FLASHLOG_DELTA_MIN && d_rh <= DHT20_FLASHLOG_DELTA_MAX;
+    uint32_t words[DHT20_FLASHLOG_ABS_SIZE / DHT20_FLASHLOG_RECORD_SIZE];
+    uint32_t len = DHT20_FLASHLOG_RECORD_SIZE;
+    if (encodable) {
+        words[0] = record_pack(time_s - log->last_time_s, d_t, d_rh);
+    } else {
+        words[0] = DHT20_FLASHLOG_REC_ABS;
+        words[1] = time_s;
+        words[2] = abs_pack(t_centi, rh_centi);
+        len = DHT20_FLASHLOG_ABS_SIZE;
+    }
+
+    /* Entries never straddle a page, so every flush programs whole entries. */
+    const uint32_t in_page = log->write_off - log->page_off;
+    const uint32_t pad = ((in_page + len) > DHT20_FLASHLOG_PAGE_SIZE) ? (DHT20_FLASHLOG_PAGE_SIZE - in_page) : 0U;
+    if ((log->write_off + pad + len) > log->sector_size) {
+        ESP_RETURN_ON_ERROR(dht20_flashlog_flush(log), TAG, "flush before sector switch failed");
+        return open_sector(log, time_s, t_centi, rh_centi);
+    }
+    if (pad != 0U) {
+        const uint32_t nop = DHT20_FLASHLOG_REC_NOP;
+        state_write_begin(log);
+        for (uint32_t off = 0; off < pad; off += DHT20_FLASHLOG_RECORD_SIZE) {
+            memcpy(&log->page_buf[in_page + off], &nop, sizeof(nop));
+        }
+        log->write_off += pad;
+        state_write_end(log);
+        ESP_RETURN_ON_ERROR(dht20_flashlog_flush(log), TAG, "padded page flush failed");
+    }
+
+    state_write_begin(log);
+    memcpy(&log->page_buf[log->write_off - log->page_off], words, len);
+    log->write_off += len;
+    log->last_time_s = time_s;
+    log->last_t_centi = t_centi;
+    log->last_rh_centi = rh_centi;
+    state_write_end(log);
+
+    /* Program only whole pages; a partial page waits in RAM. */
+    if ((log->write_off - log->page_off) >= DHT20_FLASHLOG_PAGE_SIZE) {
+        return dht20_flashlog_flush(log);
+    }
+    return ESP_OK;
+}
+
+esp_err_t dht20_flashlog_init(dht20_flashlog_t *log, const char *partition_label)
+{
+    ESP_RETURN_ON_FALSE(log != NULL, ESP_ERR_INVALID_ARG, TAG, "log is null");
+
+    memset(log, 0, sizeof(*log));
+    const char *label = (partition_label != NULL) ? partition_label : DHT20_FLASHLOG_PARTITION_LABEL;
+    log->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    ESP_RETURN_ON_FALSE(log->part != NULL, ESP_ERR_NOT_FOUND, TAG, "partition '%s' not found", label);
+
+    log->sector_size = log->part->erase_size;
+    log->sector_count = log->part->size / log->sector_size;
+    ESP_RETURN_ON_FALSE(log->sector_count >= 2U && (log->sector_size % DHT20_FLASHLOG_PAGE_SIZE) == 0U,
+                        ESP_ERR_INVALID_SIZE, TAG, "partition too small");
+
+    const void *map = NULL;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(log->part, 0, log->part->size, ESP_PARTITION_MMAP_DATA, &map, &log->map_handle),
+                        TAG, "partition mmap failed");
+    log->map = (const uint8_t *)map;
+
+    /* Head = valid sector with the highest sequence (wrap-safe). */
+    bool found = false;
+    for (uint32_t s = 0; s < log->sector_count; s++) {
+        const dht20_flashlog_header_t *hdr = sector_header(log, s);
+        if (header_valid(hdr) && (!found || (int32_t)(hdr->seq - log->head_seq) > 0)) {
+            log->head_sector = s;
+            log->head_seq = hdr->seq;
+            found = true;
+        }
+    }
+    log->initialized = true;
+    if (!found) {
+        ESP_LOGI(TAG, "empty log on '%s' (%" PRIu32 " sectors)", label, log->sector_count);
+        return ESP_OK;
+    }
+
+    /* Replay the head sector to rebuild the delta base and the append offset. */
+    const dht20_flashlog_header_t *hdr = sector_header(log, log->head_sector);
+    dht20_flashlog_point_t pt = {
+        .time_s = hdr->base_time_s,
+        .t_centi = hdr->base_t_centi,
+        .rh_centi = hdr->base_rh_centi,
+    };
+    uint32_t off = sizeof(*hdr);
+    for (;;) {
+        bool is_sample = false;
+        const uint32_t len = entry_decode(log, NULL, log->head_sector, off, &pt, &is_sample);
+        if (len == 0U) {
+            break;
+        }
+        off += len;
+    }
+    log->last_time_s = pt.time_s;
+    log->last_t_centi = pt.t_centi;
+    log->last_rh_centi = pt.rh_centi;
+    log->write_off = off;
+    log->flushed_off = off;
+    log->page_off = off - (off % DHT20_FLASHLOG_PAGE_SIZE);
+    memset(log->page_buf, 0xFF, sizeof(log->page_buf));
+    log->sector_open = true;
+
+    ESP_LOGI(TAG, "resumed log at sector %" PRIu32 " seq %" PRIu32 " offset %" PRIu32,
+             log->head_sector, log->head_seq, log->write_off);
+    return ESP_OK;
+}
+
+void dht20_flashlog_deinit(dht20_flashlog_t *log)
+{
+    if (log == NULL || !log->initialized) {
+        return;
+    }
+    (void)dht20_flashlog_flush(log);
+    esp_partition_munmap(log->map_handle);
+    log->initialized = false;
+    log->map = NULL;
+}
+
+static bool take_snapshot(const dht20_flashlog_t *log, dht20_flashlog_snapshot_t *snap)
+{
+    for (int attempt = 0; attempt < DHT20_FLASHLOG_SNAPSHOT_RETRIES; attempt++) {
+        const uint32_t seq = __atomic_load_n(&log->state_seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1U) != 0U) {
+            continue;
+        }
+        snap->head_sector = log->head_sector;
+        snap->head_seq = log->head_seq;
+        snap->flushed_off = log->flushed_off;
+        snap->write_off = log->write_off;
+        const uint32_t pending = snap->write_off - snap->flushed_off;
+        if (pending <= sizeof(snap->pending)) {
+            memcpy(snap->pending, &log->page_buf[snap->flushed_off - log->page_off], pending);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&log->state_seq, __ATOMIC_ACQUIRE) == seq && pending <= sizeof(snap->pending)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t dht20_flashlog_query(const dht20_flashlog_t *log,
+                               uint32_t from_s,
+                               uint32_t to_s,
+                               dht20_flashlog_visit_fn_t visit,
+                               void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(log != NULL && log->initialized, ESP_ERR_INVALID_STATE, TAG, "log not initialized");
+    ESP_RETURN_ON_FALSE(visit != NULL, ESP_ERR_INVALID_ARG, TAG, "visit is null");
+    if (!__atomic_load_n(&log->sector_open, __ATOMIC_ACQUIRE)) {
+        return ESP_OK;
+    }
+
+    dht20_flashlog_snapshot_t snap;
+    ESP_RETURN_ON_FALSE(take_snapshot(log, &snap), ESP_ERR_TIMEOUT, TAG, "log busy");
+
+    /*
+     * Oldest sector is the one after head; walk forward and stop at head.
+     * A clock step back can sit anywhere in a sector, so every entry is
+     * checked against the range instead of stopping at the first late one.
+     */
+    for (uint32_t i = 1; i <= log->sector_count; i++) {
+        const uint32_t sector = (snap.head_sector + i) % log->sector_count;
+        const dht20_flashlog_header_t *hdr = sector_header(log, sector);
+        /* Skip sectors recycled by the writer after the snapshot. */
+        if (!header_valid(hdr) || (int32_t)(hdr->seq - snap.head_seq) > 0) {
+            continue;
+        }
+
+        dht20_flashlog_point_t pt = {
+            .time_s = hdr->base_time_s,
+            .t_centi = hdr->base_t_centi,
+            .rh_centi = hdr->base_rh_centi,
+        };
+        bool is_sample = true;
+        uint32_t off = sizeof(*hdr);
+        for (;;) {
+            if (is_sample && pt.time_s >= from_s && pt.time_s <= to_s
+                && !visit(pt.time_s, (float)pt.t_centi / 100.0f, (float)pt.rh_centi / 100.0f, user_ctx)) {
+                return ESP_OK;
+            }
+            const uint32_t len = entry_decode(log, &snap, sector, off, &pt, &is_sample);
+            if (len == 0U) {
+                break;
+            }
+            off += len;
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,229 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "dht20_history.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define DHT20_HISTORY_MASK (DHT20_HISTORY_CAPACITY - 1U)
+#define DHT20_HISTORY_READ_RETRIES 8
+
+_Static_assert((DHT20_HISTORY_CAPACITY & DHT20_HISTORY_MASK) == 0U, "capacity must be a power of two");
+
+static const char *TAG = "dht20_history";
+
+static uint32_t load_acquire(const uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store_release(uint32_t *p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int32_t to_centi(float v)
+{
+    return (int32_t)lroundf(v * 100.0f);
+}
+
+static void acc_add(dht20_bucket_acc_t *acc, int32_t v)
+{
+    if (acc->count == 0U || v < acc->min) {
+        acc->min = v;
+    }
+    if (acc->count == 0U || v > acc->max) {
+        acc->max = v;
+    }
+    acc->count++;
+    acc->sum += v;
+    acc->sum_sq += (int64_t)v * (int64_t)v;
+}
+
+static void acc_merge(dht20_bucket_acc_t *dst, const dht20_bucket_acc_t *src)
+{
+    if (src->count == 0U) {
+        return;
+    }
+    if (dst->count == 0U || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (dst->count == 0U || src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    dst->sum_sq += src->sum_sq;
+}
+
+static void acc_to_stats(const dht20_bucket_acc_t *acc, dht20_channel_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (acc->count == 0U) {
+        return;
+    }
+    const int64_t n = (int64_t)acc->count;
+    const int64_t var_n2 = (n * acc->sum_sq) - (acc->sum * acc->sum);
+    out->count = acc->count;
+    out->min = (float)acc->min / 100.0f;
+    out->max = (float)acc->max / 100.0f;
+    out->mean = ((float)acc->sum / (float)n) / 100.0f;
+    out->stddev = (var_n2 > 0) ? (sqrtf((float)var_n2) / (float)n) / 100.0f : 0.0f;
+}
+
+esp_err_t dht20_history_init(dht20_history_t *hist, const uint32_t *windows_ms)
+{
+    static const uint32_t k_default_windows[DHT20_HISTORY_WINDOWS] = DHT20_HISTORY_DEFAULT_WINDOWS_MS;
+
+    ESP_RETURN_ON_FALSE(hist != NULL, ESP_ERR_INVALID_ARG, TAG, "hist is null");
+    const uint32_t *spans = (windows_ms != NULL) ? windows_ms : k_default_windows;
+    for (size_t i = 0; i < DHT20_HISTORY_WINDOWS; i++) {
+        ESP_RETURN_ON_FALSE(spans[i] >= DHT20_HISTORY_BUCKETS, ESP_ERR_INVALID_ARG, TAG, "window too short");
+    }
+
+    memset(hist, 0, sizeof(*hist));
+    for (size_t i = 0; i < DHT20_HISTORY_WINDOWS; i++) {
+        dht20_history_window_t *win = &hist->windows[i];
+        win->span_ms = spans[i];
+        win->bucket_ms = spans[i] / DHT20_HISTORY_BUCKETS;
+        for (size_t b = 0; b < DHT20_HISTORY_BUCKETS; b++) {
+            win->bucket_id[b] = UINT32_MAX;
+        }
+    }
+    return ESP_OK;
+}
+
+/* From the 64-bit clock directly: a uint32_t millisecond clock would wrap after ~49.7 days. */
+static uint32_t bucket_id_at(const dht20_history_window_t *win, int64_t now_us)
+{
+    return (uint32_t)(now_us / ((int64_t)win->bucket_ms * 1000LL));
+}
+
+void dht20_history_push(dht20_history_t *hist, const dht20_sample_t *sample)
+{
+    if (hist == NULL || sample == NULL) {
+        return;
+    }
+
+    /* Publish the raw sample: readers validate the slot against head afterwards. */
+    const uint32_t head = hist->head;
+    hist->ring[head & DHT20_HISTORY_MASK] = *sample;
+    store_release(&hist->head, head + 1U);
+
+    const int32_t t = to_centi(sample->temperature_c);
+    const int32_t rh = to_centi(sample->humidity_rh);
+    const int64_t now_us = (int64_t)sample->timestamp_us;
+
+    store_release(&hist->stats_seq, hist->stats_seq + 1U);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < DHT20_HISTORY_WINDOWS; i++) {
+        dht20_history_window_t *win = &hist->windows[i];
+        const uint32_t id = bucket_id_at(win, now_us);
+        const size_t slot = id % DHT20_HISTORY_BUCKETS;
+        if (win->bucket_id[slot] != id) {
+            /* Bucket slot last held an older period: recycle it. */
+            win->bucket_id[slot] = id;
+            memset(&win->temperature[slot], 0, sizeof(win->temperature[slot]));
+            memset(&win->humidity[slot], 0, sizeof(win->humidity[slot]));
+        }
+        acc_add(&win->temperature[slot], t);
+        acc_add(&win->humidity[slot], rh);
+    }
+    store_release(&hist->stats_seq, hist->stats_seq + 1U);
+}
+
+void dht20_history_push_error(dht20_history_t *hist)
+{
+    if (hist != NULL) {
+        store_release(&hist->errors, hist->errors + 1U);
+    }
+}
+
+uint32_t dht20_history_get_errors(const dht20_history_t *hist)
+{
+    return (hist != NULL) ? load_acquire(&hist->errors) : 0U;
+}
+
+size_t dht20_history_read_latest(const dht20_history_t *hist, dht20_sample_t *out, size_t max_samples)
+{
+    if (hist == NULL || out == NULL || max_samples == 0U) {
+        return 0;
+    }
+
+    const uint32_t head = load_acquire(&hist->head);
+    size_t n = (head < DHT20_HISTORY_CAPACITY) ? head : DHT20_HISTORY_CAPACITY;
+    if (n > max_samples) {
+        n = max_samples;
+    }
+    const uint32_t first = head - (uint32_t)n;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = hist->ring[(first + (uint32_t)i) & DHT20_HISTORY_MASK];
+    }
+
+    /*
+     * Drop the oldest copies if the writer lapped them meanwhile. Push writes
+     * ring[head] before publishing head + 1, so at lapped == capacity slot
+     * `first` may already be half overwritten by the next sample.
+     */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    const uint32_t head_after = load_acquire(&hist->head);
+    const uint32_t lapped = head_after - first;
+    if (lapped >= DHT20_HISTORY_CAPACITY) {
+        const size_t lost = lapped - DHT20_HISTORY_CAPACITY + 1U;
+        if (lost >= n) {
+            return 0;
+        }
+        memmove(out, out + lost, (n - lost) * sizeof(*out));
+        n -= lost;
+    }
+    return n;
+}
+
+esp_err_t dht20_history_get_stats(const dht20_history_t *hist, size_t index, dht20_window_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(hist != NULL && out != NULL, ESP_ERR_INVALID_ARG, TAG, "invalid args");
+    ESP_RETURN_ON_FALSE(index < DHT20_HISTORY_WINDOWS, ESP_ERR_INVALID_ARG, TAG, "window index out of range");
+
+    const dht20_history_window_t *win = &hist->windows[index];
+    const uint32_t now_id = bucket_id_at(win, esp_timer_get_time());
+
+    for (int attempt = 0; attempt < DHT20_HISTORY_READ_RETRIES; attempt++) {
+        if (attempt > 0) {
+            /*
+             * Single core: a writer preempted mid-update only finishes once the
+             * reader blocks; yielding alone would not run a lower-priority writer.
+             */
+            vTaskDelay(1);
+        }
+        const uint32_t seq = load_acquire(&hist->stats_seq);
+        if ((seq & 1U) != 0U) {
+            continue;
+        }
+
+        dht20_bucket_acc_t t = {0};
+        dht20_bucket_acc_t rh = {0};
+        for (size_t b = 0; b < DHT20_HISTORY_BUCKETS; b++) {
+            const uint32_t id = win->bucket_id[b];
+            if (id != UINT32_MAX && (now_id - id) < DHT20_HISTORY_BUCKETS) {
+                acc_merge(&t, &win->temperature[b]);
+                acc_merge(&rh, &win->humidity[b]);
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (load_acquire(&hist->stats_seq) == seq) {
+            out->span_ms = win->span_ms;
+            acc_to_stats(&t, &out->temperature_c);
+            acc_to_stats(&rh, &out->humidity_rh);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "driver/gpio.h"
@@ -39,8 +41,75 @@ typedef struct {
     int x_offset;
     int y_offset;
     int spi_clock_hz;
+    bool spi_clock_from_nvs; /* prefer a clock stored by display_calibrate_spi_clock() */
+    bool backlight_in_light_sleep; /* clock the backlight PWM from RC_FAST so it survives auto light sleep */
 } display_cfg_t;
 
+/* SPI2 runs from an 80 MHz source; usable pixel clocks are 80 MHz / n. */
+#define DISPLAY_SPI_CLOCK_SRC_HZ (80 * 1000 * 1000)
+#define DISPLAY_SPI_CLOCK_MIN_HZ (1 * 1000 * 1000)
+
+/**
+ * @brief Verdict for one calibration step.
+ *
+ * Called after the verification pattern was drawn at spi_clock_hz; return
+ * true if it arrived intact. MISO is not wired, so the panel cannot be read
+ * back and the judgement has to come from outside (operator, camera, ...).
+ */
+typedef bool (*display_clock_check_fn_t)(int spi_clock_hz, void *user_ctx);
+
+typedef struct {
+    int min_hz;           /* first step; 0 = display_cfg_t.spi_clock_hz */
+    int max_hz;           /* 0 = DISPLAY_SPI_CLOCK_SRC_HZ */
+    uint8_t margin_steps; /* settle this many steps below the highest passing clock */
+    display_clock_check_fn_t check;
+    void *user_ctx;
+    bool persist; /* store the result in NVS for display_cfg_t.spi_clock_from_nvs */
+} display_clock_cal_cfg_t;
+
+/** @brief Rectangle in active display coordinates. */
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} display_rect_t;
+
+#define DISPLAY_FB_MAX_DIRTY 8U
+
+/**
+ * @brief Panel bus traffic since boot, counted when a transfer is queued.
+ *
+ * Counts only depend on what was drawn, not on timing, so per-operation
+ * deltas are exact and comparable across builds. Wraps at 2^32.
+ */
+typedef struct {
+    uint32_t color_trans; /* RAMWR/RAMWRC transfers */
+    uint32_t color_bytes; /* pixel bytes in them */
+    uint32_t windows;     /* CASET/RASET address windows */
+} display_io_stats_t;
+
+/**
+ * @brief Retained RAM copy of one screen region (partial framebuffer).
+ *
+ * Between display_fb_begin() and display_flush() all draws are clipped to
+ * `area` and composed in RAM; only pixels that actually changed are sent.
+ */
+typedef struct {
+    display_rect_t area;
+    uint16_t *pixels;
+    bool synced; /* pixels mirror panel content */
+    uint8_t dirty_count;
+    display_rect_t dirty[DISPLAY_FB_MAX_DIRTY];
+} display_fb_t;
+
+/**
+ * @brief Band producer for display_draw_bands().
+ * @param band_rgb565 Buffer to fill with rows * width pixels.
+ * @param row First row of the band, relative to the target rect.
+ */
+typedef esp_err_t (*display_band_fn_t)(uint16_t *band_rgb565, int row, int rows, int width, void *user_ctx);
+
 #define DISPLAY_ROTATION_0 0U
 #define DISPLAY_ROTATION_90 1U
 #define DISPLAY_ROTATION_180 2U
@@ -48,6 +117,28 @@ typedef struct {
 
 /** @brief Initialize panel, SPI I/O and backlight control. */
 display_status_t display_init(const display_pins_t *pins, const display_cfg_t *cfg);
+/**
+ * @brief Re-create the panel IO at a new pixel clock and re-run the panel init sequence.
+ *
+ * Panel RAM content is lost and the handle from display_get_panel_handle()
+ * changes, so call this before anything caches it.
+ */
+display_status_t display_set_spi_clock(int spi_clock_hz);
+/** @brief Pixel clock currently configured (0 before display_init()). */
+int display_get_spi_clock(void);
+/** @brief Snapshot of the bus traffic counters; diff two snapshots to cost one operation. */
+void display_get_io_stats(display_io_stats_t *out);
+/**
+ * @brief Step the pixel clock up through 80 MHz / n, drawing a verification pattern at each step.
+ *
+ * Stops at the first step cfg->check rejects and applies the highest passing
+ * clock (minus margin_steps). ESP_ERR_NOT_FOUND if even the first step fails;
+ * the previous clock is restored then. Requires an initialized NVS partition
+ * when cfg->persist is set.
+ */
+display_status_t display_calibrate_spi_clock(const display_clock_cal_cfg_t *cfg, int *out_hz);
+/** @brief Drop the stored calibration result. */
+display_status_t display_forget_spi_clock(void);
 /** @brief Apply rotation (0/90/180/270). */
 void display_set_rotation(uint8_t rotation);
 /** @brief Get active display width after rotation. */
@@ -69,6 +160,73 @@ void display_draw_text_minimal(int x, int y, const char *s, uint16_t rgb565);
  * @param scale Pixel scale for each glyph dot (1 = original 5x7 font).
  */
 void display_draw_text_minimal_scaled(int x, int y, const char *s, uint16_t rgb565, uint8_t scale);
+/**
+ * @brief Draw opaque text as one address window streamed in DMA strips.
+ *
+ * Lit glyph dots use fg, the rest of each character cell uses bg, so no
+ * background rect is needed before drawing.
+ * @param scale Pixel scale for each glyph dot (1 = original 5x7 font).
+ * @param char_spacing_px Extra background pixels between characters.
+ */
+void display_draw_text_run(int x,
+                           int y,
+                           const char *s,
+                           uint16_t fg_rgb565,
+                           uint16_t bg_rgb565,
+                           uint8_t scale,
+                           uint8_t char_spacing_px);
+/**
+ * @brief Cap the RAM used by pre-expanded display_draw_text_run glyph cells.
+ *
+ * Cells are keyed by (char, scale, fg, bg) and evicted LRU; 0 disables the cache.
+ * Cells come from a static arena of DISPLAY_GLYPH_CACHE_BYTES, so larger limits are clamped.
+ */
+void display_glyph_cache_set_limit(size_t max_bytes);
+/** @brief Width in pixels covered by display_draw_text_run for the same arguments. */
+int display_get_text_width(const char *s, uint8_t scale, uint8_t char_spacing_px);
+/** @brief Height in pixels of one display_draw_text_run line at scale. */
+int display_get_text_height(uint8_t scale);
+/**
+ * @brief Blit a w*h RGB565 bitmap fully inside the active area.
+ *
+ * Outside framebuffer mode the buffer is sent zero-copy and must stay valid
+ * until the next display call.
+ */
+display_status_t display_draw_bitmap(int x, int y, int w, int h, const uint16_t *rgb565);
+/**
+ * @brief Blit a full-screen w*h bitmap rotated quarter_turns x 90 degrees clockwise.
+ *
+ * MADCTL is switched to the combined rotation for the transfer and restored
+ * afterwards, so the panel does the rotation and nothing is copied; the call
+ * returns once the pixels are sent. w*h is the bitmap's own size, which has
+ * to cover the screen once rotated (ESP_ERR_INVALID_SIZE otherwise).
+ * ESP_ERR_INVALID_STATE while a framebuffer is active.
+ */
+display_status_t display_draw_frame_rotated(const uint16_t *rgb565, int w, int h, uint8_t quarter_turns);
+/**
+ * @brief Stream a rect produced band by band through ping-pong DMA buffers.
+ *
+ * The producer renders band N+1 while band N is on the wire; bands are
+ * capped to half of the internal DMA buffer.
+ */
+display_status_t display_draw_bands(int x, int y, int w, int h, int band_rows, display_band_fn_t producer, void *user_ctx);
+/** @brief Wait until all queued color transfers completed (e.g. before reusing a display_draw_bitmap buffer). */
+display_status_t display_wait_idle(void);
+/** @brief Allocate a retained framebuffer for a region (internal RAM). */
+display_status_t display_fb_init(display_fb_t *fb, int x, int y, int w, int h);
+/** @brief Free a framebuffer created by display_fb_init(). */
+void display_fb_deinit(display_fb_t *fb);
+/** @brief Force the next flush of fb to resend its whole area. */
+void display_fb_invalidate(display_fb_t *fb);
+/**
+ * @brief Start composing into fb; draws are clipped to its area.
+ *
+ * Holds the display lock until display_flush(). Direct draws that overlap a
+ * framebuffer area while it is not composing invalidate it.
+ */
+display_status_t display_fb_begin(display_fb_t *fb);
+/** @brief Send only the changed regions of the composing framebuffer and end composing. */
+display_status_t display_flush(void);
 /** @brief Run basic panel self-test visuals. */
 void display_self_test(void);
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -18,13 +19,103 @@ typedef struct {
     esp_lcd_panel_handle_t panel;
     uint16_t width;
     uint16_t height;
+    uint16_t *band_buf; /* other panels only; NULL = allocate per draw */
+    size_t band_buf_pixels;
 } display_image_t;
 
+/** @brief Clockwise quarter turns applied to a source image when it is drawn. */
+typedef enum {
+    DISPLAY_IMAGE_ORIENT_0 = 0,
+    DISPLAY_IMAGE_ORIENT_90 = 1,
+    DISPLAY_IMAGE_ORIENT_180 = 2,
+    DISPLAY_IMAGE_ORIENT_270 = 3,
+} display_image_orient_t;
+
+/** @brief Fills `rows` rows of `width` RGB565 pixels starting at image row `row`. */
+typedef esp_err_t (*display_image_band_fn_t)(uint16_t *band_rgb565, int row, int rows, int width, void *user_ctx);
+
 void display_image_init(display_image_t *ctx, esp_lcd_panel_handle_t panel, uint16_t w, uint16_t h);
+/**
+ * @brief Reserve a DMA-capable band buffer for streaming to a panel other than display_api's.
+ *
+ * Bands are then capped to what fits and no draw allocates. The display_api
+ * panel always uses its own ping-pong buffers and ignores this.
+ */
+void display_image_set_band_buffer(display_image_t *ctx, uint16_t *dma_buf, size_t pixels);
 esp_err_t display_image_draw_full_rgb565(display_image_t *ctx, const uint16_t *img_rgb565, size_t pixels);
 esp_err_t display_image_draw_rect_rgb565(display_image_t *ctx, int x, int y, int w, int h, const uint16_t *img_rgb565, size_t pixels);
+/**
+ * @brief Draw a src_w x src_h image turned by `orient`, with its rotated top-left corner at (x, y).
+ *
+ * A full-screen image on the display_api panel (outside framebuffer mode) is
+ * rotated by the panel through display_draw_frame_rotated(). Anything else
+ * (overlays, other panels, a framebuffer being composed) is transposed in
+ * cache-sized tiles straight into the band buffers, so no rotated copy of the
+ * image is ever held in RAM. Turns match display_set_rotation() steps.
+ */
+esp_err_t display_image_draw_rect_oriented(display_image_t *ctx,
+                                           int x,
+                                           int y,
+                                           int src_w,
+                                           int src_h,
+                                           const uint16_t *img_rgb565,
+                                           size_t pixels,
+                                           display_image_orient_t orient);
+/** @brief Draw the full image band by band; overlaps band rendering with DMA on the display_api panel. */
+esp_err_t display_image_draw_streaming(display_image_t *ctx, int block_rows, display_image_band_fn_t producer, void *user_ctx);
 esp_err_t display_image_draw_test_pattern_streaming(display_image_t *ctx, int block_rows);
 
+/*
+ * Compressed images ("DIMG"), decoded band by band straight into the DMA buffers.
+ *
+ * Layout, little-endian:
+ *   0  "DIMG"
+ *   4  u8  version (DISPLAY_IMG_VERSION)
+ *   5  u8  format (display_img_format_t)
+ *   6  u16 width, u16 height
+ *   10 u16 palette_count, then palette_count RGB565 entries
+ *   .. pixel data to the end of the blob
+ *
+ * RLE16 / PAL8_RLE packets: u8 header h; h & 0x80 repeats the next value (h & 0x7F) + 1 times,
+ * otherwise h + 1 literal values follow. Values are RGB565 (u16) or palette indexes (u8);
+ * packets may span rows. PAL4 is packed 4 bpp, high nibble first, rows padded to a byte.
+ *
+ * The blob is read in place, so it can live in memory-mapped flash (EMBED_FILES rodata or
+ * an esp_partition_mmap() region). Encoder: components/display_api/tools/display_img_encode.py.
+ */
+#define DISPLAY_IMG_VERSION 1U
+#define DISPLAY_IMG_HEADER_SIZE 12U
+#define DISPLAY_IMG_RLE_MAX_RUN 128U
+#define DISPLAY_IMG_DEFAULT_BLOCK_ROWS 16
+
+typedef enum {
+    DISPLAY_IMG_FORMAT_RLE16 = 1,    /* RLE over raw RGB565, for flat UI art */
+    DISPLAY_IMG_FORMAT_PAL8_RLE = 2, /* RLE over 8-bit palette indexes (<= 256 colors) */
+    DISPLAY_IMG_FORMAT_PAL4 = 3,     /* packed 4-bit palette indexes (<= 16 colors) */
+} display_img_format_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    display_img_format_t format;
+    uint16_t palette_count;
+    const uint8_t *palette; /* palette_count u16 LE entries, inside the blob */
+    const uint8_t *data;
+    size_t data_len;
+} display_img_info_t;
+
+/** @brief Validate a DIMG header; ESP_ERR_INVALID_VERSION for an unknown version or format. */
+esp_err_t display_img_parse(const void *blob, size_t len, display_img_info_t *out_info);
+
+/**
+ * @brief Decode a DIMG blob to (x, y) band by band; no full-frame buffer is allocated.
+ *
+ * block_rows <= 0 picks the largest band display_draw_bands() accepts (DISPLAY_IMG_DEFAULT_BLOCK_ROWS
+ * on other panels). One decode at a time: ESP_ERR_INVALID_STATE while another is running.
+ * Returns ESP_ERR_INVALID_SIZE for truncated or corrupt pixel data (rows already sent stay on screen).
+ */
+esp_err_t display_image_draw_compressed(display_image_t *ctx, int x, int y, const void *blob, size_t len, int block_rows);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "display_api.h"
+#include "esp_err.h"
+
+/**
+ * @file display_server.h
+ * @brief Optional render task that owns the panel and drains posted draw commands.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPLAY_SERVER_QUEUE_LEN 32U /* power of two */
+#define DISPLAY_SERVER_TEXT_MAX 32U  /* including terminator */
+
+/** @brief Callback run on the render task (e.g. a widget redraw). */
+typedef void (*display_server_fn_t)(void *arg);
+
+/** @brief Render task configuration. */
+typedef struct {
+    uint32_t task_stack;     /* 0 = 4096 */
+    uint8_t task_priority;   /* 0 = 4 */
+    uint16_t frame_period_ms; /* min time between batches, 0 = render as soon as posted */
+} display_server_cfg_t;
+
+/** @brief Start the render task; display_init() must have succeeded. */
+esp_err_t display_server_start(const display_server_cfg_t *cfg);
+/** @brief Return true once the render task is running. */
+bool display_server_running(void);
+/**
+ * @brief Post a filled rect; never blocks.
+ * @param fb Compose into this framebuffer (flushed at batch end), or NULL for direct.
+ * @return ESP_ERR_NO_MEM when the queue is full (command dropped).
+ */
+esp_err_t display_server_post_rect(int x, int y, int w, int h, uint16_t rgb565, display_fb_t *fb);
+/** @brief Post an opaque text run (see display_draw_text_run()); the string is copied. */
+esp_err_t display_server_post_text(int x,
+                                   int y,
+                                   const char *s,
+                                   uint16_t fg_rgb565,
+                                   uint16_t bg_rgb565,
+                                   uint8_t scale,
+                                   uint8_t char_spacing_px,
+                                   display_fb_t *fb);
+/** @brief Post a backlight change; only the last one per batch is applied. */
+esp_err_t display_server_post_backlight(uint8_t percent);
+/** @brief Run fn(arg) on the render task, in order with the other commands. */
+esp_err_t display_server_post_call(display_server_fn_t fn, void *arg);
+/** @brief Number of commands dropped because the queue was full. */
+uint32_t display_server_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
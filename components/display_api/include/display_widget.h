@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "display_api.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @file display_widget.h
+ * @brief Retained-mode widgets on top of display_api.
+ *
+ * Each widget owns a box on screen and remembers what it last drew there.
+ * Setters only record the new value and mark the widget dirty when it
+ * differs; display_screen_render() then redraws the dirty widgets in one
+ * pass, and within a widget only the part that changed: the text plus the
+ * strips left uncovered by a narrower string, the grown or shrunk end of a
+ * bar, the sparkline columns whose segment moved.
+ *
+ * Setters may run on any task; the render pass belongs to one task (the
+ * display_server render task via display_server_post_call(), or the caller
+ * when no render task runs).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPLAY_WIDGET_TEXT_MAX 32U     /* including terminator */
+#define DISPLAY_WIDGET_SPARK_MAX 160U   /* sparkline columns */
+#define DISPLAY_SCREEN_MAX_WIDGETS 8U
+
+typedef enum {
+    DISPLAY_WIDGET_LABEL = 0,
+    DISPLAY_WIDGET_NUMBER,    /* label formatted from a value */
+    DISPLAY_WIDGET_BAR,       /* horizontal, filled from the left */
+    DISPLAY_WIDGET_SPARKLINE, /* one column per sample, newest on the right */
+} display_widget_kind_t;
+
+/** @brief Requested content; written by the setters under the screen lock. */
+typedef struct {
+    char text[DISPLAY_WIDGET_TEXT_MAX];
+    uint16_t fill_px;
+    uint16_t spark_len;
+    uint8_t spark_y[DISPLAY_WIDGET_SPARK_MAX]; /* row inside the box, 0 = top */
+} display_widget_state_t;
+
+struct display_screen;
+
+/** @brief One widget; set up with a display_widget_*_init() call, then treat as opaque. */
+typedef struct {
+    display_widget_kind_t kind;
+    display_rect_t box;
+    uint16_t fg;
+    uint16_t bg;
+    uint8_t scale;    /* LABEL / NUMBER */
+    bool centered;    /* LABEL / NUMBER */
+    const char *fmt;  /* NUMBER: printf format taking one double */
+    float min;        /* BAR range; SPARKLINE: unused */
+    float max;        /* BAR range; SPARKLINE: smallest vertical span */
+    struct display_screen *screen;
+    bool dirty;
+    display_widget_state_t want;
+    /* What is on the panel; touched by the render pass only. */
+    bool drawn;
+    int16_t drawn_x0;
+    int16_t drawn_x1;
+    uint16_t drawn_fill_px;
+    uint8_t drawn_top[DISPLAY_WIDGET_SPARK_MAX]; /* 0xFF = empty column */
+    uint8_t drawn_bot[DISPLAY_WIDGET_SPARK_MAX];
+} display_widget_t;
+
+/** @brief A set of widgets rendered together. */
+typedef struct display_screen {
+    display_widget_t *widgets[DISPLAY_SCREEN_MAX_WIDGETS];
+    uint8_t count;
+    display_fb_t *fb;
+    bool invalidate;
+    portMUX_TYPE lock;
+} display_screen_t;
+
+/**
+ * @brief Reset a screen.
+ * @param fb Optional framebuffer covering every widget box: a pass then composes in RAM and
+ *           goes out in one display_flush(). NULL draws each change directly.
+ */
+void display_screen_init(display_screen_t *screen, display_fb_t *fb);
+/** @brief Attach an initialized widget; ESP_ERR_NO_MEM past DISPLAY_SCREEN_MAX_WIDGETS. */
+esp_err_t display_screen_add(display_screen_t *screen, display_widget_t *widget);
+/** @brief Forget what is on the panel (something else drew over it); the next pass redraws everything. */
+void display_screen_invalidate(display_screen_t *screen);
+/**
+ * @brief Redraw the widgets that changed since the last pass.
+ * @param[out] redrawn Optional count of widgets drawn.
+ */
+esp_err_t display_screen_render(display_screen_t *screen, size_t *redrawn);
+
+/** @brief Text label; the box must fit the longest string it will show. */
+void display_widget_label_init(display_widget_t *widget,
+                               const display_rect_t *box,
+                               uint16_t fg_rgb565,
+                               uint16_t bg_rgb565,
+                               uint8_t scale,
+                               bool centered);
+/** @brief Label showing snprintf(fmt, value); fmt must stay valid. */
+void display_widget_number_init(display_widget_t *widget,
+                                const display_rect_t *box,
+                                uint16_t fg_rgb565,
+                                uint16_t bg_rgb565,
+                                uint8_t scale,
+                                bool centered,
+                                const char *fmt);
+/** @brief Bar filled in proportion to a value in [min, max]. */
+void display_widget_bar_init(display_widget_t *widget,
+                             const display_rect_t *box,
+                             uint16_t fg_rgb565,
+                             uint16_t bg_rgb565,
+                             float min,
+                             float max);
+/**
+ * @brief Sparkline auto-scaled to its series.
+ * @param min_span Smallest value range mapped to the box height, so sensor noise stays flat.
+ */
+void display_widget_sparkline_init(display_widget_t *widget,
+                                   const display_rect_t *box,
+                                   uint16_t fg_rgb565,
+                                   uint16_t bg_rgb565,
+                                   float min_span);
+
+void display_widget_set_text(display_widget_t *widget, const char *text);
+/** @brief NUMBER: format and show value; BAR: set the fill. */
+void display_widget_set_value(display_widget_t *widget, float value);
+/** @brief SPARKLINE: show the last (box width) of count values, oldest first. */
+void display_widget_set_series(display_widget_t *widget, const float *values, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
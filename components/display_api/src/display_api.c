@@ -4,13 +4,20 @@
 
 #include "display_api.h"
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "driver/ledc.h"
 #include "driver/spi_master.h"
+#include "esp_attr.h"
 #include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_vendor.h"
@@ -18,6 +25,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "nvs.h"
+#include "perf_api.h"
 
 #define DISPLAY_SPI_HOST SPI2_HOST
 #define DISPLAY_SPI_MODE 0
@@ -29,10 +38,34 @@
 #define DISPLAY_BL_LEDC_TIMER LEDC_TIMER_0
 #define DISPLAY_BL_LEDC_CHANNEL LEDC_CHANNEL_0
 #define DISPLAY_BL_LEDC_DUTY_RES LEDC_TIMER_13_BIT
+/* RC_FAST (~17.5 MHz) keeps PWM alive in light sleep but cannot clock 13 bits at 5 kHz. */
+#define DISPLAY_BL_LEDC_SLEEP_DUTY_RES LEDC_TIMER_10_BIT
 #define DISPLAY_BL_LEDC_FREQ_HZ 5000
-#define DISPLAY_BL_MAX_DUTY ((1U << DISPLAY_BL_LEDC_DUTY_RES) - 1U)
-#define DISPLAY_LINE_BUF_PIXELS_MAX 320U
+#define DISPLAY_MAX_DIMENSION_PX 320U
+/* Rows of panel width per SPI transfer; also sizes the DMA fill buffer. */
+#define DISPLAY_TRANSFER_ROWS 40U
+#define DISPLAY_GLYPH_W 5
+#define DISPLAY_GLYPH_H 7
+#define DISPLAY_GLYPH_ADVANCE 6
+#define DISPLAY_FB_MAX_REGISTERED 4U
+/* Extra pixels a merged dirty window may cover before two windows are cheaper. */
+#define DISPLAY_FB_MERGE_SLACK_PX 256
 #define DISPLAY_LOCK_TIMEOUT_MS 1000U
+#define DISPLAY_NVS_NAMESPACE "display"
+#define DISPLAY_NVS_SPI_CLOCK "spi_hz"
+#define DISPLAY_CAL_MAX_STEPS 16U
+/*
+ * Pre-expanded glyph cells live in a static arena of scale-1 cell units; a
+ * scale-s cell takes s adjacent units. Override the arena size at build time;
+ * display_glyph_cache_set_limit() can only lower it.
+ */
+#ifndef DISPLAY_GLYPH_CACHE_BYTES
+#define DISPLAY_GLYPH_CACHE_BYTES 6144U
+#endif
+#define DISPLAY_GLYPH_CACHE_SLOTS 32U
+#define DISPLAY_GLYPH_UNIT_PIXELS ((size_t)DISPLAY_GLYPH_H * (size_t)DISPLAY_GLYPH_ADVANCE)
+#define DISPLAY_GLYPH_UNITS (DISPLAY_GLYPH_CACHE_BYTES / (DISPLAY_GLYPH_UNIT_PIXELS * sizeof(uint16_t)))
+#define DISPLAY_TEXT_MAX_CELLS ((DISPLAY_MAX_DIMENSION_PX / DISPLAY_GLYPH_ADVANCE) + 1U)
 
 #define DISPLAY_COLOR_BLACK 0x0000
 #define DISPLAY_COLOR_WHITE 0xFFFF
@@ -42,8 +75,14 @@
 #define DISPLAY_COLOR_YELLOW 0xFFE0
 
 static const char *TAG = "display_api";
-static uint16_t s_line_buf[DISPLAY_LINE_BUF_PIXELS_MAX];
 static SemaphoreHandle_t s_display_lock = NULL;
+static uint16_t s_row_buf[DISPLAY_MAX_DIMENSION_PX];
+/* Color transfers submitted / completed (on_color_trans_done); wrap-safe compare. */
+static SemaphoreHandle_t s_trans_done_sem = NULL;
+static uint32_t s_trans_submitted = 0;
+static volatile uint32_t s_trans_done = 0;
+/* Bus traffic since boot; written with the display lock held, see display_get_io_stats(). */
+static display_io_stats_t s_io_stats;
 
 #define DISPLAY_LOGI(format, ...) ESP_LOGI(TAG, format, ##__VA_ARGS__)
 #define DISPLAY_LOGW(format, ...) ESP_LOGW(TAG, format, ##__VA_ARGS__)
@@ -59,17 +98,51 @@ typedef struct {
     int active_y_offset;
     esp_lcd_panel_io_handle_t io;
     esp_lcd_panel_handle_t panel;
-    uint16_t *line_buf;
+    int spi_clock_hz;
+    uint32_t bl_max_duty;
+    uint16_t *fill_buf;
+    size_t fill_buf_pixels;
+    display_fb_t *fb;
+    display_fb_t *fb_registry[DISPLAY_FB_MAX_REGISTERED];
 } display_ctx_t;
 
 static display_ctx_t g_disp = {0};
 
+/* One character cell (glyph + 1 gap column) expanded to RGB565, one pixel row per glyph row. */
+typedef struct {
+    uint16_t *pixels;
+    uint32_t last_use;
+    uint16_t fg;
+    uint16_t bg;
+    uint16_t unit; /* first arena unit */
+    uint8_t scale;
+    char c;
+} glyph_cache_entry_t;
+
+static glyph_cache_entry_t s_glyph_cache[DISPLAY_GLYPH_CACHE_SLOTS];
+static uint16_t s_glyph_arena[DISPLAY_GLYPH_UNITS * DISPLAY_GLYPH_UNIT_PIXELS];
+static bool s_glyph_unit_used[DISPLAY_GLYPH_UNITS];
+static size_t s_glyph_cache_bytes = 0;
+static size_t s_glyph_cache_limit = DISPLAY_GLYPH_UNITS * DISPLAY_GLYPH_UNIT_PIXELS * sizeof(uint16_t);
+static uint32_t s_glyph_cache_clock = 0;
+static const uint16_t *s_text_cells[DISPLAY_TEXT_MAX_CELLS];
+
+static perf_metric_t s_perf_lock_wait = PERF_HISTOGRAM_INIT("display_lock_wait_us", "Time spent waiting for the display lock", NULL);
+static perf_metric_t s_perf_rect_fb = PERF_HISTOGRAM_INIT("display_rect_us", "draw_rect duration", "path=\"fb\"");
+static perf_metric_t s_perf_rect_spi = PERF_HISTOGRAM_INIT("display_rect_us", "draw_rect duration", "path=\"spi\"");
+static perf_metric_t s_perf_color_trans = PERF_COUNTER_INIT("display_color_trans_total", "Color transfers queued (RAMWR/RAMWRC)", NULL);
+static perf_metric_t s_perf_color_bytes = PERF_COUNTER_INIT("display_color_bytes_total", "Pixel bytes in queued color transfers", NULL);
+static perf_metric_t s_perf_windows = PERF_COUNTER_INIT("display_window_cmds_total", "Address windows programmed (CASET/RASET)", NULL);
+
 static bool display_lock(void)
 {
     if (s_display_lock == NULL) {
         return true;
     }
-    return xSemaphoreTakeRecursive(s_display_lock, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) == pdTRUE;
+    const int64_t start_us = esp_timer_get_time();
+    const bool locked = xSemaphoreTakeRecursive(s_display_lock, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) == pdTRUE;
+    perf_observe_since(&s_perf_lock_wait, start_us);
+    return locked;
 }
 
 static void display_unlock(void)
@@ -100,11 +173,319 @@ static int clampi(int value, int lo, int hi)
     return value;
 }
 
-static void fill_line_buf(uint16_t color, size_t pixels)
+static void fill_buf_set(uint16_t color, size_t pixels)
 {
     for (size_t i = 0; i < pixels; i++) {
-        g_disp.line_buf[i] = color;
+        g_disp.fill_buf[i] = color;
+    }
+}
+
+/*
+ * Program CASET/RASET once for [x0, x1) x [y0, y1) in active coordinates.
+ * tx_param waits for queued color transfers, so buffers used by the previous
+ * window are free again when this returns.
+ */
+static esp_err_t set_window_locked(int x0, int y0, int x1, int y1)
+{
+    const int xs = x0 + g_disp.active_x_offset;
+    const int xe = x1 - 1 + g_disp.active_x_offset;
+    const int ys = y0 + g_disp.active_y_offset;
+    const int ye = y1 - 1 + g_disp.active_y_offset;
+
+    const uint8_t caset[4] = {
+        (uint8_t)((xs >> 8) & 0xFF), (uint8_t)(xs & 0xFF),
+        (uint8_t)((xe >> 8) & 0xFF), (uint8_t)(xe & 0xFF),
+    };
+    const uint8_t raset[4] = {
+        (uint8_t)((ys >> 8) & 0xFF), (uint8_t)(ys & 0xFF),
+        (uint8_t)((ye >> 8) & 0xFF), (uint8_t)(ye & 0xFF),
+    };
+    esp_err_t err = esp_lcd_panel_io_tx_param(g_disp.io, LCD_CMD_CASET, caset, sizeof(caset));
+    if (err == ESP_OK) {
+        err = esp_lcd_panel_io_tx_param(g_disp.io, LCD_CMD_RASET, raset, sizeof(raset));
+    }
+    ESP_RETURN_ON_ERROR(err, TAG, "CASET/RASET failed");
+    s_io_stats.windows++;
+    perf_count(&s_perf_windows, 1U);
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR on_color_trans_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    (void)io;
+    (void)edata;
+    (void)user_ctx;
+
+    BaseType_t woken = pdFALSE;
+    s_trans_done++;
+    (void)xSemaphoreGiveFromISR(s_trans_done_sem, &woken);
+    return woken == pdTRUE;
+}
+
+/* Block until the color transfer numbered `seq` (and all before it) completed. */
+static esp_err_t wait_trans_done(uint32_t seq)
+{
+    while ((int32_t)(s_trans_done - seq) < 0) {
+        if (xSemaphoreTake(s_trans_done_sem, pdMS_TO_TICKS(DISPLAY_LOCK_TIMEOUT_MS)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Stream pixels into the current window: RAMWR for the first chunk, RAMWRC after. */
+static esp_err_t write_pixels_locked(const uint16_t *pixels, size_t count, bool first_chunk)
+{
+    const int cmd = first_chunk ? LCD_CMD_RAMWR : LCD_CMD_RAMWRC;
+    esp_err_t err = esp_lcd_panel_io_tx_color(g_disp.io, cmd, pixels, count * sizeof(uint16_t));
+    if (err == ESP_OK) {
+        s_trans_submitted++;
+        s_io_stats.color_trans++;
+        s_io_stats.color_bytes += (uint32_t)(count * sizeof(uint16_t));
+        perf_count(&s_perf_color_trans, 1U);
+        perf_count(&s_perf_color_bytes, (uint32_t)(count * sizeof(uint16_t)));
+    }
+    return err;
+}
+
+/*
+ * Ping-pong row streamer over the two halves of the fill buffer. The CPU fills
+ * one half while the other is on the wire; switching halves waits for the
+ * transfer-done callback of the half being reused.
+ */
+typedef struct {
+    uint16_t *half[2];
+    uint32_t half_seq[2];
+    size_t half_pixels;
+    size_t used;
+    uint8_t cur;
+    bool first_chunk;
+    esp_err_t err;
+} pixel_stream_t;
+
+static bool stream_begin_locked(pixel_stream_t *st, int x0, int y0, int x1, int y1)
+{
+    st->half_pixels = g_disp.fill_buf_pixels / 2U;
+    st->half[0] = g_disp.fill_buf;
+    st->half[1] = g_disp.fill_buf + st->half_pixels;
+    st->half_seq[0] = s_trans_submitted;
+    st->half_seq[1] = s_trans_submitted;
+    st->used = 0;
+    st->cur = 0;
+    st->first_chunk = true;
+    st->err = set_window_locked(x0, y0, x1, y1);
+    if (st->err == ESP_OK) {
+        st->err = wait_trans_done(s_trans_submitted);
+    }
+    return st->err == ESP_OK;
+}
+
+static void stream_flush_locked(pixel_stream_t *st)
+{
+    if (st->used == 0 || st->err != ESP_OK) {
+        return;
+    }
+    st->err = write_pixels_locked(st->half[st->cur], st->used, st->first_chunk);
+    st->half_seq[st->cur] = s_trans_submitted;
+    st->first_chunk = false;
+    st->cur ^= 1U;
+    st->used = 0;
+    if (st->err == ESP_OK) {
+        st->err = wait_trans_done(st->half_seq[st->cur]);
+    }
+}
+
+/* Append one row of `count` pixels (count <= DISPLAY_MAX_DIMENSION_PX). */
+static void stream_push_row_locked(pixel_stream_t *st, const uint16_t *row, size_t count)
+{
+    if (st->used + count > st->half_pixels) {
+        stream_flush_locked(st);
+    }
+    if (st->err != ESP_OK) {
+        return;
+    }
+    memcpy(st->half[st->cur] + st->used, row, count * sizeof(uint16_t));
+    st->used += count;
+}
+
+static bool rects_overlap(const display_rect_t *r, int x0, int y0, int x1, int y1)
+{
+    return (x0 < r->x + r->w) && (r->x < x1) && (y0 < r->y + r->h) && (r->y < y1);
+}
+
+static int rect_area(const display_rect_t *r)
+{
+    return r->w * r->h;
+}
+
+static display_rect_t rect_union(const display_rect_t *a, const display_rect_t *b)
+{
+    const int x0 = (a->x < b->x) ? a->x : b->x;
+    const int y0 = (a->y < b->y) ? a->y : b->y;
+    const int x1 = max_i32(a->x + a->w, b->x + b->w);
+    const int y1 = max_i32(a->y + a->h, b->y + b->h);
+    return (display_rect_t){.x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0};
+}
+
+/*
+ * Add a dirty rect, coalescing with an existing entry when the union costs
+ * little more than the two windows sent separately. A full list merges into
+ * the entry that grows the least.
+ */
+static void fb_add_dirty(display_fb_t *fb, int x0, int y0, int x1, int y1)
+{
+    display_rect_t add = {.x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0};
+
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < fb->dirty_count; i++) {
+            const display_rect_t u = rect_union(&fb->dirty[i], &add);
+            if (rect_area(&u) <= rect_area(&fb->dirty[i]) + rect_area(&add) + DISPLAY_FB_MERGE_SLACK_PX) {
+                add = u;
+                fb->dirty[i] = fb->dirty[--fb->dirty_count];
+                merged = true;
+                break;
+            }
+        }
     }
+
+    if (fb->dirty_count < DISPLAY_FB_MAX_DIRTY) {
+        fb->dirty[fb->dirty_count++] = add;
+        return;
+    }
+
+    uint8_t best = 0;
+    int best_growth = 0;
+    for (uint8_t i = 0; i < fb->dirty_count; i++) {
+        const display_rect_t u = rect_union(&fb->dirty[i], &add);
+        const int growth = rect_area(&u) - rect_area(&fb->dirty[i]);
+        if (i == 0 || growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    fb->dirty[best] = rect_union(&fb->dirty[best], &add);
+}
+
+/*
+ * Compose one row segment into the active framebuffer. Only pixels whose
+ * value changes are tracked, so redrawing identical content sends nothing.
+ * A NULL src fills with `color`. Returns true when any pixel changed.
+ */
+static bool fb_write_row_locked(int x0, int y, const uint16_t *src, uint16_t color, int count, int *chg_x0, int *chg_x1)
+{
+    display_fb_t *fb = g_disp.fb;
+    uint16_t *dst = fb->pixels + ((size_t)(y - fb->area.y) * (size_t)fb->area.w) + (size_t)(x0 - fb->area.x);
+    int first = -1;
+    int last = -1;
+    for (int i = 0; i < count; i++) {
+        const uint16_t px = (src != NULL) ? src[i] : color;
+        if (dst[i] != px) {
+            dst[i] = px;
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+    if (first < 0) {
+        return false;
+    }
+    if (x0 + first < *chg_x0) {
+        *chg_x0 = x0 + first;
+    }
+    if (x0 + last + 1 > *chg_x1) {
+        *chg_x1 = x0 + last + 1;
+    }
+    return true;
+}
+
+/* Invalidate registered framebuffers overlapped by a direct panel write. */
+static void fb_invalidate_overlapping_locked(int x0, int y0, int x1, int y1)
+{
+    for (size_t i = 0; i < DISPLAY_FB_MAX_REGISTERED; i++) {
+        display_fb_t *fb = g_disp.fb_registry[i];
+        if (fb != NULL && rects_overlap(&fb->area, x0, y0, x1, y1)) {
+            fb->synced = false;
+        }
+    }
+}
+
+/* Clip to the active framebuffer area while composing, else to the panel. */
+static bool clip_target_locked(int x, int y, int w, int h, int *x0, int *y0, int *x1, int *y1)
+{
+    int lx = 0;
+    int ly = 0;
+    int hx = g_disp.active_width;
+    int hy = g_disp.active_height;
+    if (g_disp.fb != NULL) {
+        lx = g_disp.fb->area.x;
+        ly = g_disp.fb->area.y;
+        hx = lx + g_disp.fb->area.w;
+        hy = ly + g_disp.fb->area.h;
+    }
+    *x0 = clampi(x, lx, hx);
+    *y0 = clampi(y, ly, hy);
+    *x1 = clampi(x + w, lx, hx);
+    *y1 = clampi(y + h, ly, hy);
+    return (*x1 > *x0) && (*y1 > *y0);
+}
+
+/*
+ * Sink for row-oriented drawing: either the open panel window or the active
+ * framebuffer, so rasterizers do not care where their rows end up. A NULL
+ * row (solid fill) is only valid while composing.
+ */
+typedef struct {
+    pixel_stream_t stream;
+    int x0;
+    int x1;
+    int chg_x0;
+    int chg_y0;
+    int chg_x1;
+    int chg_y1;
+} row_sink_t;
+
+static bool sink_begin_locked(row_sink_t *sink, int x0, int y0, int x1, int y1)
+{
+    sink->x0 = x0;
+    sink->x1 = x1;
+    sink->chg_x0 = x1;
+    sink->chg_y0 = y1;
+    sink->chg_x1 = x0;
+    sink->chg_y1 = y0;
+    if (g_disp.fb != NULL) {
+        return true;
+    }
+    fb_invalidate_overlapping_locked(x0, y0, x1, y1);
+    return stream_begin_locked(&sink->stream, x0, y0, x1, y1);
+}
+
+static void sink_row_locked(row_sink_t *sink, int y, const uint16_t *row, uint16_t color)
+{
+    const int count = sink->x1 - sink->x0;
+    if (g_disp.fb == NULL) {
+        stream_push_row_locked(&sink->stream, row, (size_t)count);
+        return;
+    }
+    if (fb_write_row_locked(sink->x0, y, row, color, count, &sink->chg_x0, &sink->chg_x1)) {
+        if (y < sink->chg_y0) {
+            sink->chg_y0 = y;
+        }
+        sink->chg_y1 = y + 1;
+    }
+}
+
+static void sink_end_locked(row_sink_t *sink)
+{
+    if (g_disp.fb != NULL) {
+        if (g_disp.fb->synced && sink->chg_x1 > sink->chg_x0 && sink->chg_y1 > sink->chg_y0) {
+            fb_add_dirty(g_disp.fb, sink->chg_x0, sink->chg_y0, sink->chg_x1, sink->chg_y1);
+        }
+        return;
+    }
+    stream_flush_locked(&sink->stream);
 }
 
 static void draw_rect_locked(int x, int y, int w, int h, uint16_t rgb565)
@@ -113,21 +494,46 @@ static void draw_rect_locked(int x, int y, int w, int h, uint16_t rgb565)
         return;
     }
 
-    int x0 = clampi(x, 0, g_disp.active_width);
-    int y0 = clampi(y, 0, g_disp.active_height);
-    int x1 = clampi(x + w, 0, g_disp.active_width);
-    int y1 = clampi(y + h, 0, g_disp.active_height);
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+    if (!clip_target_locked(x, y, w, h, &x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    const int64_t start_us = esp_timer_get_time();
+    if (g_disp.fb != NULL) {
+        row_sink_t sink;
+        (void)sink_begin_locked(&sink, x0, y0, x1, y1);
+        for (int row = y0; row < y1; row++) {
+            sink_row_locked(&sink, row, NULL, rgb565);
+        }
+        sink_end_locked(&sink);
+        perf_observe_since(&s_perf_rect_fb, start_us);
+        return;
+    }
 
-    if (x1 <= x0 || y1 <= y0) {
+    fb_invalidate_overlapping_locked(x0, y0, x1, y1);
+    if (set_window_locked(x0, y0, x1, y1) != ESP_OK || wait_trans_done(s_trans_submitted) != ESP_OK) {
         return;
     }
 
-    const int draw_w = x1 - x0;
-    fill_line_buf(rgb565, (size_t)draw_w);
+    size_t remaining = (size_t)(x1 - x0) * (size_t)(y1 - y0);
+    const size_t chunk = (remaining < g_disp.fill_buf_pixels) ? remaining : g_disp.fill_buf_pixels;
+    fill_buf_set(rgb565, chunk);
 
-    for (int row = y0; row < y1; row++) {
-        esp_lcd_panel_draw_bitmap(g_disp.panel, x0, row, x1, row + 1, g_disp.line_buf);
+    bool first_chunk = true;
+    while (remaining > 0) {
+        const size_t n = (remaining < chunk) ? remaining : chunk;
+        if (write_pixels_locked(g_disp.fill_buf, n, first_chunk) != ESP_OK) {
+            return;
+        }
+        remaining -= n;
+        first_chunk = false;
     }
+    /* Submission time: the last chunk may still be on the wire (see wait_trans_done). */
+    perf_observe_since(&s_perf_rect_spi, start_us);
 }
 
 static void calc_viewport_for_rotation(uint8_t rotation, int *width, int *height, int *x_offset, int *y_offset)
@@ -146,16 +552,18 @@ static void calc_viewport_for_rotation(uint8_t rotation, int *width, int *height
     }
 }
 
-static esp_err_t configure_backlight(gpio_num_t bl_pin)
+static esp_err_t configure_backlight(gpio_num_t bl_pin, bool keep_in_light_sleep)
 {
+    const ledc_timer_bit_t duty_res = keep_in_light_sleep ? DISPLAY_BL_LEDC_SLEEP_DUTY_RES : DISPLAY_BL_LEDC_DUTY_RES;
     ledc_timer_config_t timer_cfg = {
         .speed_mode = DISPLAY_BL_LEDC_MODE,
         .timer_num = DISPLAY_BL_LEDC_TIMER,
-        .duty_resolution = DISPLAY_BL_LEDC_DUTY_RES,
+        .duty_resolution = duty_res,
         .freq_hz = DISPLAY_BL_LEDC_FREQ_HZ,
-        .clk_cfg = LEDC_AUTO_CLK,
+        .clk_cfg = keep_in_light_sleep ? LEDC_USE_RC_FAST_CLK : LEDC_AUTO_CLK,
         .deconfigure = false,
     };
+    g_disp.bl_max_duty = (1U << duty_res) - 1U;
     ESP_RETURN_ON_ERROR(ledc_timer_config(&timer_cfg), TAG, "ledc_timer_config failed");
 
     ledc_channel_config_t ch_cfg = {
@@ -166,6 +574,7 @@ static esp_err_t configure_backlight(gpio_num_t bl_pin)
         .timer_sel = DISPLAY_BL_LEDC_TIMER,
         .duty = 0,
         .hpoint = 0,
+        .sleep_mode = keep_in_light_sleep ? LEDC_SLEEP_MODE_KEEP_ALIVE : LEDC_SLEEP_MODE_NO_ALIVE_NO_PD,
         .flags = {.output_invert = 0},
     };
     return ledc_channel_config(&ch_cfg);
@@ -265,6 +674,291 @@ static const uint8_t *glyph_for_char(char c)
     }
 }
 
+static int text_width_px(size_t len, uint8_t scale, uint8_t char_spacing_px)
+{
+    if (len == 0U) {
+        return 0;
+    }
+    return ((int)len * DISPLAY_GLYPH_ADVANCE * (int)scale) + (((int)len - 1) * (int)char_spacing_px);
+}
+
+static size_t glyph_cell_bytes(uint8_t scale)
+{
+    return (size_t)DISPLAY_GLYPH_H * (size_t)DISPLAY_GLYPH_ADVANCE * (size_t)scale * sizeof(uint16_t);
+}
+
+static void glyph_cache_drop(glyph_cache_entry_t *e)
+{
+    s_glyph_cache_bytes -= glyph_cell_bytes(e->scale);
+    memset(&s_glyph_unit_used[e->unit], 0, e->scale);
+    *e = (glyph_cache_entry_t){0};
+}
+
+/* First run of `units` free arena units below the byte cap, or -1. */
+static int glyph_arena_find(size_t units)
+{
+    const size_t limit_units = s_glyph_cache_limit / (DISPLAY_GLYPH_UNIT_PIXELS * sizeof(uint16_t));
+    size_t run = 0;
+    for (size_t i = 0; i < limit_units; i++) {
+        run = s_glyph_unit_used[i] ? 0U : (run + 1U);
+        if (run == units) {
+            return (int)(i + 1U - units);
+        }
+    }
+    return -1;
+}
+
+/*
+ * Evict the least recently used entry not touched since `pinned_from`, so
+ * cells resolved for the string being drawn stay valid. Returns false when
+ * everything left is pinned.
+ */
+static bool glyph_cache_evict_one(uint32_t pinned_from)
+{
+    glyph_cache_entry_t *victim = NULL;
+    for (size_t i = 0; i < DISPLAY_GLYPH_CACHE_SLOTS; i++) {
+        glyph_cache_entry_t *e = &s_glyph_cache[i];
+        if (e->pixels != NULL && (int32_t)(e->last_use - pinned_from) < 0
+            && (victim == NULL || (int32_t)(e->last_use - victim->last_use) < 0)) {
+            victim = e;
+        }
+    }
+    if (victim == NULL) {
+        return false;
+    }
+    glyph_cache_drop(victim);
+    return true;
+}
+
+/* Cached cell for (c, scale, fg, bg), expanded on a miss; NULL when it does not fit the cap. */
+static const uint16_t *glyph_cache_get(char c, uint8_t scale, uint16_t fg, uint16_t bg, uint32_t pinned_from)
+{
+    glyph_cache_entry_t *free_slot = NULL;
+    for (size_t i = 0; i < DISPLAY_GLYPH_CACHE_SLOTS; i++) {
+        glyph_cache_entry_t *e = &s_glyph_cache[i];
+        if (e->pixels == NULL) {
+            if (free_slot == NULL) {
+                free_slot = e;
+            }
+        } else if (e->c == c && e->scale == scale && e->fg == fg && e->bg == bg) {
+            e->last_use = ++s_glyph_cache_clock;
+            return e->pixels;
+        }
+    }
+
+    const size_t bytes = glyph_cell_bytes(scale);
+    if (bytes > s_glyph_cache_limit) {
+        return NULL;
+    }
+    int unit = glyph_arena_find(scale);
+    while (free_slot == NULL || unit < 0) {
+        if (!glyph_cache_evict_one(pinned_from)) {
+            return NULL;
+        }
+        unit = glyph_arena_find(scale);
+        if (free_slot == NULL) {
+            for (size_t i = 0; i < DISPLAY_GLYPH_CACHE_SLOTS && free_slot == NULL; i++) {
+                if (s_glyph_cache[i].pixels == NULL) {
+                    free_slot = &s_glyph_cache[i];
+                }
+            }
+        }
+    }
+
+    uint16_t *pixels = &s_glyph_arena[(size_t)unit * DISPLAY_GLYPH_UNIT_PIXELS];
+    memset(&s_glyph_unit_used[unit], 1, scale);
+
+    const uint8_t *glyph = glyph_for_char(c);
+    const size_t cell_w = (size_t)DISPLAY_GLYPH_ADVANCE * (size_t)scale;
+    for (int row = 0; row < DISPLAY_GLYPH_H; row++) {
+        uint16_t *dst = pixels + ((size_t)row * cell_w);
+        for (int col = 0; col < DISPLAY_GLYPH_ADVANCE; col++) {
+            const bool lit = (col < DISPLAY_GLYPH_W) && ((glyph[col] >> row) & 1U);
+            for (int k = 0; k < (int)scale; k++) {
+                *dst++ = lit ? fg : bg;
+            }
+        }
+    }
+
+    *free_slot = (glyph_cache_entry_t){
+        .pixels = pixels,
+        .last_use = ++s_glyph_cache_clock,
+        .fg = fg,
+        .bg = bg,
+        .unit = (uint16_t)unit,
+        .scale = scale,
+        .c = c,
+    };
+    s_glyph_cache_bytes += bytes;
+    return pixels;
+}
+
+/*
+ * Rasterize one glyph row of the string into s_row_buf for columns [vis_x0, vis_x1).
+ * Characters with a cached cell are a memcpy; the rest are decoded bit by bit.
+ */
+static void raster_text_row(int text_x,
+                            int vis_x0,
+                            int vis_x1,
+                            const char *s,
+                            int glyph_row,
+                            uint16_t fg,
+                            uint16_t bg,
+                            uint8_t scale,
+                            uint8_t char_spacing_px)
+{
+    const int cell_w = DISPLAY_GLYPH_ADVANCE * (int)scale;
+    int px = text_x;
+    size_t idx = 0;
+    for (const char *c = s; *c != '\0' && px < vis_x1; c++, idx++) {
+        const uint16_t *cell = (idx < DISPLAY_TEXT_MAX_CELLS) ? s_text_cells[idx] : NULL;
+        if (cell != NULL) {
+            const int a = max_i32(px, vis_x0);
+            const int b = ((px + cell_w) < vis_x1) ? (px + cell_w) : vis_x1;
+            if (b > a) {
+                memcpy(&s_row_buf[a - vis_x0], &cell[(glyph_row * cell_w) + (a - px)], (size_t)(b - a) * sizeof(uint16_t));
+            }
+            px += cell_w;
+        } else {
+            const uint8_t *glyph = glyph_for_char(*c);
+            for (int col = 0; col < DISPLAY_GLYPH_ADVANCE; col++) {
+                const bool lit = (col < DISPLAY_GLYPH_W) && ((glyph[col] >> glyph_row) & 1U);
+                const uint16_t color = lit ? fg : bg;
+                for (int k = 0; k < (int)scale; k++, px++) {
+                    if (px >= vis_x0 && px < vis_x1) {
+                        s_row_buf[px - vis_x0] = color;
+                    }
+                }
+            }
+        }
+        if (c[1] != '\0') {
+            for (int k = 0; k < (int)char_spacing_px; k++, px++) {
+                if (px >= vis_x0 && px < vis_x1) {
+                    s_row_buf[px - vis_x0] = bg;
+                }
+            }
+        }
+    }
+}
+
+static void draw_text_run_locked(int x, int y, const char *s, uint16_t fg, uint16_t bg, uint8_t scale, uint8_t char_spacing_px)
+{
+    const size_t len = strlen(s);
+    const int w = text_width_px(len, scale, char_spacing_px);
+    const int h = DISPLAY_GLYPH_H * (int)scale;
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+    if (!clip_target_locked(x, y, w, h, &x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    /* Resolve cells once per draw; everything touched from here on is pinned. */
+    const uint32_t pinned_from = s_glyph_cache_clock + 1U;
+    const int step = (DISPLAY_GLYPH_ADVANCE * (int)scale) + (int)char_spacing_px;
+    for (size_t i = 0; i < len && i < DISPLAY_TEXT_MAX_CELLS; i++) {
+        const int cx = x + ((int)i * step);
+        const bool visible = (cx < x1) && ((cx + (DISPLAY_GLYPH_ADVANCE * (int)scale)) > x0);
+        s_text_cells[i] = visible ? glyph_cache_get(s[i], scale, fg, bg, pinned_from) : NULL;
+    }
+
+    row_sink_t sink;
+    if (!sink_begin_locked(&sink, x0, y0, x1, y1)) {
+        return;
+    }
+
+    for (int glyph_row = 0; glyph_row < DISPLAY_GLYPH_H; glyph_row++) {
+        const int row_y0 = max_i32(y + (glyph_row * (int)scale), y0);
+        const int row_y1 = (y + ((glyph_row + 1) * (int)scale) < y1) ? (y + ((glyph_row + 1) * (int)scale)) : y1;
+        if (row_y1 <= row_y0) {
+            continue;
+        }
+        raster_text_row(x, x0, x1, s, glyph_row, fg, bg, scale, char_spacing_px);
+        for (int py = row_y0; py < row_y1; py++) {
+            sink_row_locked(&sink, py, s_row_buf, 0U);
+        }
+    }
+    sink_end_locked(&sink);
+}
+
+/* Quiet on a missing key: most boots have nothing stored. */
+static esp_err_t spi_clock_load(int *hz)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(DISPLAY_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t stored = 0;
+    err = nvs_get_u32(nvs, DISPLAY_NVS_SPI_CLOCK, &stored);
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_RETURN_ON_FALSE(stored >= DISPLAY_SPI_CLOCK_MIN_HZ && stored <= DISPLAY_SPI_CLOCK_SRC_HZ, ESP_ERR_INVALID_SIZE,
+                        TAG, "stored SPI clock %" PRIu32 " out of range", stored);
+    *hz = (int)stored;
+    return ESP_OK;
+}
+
+static esp_err_t spi_clock_store(int hz)
+{
+    nvs_handle_t nvs;
+    ESP_RETURN_ON_ERROR(nvs_open(DISPLAY_NVS_NAMESPACE, NVS_READWRITE, &nvs), TAG, "nvs_open failed");
+    esp_err_t err = nvs_set_u32(nvs, DISPLAY_NVS_SPI_CLOCK, (uint32_t)hz);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+/* Panel IO at pclk_hz plus the ST7789 driver on top, through its init sequence. */
+static esp_err_t panel_open(int pclk_hz)
+{
+    esp_lcd_panel_io_spi_config_t io_config = {
+        .dc_gpio_num = g_disp.pins.dc,
+        .cs_gpio_num = g_disp.pins.cs,
+        .pclk_hz = pclk_hz,
+        .lcd_cmd_bits = DISPLAY_CMD_BITS,
+        .lcd_param_bits = DISPLAY_PARAM_BITS,
+        .spi_mode = DISPLAY_SPI_MODE,
+        .trans_queue_depth = 10,
+        .on_color_trans_done = on_color_trans_done,
+        .user_ctx = NULL,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)DISPLAY_SPI_HOST, &io_config, &g_disp.io), TAG,
+                        "new_panel_io failed");
+
+    esp_lcd_panel_dev_config_t panel_cfg = {
+        .reset_gpio_num = g_disp.pins.reset,
+        .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
+        .bits_per_pixel = DISPLAY_PIXEL_BITS,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_new_panel_st7789(g_disp.io, &panel_cfg, &g_disp.panel), TAG, "new_panel_st7789 failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_reset(g_disp.panel), TAG, "panel_reset failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_init(g_disp.panel), TAG, "panel_init failed");
+
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_set_gap(g_disp.panel, g_disp.cfg.x_offset, g_disp.cfg.y_offset), TAG, "set_gap failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_invert_color(g_disp.panel, true), TAG, "invert_color failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_disp_on_off(g_disp.panel, true), TAG, "disp_on failed");
+    g_disp.spi_clock_hz = pclk_hz;
+    return ESP_OK;
+}
+
+static void panel_close(void)
+{
+    if (g_disp.panel != NULL) {
+        esp_lcd_panel_del(g_disp.panel);
+        g_disp.panel = NULL;
+    }
+    if (g_disp.io != NULL) {
+        esp_lcd_panel_io_del(g_disp.io);
+        g_disp.io = NULL;
+    }
+}
+
 esp_err_t display_init(const display_pins_t *pins, const display_cfg_t *cfg)
 {
     esp_err_t ret = ESP_OK;
@@ -272,8 +966,8 @@ esp_err_t display_init(const display_pins_t *pins, const display_cfg_t *cfg)
     ESP_RETURN_ON_FALSE(pins != NULL, ESP_ERR_INVALID_ARG, TAG, "pins is null");
     ESP_RETURN_ON_FALSE(cfg != NULL, ESP_ERR_INVALID_ARG, TAG, "cfg is null");
     ESP_RETURN_ON_FALSE(cfg->width > 0 && cfg->height > 0, ESP_ERR_INVALID_ARG, TAG, "invalid geometry");
-    ESP_RETURN_ON_FALSE(max_i32(cfg->width, cfg->height) <= (int)DISPLAY_LINE_BUF_PIXELS_MAX,
-                        ESP_ERR_INVALID_ARG, TAG, "geometry exceeds line buffer");
+    ESP_RETURN_ON_FALSE(max_i32(cfg->width, cfg->height) <= (int)DISPLAY_MAX_DIMENSION_PX,
+                        ESP_ERR_INVALID_ARG, TAG, "geometry exceeds supported size");
     ESP_RETURN_ON_FALSE(cfg->spi_clock_hz > 0, ESP_ERR_INVALID_ARG, TAG, "invalid spi clock");
 
     if (g_disp.initialized) {
@@ -285,6 +979,10 @@ esp_err_t display_init(const display_pins_t *pins, const display_cfg_t *cfg)
         s_display_lock = xSemaphoreCreateRecursiveMutex();
         ESP_RETURN_ON_FALSE(s_display_lock != NULL, ESP_ERR_NO_MEM, TAG, "display lock alloc failed");
     }
+    if (s_trans_done_sem == NULL) {
+        s_trans_done_sem = xSemaphoreCreateBinary();
+        ESP_RETURN_ON_FALSE(s_trans_done_sem != NULL, ESP_ERR_NO_MEM, TAG, "transfer semaphore alloc failed");
+    }
 
     g_disp.pins = *pins;
     g_disp.cfg = *cfg;
@@ -295,74 +993,45 @@ esp_err_t display_init(const display_pins_t *pins, const display_cfg_t *cfg)
         .miso_io_num = -1,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = cfg->width * 40 * sizeof(uint16_t),
+        .max_transfer_sz = cfg->width * DISPLAY_TRANSFER_ROWS * sizeof(uint16_t),
         .flags = SPICOMMON_BUSFLAG_MASTER,
         .intr_flags = 0,
     };
     ESP_RETURN_ON_ERROR(spi_bus_initialize(DISPLAY_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO), TAG, "spi_bus_initialize failed");
 
-    esp_lcd_panel_io_spi_config_t io_config = {
-        .dc_gpio_num = pins->dc,
-        .cs_gpio_num = pins->cs,
-        .pclk_hz = cfg->spi_clock_hz,
-        .lcd_cmd_bits = DISPLAY_CMD_BITS,
-        .lcd_param_bits = DISPLAY_PARAM_BITS,
-        .spi_mode = DISPLAY_SPI_MODE,
-        .trans_queue_depth = 10,
-        .on_color_trans_done = NULL,
-        .user_ctx = NULL,
-    };
-    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)DISPLAY_SPI_HOST, &io_config, &g_disp.io), err, TAG, "new_panel_io failed");
+    g_disp.fill_buf_pixels = (size_t)cfg->width * DISPLAY_TRANSFER_ROWS;
+    g_disp.fill_buf = heap_caps_malloc(g_disp.fill_buf_pixels * sizeof(uint16_t), MALLOC_CAP_DMA);
+    ESP_GOTO_ON_FALSE(g_disp.fill_buf != NULL, ESP_ERR_NO_MEM, err, TAG, "fill buffer alloc failed");
 
-    esp_lcd_panel_dev_config_t panel_cfg = {
-        .reset_gpio_num = pins->reset,
-        .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
-        .bits_per_pixel = DISPLAY_PIXEL_BITS,
-    };
-    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_st7789(g_disp.io, &panel_cfg, &g_disp.panel), err, TAG, "new_panel_st7789 failed");
-    ESP_GOTO_ON_ERROR(esp_lcd_panel_reset(g_disp.panel), err, TAG, "panel_reset failed");
-    ESP_GOTO_ON_ERROR(esp_lcd_panel_init(g_disp.panel), err, TAG, "panel_init failed");
-
-    ESP_GOTO_ON_ERROR(esp_lcd_panel_set_gap(g_disp.panel, cfg->x_offset, cfg->y_offset), err, TAG, "set_gap failed");
-    ESP_GOTO_ON_ERROR(esp_lcd_panel_invert_color(g_disp.panel, true), err, TAG, "invert_color failed");
-    ESP_GOTO_ON_ERROR(esp_lcd_panel_disp_on_off(g_disp.panel, true), err, TAG, "disp_on failed");
-
-    g_disp.line_buf = s_line_buf;
+    int spi_clock_hz = cfg->spi_clock_hz;
+    if (cfg->spi_clock_from_nvs && spi_clock_load(&spi_clock_hz) == ESP_OK) {
+        DISPLAY_LOGI("using calibrated SPI clock %d Hz", spi_clock_hz);
+    }
+    ESP_GOTO_ON_ERROR(panel_open(spi_clock_hz), err, TAG, "panel open failed");
 
     g_disp.initialized = true;
-    ESP_GOTO_ON_ERROR(configure_backlight(pins->backlight), err, TAG, "configure_backlight failed");
+    ESP_GOTO_ON_ERROR(configure_backlight(pins->backlight, cfg->backlight_in_light_sleep), err, TAG,
+                      "configure_backlight failed");
     display_backlight_set(80);
     display_set_rotation(0);
 
-    DISPLAY_LOGI("initialized %dx%d @ %d Hz", cfg->width, cfg->height, cfg->spi_clock_hz);
+    DISPLAY_LOGI("initialized %dx%d @ %d Hz; reserved %u B DMA bands, %u B glyph arena", cfg->width, cfg->height,
+                 g_disp.spi_clock_hz, (unsigned)(g_disp.fill_buf_pixels * sizeof(uint16_t)),
+                 (unsigned)sizeof(s_glyph_arena));
     return ESP_OK;
 
 err:
     g_disp.initialized = false;
-    g_disp.line_buf = NULL;
-    if (g_disp.panel != NULL) {
-        esp_lcd_panel_del(g_disp.panel);
-        g_disp.panel = NULL;
-    }
-    if (g_disp.io != NULL) {
-        esp_lcd_panel_io_del(g_disp.io);
-        g_disp.io = NULL;
-    }
+    heap_caps_free(g_disp.fill_buf);
+    g_disp.fill_buf = NULL;
+    panel_close();
     spi_bus_free(DISPLAY_SPI_HOST);
     return ret;
 }
 
-void display_set_rotation(uint8_t rotation)
+/* MADCTL swap/mirror and gap for a rotation; the address window follows from the next draw. */
+static void rotation_apply_locked(uint8_t rot)
 {
-    if (!g_disp.initialized) {
-        return;
-    }
-    if (!display_lock()) {
-        return;
-    }
-
-    const uint8_t rot = rotation % 4U;
-    g_disp.rotation = rot;
     switch (rot) {
         case 0:
             esp_lcd_panel_swap_xy(g_disp.panel, false);
@@ -385,9 +1054,70 @@ void display_set_rotation(uint8_t rotation)
     }
     calc_viewport_for_rotation(rot, &g_disp.active_width, &g_disp.active_height, &g_disp.active_x_offset, &g_disp.active_y_offset);
     esp_lcd_panel_set_gap(g_disp.panel, g_disp.active_x_offset, g_disp.active_y_offset);
+}
+
+void display_set_rotation(uint8_t rotation)
+{
+    if (!g_disp.initialized) {
+        return;
+    }
+    if (!display_lock()) {
+        return;
+    }
+
+    const uint8_t rot = rotation % 4U;
+    g_disp.rotation = rot;
+    rotation_apply_locked(rot);
+    fb_invalidate_overlapping_locked(0, 0, DISPLAY_MAX_DIMENSION_PX, DISPLAY_MAX_DIMENSION_PX);
     display_unlock();
 }
 
+display_status_t display_draw_frame_rotated(const uint16_t *rgb565, int w, int h, uint8_t quarter_turns)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    ESP_RETURN_ON_FALSE(rgb565 != NULL && w > 0 && h > 0, ESP_ERR_INVALID_ARG, TAG, "invalid bitmap");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+
+    esp_err_t err = ESP_OK;
+    if (g_disp.fb != NULL) {
+        /* The framebuffer composes in the current orientation only. */
+        err = ESP_ERR_INVALID_STATE;
+        goto out;
+    }
+
+    const uint8_t turns = quarter_turns % 4U;
+    const bool swapped = (turns % 2U) != 0U;
+    if ((swapped ? h : w) != g_disp.active_width || (swapped ? w : h) != g_disp.active_height) {
+        err = ESP_ERR_INVALID_SIZE;
+        goto out;
+    }
+
+    fb_invalidate_overlapping_locked(0, 0, DISPLAY_MAX_DIMENSION_PX, DISPLAY_MAX_DIMENSION_PX);
+    if (turns != 0U) {
+        err = wait_trans_done(s_trans_submitted);
+        if (err != ESP_OK) {
+            goto out;
+        }
+        rotation_apply_locked((uint8_t)((g_disp.rotation + turns) % 4U));
+    }
+    err = set_window_locked(0, 0, w, h);
+    if (err == ESP_OK) {
+        err = write_pixels_locked(rgb565, (size_t)w * (size_t)h, true);
+    }
+    if (turns != 0U) {
+        /* MADCTL applies to pixels still in flight, so restore only once they landed. */
+        const esp_err_t wait_err = wait_trans_done(s_trans_submitted);
+        rotation_apply_locked(g_disp.rotation);
+        if (err == ESP_OK) {
+            err = wait_err;
+        }
+    }
+
+out:
+    display_unlock();
+    return err;
+}
+
 int display_get_width(void)
 {
     if (!g_disp.initialized) {
@@ -412,6 +1142,160 @@ esp_lcd_panel_handle_t display_get_panel_handle(void)
     return g_disp.panel;
 }
 
+void display_get_io_stats(display_io_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    out->color_trans = __atomic_load_n(&s_io_stats.color_trans, __ATOMIC_RELAXED);
+    out->color_bytes = __atomic_load_n(&s_io_stats.color_bytes, __ATOMIC_RELAXED);
+    out->windows = __atomic_load_n(&s_io_stats.windows, __ATOMIC_RELAXED);
+}
+
+int display_get_spi_clock(void)
+{
+    return g_disp.initialized ? g_disp.spi_clock_hz : 0;
+}
+
+display_status_t display_set_spi_clock(int spi_clock_hz)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    ESP_RETURN_ON_FALSE(spi_clock_hz >= DISPLAY_SPI_CLOCK_MIN_HZ && spi_clock_hz <= DISPLAY_SPI_CLOCK_SRC_HZ,
+                        ESP_ERR_INVALID_ARG, TAG, "spi clock out of range");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+    if (g_disp.fb != NULL) {
+        display_unlock();
+        DISPLAY_LOGW("spi clock change while a framebuffer is composing");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const int prev_hz = g_disp.spi_clock_hz;
+    esp_err_t err = wait_trans_done(s_trans_submitted);
+    if (err == ESP_OK) {
+        panel_close();
+        err = panel_open(spi_clock_hz);
+        if (err != ESP_OK) {
+            DISPLAY_LOGW("reopen at %d Hz failed (%s), back to %d Hz", spi_clock_hz, esp_err_to_name(err), prev_hz);
+            panel_close();
+            if (panel_open(prev_hz) != ESP_OK) {
+                /* No panel left to draw on. */
+                g_disp.initialized = false;
+            }
+        }
+    }
+    if (g_disp.initialized) {
+        display_set_rotation(g_disp.rotation);
+    }
+    display_unlock();
+    return err;
+}
+
+/*
+ * Calibration pattern: a 1 px checkerboard (every bit flips on every pixel),
+ * walking-one columns (each data bit alone) and a colour ramp. Dropped or
+ * shifted bits show up as tint, smearing or broken stripes.
+ */
+static esp_err_t cal_pattern_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    const int h = *(const int *)user_ctx;
+    for (int r = 0; r < rows; r++) {
+        const int y = row + r;
+        uint16_t *dst = &band[(size_t)r * (size_t)width];
+        for (int x = 0; x < width; x++) {
+            if (y < h / 3) {
+                dst[x] = ((x ^ y) & 1) ? 0xFFFFU : 0x0000U;
+            } else if (y < (2 * h) / 3) {
+                dst[x] = (uint16_t)(1U << (x & 15));
+            } else {
+                dst[x] = (uint16_t)(((uint32_t)x * 0xFFFFU) / (uint32_t)((width > 1) ? (width - 1) : 1));
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t cal_draw_pattern(int spi_clock_hz)
+{
+    int h = g_disp.active_height;
+    ESP_RETURN_ON_ERROR(display_draw_bands(0, 0, g_disp.active_width, h, (int)DISPLAY_TRANSFER_ROWS, cal_pattern_band, &h),
+                        TAG, "pattern draw failed");
+
+    char label[16];
+    snprintf(label, sizeof(label), "%d.%02d MHz", spi_clock_hz / 1000000, (spi_clock_hz / 10000) % 100);
+    const int x = (g_disp.active_width - display_get_text_width(label, 2U, 0U)) / 2;
+    display_draw_text_run((x > 0) ? x : 0, 4, label, DISPLAY_COLOR_WHITE, DISPLAY_COLOR_BLACK, 2U, 0U);
+    return display_wait_idle();
+}
+
+display_status_t display_calibrate_spi_clock(const display_clock_cal_cfg_t *cfg, int *out_hz)
+{
+    ESP_RETURN_ON_FALSE(cfg != NULL && cfg->check != NULL, ESP_ERR_INVALID_ARG, TAG, "calibration needs a check");
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+
+    const int min_hz = (cfg->min_hz > 0) ? cfg->min_hz : g_disp.cfg.spi_clock_hz;
+    const int max_hz = (cfg->max_hz > 0 && cfg->max_hz < DISPLAY_SPI_CLOCK_SRC_HZ) ? cfg->max_hz : DISPLAY_SPI_CLOCK_SRC_HZ;
+    ESP_RETURN_ON_FALSE(min_hz >= DISPLAY_SPI_CLOCK_MIN_HZ && min_hz <= max_hz, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid calibration range");
+
+    /* Ascending exact clocks 80 MHz / n; the lowest one is >= min_hz. */
+    int steps[DISPLAY_CAL_MAX_STEPS];
+    size_t step_count = 0;
+    for (int n = DISPLAY_SPI_CLOCK_SRC_HZ / min_hz; n >= 1 && step_count < DISPLAY_CAL_MAX_STEPS; n--) {
+        const int hz = DISPLAY_SPI_CLOCK_SRC_HZ / n;
+        if (hz >= min_hz && hz <= max_hz && (step_count == 0U || hz != steps[step_count - 1U])) {
+            steps[step_count++] = hz;
+        }
+    }
+    ESP_RETURN_ON_FALSE(step_count > 0U, ESP_ERR_INVALID_ARG, TAG, "no clock step in range");
+
+    const int prev_hz = g_disp.spi_clock_hz;
+    size_t passed = 0;
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < step_count; i++) {
+        err = display_set_spi_clock(steps[i]);
+        if (err == ESP_OK) {
+            err = cal_draw_pattern(steps[i]);
+        }
+        const bool ok = (err == ESP_OK) && cfg->check(steps[i], cfg->user_ctx);
+        DISPLAY_LOGI("calibration %d Hz: %s", steps[i], ok ? "pass" : "fail");
+        if (!ok) {
+            break;
+        }
+        passed = i + 1U;
+    }
+
+    if (passed == 0U) {
+        ESP_RETURN_ON_ERROR(display_set_spi_clock(prev_hz), TAG, "restore %d Hz failed", prev_hz);
+        return (err != ESP_OK) ? err : ESP_ERR_NOT_FOUND;
+    }
+
+    const size_t margin = (cfg->margin_steps < passed) ? cfg->margin_steps : (passed - 1U);
+    const int chosen_hz = steps[passed - 1U - margin];
+    ESP_RETURN_ON_ERROR(display_set_spi_clock(chosen_hz), TAG, "apply %d Hz failed", chosen_hz);
+    if (cfg->persist) {
+        ESP_RETURN_ON_ERROR(spi_clock_store(chosen_hz), TAG, "store SPI clock failed");
+    }
+    DISPLAY_LOGI("calibrated SPI clock: %d Hz", chosen_hz);
+    if (out_hz != NULL) {
+        *out_hz = chosen_hz;
+    }
+    return ESP_OK;
+}
+
+display_status_t display_forget_spi_clock(void)
+{
+    nvs_handle_t nvs;
+    ESP_RETURN_ON_ERROR(nvs_open(DISPLAY_NVS_NAMESPACE, NVS_READWRITE, &nvs), TAG, "nvs_open failed");
+    esp_err_t err = nvs_erase_key(nvs, DISPLAY_NVS_SPI_CLOCK);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    }
+    nvs_close(nvs);
+    return err;
+}
+
 void display_backlight_set(uint8_t percent)
 {
     if (!g_disp.initialized) {
@@ -422,7 +1306,7 @@ void display_backlight_set(uint8_t percent)
     }
 
     const uint8_t p = clamp_percent(percent);
-    const uint32_t duty = (DISPLAY_BL_MAX_DUTY * p) / 100U;
+    const uint32_t duty = (g_disp.bl_max_duty * p) / 100U;
     ledc_set_duty(DISPLAY_BL_LEDC_MODE, DISPLAY_BL_LEDC_CHANNEL, duty);
     ledc_update_duty(DISPLAY_BL_LEDC_MODE, DISPLAY_BL_LEDC_CHANNEL);
     display_unlock();
@@ -474,23 +1358,299 @@ void display_draw_text_minimal_scaled(int x, int y, const char *s, uint16_t rgb5
     while (*s != '\0') {
         const uint8_t *glyph = glyph_for_char(*s);
 
-        for (int col = 0; col < 5; col++) {
-            uint8_t col_bits = glyph[col];
-            for (int row = 0; row < 7; row++) {
-                if (col_bits & (1U << row)) {
-                    const int px = cursor_x + (col * (int)scale);
-                    const int py = cursor_y + (row * (int)scale);
-                    draw_rect_locked(px, py, (int)scale, (int)scale, rgb565);
+        for (int col = 0; col < DISPLAY_GLYPH_W; col++) {
+            const uint8_t col_bits = glyph[col];
+            int row = 0;
+            while (row < DISPLAY_GLYPH_H) {
+                if ((col_bits & (1U << row)) == 0U) {
+                    row++;
+                    continue;
                 }
+                /* Merge vertically adjacent dots into one rect. */
+                const int run_start = row;
+                while (row < DISPLAY_GLYPH_H && (col_bits & (1U << row)) != 0U) {
+                    row++;
+                }
+                const int px = cursor_x + (col * (int)scale);
+                const int py = cursor_y + (run_start * (int)scale);
+                draw_rect_locked(px, py, (int)scale, (row - run_start) * (int)scale, rgb565);
             }
         }
 
-        cursor_x += 6 * (int)scale;
+        cursor_x += DISPLAY_GLYPH_ADVANCE * (int)scale;
         s++;
     }
     display_unlock();
 }
 
+void display_draw_text_run(int x,
+                           int y,
+                           const char *s,
+                           uint16_t fg_rgb565,
+                           uint16_t bg_rgb565,
+                           uint8_t scale,
+                           uint8_t char_spacing_px)
+{
+    if (!g_disp.initialized || s == NULL || scale == 0U) {
+        return;
+    }
+    if (!display_lock()) {
+        return;
+    }
+    draw_text_run_locked(x, y, s, fg_rgb565, bg_rgb565, scale, char_spacing_px);
+    display_unlock();
+}
+
+void display_glyph_cache_set_limit(size_t max_bytes)
+{
+    if (!display_lock()) {
+        return;
+    }
+    s_glyph_cache_limit = (max_bytes < sizeof(s_glyph_arena)) ? max_bytes : sizeof(s_glyph_arena);
+    const size_t limit_units = s_glyph_cache_limit / (DISPLAY_GLYPH_UNIT_PIXELS * sizeof(uint16_t));
+    for (size_t i = 0; i < DISPLAY_GLYPH_CACHE_SLOTS; i++) {
+        glyph_cache_entry_t *e = &s_glyph_cache[i];
+        if (e->pixels != NULL && ((size_t)e->unit + e->scale) > limit_units) {
+            glyph_cache_drop(e);
+        }
+    }
+    display_unlock();
+}
+
+int display_get_text_width(const char *s, uint8_t scale, uint8_t char_spacing_px)
+{
+    if (s == NULL) {
+        return 0;
+    }
+    return text_width_px(strlen(s), scale, char_spacing_px);
+}
+
+int display_get_text_height(uint8_t scale)
+{
+    return DISPLAY_GLYPH_H * (int)scale;
+}
+
+display_status_t display_draw_bitmap(int x, int y, int w, int h, const uint16_t *rgb565)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    ESP_RETURN_ON_FALSE(rgb565 != NULL && w > 0 && h > 0, ESP_ERR_INVALID_ARG, TAG, "invalid bitmap");
+    ESP_RETURN_ON_FALSE(x >= 0 && y >= 0 && x + w <= g_disp.active_width && y + h <= g_disp.active_height,
+                        ESP_ERR_INVALID_ARG, TAG, "bitmap outside display");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+
+    esp_err_t err = ESP_OK;
+    if (g_disp.fb == NULL) {
+        fb_invalidate_overlapping_locked(x, y, x + w, y + h);
+        err = set_window_locked(x, y, x + w, y + h);
+        if (err == ESP_OK) {
+            err = write_pixels_locked(rgb565, (size_t)w * (size_t)h, true);
+        }
+        display_unlock();
+        return err;
+    }
+
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+    if (clip_target_locked(x, y, w, h, &x0, &y0, &x1, &y1)) {
+        row_sink_t sink;
+        (void)sink_begin_locked(&sink, x0, y0, x1, y1);
+        for (int row = y0; row < y1; row++) {
+            sink_row_locked(&sink, row, rgb565 + ((size_t)(row - y) * (size_t)w) + (size_t)(x0 - x), 0U);
+        }
+        sink_end_locked(&sink);
+    }
+    display_unlock();
+    return err;
+}
+
+display_status_t display_draw_bands(int x, int y, int w, int h, int band_rows, display_band_fn_t producer, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    ESP_RETURN_ON_FALSE(producer != NULL && w > 0 && h > 0 && band_rows > 0, ESP_ERR_INVALID_ARG, TAG, "invalid bands");
+    ESP_RETURN_ON_FALSE(x >= 0 && y >= 0 && x + w <= g_disp.active_width && y + h <= g_disp.active_height,
+                        ESP_ERR_INVALID_ARG, TAG, "bands outside display");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+
+    const int max_rows = (int)((g_disp.fill_buf_pixels / 2U) / (size_t)w);
+    const int rows_per_band = (band_rows < max_rows) ? band_rows : max_rows;
+    esp_err_t err = ESP_OK;
+
+    if (g_disp.fb != NULL) {
+        /* Composing: bands land in RAM, so one half is enough. */
+        err = wait_trans_done(s_trans_submitted);
+        row_sink_t sink;
+        int x0 = 0;
+        int y0 = 0;
+        int x1 = 0;
+        int y1 = 0;
+        const bool visible = clip_target_locked(x, y, w, h, &x0, &y0, &x1, &y1);
+        if (visible) {
+            (void)sink_begin_locked(&sink, x0, y0, x1, y1);
+        }
+        for (int row = 0; row < h && err == ESP_OK; row += rows_per_band) {
+            const int rows = ((h - row) < rows_per_band) ? (h - row) : rows_per_band;
+            err = producer(g_disp.fill_buf, row, rows, w, user_ctx);
+            for (int r = 0; r < rows && err == ESP_OK && visible; r++) {
+                const int py = y + row + r;
+                if (py >= y0 && py < y1) {
+                    sink_row_locked(&sink, py, g_disp.fill_buf + ((size_t)r * (size_t)w) + (size_t)(x0 - x), 0U);
+                }
+            }
+        }
+        if (visible) {
+            sink_end_locked(&sink);
+        }
+        display_unlock();
+        return err;
+    }
+
+    fb_invalidate_overlapping_locked(x, y, x + w, y + h);
+    pixel_stream_t st;
+    if (!stream_begin_locked(&st, x, y, x + w, y + h)) {
+        display_unlock();
+        return st.err;
+    }
+    for (int row = 0; row < h && st.err == ESP_OK; row += rows_per_band) {
+        const int rows = ((h - row) < rows_per_band) ? (h - row) : rows_per_band;
+        /* Render band N+1 here while band N is still on the wire. */
+        err = producer(st.half[st.cur], row, rows, w, user_ctx);
+        if (err != ESP_OK) {
+            break;
+        }
+        st.used = (size_t)rows * (size_t)w;
+        stream_flush_locked(&st);
+    }
+    display_unlock();
+    return (err != ESP_OK) ? err : st.err;
+}
+
+display_status_t display_wait_idle(void)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    return wait_trans_done(s_trans_submitted);
+}
+
+display_status_t display_fb_init(display_fb_t *fb, int x, int y, int w, int h)
+{
+    ESP_RETURN_ON_FALSE(g_disp.initialized, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+    ESP_RETURN_ON_FALSE(fb != NULL, ESP_ERR_INVALID_ARG, TAG, "fb is null");
+    ESP_RETURN_ON_FALSE(w > 0 && h > 0 && x >= 0 && y >= 0
+                        && x + w <= g_disp.active_width && y + h <= g_disp.active_height,
+                        ESP_ERR_INVALID_ARG, TAG, "fb area outside display");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+
+    size_t slot = DISPLAY_FB_MAX_REGISTERED;
+    for (size_t i = 0; i < DISPLAY_FB_MAX_REGISTERED; i++) {
+        if (g_disp.fb_registry[i] == NULL) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == DISPLAY_FB_MAX_REGISTERED) {
+        display_unlock();
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t *pixels = heap_caps_calloc((size_t)w * (size_t)h, sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pixels == NULL) {
+        display_unlock();
+        return ESP_ERR_NO_MEM;
+    }
+
+    fb->area = (display_rect_t){.x = x, .y = y, .w = w, .h = h};
+    fb->pixels = pixels;
+    fb->synced = false;
+    fb->dirty_count = 0;
+    g_disp.fb_registry[slot] = fb;
+    display_unlock();
+    return ESP_OK;
+}
+
+void display_fb_deinit(display_fb_t *fb)
+{
+    if (fb == NULL || fb->pixels == NULL) {
+        return;
+    }
+    if (!display_lock()) {
+        return;
+    }
+    for (size_t i = 0; i < DISPLAY_FB_MAX_REGISTERED; i++) {
+        if (g_disp.fb_registry[i] == fb) {
+            g_disp.fb_registry[i] = NULL;
+        }
+    }
+    if (g_disp.fb == fb) {
+        g_disp.fb = NULL;
+        display_unlock();
+    }
+    heap_caps_free(fb->pixels);
+    fb->pixels = NULL;
+    fb->dirty_count = 0;
+    fb->synced = false;
+    display_unlock();
+}
+
+void display_fb_invalidate(display_fb_t *fb)
+{
+    if (fb != NULL) {
+        fb->synced = false;
+    }
+}
+
+display_status_t display_fb_begin(display_fb_t *fb)
+{
+    ESP_RETURN_ON_FALSE(fb != NULL && fb->pixels != NULL, ESP_ERR_INVALID_ARG, TAG, "fb not initialized");
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+    if (g_disp.fb != NULL) {
+        display_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* The lock stays held until display_flush() so frames are not interleaved. */
+    g_disp.fb = fb;
+    return ESP_OK;
+}
+
+display_status_t display_flush(void)
+{
+    ESP_RETURN_ON_FALSE(display_lock(), ESP_ERR_TIMEOUT, TAG, "display lock timeout");
+    display_fb_t *fb = g_disp.fb;
+    if (fb == NULL) {
+        display_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_disp.fb = NULL;
+
+    if (!fb->synced) {
+        fb->dirty[0] = fb->area;
+        fb->dirty_count = 1;
+    }
+
+    esp_err_t err = ESP_OK;
+    for (uint8_t i = 0; i < fb->dirty_count && err == ESP_OK; i++) {
+        const display_rect_t *r = &fb->dirty[i];
+        pixel_stream_t st;
+        if (!stream_begin_locked(&st, r->x, r->y, r->x + r->w, r->y + r->h)) {
+            err = st.err;
+            break;
+        }
+        for (int row = r->y; row < r->y + r->h; row++) {
+            const uint16_t *src = fb->pixels + ((size_t)(row - fb->area.y) * (size_t)fb->area.w) + (size_t)(r->x - fb->area.x);
+            stream_push_row_locked(&st, src, (size_t)r->w);
+        }
+        stream_flush_locked(&st);
+        err = st.err;
+    }
+
+    fb->dirty_count = 0;
+    fb->synced = (err == ESP_OK);
+    /* Release both the flush lock and the one taken by display_fb_begin(). */
+    display_unlock();
+    display_unlock();
+    return err;
+}
+
 void display_self_test(void)
 {
     if (!g_disp.initialized) {
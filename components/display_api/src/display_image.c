@@ -7,10 +7,14 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "display_api.h"
 #include "esp_check.h"
 #include "esp_heap_caps.h"
 
+static const char *TAG = "display_image";
+
 #define RGB565_BLACK 0x0000U
 #define RGB565_WHITE 0xFFFFU
 #define RGB565_RED 0xF800U
@@ -20,6 +24,9 @@
 #define RGB565_CYAN 0x07FFU
 #define RGB565_MAGENTA 0xF81FU
 
+/* Transpose tile edge: 16 x 16 RGB565 is 512 B, a few cache lines per source column run. */
+#define DISPLAY_IMAGE_ROT_TILE 16
+
 static const uint16_t s_color_bars[8] = {
     RGB565_BLACK,
     RGB565_WHITE,
@@ -36,6 +43,15 @@ static bool display_image_ctx_valid(const display_image_t *ctx)
     return (ctx != NULL) && (ctx->panel != NULL) && (ctx->width > 0U) && (ctx->height > 0U);
 }
 
+/* Route blits for the display_api panel through it so locking and framebuffer composition apply. */
+static esp_err_t display_image_blit(display_image_t *ctx, int x, int y, int w, int h, const uint16_t *pixels)
+{
+    if (ctx->panel == display_get_panel_handle()) {
+        return display_draw_bitmap(x, y, w, h, pixels);
+    }
+    return esp_lcd_panel_draw_bitmap(ctx->panel, x, y, x + w, y + h, pixels);
+}
+
 void display_image_init(display_image_t *ctx, esp_lcd_panel_handle_t panel, uint16_t w, uint16_t h)
 {
     if (ctx == NULL) {
@@ -45,6 +61,18 @@ void display_image_init(display_image_t *ctx, esp_lcd_panel_handle_t panel, uint
     ctx->panel = panel;
     ctx->width = w;
     ctx->height = h;
+    ctx->band_buf = NULL;
+    ctx->band_buf_pixels = 0;
+}
+
+void display_image_set_band_buffer(display_image_t *ctx, uint16_t *dma_buf, size_t pixels)
+{
+    if (ctx == NULL) {
+        return;
+    }
+
+    ctx->band_buf = (pixels > 0U) ? dma_buf : NULL;
+    ctx->band_buf_pixels = (dma_buf != NULL) ? pixels : 0U;
 }
 
 esp_err_t display_image_draw_full_rgb565(display_image_t *ctx, const uint16_t *img_rgb565, size_t pixels)
@@ -58,7 +86,7 @@ esp_err_t display_image_draw_full_rgb565(display_image_t *ctx, const uint16_t *i
         return ESP_ERR_INVALID_ARG;
     }
 
-    return esp_lcd_panel_draw_bitmap(ctx->panel, 0, 0, ctx->width, ctx->height, img_rgb565);
+    return display_image_blit(ctx, 0, 0, ctx->width, ctx->height, img_rgb565);
 }
 
 esp_err_t display_image_draw_rect_rgb565(display_image_t *ctx,
@@ -82,42 +110,391 @@ esp_err_t display_image_draw_rect_rgb565(display_image_t *ctx,
         return ESP_ERR_INVALID_ARG;
     }
 
-    return esp_lcd_panel_draw_bitmap(ctx->panel, x, y, x + w, y + h, img_rgb565);
+    return display_image_blit(ctx, x, y, w, h, img_rgb565);
 }
 
-esp_err_t display_image_draw_test_pattern_streaming(display_image_t *ctx, int block_rows)
+/* Stream a rect band by band; ping-pong DMA on the display_api panel, one block buffer otherwise. */
+static esp_err_t display_image_stream_rect(display_image_t *ctx,
+                                           int x,
+                                           int y,
+                                           int w,
+                                           int h,
+                                           int block_rows,
+                                           display_image_band_fn_t producer,
+                                           void *user_ctx)
 {
-    if (!display_image_ctx_valid(ctx) || block_rows <= 0) {
-        return ESP_ERR_INVALID_ARG;
+    if (ctx->panel == display_get_panel_handle()) {
+        /* Ping-pong DMA halves: the next band renders while the previous one is on the wire. */
+        return display_draw_bands(x, y, w, h, block_rows, producer, user_ctx);
     }
 
-    const size_t rows = (size_t)block_rows;
-    const size_t width = (size_t)ctx->width;
-    const size_t alloc_pixels = width * rows;
+    uint16_t *block_buf = ctx->band_buf;
+    if (block_buf != NULL) {
+        const size_t fit_rows = ctx->band_buf_pixels / (size_t)w;
+        if (fit_rows == 0U) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if ((size_t)block_rows > fit_rows) {
+            block_rows = (int)fit_rows;
+        }
+    } else {
+        block_buf = heap_caps_malloc((size_t)w * (size_t)block_rows * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (block_buf == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t err = ESP_OK;
+    for (int row = 0; row < h && err == ESP_OK; row += block_rows) {
+        const int cur_rows = ((h - row) < block_rows) ? (h - row) : block_rows;
+        err = producer(block_buf, row, cur_rows, w, user_ctx);
+        if (err == ESP_OK) {
+            err = esp_lcd_panel_draw_bitmap(ctx->panel, x, y + row, x + w, y + row + cur_rows, block_buf);
+        }
+    }
 
-    uint16_t *block_buf = heap_caps_malloc(alloc_pixels * sizeof(uint16_t), MALLOC_CAP_DMA);
-    if (block_buf == NULL) {
-        return ESP_ERR_NO_MEM;
+    if (block_buf != ctx->band_buf) {
+        heap_caps_free(block_buf);
     }
+    return err;
+}
+
+typedef struct {
+    const uint16_t *src;
+    int src_w;
+    int src_h;
+    display_image_orient_t orient;
+} display_image_rot_t;
+
+/*
+ * Destination rows [row, row + rows) of the turned image. The source is read
+ * in DISPLAY_IMAGE_ROT_TILE squares so both the column walk through the
+ * source and the row walk through the band stay inside a few cache lines.
+ */
+static esp_err_t display_image_rot_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    const display_image_rot_t *rot = (const display_image_rot_t *)user_ctx;
+    const int sw = rot->src_w;
+    const int sh = rot->src_h;
 
-    for (int y = 0; y < (int)ctx->height; y += block_rows) {
-        const int cur_rows = (((int)ctx->height - y) < block_rows) ? ((int)ctx->height - y) : block_rows;
+    if (rot->orient == DISPLAY_IMAGE_ORIENT_180) {
+        for (int r = 0; r < rows; r++) {
+            const uint16_t *src = rot->src + ((size_t)(sh - 1 - (row + r)) * (size_t)sw) + (size_t)(sw - 1);
+            uint16_t *dst = band + ((size_t)r * (size_t)width);
+            for (int c = 0; c < width; c++) {
+                dst[c] = *(src - c);
+            }
+        }
+        return ESP_OK;
+    }
 
-        for (int r = 0; r < cur_rows; r++) {
-            for (int x = 0; x < (int)ctx->width; x++) {
-                const int bar = (x * 8) / (int)ctx->width;
-                const int idx = (bar < 0) ? 0 : ((bar > 7) ? 7 : bar);
-                block_buf[(size_t)r * width + (size_t)x] = s_color_bars[idx];
+    for (int ty = 0; ty < rows; ty += DISPLAY_IMAGE_ROT_TILE) {
+        const int ty1 = ((rows - ty) < DISPLAY_IMAGE_ROT_TILE) ? rows : (ty + DISPLAY_IMAGE_ROT_TILE);
+        for (int tx = 0; tx < width; tx += DISPLAY_IMAGE_ROT_TILE) {
+            const int tx1 = ((width - tx) < DISPLAY_IMAGE_ROT_TILE) ? width : (tx + DISPLAY_IMAGE_ROT_TILE);
+            for (int r = ty; r < ty1; r++) {
+                const int dy = row + r;
+                uint16_t *dst = band + ((size_t)r * (size_t)width);
+                if (rot->orient == DISPLAY_IMAGE_ORIENT_90) {
+                    /* dest (dx, dy) = src (dy, sh - 1 - dx) */
+                    for (int dx = tx; dx < tx1; dx++) {
+                        dst[dx] = rot->src[((size_t)(sh - 1 - dx) * (size_t)sw) + (size_t)dy];
+                    }
+                } else {
+                    /* 270: dest (dx, dy) = src (sw - 1 - dy, dx) */
+                    for (int dx = tx; dx < tx1; dx++) {
+                        dst[dx] = rot->src[((size_t)dx * (size_t)sw) + (size_t)(sw - 1 - dy)];
+                    }
+                }
             }
         }
+    }
+    return ESP_OK;
+}
 
-        esp_err_t err = esp_lcd_panel_draw_bitmap(ctx->panel, 0, y, ctx->width, y + cur_rows, block_buf);
-        if (err != ESP_OK) {
-            free(block_buf);
+esp_err_t display_image_draw_rect_oriented(display_image_t *ctx,
+                                           int x,
+                                           int y,
+                                           int src_w,
+                                           int src_h,
+                                           const uint16_t *img_rgb565,
+                                           size_t pixels,
+                                           display_image_orient_t orient)
+{
+    const bool swapped = (orient == DISPLAY_IMAGE_ORIENT_90) || (orient == DISPLAY_IMAGE_ORIENT_270);
+    const int w = swapped ? src_h : src_w;
+    const int h = swapped ? src_w : src_h;
+    if (orient == DISPLAY_IMAGE_ORIENT_0) {
+        return display_image_draw_rect_rgb565(ctx, x, y, w, h, img_rgb565, pixels);
+    }
+    if (!display_image_ctx_valid(ctx) || img_rgb565 == NULL || src_w <= 0 || src_h <= 0 || x < 0 || y < 0
+        || orient > DISPLAY_IMAGE_ORIENT_270) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((x + w) > (int)ctx->width || (y + h) > (int)ctx->height || pixels < ((size_t)src_w * (size_t)src_h)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const bool own_panel = (ctx->panel == display_get_panel_handle());
+    if (own_panel && x == 0 && y == 0 && w == display_get_width() && h == display_get_height()) {
+        const esp_err_t err = display_draw_frame_rotated(img_rgb565, src_w, src_h, (uint8_t)orient);
+        if (err != ESP_ERR_INVALID_STATE) {
             return err;
         }
+        /* A framebuffer is being composed: fall through to the software turn. */
     }
 
-    free(block_buf);
+    display_image_rot_t rot = {
+        .src = img_rgb565,
+        .src_w = src_w,
+        .src_h = src_h,
+        .orient = orient,
+    };
+    /* display_draw_bands() caps this to half its DMA buffer; other panels get a modest block. */
+    const int block_rows = own_panel ? h : DISPLAY_IMG_DEFAULT_BLOCK_ROWS;
+    return display_image_stream_rect(ctx, x, y, w, h, block_rows, display_image_rot_band, &rot);
+}
+
+esp_err_t display_image_draw_streaming(display_image_t *ctx, int block_rows, display_image_band_fn_t producer, void *user_ctx)
+{
+    if (!display_image_ctx_valid(ctx) || block_rows <= 0 || producer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return display_image_stream_rect(ctx, 0, 0, ctx->width, ctx->height, block_rows, producer, user_ctx);
+}
+
+static esp_err_t display_image_color_bars_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    (void)row;
+    (void)user_ctx;
+
+    for (int x = 0; x < width; x++) {
+        const int bar = (x * 8) / width;
+        band[x] = s_color_bars[(bar > 7) ? 7 : bar];
+    }
+    for (int r = 1; r < rows; r++) {
+        memcpy(&band[(size_t)r * (size_t)width], band, (size_t)width * sizeof(uint16_t));
+    }
     return ESP_OK;
 }
+
+esp_err_t display_image_draw_test_pattern_streaming(display_image_t *ctx, int block_rows)
+{
+    return display_image_draw_streaming(ctx, block_rows, display_image_color_bars_band, NULL);
+}
+
+static uint16_t display_img_rd16(const uint8_t *p)
+{
+    return (uint16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+esp_err_t display_img_parse(const void *blob, size_t len, display_img_info_t *out_info)
+{
+    if (blob == NULL || out_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *p = blob;
+    if (len < DISPLAY_IMG_HEADER_SIZE || memcmp(p, "DIMG", 4) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (p[4] != DISPLAY_IMG_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    const display_img_format_t format = (display_img_format_t)p[5];
+    const uint16_t width = display_img_rd16(&p[6]);
+    const uint16_t height = display_img_rd16(&p[8]);
+    const uint16_t palette_count = display_img_rd16(&p[10]);
+    if (width == 0U || height == 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint16_t palette_max = 0U;
+    switch (format) {
+    case DISPLAY_IMG_FORMAT_RLE16:
+        palette_max = 0U;
+        break;
+    case DISPLAY_IMG_FORMAT_PAL8_RLE:
+        palette_max = 256U;
+        break;
+    case DISPLAY_IMG_FORMAT_PAL4:
+        palette_max = 16U;
+        break;
+    default:
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (palette_count > palette_max || (palette_max > 0U && palette_count == 0U)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const size_t palette_bytes = (size_t)palette_count * sizeof(uint16_t);
+    if (len < DISPLAY_IMG_HEADER_SIZE + palette_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const size_t data_len = len - DISPLAY_IMG_HEADER_SIZE - palette_bytes;
+    if (format == DISPLAY_IMG_FORMAT_PAL4 && data_len < (((size_t)width + 1U) / 2U) * (size_t)height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    out_info->width = width;
+    out_info->height = height;
+    out_info->format = format;
+    out_info->palette_count = palette_count;
+    out_info->palette = p + DISPLAY_IMG_HEADER_SIZE;
+    out_info->data = p + DISPLAY_IMG_HEADER_SIZE + palette_bytes;
+    out_info->data_len = data_len;
+    return ESP_OK;
+}
+
+/*
+ * Resumable decoder: one band call consumes exactly rows * width pixels, and a
+ * packet cut at the band edge continues in the next call. The palette is
+ * copied out of flash once so the inner loops only read the pixel stream.
+ */
+typedef struct {
+    display_img_info_t info;
+    size_t pos;
+    uint32_t packet_left; /* pixels left in the current packet */
+    bool packet_repeat;
+    uint16_t repeat_color;
+    uint16_t palette[256];
+} display_img_decoder_t;
+
+static display_img_decoder_t s_img_decoder;
+static bool s_img_decoder_busy;
+
+static esp_err_t display_img_next_packet(display_img_decoder_t *dec)
+{
+    const display_img_info_t *info = &dec->info;
+    const size_t value_bytes = (info->format == DISPLAY_IMG_FORMAT_RLE16) ? 2U : 1U;
+    if (dec->pos >= info->data_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t hdr = info->data[dec->pos++];
+    dec->packet_repeat = (hdr & 0x80U) != 0U;
+    dec->packet_left = (uint32_t)(hdr & 0x7FU) + 1U;
+    const size_t need = dec->packet_repeat ? value_bytes : (size_t)dec->packet_left * value_bytes;
+    if (need > info->data_len - dec->pos) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!dec->packet_repeat) {
+        return ESP_OK;
+    }
+
+    if (value_bytes == 2U) {
+        dec->repeat_color = display_img_rd16(&info->data[dec->pos]);
+    } else {
+        const uint8_t index = info->data[dec->pos];
+        if (index >= info->palette_count) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        dec->repeat_color = dec->palette[index];
+    }
+    dec->pos += value_bytes;
+    return ESP_OK;
+}
+
+static esp_err_t display_img_decode_rle(display_img_decoder_t *dec, uint16_t *out, size_t pixels)
+{
+    const display_img_info_t *info = &dec->info;
+    while (pixels > 0U) {
+        if (dec->packet_left == 0U) {
+            ESP_RETURN_ON_ERROR(display_img_next_packet(dec), TAG, "corrupt image data at %u", (unsigned)dec->pos);
+        }
+
+        const size_t take = (dec->packet_left < pixels) ? dec->packet_left : pixels;
+        if (dec->packet_repeat) {
+            for (size_t i = 0U; i < take; i++) {
+                out[i] = dec->repeat_color;
+            }
+        } else if (info->format == DISPLAY_IMG_FORMAT_RLE16) {
+            /* Byte-wise reads: the blob may sit unaligned in mapped flash. */
+            const uint8_t *src = &info->data[dec->pos];
+            for (size_t i = 0U; i < take; i++) {
+                out[i] = display_img_rd16(&src[i * 2U]);
+            }
+            dec->pos += take * 2U;
+        } else {
+            const uint8_t *src = &info->data[dec->pos];
+            for (size_t i = 0U; i < take; i++) {
+                if (src[i] >= info->palette_count) {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                out[i] = dec->palette[src[i]];
+            }
+            dec->pos += take;
+        }
+
+        dec->packet_left -= (uint32_t)take;
+        out += take;
+        pixels -= take;
+    }
+    return ESP_OK;
+}
+
+static void display_img_decode_pal4(const display_img_decoder_t *dec, uint16_t *out, int row, int rows, int width)
+{
+    /* Fixed row stride, so a band starts at a computed offset rather than a running cursor. */
+    const size_t stride = ((size_t)width + 1U) / 2U;
+    for (int r = 0; r < rows; r++) {
+        const uint8_t *src = &dec->info.data[(size_t)(row + r) * stride];
+        for (int px = 0; px < width; px += 2) {
+            const uint8_t packed = src[px / 2];
+            *out++ = dec->palette[packed >> 4];
+            if (px + 1 < width) {
+                *out++ = dec->palette[packed & 0x0FU];
+            }
+        }
+    }
+}
+
+static esp_err_t display_img_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    display_img_decoder_t *dec = user_ctx;
+    if (dec->info.format == DISPLAY_IMG_FORMAT_PAL4) {
+        display_img_decode_pal4(dec, band, row, rows, width);
+        return ESP_OK;
+    }
+    return display_img_decode_rle(dec, band, (size_t)rows * (size_t)width);
+}
+
+esp_err_t display_image_draw_compressed(display_image_t *ctx, int x, int y, const void *blob, size_t len, int block_rows)
+{
+    if (!display_image_ctx_valid(ctx) || x < 0 || y < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    display_img_info_t info;
+    ESP_RETURN_ON_ERROR(display_img_parse(blob, len, &info), TAG, "invalid image");
+    const int w = info.width;
+    const int h = info.height;
+    if ((x + w) > (int)ctx->width || (y + h) > (int)ctx->height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* One static decoder: the palette copy alone is 512 B, too much for callers' stacks. */
+    if (__atomic_test_and_set(&s_img_decoder_busy, __ATOMIC_ACQUIRE)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    display_img_decoder_t *dec = &s_img_decoder;
+    memset(dec, 0, offsetof(display_img_decoder_t, palette));
+    dec->info = info;
+    for (uint16_t i = 0U; i < dec->info.palette_count; i++) {
+        dec->palette[i] = display_img_rd16(&dec->info.palette[(size_t)i * 2U]);
+    }
+    /* PAL4 nibbles past palette_count decode as palette[0] instead of reading stale entries. */
+    for (uint16_t i = dec->info.palette_count; i < 16U; i++) {
+        dec->palette[i] = (dec->info.palette_count > 0U) ? dec->palette[0] : 0U;
+    }
+
+    if (block_rows <= 0) {
+        /* display_draw_bands() caps this to half its DMA buffer; other panels get a modest block. */
+        block_rows = (ctx->panel == display_get_panel_handle()) ? h : DISPLAY_IMG_DEFAULT_BLOCK_ROWS;
+    }
+    const esp_err_t err = display_image_stream_rect(ctx, x, y, w, h, block_rows, display_img_band, dec);
+    __atomic_clear(&s_img_decoder_busy, __ATOMIC_RELEASE);
+    return err;
+}
@@ -0,0 +1,340 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "display_server.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define DISPLAY_SERVER_DEFAULT_STACK 4096U
+#define DISPLAY_SERVER_DEFAULT_PRIORITY 4U
+#define DISPLAY_SERVER_QUEUE_MASK (DISPLAY_SERVER_QUEUE_LEN - 1U)
+
+_Static_assert((DISPLAY_SERVER_QUEUE_LEN & DISPLAY_SERVER_QUEUE_MASK) == 0U, "queue length must be a power of two");
+
+static const char *TAG = "display_server";
+
+typedef enum {
+    DISPLAY_CMD_RECT = 0,
+    DISPLAY_CMD_TEXT,
+    DISPLAY_CMD_BACKLIGHT,
+    DISPLAY_CMD_CALL,
+} display_cmd_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t scale;
+    uint8_t spacing;
+    uint8_t percent;
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    uint16_t fg;
+    uint16_t bg;
+    display_fb_t *fb;
+    display_server_fn_t fn;
+    void *arg;
+    char text[DISPLAY_SERVER_TEXT_MAX];
+} display_cmd_t;
+
+/*
+ * Bounded MPSC ring (per-slot sequence numbers): producers claim a slot with
+ * one CAS on enq_pos and publish it by storing seq = pos + 1; the render task
+ * is the only consumer, so deq_pos needs no atomics.
+ */
+typedef struct {
+    atomic_uint seq;
+    display_cmd_t cmd;
+} display_slot_t;
+
+typedef struct {
+    bool running;
+    TaskHandle_t task;
+    uint16_t frame_period_ms;
+    atomic_uint enq_pos;
+    unsigned deq_pos;
+    atomic_uint dropped;
+    display_slot_t ring[DISPLAY_SERVER_QUEUE_LEN];
+    display_cmd_t batch[DISPLAY_SERVER_QUEUE_LEN];
+    bool skip[DISPLAY_SERVER_QUEUE_LEN];
+} display_server_ctx_t;
+
+static display_server_ctx_t g_srv = {0};
+
+static esp_err_t ring_push(const display_cmd_t *cmd)
+{
+    if (!g_srv.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    unsigned pos = atomic_load_explicit(&g_srv.enq_pos, memory_order_relaxed);
+    display_slot_t *slot = NULL;
+    for (;;) {
+        slot = &g_srv.ring[pos & DISPLAY_SERVER_QUEUE_MASK];
+        const unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_srv.enq_pos, &pos, pos + 1U,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&g_srv.dropped, 1U, memory_order_relaxed);
+            return ESP_ERR_NO_MEM;
+        } else {
+            pos = atomic_load_explicit(&g_srv.enq_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->cmd = *cmd;
+    atomic_store_explicit(&slot->seq, pos + 1U, memory_order_release);
+    xTaskNotifyGive(g_srv.task);
+    return ESP_OK;
+}
+
+static bool ring_pop(display_cmd_t *out)
+{
+    display_slot_t *slot = &g_srv.ring[g_srv.deq_pos & DISPLAY_SERVER_QUEUE_MASK];
+    const unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if ((int)(seq - (g_srv.deq_pos + 1U)) < 0) {
+        return false;
+    }
+
+    *out = slot->cmd;
+    atomic_store_explicit(&slot->seq, g_srv.deq_pos + DISPLAY_SERVER_QUEUE_LEN, memory_order_release);
+    g_srv.deq_pos++;
+    return true;
+}
+
+/* Screen area a command paints fully; false for commands with arbitrary side effects. */
+static bool cmd_opaque_rect(const display_cmd_t *cmd, display_rect_t *out)
+{
+    if (cmd->type == DISPLAY_CMD_RECT) {
+        *out = (display_rect_t){cmd->x, cmd->y, cmd->w, cmd->h};
+        return true;
+    }
+    if (cmd->type == DISPLAY_CMD_TEXT) {
+        *out = (display_rect_t){cmd->x, cmd->y, display_get_text_width(cmd->text, cmd->scale, cmd->spacing), 7 * cmd->scale};
+        return true;
+    }
+    return false;
+}
+
+static bool rect_contains(const display_rect_t *outer, const display_rect_t *inner)
+{
+    return inner->x >= outer->x && inner->y >= outer->y
+           && (inner->x + inner->w) <= (outer->x + outer->w)
+           && (inner->y + inner->h) <= (outer->y + outer->h);
+}
+
+/*
+ * Cull pass: an opaque command fully overdrawn by a later opaque command of
+ * the same target is skipped, and only the last backlight change is kept.
+ * Calls act as barriers since they may draw anything.
+ */
+static void batch_cull(size_t count)
+{
+    int last_backlight = -1;
+    for (size_t i = 0; i < count; i++) {
+        g_srv.skip[i] = false;
+        if (g_srv.batch[i].type == DISPLAY_CMD_BACKLIGHT) {
+            if (last_backlight >= 0) {
+                g_srv.skip[last_backlight] = true;
+            }
+            last_backlight = (int)i;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        display_rect_t ri;
+        if (!cmd_opaque_rect(&g_srv.batch[i], &ri)) {
+            continue;
+        }
+        for (size_t j = i + 1U; j < count; j++) {
+            const display_cmd_t *later = &g_srv.batch[j];
+            if (later->type == DISPLAY_CMD_CALL) {
+                break;
+            }
+            display_rect_t rj;
+            if (later->fb == g_srv.batch[i].fb && cmd_opaque_rect(later, &rj) && rect_contains(&rj, &ri)) {
+                g_srv.skip[i] = true;
+                break;
+            }
+        }
+    }
+}
+
+static void batch_render(size_t count)
+{
+    display_fb_t *composing = NULL;
+
+    batch_cull(count);
+    for (size_t i = 0; i < count; i++) {
+        const display_cmd_t *cmd = &g_srv.batch[i];
+        if (g_srv.skip[i]) {
+            continue;
+        }
+
+        /* Consecutive commands for the same framebuffer share one begin/flush. */
+        display_fb_t *target = (cmd->type == DISPLAY_CMD_RECT || cmd->type == DISPLAY_CMD_TEXT) ? cmd->fb : NULL;
+        if (target != composing) {
+            if (composing != NULL) {
+                (void)display_flush();
+                composing = NULL;
+            }
+            if (target != NULL && display_fb_begin(target) == ESP_OK) {
+                composing = target;
+            }
+        }
+
+        switch (cmd->type) {
+        case DISPLAY_CMD_RECT:
+            display_draw_rect(cmd->x, cmd->y, cmd->w, cmd->h, cmd->fg);
+            break;
+        case DISPLAY_CMD_TEXT:
+            display_draw_text_run(cmd->x, cmd->y, cmd->text, cmd->fg, cmd->bg, cmd->scale, cmd->spacing);
+            break;
+        case DISPLAY_CMD_BACKLIGHT:
+            display_backlight_set(cmd->percent);
+            break;
+        case DISPLAY_CMD_CALL:
+            cmd->fn(cmd->arg);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (composing != NULL) {
+        (void)display_flush();
+    }
+}
+
+static void display_server_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        TickType_t frame_start = xTaskGetTickCount();
+
+        size_t count = 0;
+        while (ring_pop(&g_srv.batch[count])) {
+            count++;
+            if (count == DISPLAY_SERVER_QUEUE_LEN) {
+                batch_render(count);
+                count = 0;
+            }
+        }
+        if (count > 0U) {
+            batch_render(count);
+        }
+
+        if (g_srv.frame_period_ms > 0U) {
+            /* Let posts accumulate into the next batch instead of rendering each one. */
+            vTaskDelayUntil(&frame_start, pdMS_TO_TICKS(g_srv.frame_period_ms));
+        }
+    }
+}
+
+esp_err_t display_server_start(const display_server_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(!g_srv.running, ESP_ERR_INVALID_STATE, TAG, "render task already running");
+    ESP_RETURN_ON_FALSE(display_get_panel_handle() != NULL, ESP_ERR_INVALID_STATE, TAG, "display not initialized");
+
+    const uint32_t stack = (cfg != NULL && cfg->task_stack != 0U) ? cfg->task_stack : DISPLAY_SERVER_DEFAULT_STACK;
+    const uint8_t prio = (cfg != NULL && cfg->task_priority != 0U) ? cfg->task_priority : DISPLAY_SERVER_DEFAULT_PRIORITY;
+    g_srv.frame_period_ms = (cfg != NULL) ? cfg->frame_period_ms : 0U;
+
+    for (unsigned i = 0; i < DISPLAY_SERVER_QUEUE_LEN; i++) {
+        atomic_init(&g_srv.ring[i].seq, i);
+    }
+    atomic_init(&g_srv.enq_pos, 0U);
+    atomic_init(&g_srv.dropped, 0U);
+    g_srv.deq_pos = 0U;
+
+    ESP_RETURN_ON_FALSE(xTaskCreate(display_server_task, "display_srv", stack, NULL, prio, &g_srv.task) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "render task create failed");
+    g_srv.running = true;
+    ESP_LOGI(TAG, "render task started (queue=%u, frame=%u ms)", (unsigned)DISPLAY_SERVER_QUEUE_LEN,
+             (unsigned)g_srv.frame_period_ms);
+    return ESP_OK;
+}
+
+bool display_server_running(void)
+{
+    return g_srv.running;
+}
+
+esp_err_t display_server_post_rect(int x, int y, int w, int h, uint16_t rgb565, display_fb_t *fb)
+{
+    const display_cmd_t cmd = {
+        .type = DISPLAY_CMD_RECT,
+        .x = (int16_t)x,
+        .y = (int16_t)y,
+        .w = (int16_t)w,
+        .h = (int16_t)h,
+        .fg = rgb565,
+        .fb = fb,
+    };
+    return ring_push(&cmd);
+}
+
+esp_err_t display_server_post_text(int x,
+                                   int y,
+                                   const char *s,
+                                   uint16_t fg_rgb565,
+                                   uint16_t bg_rgb565,
+                                   uint8_t scale,
+                                   uint8_t char_spacing_px,
+                                   display_fb_t *fb)
+{
+    ESP_RETURN_ON_FALSE(s != NULL && strlen(s) < DISPLAY_SERVER_TEXT_MAX, ESP_ERR_INVALID_ARG, TAG, "text too long");
+
+    display_cmd_t cmd = {
+        .type = DISPLAY_CMD_TEXT,
+        .scale = (scale == 0U) ? 1U : scale,
+        .spacing = char_spacing_px,
+        .x = (int16_t)x,
+        .y = (int16_t)y,
+        .fg = fg_rgb565,
+        .bg = bg_rgb565,
+        .fb = fb,
+    };
+    strlcpy(cmd.text, s, sizeof(cmd.text));
+    return ring_push(&cmd);
+}
+
+esp_err_t display_server_post_backlight(uint8_t percent)
+{
+    const display_cmd_t cmd = {
+        .type = DISPLAY_CMD_BACKLIGHT,
+        .percent = percent,
+    };
+    return ring_push(&cmd);
+}
+
+esp_err_t display_server_post_call(display_server_fn_t fn, void *arg)
+{
+    ESP_RETURN_ON_FALSE(fn != NULL, ESP_ERR_INVALID_ARG, TAG, "fn is null");
+
+    const display_cmd_t cmd = {
+        .type = DISPLAY_CMD_CALL,
+        .fn = fn,
+        .arg = arg,
+    };
+    return ring_push(&cmd);
+}
+
+uint32_t display_server_get_dropped(void)
+{
+    return atomic_load_explicit(&g_srv.dropped, memory_order_relaxed);
+}
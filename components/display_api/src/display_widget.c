@@ -0,0 +1,357 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "display_widget.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#define DISPLAY_WIDGET_SPARK_NONE 0xFFU
+
+static const char *TAG = "display_widget";
+
+static void widget_init(display_widget_t *widget,
+                        display_widget_kind_t kind,
+                        const display_rect_t *box,
+                        uint16_t fg_rgb565,
+                        uint16_t bg_rgb565)
+{
+    memset(widget, 0, sizeof(*widget));
+    widget->kind = kind;
+    widget->box = *box;
+    widget->fg = fg_rgb565;
+    widget->bg = bg_rgb565;
+    widget->dirty = true;
+}
+
+/* Setters record under the screen lock; a widget not yet on a screen has no concurrent reader. */
+static void widget_lock(display_widget_t *widget)
+{
+    if (widget->screen != NULL) {
+        portENTER_CRITICAL(&widget->screen->lock);
+    }
+}
+
+static void widget_unlock(display_widget_t *widget)
+{
+    if (widget->screen != NULL) {
+        portEXIT_CRITICAL(&widget->screen->lock);
+    }
+}
+
+void display_widget_label_init(display_widget_t *widget,
+                               const display_rect_t *box,
+                               uint16_t fg_rgb565,
+                               uint16_t bg_rgb565,
+                               uint8_t scale,
+                               bool centered)
+{
+    if (widget == NULL || box == NULL) {
+        return;
+    }
+    widget_init(widget, DISPLAY_WIDGET_LABEL, box, fg_rgb565, bg_rgb565);
+    widget->scale = (scale > 0U) ? scale : 1U;
+    widget->centered = centered;
+}
+
+void display_widget_number_init(display_widget_t *widget,
+                                const display_rect_t *box,
+                                uint16_t fg_rgb565,
+                                uint16_t bg_rgb565,
+                                uint8_t scale,
+                                bool centered,
+                                const char *fmt)
+{
+    if (widget == NULL || box == NULL || fmt == NULL) {
+        return;
+    }
+    display_widget_label_init(widget, box, fg_rgb565, bg_rgb565, scale, centered);
+    widget->kind = DISPLAY_WIDGET_NUMBER;
+    widget->fmt = fmt;
+}
+
+void display_widget_bar_init(display_widget_t *widget,
+                             const display_rect_t *box,
+                             uint16_t fg_rgb565,
+                             uint16_t bg_rgb565,
+                             float min,
+                             float max)
+{
+    if (widget == NULL || box == NULL) {
+        return;
+    }
+    widget_init(widget, DISPLAY_WIDGET_BAR, box, fg_rgb565, bg_rgb565);
+    widget->min = min;
+    widget->max = (max > min) ? max : (min + 1.0f);
+}
+
+void display_widget_sparkline_init(display_widget_t *widget,
+                                   const display_rect_t *box,
+                                   uint16_t fg_rgb565,
+                                   uint16_t bg_rgb565,
+                                   float min_span)
+{
+    if (widget == NULL || box == NULL) {
+        return;
+    }
+    widget_init(widget, DISPLAY_WIDGET_SPARKLINE, box, fg_rgb565, bg_rgb565);
+    if (widget->box.w > (int)DISPLAY_WIDGET_SPARK_MAX) {
+        widget->box.w = (int)DISPLAY_WIDGET_SPARK_MAX;
+    }
+    if (widget->box.h > (int)DISPLAY_WIDGET_SPARK_NONE) {
+        widget->box.h = (int)DISPLAY_WIDGET_SPARK_NONE;
+    }
+    widget->max = (min_span > 0.0f) ? min_span : 0.0f;
+}
+
+void display_widget_set_text(display_widget_t *widget, const char *text)
+{
+    if (widget == NULL || text == NULL) {
+        return;
+    }
+    widget_lock(widget);
+    if (strncmp(widget->want.text, text, sizeof(widget->want.text) - 1U) != 0) {
+        strncpy(widget->want.text, text, sizeof(widget->want.text) - 1U);
+        widget->want.text[sizeof(widget->want.text) - 1U] = '\0';
+        widget->dirty = true;
+    }
+    widget_unlock(widget);
+}
+
+void display_widget_set_value(display_widget_t *widget, float value)
+{
+    if (widget == NULL) {
+        return;
+    }
+    if (widget->kind == DISPLAY_WIDGET_NUMBER) {
+        char text[DISPLAY_WIDGET_TEXT_MAX];
+        snprintf(text, sizeof(text), widget->fmt, (double)value);
+        display_widget_set_text(widget, text);
+        return;
+    }
+    if (widget->kind != DISPLAY_WIDGET_BAR) {
+        return;
+    }
+
+    float frac = (value - widget->min) / (widget->max - widget->min);
+    frac = (frac < 0.0f) ? 0.0f : ((frac > 1.0f) ? 1.0f : frac);
+    const uint16_t fill_px = (uint16_t)((frac * (float)widget->box.w) + 0.5f);
+    widget_lock(widget);
+    if (widget->want.fill_px != fill_px) {
+        widget->want.fill_px = fill_px;
+        widget->dirty = true;
+    }
+    widget_unlock(widget);
+}
+
+void display_widget_set_series(display_widget_t *widget, const float *values, size_t count)
+{
+    if (widget == NULL || widget->kind != DISPLAY_WIDGET_SPARKLINE || (values == NULL && count > 0U)) {
+        return;
+    }
+
+    const size_t cols = (size_t)widget->box.w;
+    const size_t n = (count < cols) ? count : cols;
+    values += count - n;
+
+    float lo = 0.0f;
+    float hi = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        lo = (i == 0U || values[i] < lo) ? values[i] : lo;
+        hi = (i == 0U || values[i] > hi) ? values[i] : hi;
+    }
+    if ((hi - lo) < widget->max) {
+        const float mid = (hi + lo) * 0.5f;
+        lo = mid - (widget->max * 0.5f);
+        hi = mid + (widget->max * 0.5f);
+    }
+    const float span = (hi > lo) ? (hi - lo) : 1.0f;
+    const float rows = (float)(widget->box.h - 1);
+
+    uint8_t spark_y[DISPLAY_WIDGET_SPARK_MAX];
+    for (size_t i = 0; i < n; i++) {
+        spark_y[i] = (uint8_t)(rows - (((values[i] - lo) / span) * rows) + 0.5f);
+    }
+
+    widget_lock(widget);
+    if (widget->want.spark_len != n || memcmp(widget->want.spark_y, spark_y, n) != 0) {
+        widget->want.spark_len = (uint16_t)n;
+        memcpy(widget->want.spark_y, spark_y, n);
+        widget->dirty = true;
+    }
+    widget_unlock(widget);
+}
+
+/* Opaque text plus the strips a wider previous string leaves behind. */
+static void widget_draw_text(display_widget_t *widget, const char *text)
+{
+    const display_rect_t *b = &widget->box;
+    const int tw = display_get_text_width(text, widget->scale, 0U);
+    int tx = widget->centered ? (b->x + ((b->w - tw) / 2)) : b->x;
+    tx = (tx < b->x) ? b->x : tx;
+    const int ty = b->y + ((b->h - display_get_text_height(widget->scale)) / 2);
+
+    if (!widget->drawn) {
+        display_draw_rect(b->x, b->y, b->w, b->h, widget->bg);
+    } else {
+        if (widget->drawn_x0 < tx) {
+            display_draw_rect(widget->drawn_x0, b->y, tx - widget->drawn_x0, b->h, widget->bg);
+        }
+        if (widget->drawn_x1 > (tx + tw)) {
+            display_draw_rect(tx + tw, b->y, widget->drawn_x1 - (tx + tw), b->h, widget->bg);
+        }
+    }
+    if (tw > 0) {
+        display_draw_text_run(tx, ty, text, widget->fg, widget->bg, widget->scale, 0U);
+    }
+    widget->drawn_x0 = (int16_t)tx;
+    widget->drawn_x1 = (int16_t)(tx + tw);
+}
+
+static void widget_draw_bar(display_widget_t *widget, uint16_t fill_px)
+{
+    const display_rect_t *b = &widget->box;
+    if (!widget->drawn) {
+        display_draw_rect(b->x, b->y, fill_px, b->h, widget->fg);
+        display_draw_rect(b->x + fill_px, b->y, b->w - fill_px, b->h, widget->bg);
+    } else if (fill_px > widget->drawn_fill_px) {
+        display_draw_rect(b->x + widget->drawn_fill_px, b->y, fill_px - widget->drawn_fill_px, b->h, widget->fg);
+    } else if (fill_px < widget->drawn_fill_px) {
+        display_draw_rect(b->x + fill_px, b->y, widget->drawn_fill_px - fill_px, b->h, widget->bg);
+    }
+    widget->drawn_fill_px = fill_px;
+}
+
+/* Each column is the vertical segment from the previous sample to this one; only moved segments are redrawn. */
+static void widget_draw_sparkline(display_widget_t *widget, const display_widget_state_t *st)
+{
+    const display_rect_t *b = &widget->box;
+    if (!widget->drawn) {
+        display_draw_rect(b->x, b->y, b->w, b->h, widget->bg);
+        memset(widget->drawn_top, DISPLAY_WIDGET_SPARK_NONE, sizeof(widget->drawn_top));
+        memset(widget->drawn_bot, DISPLAY_WIDGET_SPARK_NONE, sizeof(widget->drawn_bot));
+    }
+
+    const int first = b->w - (int)st->spark_len;
+    for (int col = 0; col < b->w; col++) {
+        uint8_t top = DISPLAY_WIDGET_SPARK_NONE;
+        uint8_t bot = DISPLAY_WIDGET_SPARK_NONE;
+        if (col >= first) {
+            const int i = col - first;
+            const uint8_t y = st->spark_y[i];
+            const uint8_t prev = (i > 0) ? st->spark_y[i - 1] : y;
+            top = (y < prev) ? y : prev;
+            bot = (y < prev) ? prev : y;
+        }
+        if (widget->drawn_top[col] == top && widget->drawn_bot[col] == bot) {
+            continue;
+        }
+        if (widget->drawn_top[col] != DISPLAY_WIDGET_SPARK_NONE) {
+            display_draw_rect(b->x + col, b->y + widget->drawn_top[col], 1, widget->drawn_bot[col] - widget->drawn_top[col] + 1,
+                              widget->bg);
+        }
+        if (top != DISPLAY_WIDGET_SPARK_NONE) {
+            display_draw_rect(b->x + col, b->y + top, 1, bot - top + 1, widget->fg);
+        }
+        widget->drawn_top[col] = top;
+        widget->drawn_bot[col] = bot;
+    }
+}
+
+void display_screen_init(display_screen_t *screen, display_fb_t *fb)
+{
+    if (screen == NULL) {
+        return;
+    }
+    memset(screen, 0, sizeof(*screen));
+    screen->fb = fb;
+    screen->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+}
+
+esp_err_t display_screen_add(display_screen_t *screen, display_widget_t *widget)
+{
+    ESP_RETURN_ON_FALSE(screen != NULL && widget != NULL, ESP_ERR_INVALID_ARG, TAG, "screen or widget is null");
+    ESP_RETURN_ON_FALSE(widget->screen == NULL, ESP_ERR_INVALID_STATE, TAG, "widget already on a screen");
+    ESP_RETURN_ON_FALSE(screen->count < DISPLAY_SCREEN_MAX_WIDGETS, ESP_ERR_NO_MEM, TAG, "screen full");
+
+    portENTER_CRITICAL(&screen->lock);
+    widget->screen = screen;
+    screen->widgets[screen->count++] = widget;
+    portEXIT_CRITICAL(&screen->lock);
+    return ESP_OK;
+}
+
+void display_screen_invalidate(display_screen_t *screen)
+{
+    if (screen == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&screen->lock);
+    screen->invalidate = true;
+    portEXIT_CRITICAL(&screen->lock);
+}
+
+esp_err_t display_screen_render(display_screen_t *screen, size_t *redrawn)
+{
+    ESP_RETURN_ON_FALSE(screen != NULL, ESP_ERR_INVALID_ARG, TAG, "screen is null");
+
+    portENTER_CRITICAL(&screen->lock);
+    const bool invalidate = screen->invalidate;
+    const uint8_t count = screen->count;
+    screen->invalidate = false;
+    portEXIT_CRITICAL(&screen->lock);
+
+    size_t drawn = 0;
+    bool composing = false;
+    /* One widget's snapshot at a time keeps the render task's stack small. */
+    display_widget_state_t st;
+    for (uint8_t i = 0; i < count; i++) {
+        display_widget_t *widget = screen->widgets[i];
+        portENTER_CRITICAL(&screen->lock);
+        const bool dirty = widget->dirty || invalidate;
+        if (dirty) {
+            st = widget->want;
+            widget->dirty = false;
+        }
+        portEXIT_CRITICAL(&screen->lock);
+        if (!dirty) {
+            continue;
+        }
+
+        if (drawn == 0U && screen->fb != NULL) {
+            composing = (display_fb_begin(screen->fb) == ESP_OK);
+        }
+        if (invalidate) {
+            widget->drawn = false;
+        }
+        switch (widget->kind) {
+        case DISPLAY_WIDGET_LABEL:
+        case DISPLAY_WIDGET_NUMBER:
+            widget_draw_text(widget, st.text);
+            break;
+        case DISPLAY_WIDGET_BAR:
+            widget_draw_bar(widget, st.fill_px);
+            break;
+        case DISPLAY_WIDGET_SPARKLINE:
+            widget_draw_sparkline(widget, &st);
+            break;
+        default:
+            break;
+        }
+        widget->drawn = true;
+        drawn++;
+    }
+
+    esp_err_t err = ESP_OK;
+    if (composing) {
+        err = display_flush();
+    }
+    if (redrawn != NULL) {
+        *redrawn = drawn;
+    }
+    return err;
+}
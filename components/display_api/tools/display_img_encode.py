@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: 0BSD
+"""Encode an image into the DIMG format decoded by display_image_draw_compressed().
+
+    display_img_encode.py logo.png logo.dimg [--format auto|rle16|pal8|pal4]
+
+Pixels are quantized to RGB565 first; "auto" keeps the smallest encoding the
+color count allows. Embed the result with EMBED_FILES (or write it to a data
+partition and esp_partition_mmap() it): the decoder reads it in place.
+"""
+
+import argparse
+import struct
+import sys
+
+FORMAT_RLE16 = 1
+FORMAT_PAL8_RLE = 2
+FORMAT_PAL4 = 3
+VERSION = 1
+MAX_RUN = 128
+
+
+def to_rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def rle(values, pack):
+    """Packets: 0x80|(n-1) + value for runs, (n-1) + n values for literals."""
+    out = bytearray()
+    i = 0
+    n = len(values)
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_RUN and values[i + run] == values[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out += pack(values[i])
+            i += run
+            continue
+        start = i
+        # Literal until the next run of 2+ (a run of 2 costs the same as 2 literals but ends the packet).
+        while i < n and i - start < MAX_RUN and not (i + 2 < n and values[i] == values[i + 1] == values[i + 2]):
+            i += 1
+        out.append(i - start - 1)
+        for v in values[start:i]:
+            out += pack(v)
+    return bytes(out)
+
+
+def encode(width, height, pixels, fmt):
+    colors = sorted(set(pixels))
+    palette = b""
+    if fmt == FORMAT_RLE16:
+        data = rle(pixels, lambda v: struct.pack("<H", v))
+        colors = []
+    else:
+        index = {c: i for i, c in enumerate(colors)}
+        idx = [index[p] for p in pixels]
+        if fmt == FORMAT_PAL8_RLE:
+            data = rle(idx, lambda v: bytes((v,)))
+        else:
+            rows = bytearray()
+            for y in range(height):
+                row = idx[y * width:(y + 1) * width] + [0]
+                for x in range(0, width, 2):
+                    rows.append((row[x] << 4) | row[x + 1])
+            data = bytes(rows)
+        palette = b"".join(struct.pack("<H", c) for c in colors)
+    header = b"DIMG" + struct.pack("<BBHHH", VERSION, fmt, width, height, len(colors))
+    return header + palette + data
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("input")
+    ap.add_argument("output")
+    ap.add_argument("--format", choices=("auto", "rle16", "pal8", "pal4"), default="auto")
+    args = ap.parse_args()
+
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("display_img_encode.py needs Pillow (pip install pillow)")
+
+    img = Image.open(args.input).convert("RGB")
+    width, height = img.size
+    if width > 0xFFFF or height > 0xFFFF:
+        sys.exit("image too large")
+    pixels = [to_rgb565(r, g, b) for (r, g, b) in img.getdata()]
+    ncolors = len(set(pixels))
+
+    candidates = {"rle16": [FORMAT_RLE16], "pal8": [FORMAT_PAL8_RLE], "pal4": [FORMAT_PAL4]}.get(args.format)
+    if candidates is None:
+        candidates = [FORMAT_RLE16]
+        if ncolors <= 256:
+            candidates.append(FORMAT_PAL8_RLE)
+        if ncolors <= 16:
+            candidates.append(FORMAT_PAL4)
+    limit = {FORMAT_RLE16: None, FORMAT_PAL8_RLE: 256, FORMAT_PAL4: 16}
+    for fmt in candidates:
+        if limit[fmt] is not None and ncolors > limit[fmt]:
+            sys.exit(f"{ncolors} colors do not fit the requested palette format")
+
+    blob = min((encode(width, height, pixels, fmt) for fmt in candidates), key=len)
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print(f"{args.output}: {width}x{height}, {ncolors} colors, format {blob[5]}, "
+          f"{len(blob)} B ({100.0 * len(blob) / (width * height * 2):.1f}% of RGB565)")
+
+
+if __name__ == "__main__":
+    main()
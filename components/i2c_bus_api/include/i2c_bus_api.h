@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/**
+ * @file i2c_bus_api.h
+ * @brief Shared I2C master bus on the i2c_master driver, for several devices.
+ *
+ * Each device gets its own driver handle, clock and timeout. A transaction
+ * is a short list of ops (write, read, or write + repeated-start read) that
+ * runs back to back while the bus is held, so a register-select and its
+ * read cost one bus turnaround instead of two. Transactions run either on
+ * the caller (i2c_bus_run) or on the bus worker task (i2c_bus_submit).
+ *
+ * Devices are isolated from each other's failures: a timeout only fails the
+ * transaction of that device, and after I2C_BUS_FAIL_LIMIT consecutive
+ * failures the bus is reset and the device is skipped for
+ * I2C_BUS_COOLDOWN_MS, so a dead sensor stops costing every other device
+ * its full timeout on each cycle.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_BUS_MAX_OPS 4U
+#define I2C_BUS_DEFAULT_QUEUE_DEPTH 8U
+#define I2C_BUS_DEFAULT_TIMEOUT_MS 20U
+#define I2C_BUS_FAIL_LIMIT 3U
+#define I2C_BUS_COOLDOWN_MS 1000U
+
+typedef struct {
+    i2c_port_num_t port; /* -1 = any free port */
+    gpio_num_t sda_gpio;
+    gpio_num_t scl_gpio;
+    bool internal_pullup;
+    uint8_t queue_depth;   /* pending i2c_bus_submit() transactions, 0 = I2C_BUS_DEFAULT_QUEUE_DEPTH */
+    uint8_t task_priority; /* worker task, 0 = 5 */
+} i2c_bus_cfg_t;
+
+/** @brief Bus state; treat as opaque. */
+typedef struct {
+    i2c_master_bus_handle_t handle;
+    SemaphoreHandle_t lock;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+    volatile bool stop;
+} i2c_bus_t;
+
+/** @brief One device on a bus; treat as opaque. */
+typedef struct {
+    i2c_bus_t *bus;
+    i2c_master_dev_handle_t handle;
+    uint16_t addr;
+    uint32_t timeout_ms;
+    uint8_t fail_streak;
+    int64_t cooldown_until_us;
+    uint32_t error_count;
+} i2c_bus_dev_t;
+
+typedef enum {
+    I2C_BUS_OP_WRITE = 0,
+    I2C_BUS_OP_READ,
+    I2C_BUS_OP_WRITE_READ, /* tx, repeated start, rx: one transaction */
+} i2c_bus_op_kind_t;
+
+typedef struct {
+    i2c_bus_op_kind_t kind;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+} i2c_bus_op_t;
+
+/** @brief Async completion; runs on the bus worker task. */
+typedef void (*i2c_bus_done_cb_t)(esp_err_t status, void *user_ctx);
+
+/**
+ * @brief Queued transaction. It and every buffer it points to must stay valid
+ * while pending, which lasts until done_cb returned; resubmitting a pending
+ * transaction (including from its own done_cb) fails with ESP_ERR_INVALID_STATE.
+ */
+typedef struct {
+    i2c_bus_dev_t *dev;
+    i2c_bus_op_t ops[I2C_BUS_MAX_OPS];
+    uint8_t op_count;
+    i2c_bus_done_cb_t done_cb;
+    void *user_ctx;
+    bool pending;
+} i2c_bus_txn_t;
+
+/** @brief Create the master bus and its worker task. */
+esp_err_t i2c_bus_init(i2c_bus_t *bus, const i2c_bus_cfg_t *cfg);
+/**
+ * @brief Stop the worker and delete the bus; every device must be removed first.
+ *
+ * Returns ESP_ERR_TIMEOUT if the worker has not exited in time; the queue and
+ * lock are then left alive and a later call finishes the teardown.
+ */
+esp_err_t i2c_bus_deinit(i2c_bus_t *bus);
+/**
+ * @brief Attach a 7-bit device.
+ * @param timeout_ms Per-op timeout, 0 = I2C_BUS_DEFAULT_TIMEOUT_MS.
+ */
+esp_err_t i2c_bus_add_device(i2c_bus_t *bus, i2c_bus_dev_t *dev, uint16_t addr, uint32_t scl_hz, uint32_t timeout_ms);
+esp_err_t i2c_bus_remove_device(i2c_bus_dev_t *dev);
+/**
+ * @brief Run ops back to back on the calling task, holding the bus.
+ * @return First failing op's error; ESP_ERR_TIMEOUT without touching the bus while the device cools down.
+ */
+esp_err_t i2c_bus_run(i2c_bus_dev_t *dev, const i2c_bus_op_t *ops, size_t op_count);
+/** @brief Queue txn for the worker; ESP_ERR_NO_MEM when the queue is full. */
+esp_err_t i2c_bus_submit(i2c_bus_txn_t *txn);
+
+static inline esp_err_t i2c_bus_write(i2c_bus_dev_t *dev, const uint8_t *tx, size_t tx_len)
+{
+    const i2c_bus_op_t op = {.kind = I2C_BUS_OP_WRITE, .tx = tx, .tx_len = tx_len};
+    return i2c_bus_run(dev, &op, 1U);
+}
+
+static inline esp_err_t i2c_bus_read(i2c_bus_dev_t *dev, uint8_t *rx, size_t rx_len)
+{
+    const i2c_bus_op_t op = {.kind = I2C_BUS_OP_READ, .rx = rx, .rx_len = rx_len};
+    return i2c_bus_run(dev, &op, 1U);
+}
+
+static inline esp_err_t i2c_bus_write_read(i2c_bus_dev_t *dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    const i2c_bus_op_t op = {.kind = I2C_BUS_OP_WRITE_READ, .tx = tx, .tx_len = tx_len, .rx = rx, .rx_len = rx_len};
+    return i2c_bus_run(dev, &op, 1U);
+}
+
+#ifdef __cplusplus
+}
+#endif
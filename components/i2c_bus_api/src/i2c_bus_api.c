@@ -0,0 +1,242 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "i2c_bus_api.h"
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "perf_api.h"
+
+#define I2C_BUS_TASK_STACK 3072U
+#define I2C_BUS_DEFAULT_PRIORITY 5U
+#define I2C_BUS_STOP_WAIT_MS 200U
+
+static const char *TAG = "i2c_bus";
+
+static perf_metric_t s_perf_txn = PERF_HISTOGRAM_INIT("i2c_bus_txn_us", "I2C transaction, bus acquired to last op", NULL);
+static perf_metric_t s_perf_errors = PERF_COUNTER_INIT("i2c_bus_errors_total", "Failed I2C transactions", NULL);
+static perf_metric_t s_perf_resets = PERF_COUNTER_INIT("i2c_bus_resets_total", "Bus resets after repeated device failures", NULL);
+
+static esp_err_t i2c_bus_op_exec(const i2c_bus_dev_t *dev, const i2c_bus_op_t *op)
+{
+    const int timeout_ms = (int)dev->timeout_ms;
+    switch (op->kind) {
+    case I2C_BUS_OP_WRITE:
+        return i2c_master_transmit(dev->handle, op->tx, op->tx_len, timeout_ms);
+    case I2C_BUS_OP_READ:
+        return i2c_master_receive(dev->handle, op->rx, op->rx_len, timeout_ms);
+    case I2C_BUS_OP_WRITE_READ:
+        return i2c_master_transmit_receive(dev->handle, op->tx, op->tx_len, op->rx, op->rx_len, timeout_ms);
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+/*
+ * Run a transaction with the bus held. A device in cooldown fails fast; the
+ * first attempt after the cooldown is a probe that either clears the streak
+ * or starts the next cooldown. The streak and deadline are only touched under
+ * the lock, so the check comes after the take.
+ */
+static esp_err_t i2c_bus_exec(i2c_bus_dev_t *dev, const i2c_bus_op_t *ops, size_t op_count)
+{
+    i2c_bus_t *bus = dev->bus;
+    (void)xSemaphoreTake(bus->lock, portMAX_DELAY);
+    if (dev->fail_streak >= I2C_BUS_FAIL_LIMIT && esp_timer_get_time() < dev->cooldown_until_us) {
+        (void)xSemaphoreGive(bus->lock);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    const int64_t start_us = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < op_count && err == ESP_OK; i++) {
+        err = i2c_bus_op_exec(dev, &ops[i]);
+    }
+    perf_observe_since(&s_perf_txn, start_us);
+
+    if (err == ESP_OK) {
+        dev->fail_streak = 0U;
+    } else {
+        dev->error_count++;
+        perf_count(&s_perf_errors, 1U);
+        if (dev->fail_streak < UINT8_MAX) {
+            dev->fail_streak++;
+        }
+        if (dev->fail_streak >= I2C_BUS_FAIL_LIMIT) {
+            /* A slave stuck mid-byte holds SDA low for everyone: clock it free. */
+            (void)i2c_master_bus_reset(bus->handle);
+            perf_count(&s_perf_resets, 1U);
+            dev->cooldown_until_us = esp_timer_get_time() + ((int64_t)I2C_BUS_COOLDOWN_MS * 1000LL);
+            ESP_LOGW(TAG, "device 0x%02x: %u failures (%s), skipped for %u ms", dev->addr, dev->fail_streak,
+                     esp_err_to_name(err), (unsigned)I2C_BUS_COOLDOWN_MS);
+        }
+    }
+    (void)xSemaphoreGive(bus->lock);
+    return err;
+}
+
+static void i2c_bus_task(void *arg)
+{
+    i2c_bus_t *bus = (i2c_bus_t *)arg;
+
+    while (!bus->stop) {
+        i2c_bus_txn_t *txn = NULL;
+        if (xQueueReceive(bus->queue, &txn, portMAX_DELAY) != pdTRUE || txn == NULL) {
+            continue;
+        }
+        const esp_err_t err = i2c_bus_exec(txn->dev, txn->ops, txn->op_count);
+        if (txn->done_cb != NULL) {
+            txn->done_cb(err, txn->user_ctx);
+        }
+        /* Only after the callback, so an owner waiting on pending knows txn is untouched from here on. */
+        __atomic_store_n(&txn->pending, false, __ATOMIC_RELEASE);
+    }
+
+    /* Last touch of *bus: deinit frees the queue and lock once it sees this. */
+    __atomic_store_n(&bus->task, NULL, __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+}
+
+esp_err_t i2c_bus_init(i2c_bus_t *bus, const i2c_bus_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(bus != NULL, ESP_ERR_INVALID_ARG, TAG, "bus is null");
+    ESP_RETURN_ON_FALSE(cfg != NULL, ESP_ERR_INVALID_ARG, TAG, "cfg is null");
+
+    esp_err_t ret = ESP_OK;
+    memset(bus, 0, sizeof(*bus));
+
+    const i2c_master_bus_config_t bus_cfg = {
+        .i2c_port = cfg->port,
+        .sda_io_num = cfg->sda_gpio,
+        .scl_io_num = cfg->scl_gpio,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        /* Synchronous driver calls: queueing and ordering are done here, per device. */
+        .trans_queue_depth = 0,
+        .flags = {
+            .enable_internal_pullup = cfg->internal_pullup,
+        },
+    };
+    const UBaseType_t depth = (cfg->queue_depth != 0U) ? cfg->queue_depth : I2C_BUS_DEFAULT_QUEUE_DEPTH;
+
+    bus->lock = xSemaphoreCreateMutex();
+    bus->queue = xQueueCreate(depth, sizeof(i2c_bus_txn_t *));
+    ESP_GOTO_ON_FALSE(bus->lock != NULL && bus->queue != NULL, ESP_ERR_NO_MEM, err, TAG, "bus lock/queue alloc failed");
+    ESP_GOTO_ON_ERROR(i2c_new_master_bus(&bus_cfg, &bus->handle), err, TAG, "i2c_new_master_bus failed");
+
+    const uint8_t prio = (cfg->task_priority != 0U) ? cfg->task_priority : I2C_BUS_DEFAULT_PRIORITY;
+    if (xTaskCreate(i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, bus, prio, &bus->task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "worker task create failed");
+        goto err;
+    }
+    return ESP_OK;
+
+err:
+    if (bus->handle != NULL) {
+        (void)i2c_del_master_bus(bus->handle);
+        bus->handle = NULL;
+    }
+    if (bus->queue != NULL) {
+        vQueueDelete(bus->queue);
+        bus->queue = NULL;
+    }
+    if (bus->lock != NULL) {
+        vSemaphoreDelete(bus->lock);
+        bus->lock = NULL;
+    }
+    return ret;
+}
+
+esp_err_t i2c_bus_deinit(i2c_bus_t *bus)
+{
+    /* queue outlives handle when an earlier call timed out waiting for the worker. */
+    ESP_RETURN_ON_FALSE(bus != NULL && bus->queue != NULL, ESP_ERR_INVALID_STATE, TAG, "bus not initialized");
+    ESP_RETURN_ON_FALSE(bus->task == NULL || xTaskGetCurrentTaskHandle() != bus->task, ESP_ERR_INVALID_STATE, TAG,
+                        "deinit from a done_cb");
+
+    if (bus->handle != NULL) {
+        /* Refuses while devices are attached, before anything is torn down. */
+        ESP_RETURN_ON_ERROR(i2c_del_master_bus(bus->handle), TAG, "devices still attached");
+        bus->handle = NULL;
+
+        bus->stop = true;
+        i2c_bus_txn_t *wake = NULL;
+        (void)xQueueSend(bus->queue, &wake, portMAX_DELAY);
+    }
+    for (uint32_t waited = 0; __atomic_load_n(&bus->task, __ATOMIC_ACQUIRE) != NULL; waited += 10U) {
+        /* The worker may still be inside a done_cb using the queue or lock: keep both alive, caller retries. */
+        ESP_RETURN_ON_FALSE(waited < I2C_BUS_STOP_WAIT_MS, ESP_ERR_TIMEOUT, TAG, "worker still running");
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    vQueueDelete(bus->queue);
+    vSemaphoreDelete(bus->lock);
+    bus->queue = NULL;
+    bus->lock = NULL;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(i2c_bus_t *bus, i2c_bus_dev_t *dev, uint16_t addr, uint32_t scl_hz, uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(bus != NULL && bus->handle != NULL, ESP_ERR_INVALID_STATE, TAG, "bus not initialized");
+    ESP_RETURN_ON_FALSE(dev != NULL, ESP_ERR_INVALID_ARG, TAG, "dev is null");
+    ESP_RETURN_ON_FALSE(addr <= 0x7FU, ESP_ERR_INVALID_ARG, TAG, "addr is not 7-bit");
+    ESP_RETURN_ON_FALSE(scl_hz > 0U, ESP_ERR_INVALID_ARG, TAG, "scl_hz is zero");
+
+    memset(dev, 0, sizeof(*dev));
+    const i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = addr,
+        .scl_speed_hz = scl_hz,
+    };
+    ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(bus->handle, &dev_cfg, &dev->handle), TAG, "add device failed");
+
+    dev->bus = bus;
+    dev->addr = addr;
+    dev->timeout_ms = (timeout_ms != 0U) ? timeout_ms : I2C_BUS_DEFAULT_TIMEOUT_MS;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_remove_device(i2c_bus_dev_t *dev)
+{
+    ESP_RETURN_ON_FALSE(dev != NULL && dev->handle != NULL, ESP_ERR_INVALID_STATE, TAG, "device not attached");
+
+    (void)xSemaphoreTake(dev->bus->lock, portMAX_DELAY);
+    const esp_err_t err = i2c_master_bus_rm_device(dev->handle);
+    (void)xSemaphoreGive(dev->bus->lock);
+    ESP_RETURN_ON_ERROR(err, TAG, "rm device failed");
+
+    dev->handle = NULL;
+    dev->bus = NULL;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_run(i2c_bus_dev_t *dev, const i2c_bus_op_t *ops, size_t op_count)
+{
+    ESP_RETURN_ON_FALSE(dev != NULL && dev->handle != NULL, ESP_ERR_INVALID_STATE, TAG, "device not attached");
+    ESP_RETURN_ON_FALSE(ops != NULL && op_count > 0U, ESP_ERR_INVALID_ARG, TAG, "no ops");
+
+    return i2c_bus_exec(dev, ops, op_count);
+}
+
+esp_err_t i2c_bus_submit(i2c_bus_txn_t *txn)
+{
+    ESP_RETURN_ON_FALSE(txn != NULL, ESP_ERR_INVALID_ARG, TAG, "txn is null");
+    ESP_RETURN_ON_FALSE(txn->dev != NULL && txn->dev->handle != NULL, ESP_ERR_INVALID_STATE, TAG, "device not attached");
+    ESP_RETURN_ON_FALSE(txn->op_count > 0U && txn->op_count <= I2C_BUS_MAX_OPS, ESP_ERR_INVALID_ARG, TAG,
+                        "op_count out of range");
+
+    if (__atomic_test_and_set(&txn->pending, __ATOMIC_ACQUIRE)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueSend(txn->dev->bus->queue, &txn, 0) != pdTRUE) {
+        __atomic_store_n(&txn->pending, false, __ATOMIC_RELEASE);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
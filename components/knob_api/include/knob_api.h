@@ -8,7 +8,10 @@
 #include <stdint.h>
 
 #include "driver/gpio.h"
+#include "driver/pulse_cnt.h"
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 /**
  * @file knob_api.h
@@ -29,11 +32,19 @@ typedef struct {
     gpio_num_t sw;
 } knob_pins_t;
 
+/** @brief Quadrature decoding backend. */
+typedef enum {
+    KNOB_BACKEND_POLL = 0, /* software transition table, one sample per knob_poll() */
+    KNOB_BACKEND_PCNT,     /* PCNT x4 quadrature counting with glitch filter */
+} knob_backend_t;
+
 /** @brief Runtime configuration for encoder sampling and button behavior. */
 typedef struct {
     bool enable_pullup;
     bool button_active_low;
     uint32_t button_debounce_ms;
+    knob_backend_t backend;
+    uint32_t glitch_filter_ns; /* PCNT only, 0 = default */
 } knob_cfg_t;
 
 /** @brief Event returned by knob polling. */
@@ -56,12 +67,34 @@ typedef struct {
     uint32_t last_sw_change_ms;
     bool pressed_latched;
     bool initialized;
+    pcnt_unit_handle_t pcnt_unit;
+    pcnt_channel_handle_t pcnt_chan_clk;
+    pcnt_channel_handle_t pcnt_chan_dt;
+    int pcnt_consumed; /* hardware count already reported as detents */
+    TaskHandle_t wake_task; /* knob_enable_wake() */
 } knob_t;
 
 /** @brief Initialize a knob instance and GPIOs (input-only). */
 knob_status_t knob_init(knob_t *knob, const knob_pins_t *pins, const knob_cfg_t *cfg);
-/** @brief Poll encoder/button and return incremental events. */
+/** @brief Release the PCNT unit (if any) and mark the knob uninitialized. */
+void knob_deinit(knob_t *knob);
+/**
+ * @brief Poll encoder/button and return incremental events.
+ *
+ * With KNOB_BACKEND_PCNT steps are counted in hardware, so delta may be
+ * larger than 1 when polled slowly.
+ */
 knob_status_t knob_poll(knob_t *knob, knob_event_t *event_out);
+/**
+ * @brief Notify `task` (xTaskNotifyGive) on any CLK/DT/SW level change and
+ *        arm those pins as light-sleep GPIO wakeup sources.
+ *
+ * Pins are level-armed against their current level; after a wake the ISR
+ * masks them until the next knob_poll() re-arms, so a held button cannot
+ * storm. Lets the caller block until input instead of polling. PCNT does not
+ * count during light sleep, so the edge that wakes the chip may be lost.
+ */
+knob_status_t knob_enable_wake(knob_t *knob, TaskHandle_t task);
 /** @brief Get current logical knob position. */
 int32_t knob_get_position(const knob_t *knob);
 /** @brief Set current logical knob position. */
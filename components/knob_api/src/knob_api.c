@@ -9,11 +9,17 @@
 #include <string.h>
 
 #include "esp_check.h"
+#include "esp_sleep.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #define KNOB_TAG "knob_api"
 #define KNOB_DEFAULT_DEBOUNCE_MS 30U
+#define KNOB_DEFAULT_GLITCH_NS 1000U
+#define KNOB_TRANSITIONS_PER_DETENT 4
+/* PCNT is 16-bit; accum_count plus limit watch points extends it in software. */
+#define KNOB_PCNT_HIGH_LIMIT 10000
+#define KNOB_PCNT_LOW_LIMIT (-10000)
 
 static uint32_t knob_now_ms(void)
 {
@@ -32,6 +38,138 @@ static uint8_t knob_read_sw(const knob_t *knob)
     return (uint8_t)(gpio_get_level(knob->pins.sw) & 0x01U);
 }
 
+static void knob_pcnt_release(knob_t *knob)
+{
+    if (knob->pcnt_unit == NULL) {
+        return;
+    }
+    (void)pcnt_unit_stop(knob->pcnt_unit);
+    (void)pcnt_unit_disable(knob->pcnt_unit);
+    if (knob->pcnt_chan_clk != NULL) {
+        (void)pcnt_del_channel(knob->pcnt_chan_clk);
+    }
+    if (knob->pcnt_chan_dt != NULL) {
+        (void)pcnt_del_channel(knob->pcnt_chan_dt);
+    }
+    (void)pcnt_del_unit(knob->pcnt_unit);
+    knob->pcnt_unit = NULL;
+    knob->pcnt_chan_clk = NULL;
+    knob->pcnt_chan_dt = NULL;
+}
+
+/*
+ * x4 quadrature decoding: each channel counts edges of one line and uses the
+ * other as direction level. Signs match transition_table (CLK leading = +1).
+ */
+static esp_err_t knob_pcnt_setup(knob_t *knob)
+{
+    esp_err_t ret = ESP_OK;
+
+    const pcnt_unit_config_t unit_cfg = {
+        .low_limit = KNOB_PCNT_LOW_LIMIT,
+        .high_limit = KNOB_PCNT_HIGH_LIMIT,
+        .flags.accum_count = true,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_new_unit(&unit_cfg, &knob->pcnt_unit), KNOB_TAG, "pcnt_new_unit failed");
+
+    const pcnt_glitch_filter_config_t filter_cfg = {
+        .max_glitch_ns = (knob->cfg.glitch_filter_ns != 0U) ? knob->cfg.glitch_filter_ns : KNOB_DEFAULT_GLITCH_NS,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_unit_set_glitch_filter(knob->pcnt_unit, &filter_cfg), err, KNOB_TAG, "glitch filter failed");
+
+    const pcnt_chan_config_t clk_cfg = {
+        .edge_gpio_num = knob->pins.clk,
+        .level_gpio_num = knob->pins.dt,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_new_channel(knob->pcnt_unit, &clk_cfg, &knob->pcnt_chan_clk), err, KNOB_TAG, "clk channel failed");
+    const pcnt_chan_config_t dt_cfg = {
+        .edge_gpio_num = knob->pins.dt,
+        .level_gpio_num = knob->pins.clk,
+    };
+    ESP_GOTO_ON_ERROR(pcnt_new_channel(knob->pcnt_unit, &dt_cfg, &knob->pcnt_chan_dt), err, KNOB_TAG, "dt channel failed");
+
+    ESP_GOTO_ON_ERROR(pcnt_channel_set_edge_action(knob->pcnt_chan_clk, PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                                   PCNT_CHANNEL_EDGE_ACTION_INCREASE), err, KNOB_TAG, "clk edge action failed");
+    ESP_GOTO_ON_ERROR(pcnt_channel_set_level_action(knob->pcnt_chan_clk, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                    PCNT_CHANNEL_LEVEL_ACTION_INVERSE), err, KNOB_TAG, "clk level action failed");
+    ESP_GOTO_ON_ERROR(pcnt_channel_set_edge_action(knob->pcnt_chan_dt, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                                   PCNT_CHANNEL_EDGE_ACTION_DECREASE), err, KNOB_TAG, "dt edge action failed");
+    ESP_GOTO_ON_ERROR(pcnt_channel_set_level_action(knob->pcnt_chan_dt, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                    PCNT_CHANNEL_LEVEL_ACTION_INVERSE), err, KNOB_TAG, "dt level action failed");
+
+    ESP_GOTO_ON_ERROR(pcnt_unit_add_watch_point(knob->pcnt_unit, KNOB_PCNT_HIGH_LIMIT), err, KNOB_TAG, "watch point failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_add_watch_point(knob->pcnt_unit, KNOB_PCNT_LOW_LIMIT), err, KNOB_TAG, "watch point failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_enable(knob->pcnt_unit), err, KNOB_TAG, "pcnt enable failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_clear_count(knob->pcnt_unit), err, KNOB_TAG, "pcnt clear failed");
+    ESP_GOTO_ON_ERROR(pcnt_unit_start(knob->pcnt_unit), err, KNOB_TAG, "pcnt start failed");
+
+    knob->pcnt_consumed = 0;
+    return ESP_OK;
+
+err:
+    knob_pcnt_release(knob);
+    return ret;
+}
+
+/* Turn whole detents of the hardware count into position steps; partial detents carry over. */
+static int8_t knob_pcnt_take_steps(knob_t *knob)
+{
+    int count = 0;
+    if (pcnt_unit_get_count(knob->pcnt_unit, &count) != ESP_OK) {
+        return 0;
+    }
+
+    int steps = (count - knob->pcnt_consumed) / KNOB_TRANSITIONS_PER_DETENT;
+    if (steps > INT8_MAX) {
+        steps = INT8_MAX;
+    } else if (steps < -INT8_MAX) {
+        steps = -INT8_MAX;
+    }
+    knob->pcnt_consumed += steps * KNOB_TRANSITIONS_PER_DETENT;
+    return (int8_t)steps;
+}
+
+static void knob_wake_isr(void *arg)
+{
+    knob_t *knob = arg;
+    BaseType_t woken = pdFALSE;
+
+    /* Level-triggered: mask until knob_poll() re-arms against the new level. */
+    (void)gpio_intr_disable(knob->pins.clk);
+    (void)gpio_intr_disable(knob->pins.dt);
+    (void)gpio_intr_disable(knob->pins.sw);
+    vTaskNotifyGiveFromISR(knob->wake_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void knob_wake_arm_pin(gpio_num_t pin)
+{
+    const gpio_int_type_t level = (gpio_get_level(pin) != 0) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+    (void)gpio_wakeup_enable(pin, level);
+    (void)gpio_intr_enable(pin);
+}
+
+static void knob_wake_arm(const knob_t *knob)
+{
+    knob_wake_arm_pin(knob->pins.clk);
+    knob_wake_arm_pin(knob->pins.dt);
+    knob_wake_arm_pin(knob->pins.sw);
+}
+
+static void knob_wake_release(knob_t *knob)
+{
+    if (knob->wake_task == NULL) {
+        return;
+    }
+    const gpio_num_t pins[3] = {knob->pins.clk, knob->pins.dt, knob->pins.sw};
+    for (size_t i = 0; i < 3U; i++) {
+        (void)gpio_intr_disable(pins[i]);
+        (void)gpio_wakeup_disable(pins[i]);
+        (void)gpio_isr_handler_remove(pins[i]);
+    }
+    knob->wake_task = NULL;
+}
+
 knob_status_t knob_init(knob_t *knob, const knob_pins_t *pins, const knob_cfg_t *cfg)
 {
     ESP_RETURN_ON_FALSE(knob != NULL, ESP_ERR_INVALID_ARG, KNOB_TAG, "knob is null");
@@ -67,6 +205,10 @@ knob_status_t knob_init(knob_t *knob, const knob_pins_t *pins, const knob_cfg_t
     };
     ESP_RETURN_ON_ERROR(gpio_config(&io_cfg), KNOB_TAG, "gpio_config failed");
 
+    if (local_cfg.backend == KNOB_BACKEND_PCNT) {
+        ESP_RETURN_ON_ERROR(knob_pcnt_setup(knob), KNOB_TAG, "pcnt backend setup failed");
+    }
+
     knob->last_ab = knob_read_ab(knob);
     knob->last_sw_level = knob_read_sw(knob);
     knob->last_sw_change_ms = knob_now_ms();
@@ -90,19 +232,24 @@ knob_status_t knob_poll(knob_t *knob, knob_event_t *event_out)
 
     memset(event_out, 0, sizeof(*event_out));
 
-    const uint8_t ab = knob_read_ab(knob);
-    const uint8_t idx = (uint8_t)((knob->last_ab << 2) | ab);
-    knob->step_acc = (int8_t)(knob->step_acc + transition_table[idx]);
-    knob->last_ab = ab;
-
-    if (knob->step_acc >= 4) {
-        knob->position++;
-        event_out->delta = 1;
-        knob->step_acc = 0;
-    } else if (knob->step_acc <= -4) {
-        knob->position--;
-        event_out->delta = -1;
-        knob->step_acc = 0;
+    if (knob->pcnt_unit != NULL) {
+        event_out->delta = knob_pcnt_take_steps(knob);
+        knob->position += event_out->delta;
+    } else {
+        const uint8_t ab = knob_read_ab(knob);
+        const uint8_t idx = (uint8_t)((knob->last_ab << 2) | ab);
+        knob->step_acc = (int8_t)(knob->step_acc + transition_table[idx]);
+        knob->last_ab = ab;
+
+        if (knob->step_acc >= KNOB_TRANSITIONS_PER_DETENT) {
+            knob->position++;
+            event_out->delta = 1;
+            knob->step_acc = 0;
+        } else if (knob->step_acc <= -KNOB_TRANSITIONS_PER_DETENT) {
+            knob->position--;
+            event_out->delta = -1;
+            knob->step_acc = 0;
+        }
     }
 
     const uint8_t raw_sw = knob_read_sw(knob);
@@ -126,9 +273,45 @@ knob_status_t knob_poll(knob_t *knob, knob_event_t *event_out)
     }
 
     event_out->position = knob->position;
+    if (knob->wake_task != NULL) {
+        knob_wake_arm(knob);
+    }
     return ESP_OK;
 }
 
+knob_status_t knob_enable_wake(knob_t *knob, TaskHandle_t task)
+{
+    ESP_RETURN_ON_FALSE(knob != NULL && task != NULL, ESP_ERR_INVALID_ARG, KNOB_TAG, "invalid args");
+    ESP_RETURN_ON_FALSE(knob->initialized, ESP_ERR_INVALID_STATE, KNOB_TAG, "knob not initialized");
+    ESP_RETURN_ON_FALSE(knob->wake_task == NULL, ESP_ERR_INVALID_STATE, KNOB_TAG, "wake already enabled");
+
+    const esp_err_t isr_err = gpio_install_isr_service(0);
+    ESP_RETURN_ON_FALSE(isr_err == ESP_OK || isr_err == ESP_ERR_INVALID_STATE, isr_err, KNOB_TAG, "gpio isr service failed");
+
+    knob->wake_task = task;
+    const gpio_num_t pins[3] = {knob->pins.clk, knob->pins.dt, knob->pins.sw};
+    for (size_t i = 0; i < 3U; i++) {
+        const esp_err_t err = gpio_isr_handler_add(pins[i], knob_wake_isr, knob);
+        if (err != ESP_OK) {
+            knob_wake_release(knob);
+            ESP_RETURN_ON_ERROR(err, KNOB_TAG, "gpio isr handler add failed");
+        }
+    }
+    ESP_RETURN_ON_ERROR(esp_sleep_enable_gpio_wakeup(), KNOB_TAG, "gpio wakeup enable failed");
+    knob_wake_arm(knob);
+    return ESP_OK;
+}
+
+void knob_deinit(knob_t *knob)
+{
+    if (knob == NULL) {
+        return;
+    }
+    knob_wake_release(knob);
+    knob_pcnt_release(knob);
+    knob->initialized = false;
+}
+
 int32_t knob_get_position(const knob_t *knob)
 {
     if ((knob == NULL) || (!knob->initialized)) {
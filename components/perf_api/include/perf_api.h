@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+/**
+ * @file perf_api.h
+ * @brief Fixed-slot counters and latency histograms, updated with atomics.
+ *
+ * Metrics are static perf_metric_t objects owned by the instrumented module;
+ * the first update links them into a global list, so no init call or heap
+ * is needed. perf_render_prometheus() prints every linked metric plus heap
+ * gauges in the Prometheus text exposition format.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set to 0 to compile all updates out. */
+#ifndef PERF_API_ENABLE
+#define PERF_API_ENABLE 1
+#endif
+
+/* Histogram bounds in microseconds (x4 steps); one extra bucket for +Inf. */
+#define PERF_HIST_BOUNDS_US {16U, 64U, 256U, 1024U, 4096U, 16384U, 65536U, 262144U, 1048576U}
+#define PERF_HIST_BUCKETS 10U
+
+typedef enum {
+    PERF_METRIC_COUNTER = 0,
+    PERF_METRIC_HISTOGRAM,
+} perf_metric_kind_t;
+
+/** @brief One metric slot. Metrics sharing a name form one family (distinct labels). */
+typedef struct perf_metric {
+    const char *name;
+    const char *help;
+    const char *labels; /* e.g. "uri=\"/api/status\"", or NULL */
+    perf_metric_kind_t kind;
+    struct perf_metric *next;
+    uint32_t registered;
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[PERF_HIST_BUCKETS];
+} perf_metric_t;
+
+#define PERF_COUNTER_INIT(name_, help_, labels_) \
+    {.name = (name_), .help = (help_), .labels = (labels_), .kind = PERF_METRIC_COUNTER}
+#define PERF_HISTOGRAM_INIT(name_, help_, labels_) \
+    {.name = (name_), .help = (help_), .labels = (labels_), .kind = PERF_METRIC_HISTOGRAM}
+
+/** @brief Text sink for perf_render_prometheus(). */
+typedef esp_err_t (*perf_write_fn_t)(const char *text, size_t len, void *user_ctx);
+
+/** @brief Link a metric into the scrape list (done implicitly on first update). */
+void perf_register(perf_metric_t *metric);
+/** @brief Print all metrics; stops at the first write error. */
+esp_err_t perf_render_prometheus(perf_write_fn_t write, void *user_ctx);
+
+#if PERF_API_ENABLE
+/** @brief Add n to a counter. */
+void perf_count(perf_metric_t *metric, uint32_t n);
+/** @brief Record one histogram observation in microseconds. */
+void perf_observe_us(perf_metric_t *metric, uint32_t value_us);
+#else
+static inline void perf_count(perf_metric_t *metric, uint32_t n)
+{
+    (void)metric;
+    (void)n;
+}
+
+static inline void perf_observe_us(perf_metric_t *metric, uint32_t value_us)
+{
+    (void)metric;
+    (void)value_us;
+}
+#endif
+
+/** @brief Record the time elapsed since start_us (from esp_timer_get_time()). */
+static inline void perf_observe_since(perf_metric_t *metric, int64_t start_us)
+{
+    const int64_t dt = esp_timer_get_time() - start_us;
+    perf_observe_us(metric, (dt <= 0) ? 0U : ((dt >= (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)dt));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,200 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "perf_api.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+
+#define PERF_LINE_MAX 160
+
+static const char *TAG = "perf_api";
+
+static perf_metric_t *s_metrics = NULL;
+static const uint32_t s_bounds_us[PERF_HIST_BUCKETS - 1U] = PERF_HIST_BOUNDS_US;
+
+void perf_register(perf_metric_t *metric)
+{
+    if (metric == NULL || __atomic_exchange_n(&metric->registered, 1U, __ATOMIC_ACQ_REL) != 0U) {
+        return;
+    }
+
+    /* Lock-free push; the list is only ever prepended to. */
+    perf_metric_t *head = __atomic_load_n(&s_metrics, __ATOMIC_ACQUIRE);
+    do {
+        metric->next = head;
+    } while (!__atomic_compare_exchange_n(&s_metrics, &head, metric, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+#if PERF_API_ENABLE
+static void perf_ensure_registered(perf_metric_t *metric)
+{
+    if (__atomic_load_n(&metric->registered, __ATOMIC_RELAXED) == 0U) {
+        perf_register(metric);
+    }
+}
+
+void perf_count(perf_metric_t *metric, uint32_t n)
+{
+    if (metric == NULL) {
+        return;
+    }
+    perf_ensure_registered(metric);
+    (void)__atomic_fetch_add(&metric->count, n, __ATOMIC_RELAXED);
+}
+
+void perf_observe_us(perf_metric_t *metric, uint32_t value_us)
+{
+    if (metric == NULL) {
+        return;
+    }
+    perf_ensure_registered(metric);
+
+    size_t bucket = 0;
+    while (bucket < (PERF_HIST_BUCKETS - 1U) && value_us > s_bounds_us[bucket]) {
+        bucket++;
+    }
+    (void)__atomic_fetch_add(&metric->buckets[bucket], 1U, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&metric->sum, (uint64_t)value_us, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&metric->count, 1U, __ATOMIC_RELAXED);
+
+    uint32_t seen = __atomic_load_n(&metric->max, __ATOMIC_RELAXED);
+    while (value_us > seen
+           && !__atomic_compare_exchange_n(&metric->max, &seen, value_us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+#endif
+
+/* Render state; the first write error latches and silences the rest. */
+typedef struct {
+    perf_write_fn_t write;
+    void *user_ctx;
+    esp_err_t err;
+} perf_out_t;
+
+static void perf_printf(perf_out_t *out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void perf_printf(perf_out_t *out, const char *fmt, ...)
+{
+    if (out->err != ESP_OK) {
+        return;
+    }
+
+    char line[PERF_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out->err = out->write(line, ((size_t)n < sizeof(line)) ? (size_t)n : (sizeof(line) - 1U), out->user_ctx);
+    }
+}
+
+/* "{labels,extra}" with the right separators for any empty part. */
+static void perf_labels(char *out, size_t out_len, const char *labels, const char *extra)
+{
+    const bool has_labels = labels != NULL && labels[0] != '\0';
+    const bool has_extra = extra != NULL && extra[0] != '\0';
+    if (!has_labels && !has_extra) {
+        out[0] = '\0';
+        return;
+    }
+    snprintf(out, out_len, "{%s%s%s}", has_labels ? labels : "", (has_labels && has_extra) ? "," : "",
+             has_extra ? extra : "");
+}
+
+static void perf_render_metric(perf_out_t *out, const perf_metric_t *m)
+{
+    char labels[96];
+    if (m->kind == PERF_METRIC_COUNTER) {
+        perf_labels(labels, sizeof(labels), m->labels, NULL);
+        perf_printf(out, "%s%s %" PRIu32 "\n", m->name, labels, __atomic_load_n(&m->count, __ATOMIC_RELAXED));
+        return;
+    }
+
+    /* Buckets are stored per range; Prometheus wants them cumulative. */
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < PERF_HIST_BUCKETS; i++) {
+        char le[20];
+        if (i < (PERF_HIST_BUCKETS - 1U)) {
+            snprintf(le, sizeof(le), "le=\"%" PRIu32 "\"", s_bounds_us[i]);
+        } else {
+            snprintf(le, sizeof(le), "le=\"+Inf\"");
+        }
+        cumulative += __atomic_load_n(&m->buckets[i], __ATOMIC_RELAXED);
+        perf_labels(labels, sizeof(labels), m->labels, le);
+        perf_printf(out, "%s_bucket%s %" PRIu32 "\n", m->name, labels, cumulative);
+    }
+    perf_labels(labels, sizeof(labels), m->labels, NULL);
+    perf_printf(out, "%s_sum%s %" PRIu64 "\n", m->name, labels, __atomic_load_n(&m->sum, __ATOMIC_RELAXED));
+    perf_printf(out, "%s_count%s %" PRIu32 "\n", m->name, labels, cumulative);
+}
+
+static void perf_render_max(perf_out_t *out, const perf_metric_t *m)
+{
+    char labels[96];
+    perf_labels(labels, sizeof(labels), m->labels, NULL);
+    perf_printf(out, "%s_max%s %" PRIu32 "\n", m->name, labels, __atomic_load_n(&m->max, __ATOMIC_RELAXED));
+}
+
+static void perf_render_gauge(perf_out_t *out, const char *name, const char *help, uint32_t value)
+{
+    perf_printf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %" PRIu32 "\n", name, help, name, name, value);
+}
+
+static bool perf_family_seen(const perf_metric_t *head, const perf_metric_t *m)
+{
+    for (const perf_metric_t *p = head; p != m; p = p->next) {
+        if (strcmp(p->name, m->name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t perf_render_prometheus(perf_write_fn_t write, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(write != NULL, ESP_ERR_INVALID_ARG, TAG, "write is null");
+
+    perf_out_t out = {.write = write, .user_ctx = user_ctx, .err = ESP_OK};
+    const perf_metric_t *const head = __atomic_load_n(&s_metrics, __ATOMIC_ACQUIRE);
+    for (const perf_metric_t *m = head; m != NULL; m = m->next) {
+        /* Emit each family once, at its first list entry, with all its label sets. */
+        if (perf_family_seen(head, m)) {
+            continue;
+        }
+
+        const bool histogram = (m->kind == PERF_METRIC_HISTOGRAM);
+        perf_printf(&out, "# HELP %s %s\n# TYPE %s %s\n", m->name, (m->help != NULL) ? m->help : m->name, m->name,
+                    histogram ? "histogram" : "counter");
+        for (const perf_metric_t *f = m; f != NULL; f = f->next) {
+            if (strcmp(f->name, m->name) == 0) {
+                perf_render_metric(&out, f);
+            }
+        }
+
+        /* Worst case since boot, as a companion gauge family. */
+        if (histogram) {
+            perf_printf(&out, "# TYPE %s_max gauge\n", m->name);
+            for (const perf_metric_t *f = m; f != NULL; f = f->next) {
+                if (strcmp(f->name, m->name) == 0) {
+                    perf_render_max(&out, f);
+                }
+            }
+        }
+    }
+
+    perf_render_gauge(&out, "heap_free_bytes", "Free heap now", esp_get_free_heap_size());
+    perf_render_gauge(&out, "heap_min_free_bytes", "Free heap low-water mark since boot", esp_get_minimum_free_heap_size());
+    perf_render_gauge(&out, "heap_largest_free_block_bytes", "Largest allocatable block",
+                      (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    perf_render_gauge(&out, "uptime_seconds", "Time since boot", (uint32_t)(esp_timer_get_time() / 1000000LL));
+    return out.err;
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+/**
+ * @file rgb_led_api.h
+ * @brief Single WS2812-style LED with hardware-timed effects on RMT.
+ *
+ * An effect is precomputed into RMT symbol steps (one GRB frame plus a latch
+ * gap each). Every step goes out as one looped RMT transaction, so the
+ * peripheral holds the color for the step duration on its own; an engine task
+ * only queues the next step when a transaction completes. Posting an effect
+ * never blocks and costs the caller no RMT time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RGB_LED_MAX_STEPS 64U
+/* One hardware loop of a step: 24 data bits (1.2 us each) plus a 6.55 ms latch gap. */
+#define RGB_LED_LOOP_PERIOD_US 6582U
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_led_color_t;
+
+typedef enum {
+    RGB_LED_EFFECT_SOLID = 0,
+    RGB_LED_EFFECT_FADE,    /* from the current color to color over duration_ms, then hold */
+    RGB_LED_EFFECT_BREATHE, /* off -> color -> off every duration_ms, forever */
+    RGB_LED_EFFECT_BLINK,   /* color for on_ms, off for duration_ms - on_ms; repeat times, then back to the base color */
+} rgb_led_effect_kind_t;
+
+typedef struct {
+    rgb_led_effect_kind_t kind;
+    rgb_led_color_t color;
+    uint32_t duration_ms; /* fade time, breathe period or blink period */
+    uint32_t on_ms;       /* blink only */
+    uint16_t repeat;      /* blink only, 0 = forever */
+} rgb_led_effect_t;
+
+typedef struct {
+    gpio_num_t gpio;
+    uint8_t task_priority; /* 0 = 2 */
+} rgb_led_cfg_t;
+
+/** @brief Create the RMT channel and the engine task; the LED starts off. */
+esp_err_t rgb_led_init(const rgb_led_cfg_t *cfg);
+/** @brief Stop the engine and release the RMT channel. */
+void rgb_led_deinit(void);
+bool rgb_led_ready(void);
+/**
+ * @brief Replace the running effect; never blocks.
+ *
+ * Only the latest post is kept if several arrive before the engine runs.
+ * The old effect's transactions already handed to the RMT still play out
+ * first: up to 3 of them (the one on the wire plus 2 queued), each up to
+ * 8 loops of ~6.6 ms, so the change shows within about 160 ms.
+ */
+esp_err_t rgb_led_post(const rgb_led_effect_t *effect);
+/** @brief Shorthand for a RGB_LED_EFFECT_SOLID post; also sets the base color blinks return to. */
+esp_err_t rgb_led_set_color(uint8_t r, uint8_t g, uint8_t b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,400 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "rgb_led_api.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "driver/rmt_encoder.h"
+#include "driver/rmt_tx.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define RGB_LED_RMT_RESOLUTION_HZ 10000000U
+#define RGB_LED_T0H_TICKS 4U  /* 0.4 us */
+#define RGB_LED_T1H_TICKS 8U  /* 0.8 us */
+#define RGB_LED_BIT_TICKS 12U /* 1.2 us */
+#define RGB_LED_GAP_TICKS 32767U
+#define RGB_LED_FRAME_BITS 24U
+#define RGB_LED_STEP_SYMBOLS (RGB_LED_FRAME_BITS + 1U)
+/* Payload plus the driver's end marker must fit one 48-symbol RMT block for hardware looping. */
+#define RGB_LED_MEM_BLOCK_SYMBOLS 48U
+/* Loops per transaction: bounds how long a replaced effect keeps playing (8 * 6.6 ms). */
+#define RGB_LED_MAX_LOOPS_PER_TX 8U
+/* Transactions queued ahead of the one on the wire. */
+#define RGB_LED_QUEUE_AHEAD 2U
+#define RGB_LED_TASK_STACK 3072U
+#define RGB_LED_DEFAULT_PRIORITY 2U
+#define RGB_LED_STOP_WAIT_MS 200U
+
+_Static_assert(RGB_LED_STEP_SYMBOLS + 1U <= RGB_LED_MEM_BLOCK_SYMBOLS, "step must fit one RMT block");
+
+static const char *TAG = "rgb_led_api";
+
+/* One precomputed frame plus latch gap, replayed `loops` times back to back by the RMT. */
+typedef struct {
+    rmt_symbol_word_t symbols[RGB_LED_STEP_SYMBOLS];
+    rgb_led_color_t color;
+    uint32_t loops;
+} rgb_led_step_t;
+
+typedef struct {
+    bool initialized;
+    volatile bool stop;
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t encoder;
+    QueueHandle_t post_queue;
+    TaskHandle_t task;
+    uint32_t done; /* transactions completed, written by the RMT ISR */
+    /* Engine task only. */
+    uint32_t submitted;
+    uint32_t completed;
+    rgb_led_color_t flight_color[RGB_LED_QUEUE_AHEAD + 1U]; /* by submit number, for `shown` */
+    bool has_pending;
+    rgb_led_effect_t pending; /* built once nothing is in flight */
+    rgb_led_step_t steps[RGB_LED_MAX_STEPS]; /* in flight transactions point into it */
+    uint8_t step_count;
+    uint8_t next_step;
+    uint8_t cur_step;
+    uint32_t loops_left;
+    bool cyclic;
+    uint16_t cycles_left; /* cyclic effects, 0 = forever */
+    rgb_led_color_t base;
+    rgb_led_color_t shown; /* color of the last completed transaction */
+} rgb_led_ctx_t;
+
+static rgb_led_ctx_t g_led = {0};
+
+static uint32_t rgb_led_ms_to_loops(uint32_t ms)
+{
+    const uint32_t loops = (uint32_t)(((uint64_t)ms * 1000U + (RGB_LED_LOOP_PERIOD_US / 2U)) / RGB_LED_LOOP_PERIOD_US);
+    return (loops > 0U) ? loops : 1U;
+}
+
+static void rgb_led_encode_step(rgb_led_step_t *step, rgb_led_color_t color, uint32_t loops)
+{
+    const uint32_t grb = ((uint32_t)color.g << 16) | ((uint32_t)color.r << 8) | (uint32_t)color.b;
+    for (uint32_t i = 0; i < RGB_LED_FRAME_BITS; i++) {
+        const bool one = ((grb >> (RGB_LED_FRAME_BITS - 1U - i)) & 1U) != 0U;
+        const uint32_t high = one ? RGB_LED_T1H_TICKS : RGB_LED_T0H_TICKS;
+        step->symbols[i] = (rmt_symbol_word_t){
+            .level0 = 1,
+            .duration0 = high,
+            .level1 = 0,
+            .duration1 = RGB_LED_BIT_TICKS - high,
+        };
+    }
+    /* Low for ~6.5 ms: latches the frame and paces the loop. */
+    step->symbols[RGB_LED_FRAME_BITS] = (rmt_symbol_word_t){
+        .level0 = 0,
+        .duration0 = RGB_LED_GAP_TICKS,
+        .level1 = 0,
+        .duration1 = RGB_LED_GAP_TICKS,
+    };
+    step->color = color;
+    step->loops = loops;
+}
+
+static uint8_t rgb_led_lerp(uint8_t from, uint8_t to, uint32_t num, uint32_t den)
+{
+    return (uint8_t)((int32_t)from + (((int32_t)to - (int32_t)from) * (int32_t)num) / (int32_t)den);
+}
+
+static rgb_led_color_t rgb_led_scale(rgb_led_color_t color, uint32_t level, uint32_t max_level)
+{
+    return (rgb_led_color_t){
+        .r = (uint8_t)(((uint32_t)color.r * level) / max_level),
+        .g = (uint8_t)(((uint32_t)color.g * level) / max_level),
+        .b = (uint8_t)(((uint32_t)color.b * level) / max_level),
+    };
+}
+
+static void rgb_led_build_solid(rgb_led_color_t color)
+{
+    rgb_led_encode_step(&g_led.steps[0], color, 1U);
+    g_led.step_count = 1U;
+    g_led.cyclic = false;
+    g_led.cycles_left = 0U;
+    g_led.base = color;
+}
+
+/* Precompute every frame of an effect up front; the task then only queues symbol buffers. */
+static void rgb_led_build(const rgb_led_effect_t *effect)
+{
+    const uint32_t total_loops = rgb_led_ms_to_loops(effect->duration_ms);
+
+    g_led.next_step = 0U;
+    g_led.loops_left = 0U;
+
+    switch (effect->kind) {
+    case RGB_LED_EFFECT_FADE: {
+        const uint32_t n = (total_loops < RGB_LED_MAX_STEPS) ? total_loops : RGB_LED_MAX_STEPS;
+        const rgb_led_color_t from = g_led.shown;
+        for (uint32_t i = 0; i < n; i++) {
+            const rgb_led_color_t c = {
+                .r = rgb_led_lerp(from.r, effect->color.r, i + 1U, n),
+                .g = rgb_led_lerp(from.g, effect->color.g, i + 1U, n),
+                .b = rgb_led_lerp(from.b, effect->color.b, i + 1U, n),
+            };
+            /* Spread the remainder so the whole fade still takes duration_ms. */
+            const uint32_t loops = ((total_loops * (i + 1U)) / n) - ((total_loops * i) / n);
+            rgb_led_encode_step(&g_led.steps[i], c, loops);
+        }
+        g_led.step_count = (uint8_t)n;
+        g_led.cyclic = false;
+        g_led.base = effect->color;
+        break;
+    }
+    case RGB_LED_EFFECT_BREATHE: {
+        uint32_t n = (total_loops < RGB_LED_MAX_STEPS) ? total_loops : RGB_LED_MAX_STEPS;
+        n = (n < 2U) ? 2U : (n & ~1U);
+        const uint32_t half = n / 2U;
+        for (uint32_t i = 0; i < n; i++) {
+            /* Triangle wave squared: roughly linear perceived brightness. */
+            const uint32_t k = (i < half) ? (i + 1U) : (n - i - 1U);
+            const uint32_t loops = ((total_loops * (i + 1U)) / n) - ((total_loops * i) / n);
+            rgb_led_encode_step(&g_led.steps[i], rgb_led_scale(effect->color, k * k, half * half), (loops > 0U) ? loops : 1U);
+        }
+        g_led.step_count = (uint8_t)n;
+        g_led.cyclic = true;
+        g_led.cycles_left = 0U;
+        break;
+    }
+    case RGB_LED_EFFECT_BLINK: {
+        const uint32_t on_ms = (effect->on_ms < effect->duration_ms) ? effect->on_ms : effect->duration_ms;
+        const rgb_led_color_t off = {0};
+        rgb_led_encode_step(&g_led.steps[0], effect->color, rgb_led_ms_to_loops(on_ms));
+        rgb_led_encode_step(&g_led.steps[1], off, rgb_led_ms_to_loops(effect->duration_ms - on_ms));
+        g_led.step_count = 2U;
+        g_led.cyclic = true;
+        g_led.cycles_left = effect->repeat;
+        break;
+    }
+    case RGB_LED_EFFECT_SOLID:
+    default:
+        rgb_led_build_solid(effect->color);
+        break;
+    }
+}
+
+/* Next transaction of the current effect, or false when it finished. */
+static bool rgb_led_next(const rgb_led_step_t **out_step, uint32_t *out_loops)
+{
+    if (g_led.loops_left == 0U) {
+        if (g_led.next_step >= g_led.step_count) {
+            if (!g_led.cyclic) {
+                return false;
+            }
+            if ((g_led.cycles_left > 0U) && (--g_led.cycles_left == 0U)) {
+                /* Finite blink done: back to the color it interrupted, once its steps left the RMT. */
+                if (!g_led.has_pending) {
+                    g_led.pending = (rgb_led_effect_t){.kind = RGB_LED_EFFECT_SOLID, .color = g_led.base};
+                    g_led.has_pending = true;
+                }
+                g_led.step_count = 0U;
+                g_led.cyclic = false;
+                return false;
+            }
+            g_led.next_step = 0U;
+        }
+        g_led.cur_step = g_led.next_step++;
+        g_led.loops_left = g_led.steps[g_led.cur_step].loops;
+    }
+
+    const uint32_t loops = (g_led.loops_left < RGB_LED_MAX_LOOPS_PER_TX) ? g_led.loops_left : RGB_LED_MAX_LOOPS_PER_TX;
+    g_led.loops_left -= loops;
+    *out_step = &g_led.steps[g_led.cur_step];
+    *out_loops = loops;
+    return true;
+}
+
+static bool IRAM_ATTR rgb_led_on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    (void)channel;
+    (void)edata;
+    (void)user_ctx;
+
+    BaseType_t woken = pdFALSE;
+    __atomic_add_fetch(&g_led.done, 1U, __ATOMIC_RELEASE);
+    vTaskNotifyGiveFromISR(g_led.task, &woken);
+    return woken == pdTRUE;
+}
+
+static void rgb_led_task(void *arg)
+{
+    (void)arg;
+
+    while (!g_led.stop) {
+        rgb_led_effect_t effect;
+        if (xQueueReceive(g_led.post_queue, &effect, 0) == pdTRUE) {
+            g_led.pending = effect;
+            g_led.has_pending = true;
+        }
+
+        const uint32_t done = __atomic_exchange_n(&g_led.done, 0U, __ATOMIC_ACQUIRE);
+        if (done > 0U) {
+            g_led.completed += done;
+            g_led.shown = g_led.flight_color[(g_led.completed - 1U) % (RGB_LED_QUEUE_AHEAD + 1U)];
+        }
+
+        /*
+         * Queued transactions point into steps[] until they are done, so a new
+         * effect is only built once they drained (at most ~160 ms; they would
+         * play before it anyway). Nothing new is queued meanwhile.
+         */
+        if (g_led.has_pending && g_led.submitted == g_led.completed) {
+            g_led.has_pending = false;
+            rgb_led_build(&g_led.pending);
+        }
+
+        const rgb_led_step_t *step = NULL;
+        uint32_t loops = 0U;
+        while (!g_led.has_pending && ((g_led.submitted - g_led.completed) <= RGB_LED_QUEUE_AHEAD)
+               && rgb_led_next(&step, &loops)) {
+            const rmt_transmit_config_t tx_cfg = {
+                .loop_count = (loops > 1U) ? (int)loops : 0,
+                .flags = {
+                    .eot_level = 0,
+                },
+            };
+            const esp_err_t err = rmt_transmit(g_led.channel, g_led.encoder, step->symbols, sizeof(step->symbols), &tx_cfg);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "rmt_transmit failed: %s", esp_err_to_name(err));
+                g_led.step_count = 0U;
+                g_led.cyclic = false;
+                g_led.loops_left = 0U;
+                break;
+            }
+            g_led.flight_color[g_led.submitted % (RGB_LED_QUEUE_AHEAD + 1U)] = step->color;
+            g_led.submitted++;
+        }
+        if (g_led.has_pending && g_led.submitted == g_led.completed) {
+            continue; /* a finished blink queued its restore: build it now */
+        }
+
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    (void)rmt_tx_wait_all_done(g_led.channel, (int)RGB_LED_STOP_WAIT_MS);
+    g_led.task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t rgb_led_init(const rgb_led_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(cfg != NULL, ESP_ERR_INVALID_ARG, TAG, "cfg is null");
+    ESP_RETURN_ON_FALSE(!g_led.initialized, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+
+    esp_err_t ret = ESP_OK;
+    const rmt_tx_channel_config_t tx_chan_cfg = {
+        .gpio_num = cfg->gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RGB_LED_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = RGB_LED_MEM_BLOCK_SYMBOLS,
+        .trans_queue_depth = RGB_LED_QUEUE_AHEAD + 1U,
+        .flags = {
+            .invert_out = false,
+            .with_dma = false, /* looped transactions must run from RMT memory */
+        },
+    };
+    const rmt_copy_encoder_config_t copy_cfg = {0};
+    const rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = rgb_led_on_trans_done,
+    };
+
+    g_led.stop = false;
+    g_led.done = 0U;
+    g_led.submitted = 0U;
+    g_led.completed = 0U;
+    g_led.has_pending = false;
+    g_led.step_count = 0U;
+    g_led.shown = (rgb_led_color_t){0};
+    g_led.base = (rgb_led_color_t){0};
+
+    g_led.post_queue = xQueueCreate(1, sizeof(rgb_led_effect_t));
+    ESP_RETURN_ON_FALSE(g_led.post_queue != NULL, ESP_ERR_NO_MEM, TAG, "post queue alloc failed");
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&tx_chan_cfg, &g_led.channel), err, TAG, "rmt_new_tx_channel failed");
+    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_cfg, &g_led.encoder), err, TAG, "rmt_new_copy_encoder failed");
+    ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(g_led.channel, &cbs, NULL), err, TAG, "rmt callbacks failed");
+    ESP_GOTO_ON_ERROR(rmt_enable(g_led.channel), err, TAG, "rmt_enable failed");
+
+    const uint8_t prio = (cfg->task_priority != 0U) ? cfg->task_priority : RGB_LED_DEFAULT_PRIORITY;
+    if (xTaskCreate(rgb_led_task, "rgb_led", RGB_LED_TASK_STACK, NULL, prio, &g_led.task) != pdPASS) {
+        (void)rmt_disable(g_led.channel);
+        ret = ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "engine task create failed");
+        goto err;
+    }
+
+    g_led.initialized = true;
+    /* Start dark: the LED may hold random data from power-up. */
+    return rgb_led_set_color(0U, 0U, 0U);
+
+err:
+    if (g_led.encoder != NULL) {
+        (void)rmt_del_encoder(g_led.encoder);
+        g_led.encoder = NULL;
+    }
+    if (g_led.channel != NULL) {
+        (void)rmt_del_channel(g_led.channel);
+        g_led.channel = NULL;
+    }
+    vQueueDelete(g_led.post_queue);
+    g_led.post_queue = NULL;
+    return ret;
+}
+
+void rgb_led_deinit(void)
+{
+    if (!g_led.initialized) {
+        return;
+    }
+
+    g_led.initialized = false;
+    g_led.stop = true;
+    (void)xTaskNotifyGive(g_led.task);
+    for (uint32_t waited = 0; (g_led.task != NULL) && (waited < RGB_LED_STOP_WAIT_MS * 2U); waited += 10U) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    (void)rmt_disable(g_led.channel);
+    (void)rmt_del_encoder(g_led.encoder);
+    (void)rmt_del_channel(g_led.channel);
+    vQueueDelete(g_led.post_queue);
+    g_led.encoder = NULL;
+    g_led.channel = NULL;
+    g_led.post_queue = NULL;
+}
+
+bool rgb_led_ready(void)
+{
+    return g_led.initialized;
+}
+
+esp_err_t rgb_led_post(const rgb_led_effect_t *effect)
+{
+    ESP_RETURN_ON_FALSE(effect != NULL, ESP_ERR_INVALID_ARG, TAG, "effect is null");
+    ESP_RETURN_ON_FALSE(effect->kind <= RGB_LED_EFFECT_BLINK, ESP_ERR_INVALID_ARG, TAG, "unknown effect");
+    if (!g_led.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    (void)xQueueOverwrite(g_led.post_queue, effect);
+    (void)xTaskNotifyGive(g_led.task);
+    return ESP_OK;
+}
+
+esp_err_t rgb_led_set_color(uint8_t r, uint8_t g, uint8_t b)
+{
+    const rgb_led_effect_t effect = {
+        .kind = RGB_LED_EFFECT_SOLID,
+        .color = {.r = r, .g = g, .b = b},
+    };
+    return rgb_led_post(&effect);
+}
@@ -21,6 +21,9 @@ extern "C" {
 
 #define SNTP_API_DEFAULT_SERVER "pool.ntp.org"
 #define SNTP_API_MIN_SYNC_INTERVAL_MS 15000U
+/* Upper clamp for the adaptive interval; lwIP timeouts must stay well below 2^32 ms. */
+#define SNTP_API_MAX_SYNC_INTERVAL_MS (7U * 24U * 3600U * 1000U)
+#define SNTP_API_DEFAULT_MAX_ERROR_MS 500U
 
 typedef struct {
     const char *server_name;
@@ -34,8 +37,31 @@ typedef struct {
     uint8_t line_gap_px; /* 0 = auto */
     uint8_t date_char_spacing_px; /* extra spacing between chars */
     uint8_t time_char_spacing_px; /* extra spacing between chars */
+    bool use_framebuffer; /* compose bar in RAM, send only changed pixels */
+    bool smooth_sync; /* slew small corrections with adjtime() instead of stepping the clock */
+    uint32_t max_sync_interval_ms; /* adaptive interval ceiling; 0 = keep sync_interval_ms fixed */
+    uint32_t max_error_ms; /* adaptive target for drift between syncs; 0 = SNTP_API_DEFAULT_MAX_ERROR_MS */
 } sntp_api_cfg_t;
 
+/** @brief Last SNTP sync and the drift measured between syncs. */
+typedef struct {
+    uint32_t sync_count;
+    int64_t last_sync_unix_us;   /* server time at the last sync, 0 = never synced */
+    int64_t last_sync_uptime_us; /* esp_timer time of the last sync */
+    int64_t last_offset_us;      /* server minus local clock at the last sync */
+    int64_t slew_pending_us;     /* adjtime() correction still outstanding (smooth mode) */
+    float drift_ppm;             /* local clock rate error, positive = local runs fast */
+    bool drift_valid;            /* false until two consecutive syncs bracketed a clean interval */
+    bool slewed;                 /* last correction was slewed (smooth mode) rather than stepped */
+    uint32_t sync_interval_ms;   /* interval until the next poll */
+} sntp_api_sync_info_t;
+
+/** @brief Sync hook; runs on the lwIP tcpip task after the clock was corrected, keep it short. */
+typedef void (*sntp_api_sync_cb_t)(const sntp_api_sync_info_t *info, void *user_ctx);
+
+/** @brief Redraw hook for event-driven mode; runs on the esp_timer task. */
+typedef void (*sntp_api_redraw_fn_t)(void *user_ctx);
+
 typedef struct {
     uint16_t bar_bg_color;
     uint16_t bar_fg_color;
@@ -53,12 +79,42 @@ esp_err_t sntp_api_init(const sntp_api_cfg_t *cfg);
 void sntp_api_deinit(void);
 /** @brief Return true when system time looks valid (already synced at least once). */
 bool sntp_api_is_time_valid(void);
+/** @brief Snapshot of the last sync; ESP_ERR_INVALID_STATE before sntp_api_init(). */
+esp_err_t sntp_api_get_sync_info(sntp_api_sync_info_t *out_info);
+/**
+ * @brief Register the sync listener (one slot, NULL clears).
+ *
+ * sntp_api overrides the weak sntp_sync_time() to measure the offset before
+ * applying it, so sntp_set_time_sync_notification_cb() hooks are not called.
+ */
+void sntp_api_set_sync_cb(sntp_api_sync_cb_t cb, void *user_ctx);
 /** @brief Format status text as "GMT±XX DD.MM.AAAA HH:MM". */
 esp_err_t sntp_api_format_status(char *out, size_t out_len);
 /** @brief Draw status bar immediately on top area of display. */
 void sntp_api_status_bar_draw(void);
-/** @brief Draw status bar only if min_period_ms elapsed since last draw. */
+/**
+ * @brief Forget what the bar last drew, so the next draw repaints all of it.
+ *
+ * Draws only send the characters that changed; call this after something
+ * else painted over the bar area.
+ */
+void sntp_api_status_bar_invalidate(void);
+/**
+ * @brief Ask the task that draws the bar to redraw it; safe from any task, never draws itself.
+ *
+ * Event-driven mode runs the redraw hook right away; polled mode draws at the
+ * next sntp_api_status_bar_update_if_due(), whatever its period.
+ */
+void sntp_api_status_bar_request_redraw(void);
+/** @brief Draw status bar only if min_period_ms elapsed since last draw (or a redraw was requested). */
 void sntp_api_status_bar_update_if_due(uint32_t min_period_ms);
+/**
+ * @brief Event-driven mode: redraw at each wall-clock minute edge, after SNTP syncs and style changes.
+ * @param redraw_fn Called instead of drawing on the esp_timer task (e.g. to post to a render task); NULL draws directly.
+ */
+esp_err_t sntp_api_status_bar_start_auto(sntp_api_redraw_fn_t redraw_fn, void *user_ctx);
+/** @brief Leave event-driven mode. */
+void sntp_api_status_bar_stop_auto(void);
 /** @brief Get current status bar style. */
 esp_err_t sntp_api_get_style(sntp_api_style_t *out_style);
 /** @brief Set status bar style and force redraw on next update. */
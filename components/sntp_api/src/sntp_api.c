@@ -5,8 +5,11 @@
 #include "sntp_api.h"
 
 #include <inttypes.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <time.h>
 
 #include "apps/esp_sntp.h"
@@ -15,11 +18,35 @@
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 
 #define SNTP_API_MIN_VALID_UNIX_TS 1577836800LL /* 2020-01-01 00:00:00 UTC */
+#define SNTP_API_MINUTE_US 60000000LL
+/* Fire slightly after the edge so the new minute is already visible to time(). */
+#define SNTP_API_EDGE_MARGIN_US 20000LL
+#define SNTP_API_KICK_US 1000ULL
+/* Larger offsets step the clock: adjtime() slews ~1.5%, so 2 s already takes minutes. */
+#define SNTP_API_SLEW_MAX_US 2000000LL
+/* Drift samples beyond this come from a manual settimeofday(), not the crystal. */
+#define SNTP_API_DRIFT_PLAUSIBLE_PPM 500.0
 
 static const char *TAG = "sntp_api";
 
+/* Last drawn bar: per-line origin and scale, reused until the style or width changes. */
+typedef struct {
+    bool valid;
+    int w;
+    int bar_h;
+    uint8_t date_scale;
+    uint8_t time_scale;
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+    char line1[24];
+    char line2[8];
+} sntp_bar_layout_t;
+
 typedef struct {
     bool initialized;
     int8_t gmt_offset_hours;
@@ -32,11 +59,24 @@ typedef struct {
     uint8_t line_gap_px;
     uint8_t date_char_spacing_px;
     uint8_t time_char_spacing_px;
-    int64_t last_draw_us;
-    char last_line[40];
+    bool use_framebuffer;
+    display_fb_t bar_fb;
+    int64_t last_draw_us; /* only touched by the drawing task */
+    bool redraw_due;      /* set from any task, consumed by the next poll or draw (atomic) */
+    sntp_bar_layout_t layout;
+    esp_timer_handle_t bar_timer;
+    bool bar_auto;
+    sntp_api_redraw_fn_t redraw_fn;
+    void *redraw_ctx;
+    uint32_t max_sync_interval_ms;
+    uint32_t max_error_ms;
+    sntp_api_sync_info_t sync; /* written on the tcpip task, guarded by s_sync_mux */
+    sntp_api_sync_cb_t sync_cb;
+    void *sync_cb_ctx;
 } sntp_api_ctx_t;
 
 static sntp_api_ctx_t g_sntp = {0};
+static portMUX_TYPE s_sync_mux = portMUX_INITIALIZER_UNLOCKED;
 
 static void style_from_ctx(sntp_api_style_t *style)
 {
@@ -53,34 +93,231 @@ static void style_from_ctx(sntp_api_style_t *style)
     style->time_char_spacing_px = g_sntp.time_char_spacing_px;
 }
 
-static int text_width_px(const char *s, const uint8_t scale, const uint8_t char_spacing_px)
+/* (Re)allocate the bar framebuffer when the bar geometry changed. */
+static esp_err_t bar_fb_prepare(int w, int bar_h)
+{
+    const display_rect_t *area = &g_sntp.bar_fb.area;
+    if (g_sntp.bar_fb.pixels != NULL && area->w == w && area->h == bar_h) {
+        return ESP_OK;
+    }
+    display_fb_deinit(&g_sntp.bar_fb);
+    esp_err_t err = display_fb_init(&g_sntp.bar_fb, 0, 0, w, bar_h);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "bar framebuffer unavailable (%s), drawing direct", esp_err_to_name(err));
+        g_sntp.use_framebuffer = false;
+    }
+    return err;
+}
+
+/* Recompute scales and line origins for the current style; only on style/width/length changes. */
+static void bar_layout_compute(sntp_bar_layout_t *lay, int w, const char *line1, const char *line2)
+{
+    int date_scale = (g_sntp.date_scale > 0U) ? (int)g_sntp.date_scale : ((int)g_sntp.text_scale + 1);
+    if (date_scale < 1) {
+        date_scale = 1;
+    }
+    while (date_scale > 1
+           && display_get_text_width(line1, (uint8_t)date_scale, g_sntp.date_char_spacing_px) > (w - 4)) {
+        date_scale--;
+    }
+
+    int time_scale = (g_sntp.time_scale > 0U) ? (int)g_sntp.time_scale : (date_scale * 2);
+    if (time_scale < 1) {
+        time_scale = 1;
+    }
+
+    const int line1_h = 7 * date_scale;
+    const int line2_h = 7 * time_scale;
+    const int pad = 2;
+    const int gap = (g_sntp.line_gap_px > 0U) ? (int)g_sntp.line_gap_px : (2 + line1_h);
+    const int x1 = (w - display_get_text_width(line1, (uint8_t)date_scale, g_sntp.date_char_spacing_px)) / 2;
+    const int x2 = (w - display_get_text_width(line2, (uint8_t)time_scale, g_sntp.time_char_spacing_px)) / 2;
+
+    lay->w = w;
+    lay->bar_h = pad + line1_h + gap + line2_h + pad;
+    lay->date_scale = (uint8_t)date_scale;
+    lay->time_scale = (uint8_t)time_scale;
+    lay->x1 = (x1 < 0) ? 0 : x1;
+    lay->y1 = pad;
+    lay->x2 = (x2 < 0) ? 0 : x2;
+    lay->y2 = pad + line1_h + gap;
+}
+
+/*
+ * Redraw only the character cells of `line` that differ from `prev` (all of
+ * them when prev is NULL); adjacent changed cells go out as one opaque run.
+ */
+static void draw_changed_cells(int x, int y, const char *prev, const char *line, uint8_t scale, uint8_t spacing)
 {
-    if (s == NULL) {
-        return 0;
+    const int step = display_get_text_width("0", scale, 0U) + (int)spacing;
+    char run[sizeof(g_sntp.layout.line1)];
+    const size_t len = strlen(line);
+    size_t i = 0;
+
+    while (i < len) {
+        if (prev != NULL && prev[i] == line[i]) {
+            i++;
+            continue;
+        }
+        size_t j = i;
+        while (j < len && (prev == NULL || prev[j] != line[j]) && (j - i) < (sizeof(run) - 1U)) {
+            run[j - i] = line[j];
+            j++;
+        }
+        run[j - i] = '\0';
+        display_draw_text_run(x + ((int)i * step), y, run, g_sntp.bar_fg_color, g_sntp.bar_bg_color, scale, spacing);
+        i = j;
     }
-    const int len = (int)strlen(s);
-    if (len <= 0) {
-        return 0;
+}
+
+/* Arm the bar timer for the next wall-clock minute edge. */
+static void bar_timer_arm_next_edge(void)
+{
+    struct timeval tv = {0};
+    gettimeofday(&tv, NULL);
+    const int64_t wall_us = ((int64_t)tv.tv_sec * 1000000LL) + (int64_t)tv.tv_usec;
+    const int64_t delay_us = SNTP_API_MINUTE_US - (wall_us % SNTP_API_MINUTE_US) + SNTP_API_EDGE_MARGIN_US;
+
+    (void)esp_timer_stop(g_sntp.bar_timer);
+    (void)esp_timer_start_once(g_sntp.bar_timer, (uint64_t)delay_us);
+}
+
+/* Redraw as soon as possible (time jump or style change); the callback re-arms to the next edge. */
+static void bar_timer_kick(void)
+{
+    if (!g_sntp.bar_auto) {
+        return;
     }
+    (void)esp_timer_stop(g_sntp.bar_timer);
+    (void)esp_timer_start_once(g_sntp.bar_timer, SNTP_API_KICK_US);
+}
 
-    const int glyph_w = 6 * (int)scale;
-    const int extra = (len > 1) ? ((len - 1) * (int)char_spacing_px) : 0;
-    return (len * glyph_w) + extra;
+/* Safe from any task: the drawing task owns last_draw_us, this only raises a flag for it. */
+static void bar_request_redraw(void)
+{
+    __atomic_store_n(&g_sntp.redraw_due, true, __ATOMIC_RELEASE);
 }
 
-static void draw_text_scaled_spaced(int x, int y, const char *s, uint16_t rgb565, uint8_t scale, uint8_t char_spacing_px)
+static void bar_timer_cb(void *arg)
 {
-    if (s == NULL || scale == 0U) {
+    (void)arg;
+    if (!g_sntp.bar_auto) {
         return;
     }
+    if (g_sntp.redraw_fn != NULL) {
+        g_sntp.redraw_fn(g_sntp.redraw_ctx);
+    } else {
+        sntp_api_status_bar_draw();
+    }
+    bar_timer_arm_next_edge();
+}
 
-    char one[2] = {0};
-    int cursor_x = x;
-    while (*s != '\0') {
-        one[0] = *s;
-        display_draw_text_minimal_scaled(cursor_x, y, one, rgb565, scale);
-        cursor_x += (6 * (int)scale) + (int)char_spacing_px;
-        s++;
+static int64_t timeval_to_us(const struct timeval *tv)
+{
+    return ((int64_t)tv->tv_sec * 1000000LL) + (int64_t)tv->tv_usec;
+}
+
+/*
+ * Next poll interval: keep |drift| * interval under max_error_ms, growing at
+ * most 2x per sync so one lucky sample cannot jump straight to the ceiling,
+ * and halving whenever the measured offset already exceeded the target.
+ */
+static uint32_t sync_interval_next(const sntp_api_sync_info_t *info)
+{
+    const uint32_t base_ms = g_sntp.sync_interval_ms;
+    const uint32_t cur_ms = info->sync_interval_ms;
+    if (g_sntp.max_sync_interval_ms <= base_ms || !info->drift_valid) {
+        return base_ms;
+    }
+    if (llabs(info->last_offset_us) > ((int64_t)g_sntp.max_error_ms * 1000LL)) {
+        return (cur_ms / 2U > base_ms) ? (cur_ms / 2U) : base_ms;
+    }
+
+    const double drift = fabs((double)info->drift_ppm);
+    double next_ms = (drift > 0.01) ? ((double)g_sntp.max_error_ms * 1e6 / drift) : (double)g_sntp.max_sync_interval_ms;
+    if (next_ms > 2.0 * (double)cur_ms) {
+        next_ms = 2.0 * (double)cur_ms;
+    }
+    if (next_ms > (double)g_sntp.max_sync_interval_ms) {
+        next_ms = (double)g_sntp.max_sync_interval_ms;
+    }
+    return (next_ms < (double)base_ms) ? base_ms : (uint32_t)next_ms;
+}
+
+/*
+ * Overrides the weak esp_sntp default with the same IMMED/SMOOTH handling,
+ * because the offset has to be read before the correction is applied.
+ * Runs on the lwIP tcpip task.
+ */
+void sntp_sync_time(struct timeval *tv)
+{
+    struct timeval now = {0};
+    struct timeval pending = {0};
+    gettimeofday(&now, NULL);
+    (void)adjtime(NULL, &pending);
+    const int64_t uptime_us = esp_timer_get_time();
+    const int64_t offset_us = timeval_to_us(tv) - timeval_to_us(&now);
+    const int64_t pending_us = timeval_to_us(&pending);
+
+    bool slewing = false;
+    if (sntp_get_sync_mode() == SNTP_SYNC_MODE_SMOOTH && llabs(offset_us) <= SNTP_API_SLEW_MAX_US) {
+        const struct timeval delta = {
+            .tv_sec = (time_t)(offset_us / 1000000LL),
+            .tv_usec = (suseconds_t)(offset_us % 1000000LL),
+        };
+        slewing = (adjtime(&delta, NULL) == 0);
+    }
+    if (slewing) {
+        sntp_set_sync_status(SNTP_SYNC_STATUS_IN_PROGRESS);
+    } else {
+        settimeofday(tv, NULL);
+        sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    }
+
+    portENTER_CRITICAL(&s_sync_mux);
+    sntp_api_sync_info_t info = g_sntp.sync;
+    portEXIT_CRITICAL(&s_sync_mux);
+
+    /*
+     * Between syncs the error grew from the slew still pending at the previous
+     * sync to the offset seen now; what adjtime() has not applied yet is part
+     * of both, so the clock itself gained (pending - offset) over the interval.
+     */
+    const int64_t elapsed_us = uptime_us - info.last_sync_uptime_us;
+    if (info.sync_count > 0U && elapsed_us > 0 && llabs(offset_us) <= SNTP_API_SLEW_MAX_US) {
+        const double sample_ppm = (double)(pending_us - offset_us) * 1e6 / (double)elapsed_us;
+        if (fabs(sample_ppm) <= SNTP_API_DRIFT_PLAUSIBLE_PPM) {
+            info.drift_ppm = info.drift_valid ? (float)((info.drift_ppm + sample_ppm) / 2.0) : (float)sample_ppm;
+            info.drift_valid = true;
+        }
+    }
+    info.sync_count++;
+    info.last_sync_unix_us = timeval_to_us(tv);
+    info.last_sync_uptime_us = uptime_us;
+    info.last_offset_us = offset_us;
+    info.slew_pending_us = slewing ? offset_us : 0;
+    info.slewed = slewing;
+
+    const uint32_t next_ms = sync_interval_next(&info);
+    if (next_ms != info.sync_interval_ms) {
+        /* lwIP reads the interval when it re-arms the poll right after this returns. */
+        esp_sntp_set_sync_interval(next_ms);
+        ESP_LOGI(TAG, "sync interval %" PRIu32 " -> %" PRIu32 " s (drift %" PRId32 " ppb)", info.sync_interval_ms / 1000U,
+                 next_ms / 1000U, (int32_t)(info.drift_ppm * 1000.0f));
+        info.sync_interval_ms = next_ms;
+    }
+
+    portENTER_CRITICAL(&s_sync_mux);
+    g_sntp.sync = info;
+    const sntp_api_sync_cb_t cb = g_sntp.sync_cb;
+    void *cb_ctx = g_sntp.sync_cb_ctx;
+    portEXIT_CRITICAL(&s_sync_mux);
+
+    /* The wall clock moved under the bar: polled mode redraws at the next update, auto mode now. */
+    bar_request_redraw();
+    bar_timer_kick();
+    if (cb != NULL) {
+        cb(&info, cb_ctx);
     }
 }
 
@@ -100,6 +337,9 @@ esp_err_t sntp_api_init(const sntp_api_cfg_t *cfg)
         .time_char_spacing_px = 0U,
     };
     const sntp_api_cfg_t *use_cfg = (cfg != NULL) ? cfg : &defaults;
+    const uint32_t max_interval_ms = (use_cfg->max_sync_interval_ms > SNTP_API_MAX_SYNC_INTERVAL_MS)
+                                         ? SNTP_API_MAX_SYNC_INTERVAL_MS
+                                         : use_cfg->max_sync_interval_ms;
 
     ESP_RETURN_ON_FALSE(use_cfg->server_name != NULL, ESP_ERR_INVALID_ARG, TAG, "server_name is null");
     ESP_RETURN_ON_FALSE(use_cfg->gmt_offset_hours >= -12 && use_cfg->gmt_offset_hours <= 14,
@@ -121,11 +361,21 @@ esp_err_t sntp_api_init(const sntp_api_cfg_t *cfg)
     if (use_cfg->sync_interval_ms >= SNTP_API_MIN_SYNC_INTERVAL_MS) {
         esp_sntp_set_sync_interval(use_cfg->sync_interval_ms);
     }
+    sntp_set_sync_mode(use_cfg->smooth_sync ? SNTP_SYNC_MODE_SMOOTH : SNTP_SYNC_MODE_IMMED);
+
+    /* Before esp_sntp_init(): the first reply may arrive on the tcpip task right away. */
+    g_sntp.sync_interval_ms = sntp_get_sync_interval();
+    g_sntp.max_sync_interval_ms = max_interval_ms;
+    g_sntp.max_error_ms = (use_cfg->max_error_ms > 0U) ? use_cfg->max_error_ms : SNTP_API_DEFAULT_MAX_ERROR_MS;
+    portENTER_CRITICAL(&s_sync_mux);
+    g_sntp.sync = (sntp_api_sync_info_t){
+        .sync_interval_ms = g_sntp.sync_interval_ms,
+    };
+    portEXIT_CRITICAL(&s_sync_mux);
     esp_sntp_init();
 
     g_sntp.initialized = true;
     g_sntp.gmt_offset_hours = use_cfg->gmt_offset_hours;
-    g_sntp.sync_interval_ms = use_cfg->sync_interval_ms;
     g_sntp.bar_bg_color = use_cfg->bar_bg_color;
     g_sntp.bar_fg_color = use_cfg->bar_fg_color;
     g_sntp.text_scale = use_cfg->text_scale;
@@ -134,22 +384,32 @@ esp_err_t sntp_api_init(const sntp_api_cfg_t *cfg)
     g_sntp.line_gap_px = use_cfg->line_gap_px;
     g_sntp.date_char_spacing_px = use_cfg->date_char_spacing_px;
     g_sntp.time_char_spacing_px = use_cfg->time_char_spacing_px;
+    g_sntp.use_framebuffer = use_cfg->use_framebuffer;
     g_sntp.last_draw_us = 0;
-    g_sntp.last_line[0] = '\0';
+    bar_request_redraw();
+    g_sntp.layout.valid = false;
 
-    ESP_LOGI(TAG, "SNTP started server=%s gmt_offset=%+d sync_interval_ms=%" PRIu32,
-             use_cfg->server_name, use_cfg->gmt_offset_hours, use_cfg->sync_interval_ms);
+    ESP_LOGI(TAG, "SNTP started server=%s gmt_offset=%+d sync_interval_ms=%" PRIu32 " max=%" PRIu32 " smooth=%d",
+             use_cfg->server_name, use_cfg->gmt_offset_hours, g_sntp.sync_interval_ms, max_interval_ms,
+             use_cfg->smooth_sync ? 1 : 0);
     return ESP_OK;
 }
 
 void sntp_api_deinit(void)
 {
+    sntp_api_status_bar_stop_auto();
+    if (g_sntp.bar_timer != NULL) {
+        (void)esp_timer_delete(g_sntp.bar_timer);
+        g_sntp.bar_timer = NULL;
+    }
     if (esp_sntp_enabled()) {
         esp_sntp_stop();
     }
     g_sntp.initialized = false;
+    display_fb_deinit(&g_sntp.bar_fb);
     g_sntp.last_draw_us = 0;
-    g_sntp.last_line[0] = '\0';
+    __atomic_store_n(&g_sntp.redraw_due, false, __ATOMIC_RELAXED);
+    g_sntp.layout.valid = false;
 }
 
 bool sntp_api_is_time_valid(void)
@@ -159,6 +419,31 @@ bool sntp_api_is_time_valid(void)
     return (int64_t)now >= SNTP_API_MIN_VALID_UNIX_TS;
 }
 
+esp_err_t sntp_api_get_sync_info(sntp_api_sync_info_t *out_info)
+{
+    ESP_RETURN_ON_FALSE(out_info != NULL, ESP_ERR_INVALID_ARG, TAG, "out_info is null");
+    ESP_RETURN_ON_FALSE(g_sntp.initialized, ESP_ERR_INVALID_STATE, TAG, "SNTP not initialized");
+
+    portENTER_CRITICAL(&s_sync_mux);
+    *out_info = g_sntp.sync;
+    portEXIT_CRITICAL(&s_sync_mux);
+
+    if (out_info->slewed) {
+        struct timeval pending = {0};
+        (void)adjtime(NULL, &pending);
+        out_info->slew_pending_us = timeval_to_us(&pending);
+    }
+    return ESP_OK;
+}
+
+void sntp_api_set_sync_cb(sntp_api_sync_cb_t cb, void *user_ctx)
+{
+    portENTER_CRITICAL(&s_sync_mux);
+    g_sntp.sync_cb = cb;
+    g_sntp.sync_cb_ctx = user_ctx;
+    portEXIT_CRITICAL(&s_sync_mux);
+}
+
 esp_err_t sntp_api_format_status(char *out, size_t out_len)
 {
     ESP_RETURN_ON_FALSE(out != NULL, ESP_ERR_INVALID_ARG, TAG, "out is null");
@@ -218,6 +503,8 @@ void sntp_api_status_bar_draw(void)
     if (w <= 0) {
         return;
     }
+    /* Cleared before reading the clock, so a request raised mid-draw gets its own redraw. */
+    __atomic_store_n(&g_sntp.redraw_due, false, __ATOMIC_RELAXED);
 
     const int offset_h = g_sntp.initialized ? g_sntp.gmt_offset_hours : 0;
     int offset = offset_h;
@@ -251,56 +538,61 @@ void sntp_api_status_bar_draw(void)
         year = 9999;
     }
 
-    char line1[24] = {0};
-    char line2[8] = {0};
-    char key[40] = {0};
+    char line1[sizeof(g_sntp.layout.line1)] = {0};
+    char line2[sizeof(g_sntp.layout.line2)] = {0};
 
     snprintf(line1, sizeof(line1), "GMT%+03d %02d.%02d.%04d",
              offset, day, month, year);
     snprintf(line2, sizeof(line2), "%02d:%02d", tm_local.tm_hour, tm_local.tm_min);
-    snprintf(key, sizeof(key), "%s|%s", line1, line2);
 
-    if (strcmp(key, g_sntp.last_line) == 0) {
+    sntp_bar_layout_t *lay = &g_sntp.layout;
+    /* A direct draw over the composed bar desynced it, so the panel no longer shows lay->line*. */
+    const bool bar_lost = g_sntp.use_framebuffer && g_sntp.bar_fb.pixels != NULL && !g_sntp.bar_fb.synced;
+    const bool relayout = !lay->valid || bar_lost || lay->w != w
+                          || strlen(lay->line1) != strlen(line1) || strlen(lay->line2) != strlen(line2);
+
+    if (!relayout && strcmp(line1, lay->line1) == 0 && strcmp(line2, lay->line2) == 0) {
         g_sntp.last_draw_us = esp_timer_get_time();
         return;
     }
 
-    int date_scale = (g_sntp.date_scale > 0U) ? (int)g_sntp.date_scale : ((int)g_sntp.text_scale + 1);
-    if (date_scale < 1) {
-        date_scale = 1;
-    }
-    while (date_scale > 1
-           && text_width_px(line1, (uint8_t)date_scale, g_sntp.date_char_spacing_px) > (w - 4)) {
-        date_scale--;
+    if (relayout) {
+        bar_layout_compute(lay, w, line1, line2);
     }
 
-    int time_scale = (g_sntp.time_scale > 0U) ? (int)g_sntp.time_scale : (date_scale * 2);
-    if (time_scale < 1) {
-        time_scale = 1;
+    bool composing = false;
+    if (g_sntp.use_framebuffer) {
+        composing = (bar_fb_prepare(w, lay->bar_h) == ESP_OK) && (display_fb_begin(&g_sntp.bar_fb) == ESP_OK);
     }
-
-    const int line1_h = 7 * date_scale;
-    const int line2_h = 7 * time_scale;
-    const int pad = 2;
-    const int gap = (g_sntp.line_gap_px > 0U) ? (int)g_sntp.line_gap_px : (2 + line1_h);
-    const int bar_h = pad + line1_h + gap + line2_h + pad;
-    int x1 = (w - text_width_px(line1, (uint8_t)date_scale, g_sntp.date_char_spacing_px)) / 2;
-    int x2 = (w - text_width_px(line2, (uint8_t)time_scale, g_sntp.time_char_spacing_px)) / 2;
-    if (x1 < 0) {
-        x1 = 0;
+    if (relayout) {
+        display_draw_rect(0, 0, w, lay->bar_h, g_sntp.bar_bg_color);
     }
-    if (x2 < 0) {
-        x2 = 0;
+    draw_changed_cells(lay->x1, lay->y1, relayout ? NULL : lay->line1, line1, lay->date_scale, g_sntp.date_char_spacing_px);
+    draw_changed_cells(lay->x2, lay->y2, relayout ? NULL : lay->line2, line2, lay->time_scale, g_sntp.time_char_spacing_px);
+    if (composing) {
+        (void)display_flush();
     }
-    display_draw_rect(0, 0, w, bar_h, g_sntp.bar_bg_color);
-    draw_text_scaled_spaced(x1, pad, line1, g_sntp.bar_fg_color, (uint8_t)date_scale, g_sntp.date_char_spacing_px);
-    draw_text_scaled_spaced(x2, pad + line1_h + gap, line2, g_sntp.bar_fg_color, (uint8_t)time_scale, g_sntp.time_char_spacing_px);
 
-    strncpy(g_sntp.last_line, key, sizeof(g_sntp.last_line));
-    g_sntp.last_line[sizeof(g_sntp.last_line) - 1] = '\0';
+    strlcpy(lay->line1, line1, sizeof(lay->line1));
+    strlcpy(lay->line2, line2, sizeof(lay->line2));
+    lay->valid = true;
     g_sntp.last_draw_us = esp_timer_get_time();
 }
 
+void sntp_api_status_bar_invalidate(void)
+{
+    g_sntp.layout.valid = false;
+}
+
+void sntp_api_status_bar_request_redraw(void)
+{
+    if (!g_sntp.initialized) {
+        return;
+    }
+    bar_request_redraw();
+    bar_timer_kick();
+}
+
 void sntp_api_status_bar_update_if_due(uint32_t min_period_ms)
 {
     if (!g_sntp.initialized) {
@@ -309,13 +601,44 @@ void sntp_api_status_bar_update_if_due(uint32_t min_period_ms)
 
     const uint32_t period_ms = (min_period_ms == 0U) ? 1000U : min_period_ms;
     const int64_t now_us = esp_timer_get_time();
-    if (g_sntp.last_draw_us != 0 && (now_us - g_sntp.last_draw_us) < ((int64_t)period_ms * 1000LL)) {
+    const bool forced = __atomic_load_n(&g_sntp.redraw_due, __ATOMIC_ACQUIRE);
+    if (!forced && g_sntp.last_draw_us != 0 && (now_us - g_sntp.last_draw_us) < ((int64_t)period_ms * 1000LL)) {
         return;
     }
 
     sntp_api_status_bar_draw();
 }
 
+esp_err_t sntp_api_status_bar_start_auto(sntp_api_redraw_fn_t redraw_fn, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(g_sntp.initialized, ESP_ERR_INVALID_STATE, TAG, "SNTP not initialized");
+
+    if (g_sntp.bar_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = bar_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "sntp_bar",
+            .skip_unhandled_events = true,
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &g_sntp.bar_timer), TAG, "bar timer create failed");
+    }
+
+    g_sntp.redraw_fn = redraw_fn;
+    g_sntp.redraw_ctx = user_ctx;
+    g_sntp.bar_auto = true;
+    bar_timer_kick();
+    return ESP_OK;
+}
+
+void sntp_api_status_bar_stop_auto(void)
+{
+    g_sntp.bar_auto = false;
+    if (g_sntp.bar_timer != NULL) {
+        (void)esp_timer_stop(g_sntp.bar_timer);
+    }
+}
+
 esp_err_t sntp_api_get_style(sntp_api_style_t *out_style)
 {
     ESP_RETURN_ON_FALSE(out_style != NULL, ESP_ERR_INVALID_ARG, TAG, "out_style is null");
@@ -340,8 +663,9 @@ esp_err_t sntp_api_set_style(const sntp_api_style_t *style)
     g_sntp.date_char_spacing_px = style->date_char_spacing_px;
     g_sntp.time_char_spacing_px = style->time_char_spacing_px;
 
-    /* Force redraw even if time text did not change. */
-    g_sntp.last_line[0] = '\0';
-    g_sntp.last_draw_us = 0;
+    /* Force a full relayout and redraw even if time text did not change. */
+    g_sntp.layout.valid = false;
+    bar_request_redraw();
+    bar_timer_kick();
     return ESP_OK;
 }
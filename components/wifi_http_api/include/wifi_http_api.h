@@ -23,12 +23,44 @@ typedef struct {
     uint8_t ap_channel;
     uint8_t ap_max_connection;
     wifi_mode_t start_mode;
+    bool sta_modem_sleep; /* WIFI_PS_MIN_MODEM while connected in STA-only mode, WIFI_PS_NONE otherwise */
 } wifi_http_api_cfg_t;
 
+/** @brief Row sink handed to a history source; returns false to stop (client gone). */
+typedef bool (*wifi_http_api_history_row_fn_t)(uint32_t time_s, float temperature_c, float humidity_rh, void *row_ctx);
+
+/**
+ * @brief Sensor history provider for GET /api/history (runs on the httpd task).
+ *
+ * Must call row_fn for rows with from_s <= time_s <= to_s in ascending time
+ * order and stop when it returns false.
+ */
+typedef esp_err_t (*wifi_http_api_history_fn_t)(uint32_t from_s,
+                                                uint32_t to_s,
+                                                wifi_http_api_history_row_fn_t row_fn,
+                                                void *row_ctx,
+                                                void *user_ctx);
+
 esp_err_t wifi_http_api_init(const wifi_http_api_cfg_t *cfg);
 void wifi_http_api_deinit(void);
 bool wifi_http_api_sta_connected(void);
 const char *wifi_http_api_sta_ip(void);
+/** @brief Install (or clear with NULL) the provider behind GET /api/history. */
+void wifi_http_api_set_history_source(wifi_http_api_history_fn_t fn, void *user_ctx);
+/**
+ * @brief Publish a JSON payload on the GET /api/events stream (any task).
+ *
+ * The last payload per event name is kept and replayed to new clients;
+ * a payload equal to the previous one for that name is not re-sent.
+ * @return ESP_ERR_INVALID_STATE, without logging, before wifi_http_api_init() set the server up.
+ */
+esp_err_t wifi_http_api_events_publish(const char *event, const char *json);
+/**
+ * @brief Publish the built-in `sntp` event from the current sntp_api state (any task).
+ *
+ * Call it from the sntp_api sync callback; nothing polls for it.
+ */
+void wifi_http_api_events_publish_sntp(void);
 
 #ifdef __cplusplus
 }
@@ -5,12 +5,18 @@
 #include "wifi_http_api.h"
 
 #include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <unistd.h>
 
-#include "cJSON.h"
+#include "bench_api.h"
 #include "display_api.h"
+#include "display_server.h"
 #include "esp_check.h"
 #include "esp_event.h"
 #include "esp_http_server.h"
@@ -18,28 +24,91 @@
 #include "esp_netif.h"
 #include "esp_timer.h"
 #include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
 #include "nvs.h"
 #include "nvs_flash.h"
+#include "perf_api.h"
 #include "sntp_api.h"
 
 #define WIFI_HTTP_API_NVS_NAMESPACE "wifi_http"
 #define WIFI_HTTP_API_NVS_STA_SSID "sta_ssid"
 #define WIFI_HTTP_API_NVS_STA_PASS "sta_pass"
 #define WIFI_HTTP_API_MAX_JSON_BODY 512
+#define WIFI_HTTP_API_JSON_MAX_FIELDS 16U
 #define WIFI_HTTP_API_DEFAULT_BRIGHTNESS 90U
 #define WIFI_HTTP_API_MAX_TEXT_SCALE 16U
+#define WIFI_HTTP_API_HISTORY_CHUNK 512U
+#define WIFI_HTTP_API_HISTORY_ROW_MAX 40U /* longest CSV row incl. newline */
+#define WIFI_HTTP_API_MAX_QUERY 96U
+#define WIFI_HTTP_API_JSON_CHUNK 256U
+#define WIFI_HTTP_API_JSON_MAX_DEPTH 4U
+/* The UI only changes with the firmware, so always revalidate; a hit costs one 304. */
+#define WIFI_HTTP_API_UI_CACHE_CONTROL "no-cache"
+#define WIFI_HTTP_API_MAX_IF_NONE_MATCH 64U
+#define WIFI_HTTP_API_SCAN_MAX_APS 16U
+/* Server-Sent Events: each client pins one of the httpd's max_open_sockets (default 7). */
+#define WIFI_HTTP_API_EVENTS_MAX_CLIENTS 3U
+#define WIFI_HTTP_API_EVENTS_TOPICS 6U
+#define WIFI_HTTP_API_EVENTS_NAME_MAX 12U
+#define WIFI_HTTP_API_EVENTS_DATA_MAX 112U
+#define WIFI_HTTP_API_EVENTS_KEEPALIVE_MS 15000U /* timer runs only while a client is connected */
+#define WIFI_HTTP_API_BENCH_FILTER_MAX 64U
+#define WIFI_HTTP_API_BENCH_TIMEOUT_S 2
+/* Largest frame: display POST, json_body_t (~900 B) plus json_writer_t (~300 B); 2 KB spare over the 4 KB default. */
+#define WIFI_HTTP_API_HTTPD_STACK 6144U
 
 static const char *TAG = "wifi_http_api";
 
+/* web/index.html, gzip'd at build time (see CMakeLists.txt). */
+extern const uint8_t s_web_ui_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t s_web_ui_gz_end[] asm("_binary_index_html_gz_end");
+
+/* Trimmed scan result kept between scans (wifi_ap_record_t is ~80 bytes). */
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t authmode;
+} wifi_http_api_scan_ap_t;
+
+typedef struct {
+    int64_t done_us; /* 0 = no completed scan yet */
+    uint16_t count;
+    bool in_progress;
+    wifi_http_api_scan_ap_t aps[WIFI_HTTP_API_SCAN_MAX_APS];
+} wifi_http_api_scan_cache_t;
+
+/* Latest payload per event name; bit i of dirty is set until client slot i got it. */
+typedef struct {
+    char name[WIFI_HTTP_API_EVENTS_NAME_MAX];
+    char data[WIFI_HTTP_API_EVENTS_DATA_MAX];
+    uint8_t dirty;
+} wifi_http_api_event_topic_t;
+
+_Static_assert(WIFI_HTTP_API_EVENTS_MAX_CLIENTS <= 8U, "dirty is one bit per client slot");
+#define WIFI_HTTP_API_EVENTS_ALL_CLIENTS ((uint8_t)((1U << WIFI_HTTP_API_EVENTS_MAX_CLIENTS) - 1U))
+
+typedef struct {
+    SemaphoreHandle_t lock; /* guards topics and work_queued */
+    esp_timer_handle_t keepalive_timer;
+    wifi_http_api_event_topic_t topics[WIFI_HTTP_API_EVENTS_TOPICS];
+    bool work_queued;
+    int client_fd[WIFI_HTTP_API_EVENTS_MAX_CLIENTS]; /* httpd task only; -1 = free */
+} wifi_http_api_events_t;
+
 typedef struct {
     bool initialized;
     bool sta_connected;
     esp_netif_t *netif_sta;
     esp_netif_t *netif_ap;
     httpd_handle_t httpd;
+    uint16_t http_port;
     esp_event_handler_instance_t wifi_evt_inst;
     esp_event_handler_instance_t ip_evt_inst;
     wifi_mode_t mode;
+    bool sta_modem_sleep;
     char sta_ssid[33];
     char sta_pass[65];
     char sta_ip[16];
@@ -49,89 +118,69 @@ typedef struct {
     uint8_t ap_max_connection;
     uint8_t display_brightness_pct;
     sntp_api_style_t sntp_style_cache;
+    wifi_http_api_history_fn_t history_fn;
+    void *history_ctx;
+    char ui_etag[19]; /* quoted 64-bit content hash */
+    SemaphoreHandle_t scan_lock; /* guards scan; filled on the event task */
+    wifi_http_api_scan_cache_t scan;
+    wifi_http_api_events_t events;
+    uint32_t httpd_stack_free_min; /* bytes never touched on the httpd stack; httpd task only */
 } wifi_http_api_ctx_t;
 
-static wifi_http_api_ctx_t g_wifi = {0};
+/*
+ * Streaming JSON emitter for responses. Output goes into a stack buffer; a
+ * response that fits is sent in one piece, a larger one switches to chunked
+ * transfer. Errors latch in err and turn later calls into no-ops.
+ */
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t err;
+    bool chunked;
+    uint8_t depth;
+    bool need_comma[WIFI_HTTP_API_JSON_MAX_DEPTH + 1U];
+    size_t len;
+    char buf[WIFI_HTTP_API_JSON_CHUNK];
+} json_writer_t;
+
+typedef enum {
+    JSON_FIELD_NULL = 0,
+    JSON_FIELD_BOOL,
+    JSON_FIELD_NUMBER,
+    JSON_FIELD_STRING,
+} json_field_kind_t;
 
-static const char *s_web_ui_html =
-    "<!doctype html><html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'>"
-    "<title>ESP32-C6 Wi-Fi</title><style>body{font-family:monospace;background:#101418;color:#e6edf3;padding:16px}"
-    "input,select,button{margin:4px 0;padding:8px;background:#1d2733;color:#e6edf3;border:1px solid #304055;border-radius:6px}"
-    "button{cursor:pointer}pre{background:#0b1016;padding:12px;border-radius:8px;overflow:auto}section{border:1px solid #304055;padding:12px;border-radius:10px;margin:10px 0}"
-    "</style></head><body><h3>ESP32-C6 Wi-Fi Config</h3>"
-    "<section><h4>Status</h4><button onclick='status()'>Refresh</button><pre id='out'>{}</pre></section>"
-    "<section><h4>Mode</h4><select id='mode'><option>AP</option><option>STA</option><option>APSTA</option></select>"
-    "<button onclick='setMode()'>Apply Mode</button></section>"
-    "<section><h4>AP Config</h4>SSID<br><input id='ap_ssid' value='ESP32C6-Setup'><br>Password (blank=open)<br><input id='ap_pass' value='12345678'>"
-    "<br>Channel<br><input id='ap_ch' value='1' type='number' min='1' max='13'><br><button onclick='setAp()'>Apply AP</button></section>"
-    "<section><h4>STA Config</h4>SSID<br><input id='sta_ssid'><br>Password<br><input id='sta_pass' type='password'>"
-    "<br><button onclick='setSta()'>Save+Connect STA</button> <button onclick='disconnectSta()'>Disconnect STA</button>"
-    "<br><button onclick='scan()'>Scan APs</button><pre id='scan'></pre></section>"
-    "<section><h4>Display / SNTP Bar</h4>"
-    "Brightness (0..100)<br><input id='disp_br' value='90' type='number' min='0' max='100'>"
-    "<br>Background RGB565 (e.g. 0x0000)<br><input id='bar_bg' value='0x0000'>"
-    "<br>Foreground RGB565 (e.g. 0xFFFF)<br><input id='bar_fg' value='0xFFFF'>"
-    "<br>Base scale<br><input id='txt_scale' value='1' type='number' min='1' max='16'>"
-    "<br>Date scale (0=auto)<br><input id='date_scale' value='0' type='number' min='0' max='16'>"
-    "<br>Time scale (0=auto)<br><input id='time_scale' value='0' type='number' min='0' max='16'>"
-    "<br>Line gap px (0=auto)<br><input id='line_gap' value='0' type='number' min='0' max='120'>"
-    "<br>Date char spacing px<br><input id='date_sp' value='0' type='number' min='0' max='20'>"
-    "<br>Time char spacing px<br><input id='time_sp' value='0' type='number' min='0' max='20'>"
-    "<br><button onclick='loadDisplay()'>Load Display Config</button> <button onclick='setDisplay()'>Apply Display Config</button>"
-    "<pre id='disp'></pre></section>"
-    "<script>"
-    "const el=id=>document.getElementById(id);"
-    "const show=(id,v)=>{el(id).textContent=JSON.stringify(v,null,2);};"
-    "const color565=v=>{const n=Number(v)||0;return '0x'+n.toString(16).toUpperCase().padStart(4,'0');};"
-    "const j=async(u,m,d)=>{"
-    "try{"
-    "const r=await fetch(u,{method:m,headers:{'Content-Type':'application/json'},body:d?JSON.stringify(d):undefined});"
-    "const t=await r.text();"
-    "let o;"
-    "try{o=JSON.parse(t);}catch(_){o={ok:false,error:t||r.statusText};}"
-    "if(!r.ok&&o.ok===undefined)o.ok=false;"
-    "return o;"
-    "}catch(e){return {ok:false,error:String(e)};}"
-    "};"
-    "async function status(){"
-    "const s=await j('/api/status','GET');"
-    "show('out',s);"
-    "if(s&&s.ok){"
-    "if(s.mode)el('mode').value=s.mode;"
-    "if(s.ap){el('ap_ssid').value=s.ap.ssid||'';el('ap_ch').value=s.ap.channel||1;}"
-    "if(s.sta){el('sta_ssid').value=s.sta.ssid||'';}"
-    "}"
-    "}"
-    "async function scan(){show('scan',await j('/api/scan','GET'));}"
-    "async function setMode(){show('out',await j('/api/mode','POST',{mode:el('mode').value}));status();}"
-    "async function setAp(){show('out',await j('/api/ap','POST',{ssid:el('ap_ssid').value,password:el('ap_pass').value,channel:Number(el('ap_ch').value)}));status();}"
-    "async function setSta(){show('out',await j('/api/sta','POST',{ssid:el('sta_ssid').value,password:el('sta_pass').value,connect:true}));status();}"
-    "async function disconnectSta(){show('out',await j('/api/sta/disconnect','POST',{}));status();}"
-    "async function loadDisplay(){"
-    "const d=await j('/api/display','GET');"
-    "show('disp',d);"
-    "if(!d.ok)return;"
-    "el('disp_br').value=d.brightness;"
-    "el('bar_bg').value=color565(d.bar_bg_color);"
-    "el('bar_fg').value=color565(d.bar_fg_color);"
-    "el('txt_scale').value=d.text_scale;"
-    "el('date_scale').value=d.date_scale;"
-    "el('time_scale').value=d.time_scale;"
-    "el('line_gap').value=d.line_gap_px;"
-    "el('date_sp').value=d.date_char_spacing_px;"
-    "el('time_sp').value=d.time_char_spacing_px;"
-    "}"
-    "async function setDisplay(){"
-    "const d=await j('/api/display','POST',{"
-    "brightness:Number(el('disp_br').value),bar_bg_color:el('bar_bg').value,bar_fg_color:el('bar_fg').value,"
-    "text_scale:Number(el('txt_scale').value),date_scale:Number(el('date_scale').value),time_scale:Number(el('time_scale').value),"
-    "line_gap_px:Number(el('line_gap').value),date_char_spacing_px:Number(el('date_sp').value),time_char_spacing_px:Number(el('time_sp').value),"
-    "redraw:true});"
-    "show('disp',d);"
-    "}"
-    "status();"
-    "loadDisplay();"
-    "</script></body></html>";
+typedef struct {
+    const char *key;
+    const char *str; /* JSON_FIELD_STRING */
+    double num;      /* JSON_FIELD_NUMBER; 1/0 for JSON_FIELD_BOOL */
+    json_field_kind_t kind;
+} json_field_t;
+
+/*
+ * Request body parsed in place: a flat object of scalars, which is all the
+ * POST endpoints accept. Lives on the httpd task stack (sized for it, see
+ * WIFI_HTTP_API_HTTPD_STACK), so parsing never touches the heap.
+ */
+typedef struct {
+    char buf[WIFI_HTTP_API_MAX_JSON_BODY + 1];
+    json_field_t fields[WIFI_HTTP_API_JSON_MAX_FIELDS];
+    size_t count;
+} json_body_t;
+
+/* Per-request streaming state for GET /api/history; lives on the httpd task stack. */
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t err;
+    bool binary;
+    bool any_row;
+    uint32_t step_s;
+    uint32_t next_s;
+    uint32_t rows;
+    size_t len;
+    char buf[WIFI_HTTP_API_HISTORY_CHUNK];
+} history_stream_t;
+
+static wifi_http_api_ctx_t g_wifi = {0};
 
 static const char *mode_to_str(const wifi_mode_t mode)
 {
@@ -227,88 +276,467 @@ static esp_err_t nvs_load_sta_credentials(char *ssid, size_t ssid_len, char *pas
     return err;
 }
 
-static esp_err_t read_json_body(httpd_req_t *req, char *buf, size_t buf_len, cJSON **out_json)
+static size_t json_utf8_put(char *dst, uint32_t cp)
+{
+    if (cp < 0x80U) {
+        dst[0] = (char)cp;
+        return 1U;
+    }
+    if (cp < 0x800U) {
+        dst[0] = (char)(0xC0U | (cp >> 6));
+        dst[1] = (char)(0x80U | (cp & 0x3FU));
+        return 2U;
+    }
+    if (cp < 0x10000U) {
+        dst[0] = (char)(0xE0U | (cp >> 12));
+        dst[1] = (char)(0x80U | ((cp >> 6) & 0x3FU));
+        dst[2] = (char)(0x80U | (cp & 0x3FU));
+        return 3U;
+    }
+    dst[0] = (char)(0xF0U | (cp >> 18));
+    dst[1] = (char)(0x80U | ((cp >> 12) & 0x3FU));
+    dst[2] = (char)(0x80U | ((cp >> 6) & 0x3FU));
+    dst[3] = (char)(0x80U | (cp & 0x3FU));
+    return 4U;
+}
+
+static bool json_hex4(const char *p, uint32_t *out)
+{
+    uint32_t v = 0U;
+    for (int i = 0; i < 4; i++) {
+        const char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') {
+            v |= (uint32_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            v |= (uint32_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            v |= (uint32_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    *out = v;
+    return true;
+}
+
+/* Unescape the string starting after its opening quote in place; *pp ends past the closing quote. */
+static const char *json_parse_string(char **pp)
+{
+    char *src = *pp;
+    char *dst = src;
+    const char *start = src;
+    while (*src != '"') {
+        if (*src == '\0' || (unsigned char)*src < 0x20U) {
+            return NULL;
+        }
+        if (*src != '\\') {
+            *dst++ = *src++;
+            continue;
+        }
+        src++;
+        uint32_t cp = 0U;
+        switch (*src) {
+        case '"': case '\\': case '/': cp = (uint32_t)*src; break;
+        case 'b': cp = '\b'; break;
+        case 'f': cp = '\f'; break;
+        case 'n': cp = '\n'; break;
+        case 'r': cp = '\r'; break;
+        case 't': cp = '\t'; break;
+        case 'u':
+            if (!json_hex4(src + 1, &cp)) {
+                return NULL;
+            }
+            src += 4;
+            if (cp >= 0xD800U && cp <= 0xDBFFU) {
+                uint32_t lo = 0U;
+                if (src[1] != '\\' || src[2] != 'u' || !json_hex4(src + 3, &lo) || lo < 0xDC00U || lo > 0xDFFFU) {
+                    return NULL;
+                }
+                cp = 0x10000U + ((cp - 0xD800U) << 10) + (lo - 0xDC00U);
+                src += 6;
+            } else if (cp >= 0xDC00U && cp <= 0xDFFFU) {
+                return NULL;
+            }
+            break;
+        default:
+            return NULL;
+        }
+        src++;
+        /* An escape is never shorter than its UTF-8 encoding, so dst cannot overtake src. */
+        dst += json_utf8_put(dst, cp);
+    }
+    *dst = '\0';
+    *pp = src + 1;
+    return start;
+}
+
+static char *json_skip_ws(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+static bool json_parse_value(char **pp, json_field_t *f)
+{
+    char *p = *pp;
+    if (*p == '"') {
+        p++;
+        f->kind = JSON_FIELD_STRING;
+        f->str = json_parse_string(&p);
+        if (f->str == NULL) {
+            return false;
+        }
+    } else if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+        f->kind = JSON_FIELD_BOOL;
+        f->num = (*p == 't') ? 1.0 : 0.0;
+        p += (*p == 't') ? 4 : 5;
+    } else if (strncmp(p, "null", 4) == 0) {
+        f->kind = JSON_FIELD_NULL;
+        p += 4;
+    } else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+        char *end = NULL;
+        f->kind = JSON_FIELD_NUMBER;
+        f->num = strtod(p, &end);
+        /* strtod also takes "-nan", "-inf" and overflows to inf; JSON has none of them. */
+        if (end == p || !isfinite(f->num)) {
+            return false;
+        }
+        p = end;
+    } else {
+        /* Nested objects and arrays: no endpoint takes one. */
+        return false;
+    }
+    *pp = p;
+    return true;
+}
+
+/* Parse a flat JSON object in place; keys and string values point into body->buf. */
+static bool json_body_parse(json_body_t *body)
+{
+    body->count = 0U;
+    char *p = json_skip_ws(body->buf);
+    if (*p++ != '{') {
+        return false;
+    }
+    p = json_skip_ws(p);
+    if (*p == '}') {
+        return *json_skip_ws(p + 1) == '\0';
+    }
+
+    for (;;) {
+        if (*p++ != '"' || body->count >= WIFI_HTTP_API_JSON_MAX_FIELDS) {
+            return false;
+        }
+        json_field_t *f = &body->fields[body->count++];
+        *f = (json_field_t){0};
+        f->key = json_parse_string(&p);
+        if (f->key == NULL) {
+            return false;
+        }
+        p = json_skip_ws(p);
+        if (*p++ != ':') {
+            return false;
+        }
+        p = json_skip_ws(p);
+        if (!json_parse_value(&p, f)) {
+            return false;
+        }
+        p = json_skip_ws(p);
+        if (*p == '}') {
+            return *json_skip_ws(p + 1) == '\0';
+        }
+        if (*p++ != ',') {
+            return false;
+        }
+        p = json_skip_ws(p);
+    }
+}
+
+/* First field named key, compared case-insensitively; NULL when absent. */
+static const json_field_t *json_body_get(const json_body_t *body, const char *key)
 {
-    if (req == NULL || buf == NULL || out_json == NULL) {
+    for (size_t i = 0; i < body->count; i++) {
+        if (strcasecmp(body->fields[i].key, key) == 0) {
+            return &body->fields[i];
+        }
+    }
+    return NULL;
+}
+
+static bool json_field_is(const json_field_t *f, json_field_kind_t kind)
+{
+    return (f != NULL) && (f->kind == kind);
+}
+
+/* Number truncated toward zero, saturating at the int range. */
+static int json_field_int(const json_field_t *f)
+{
+    if (f->num >= (double)INT_MAX) {
+        return INT_MAX;
+    }
+    if (f->num <= (double)INT_MIN) {
+        return INT_MIN;
+    }
+    return (int)f->num;
+}
+
+static esp_err_t read_json_body(httpd_req_t *req, json_body_t *body)
+{
+    if (req == NULL || body == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (req->content_len <= 0 || req->content_len >= (int)buf_len) {
+    if (req->content_len <= 0 || req->content_len >= (int)sizeof(body->buf)) {
         return ESP_ERR_INVALID_SIZE;
     }
 
     int received = 0;
     while (received < req->content_len) {
-        int r = httpd_req_recv(req, buf + received, req->content_len - received);
+        int r = httpd_req_recv(req, body->buf + received, req->content_len - received);
         if (r <= 0) {
             return ESP_FAIL;
         }
         received += r;
     }
-    buf[received] = '\0';
-
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    body->buf[received] = '\0';
 
-    *out_json = root;
-    return ESP_OK;
+    return json_body_parse(body) ? ESP_OK : ESP_ERR_INVALID_ARG;
 }
 
 static void set_http_status(httpd_req_t *req, int status)
 {
     if (status == 200) {
         httpd_resp_set_status(req, "200 OK");
+    } else if (status == 304) {
+        httpd_resp_set_status(req, "304 Not Modified");
+    } else if (status == 202) {
+        httpd_resp_set_status(req, "202 Accepted");
     } else if (status == 400) {
         httpd_resp_set_status(req, "400 Bad Request");
+    } else if (status == 409) {
+        httpd_resp_set_status(req, "409 Conflict");
+    } else if (status == 503) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
     } else if (status == 500) {
         httpd_resp_set_status(req, "500 Internal Server Error");
     }
 }
 
-static esp_err_t send_json_response(httpd_req_t *req, int status, cJSON *json)
+static void json_flush(json_writer_t *w)
+{
+    if (w->err != ESP_OK || w->len == 0U) {
+        return;
+    }
+    w->err = httpd_resp_send_chunk(w->req, w->buf, (ssize_t)w->len);
+    w->chunked = true;
+    w->len = 0;
+}
+
+static void json_put(json_writer_t *w, const char *s, size_t n)
 {
+    while (n > 0U && w->err == ESP_OK) {
+        if (w->len == sizeof(w->buf)) {
+            json_flush(w);
+            continue;
+        }
+        const size_t room = sizeof(w->buf) - w->len;
+        const size_t take = (n < room) ? n : room;
+        memcpy(&w->buf[w->len], s, take);
+        w->len += take;
+        s += take;
+        n -= take;
+    }
+}
+
+static void json_putc(json_writer_t *w, char c)
+{
+    json_put(w, &c, 1U);
+}
+
+static void json_put_escaped(json_writer_t *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_putc(w, '"');
+    const char *run = s;
+    for (; *s != '\0'; s++) {
+        const unsigned char c = (unsigned char)*s;
+        if (c >= 0x20U && c != '"' && c != '\\') {
+            continue;
+        }
+        json_put(w, run, (size_t)(s - run));
+        run = s + 1;
+        if (c == '"' || c == '\\') {
+            const char esc[2] = {'\\', (char)c};
+            json_put(w, esc, sizeof(esc));
+        } else {
+            const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0FU]};
+            json_put(w, esc, sizeof(esc));
+        }
+    }
+    json_put(w, run, (size_t)(s - run));
+    json_putc(w, '"');
+}
+
+/* Emit the separator and, inside an object, the "key": prefix. */
+static void json_key(json_writer_t *w, const char *key)
+{
+    if (w->need_comma[w->depth]) {
+        json_putc(w, ',');
+    }
+    w->need_comma[w->depth] = true;
+    if (key != NULL) {
+        json_put_escaped(w, key);
+        json_putc(w, ':');
+    }
+}
+
+static void json_open(json_writer_t *w, const char *key, char bracket)
+{
+    json_key(w, key);
+    json_putc(w, bracket);
+    if (w->depth < WIFI_HTTP_API_JSON_MAX_DEPTH) {
+        w->depth++;
+        w->need_comma[w->depth] = false;
+    } else if (w->err == ESP_OK) {
+        w->err = ESP_ERR_INVALID_STATE;
+    }
+}
+
+static void json_close(json_writer_t *w, char bracket)
+{
+    json_putc(w, bracket);
+    if (w->depth > 0U) {
+        w->depth--;
+    }
+}
+
+static void json_obj_begin(json_writer_t *w, const char *key)
+{
+    json_open(w, key, '{');
+}
+
+static void json_obj_end(json_writer_t *w)
+{
+    json_close(w, '}');
+}
+
+static void json_arr_begin(json_writer_t *w, const char *key)
+{
+    json_open(w, key, '[');
+}
+
+static void json_arr_end(json_writer_t *w)
+{
+    json_close(w, ']');
+}
+
+static void json_str(json_writer_t *w, const char *key, const char *val)
+{
+    json_key(w, key);
+    json_put_escaped(w, (val != NULL) ? val : "");
+}
+
+static void json_bool(json_writer_t *w, const char *key, bool val)
+{
+    json_key(w, key);
+    json_put(w, val ? "true" : "false", val ? 4U : 5U);
+}
+
+static void json_int(json_writer_t *w, const char *key, int64_t val)
+{
+    char num[24];
+    const int n = snprintf(num, sizeof(num), "%" PRId64, val);
+    json_key(w, key);
+    json_put(w, num, (size_t)n);
+}
+
+/* Start a response body: status line, content type and the root object. */
+static void json_begin(json_writer_t *w, httpd_req_t *req, int status)
+{
+    w->req = req;
+    w->err = ESP_OK;
+    w->chunked = false;
+    w->depth = 0;
+    w->need_comma[0] = false;
+    w->len = 0;
     set_http_status(req, status);
     httpd_resp_set_type(req, "application/json");
+    json_obj_begin(w, NULL);
+}
 
-    char *payload = cJSON_PrintUnformatted(json);
-    if (payload == NULL) {
-        return ESP_ERR_NO_MEM;
+/* Close the root object and send whatever is still buffered. */
+static esp_err_t json_end(json_writer_t *w)
+{
+    while (w->depth > 0U) {
+        json_obj_end(w);
     }
-    esp_err_t err = httpd_resp_sendstr(req, payload);
-    cJSON_free(payload);
-    return err;
+    if (w->err != ESP_OK) {
+        return w->err;
+    }
+    if (!w->chunked) {
+        return httpd_resp_send(w->req, w->buf, (ssize_t)w->len);
+    }
+    json_flush(w);
+    if (w->err != ESP_OK) {
+        return w->err;
+    }
+    return httpd_resp_send_chunk(w->req, NULL, 0);
 }
 
 static esp_err_t send_error_json(httpd_req_t *req, int status, const char *msg)
 {
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        return ESP_ERR_NO_MEM;
+    json_writer_t w;
+    json_begin(&w, req, status);
+    json_bool(&w, "ok", false);
+    json_str(&w, "error", (msg != NULL) ? msg : "unknown");
+    return json_end(&w);
+}
+
+static esp_err_t send_ok_json(httpd_req_t *req)
+{
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    return json_end(&w);
+}
+
+static bool query_read_u32(const char *query, const char *key, uint32_t *out, bool *bad)
+{
+    char val[16] = {0};
+    if (query == NULL || httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK) {
+        return false;
     }
-    cJSON_AddBoolToObject(root, "ok", false);
-    cJSON_AddStringToObject(root, "error", (msg != NULL) ? msg : "unknown");
-    esp_err_t err = send_json_response(req, status, root);
-    cJSON_Delete(root);
-    return err;
+
+    char *endptr = NULL;
+    errno = 0;
+    unsigned long parsed = strtoul(val, &endptr, 10);
+    if (errno != 0 || endptr == val || *endptr != '\0' || parsed > UINT32_MAX) {
+        *bad = true;
+        return false;
+    }
+    *out = (uint32_t)parsed;
+    return true;
 }
 
-static esp_err_t json_read_u8(cJSON *root, const char *key, uint8_t min_v, uint8_t max_v, uint8_t *out, bool *present)
+static esp_err_t json_read_u8(const json_body_t *body, const char *key, uint8_t min_v, uint8_t max_v, uint8_t *out, bool *present)
 {
-    if (root == NULL || key == NULL || out == NULL || present == NULL) {
+    if (body == NULL || key == NULL || out == NULL || present == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *item = cJSON_GetObjectItem(root, key);
+    const json_field_t *item = json_body_get(body, key);
     if (item == NULL) {
         *present = false;
         return ESP_OK;
     }
-    if (!cJSON_IsNumber(item)) {
+    if (!json_field_is(item, JSON_FIELD_NUMBER)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    const int v = item->valueint;
+    const int v = json_field_int(item);
     if (v < (int)min_v || v > (int)max_v) {
         return ESP_ERR_INVALID_ARG;
     }
@@ -318,29 +746,29 @@ static esp_err_t json_read_u8(cJSON *root, const char *key, uint8_t min_v, uint8
     return ESP_OK;
 }
 
-static esp_err_t json_read_u16_color(cJSON *root, const char *key, uint16_t *out, bool *present)
+static esp_err_t json_read_u16_color(const json_body_t *body, const char *key, uint16_t *out, bool *present)
 {
-    if (root == NULL || key == NULL || out == NULL || present == NULL) {
+    if (body == NULL || key == NULL || out == NULL || present == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *item = cJSON_GetObjectItem(root, key);
+    const json_field_t *item = json_body_get(body, key);
     if (item == NULL) {
         *present = false;
         return ESP_OK;
     }
 
     uint32_t v = 0U;
-    if (cJSON_IsNumber(item)) {
-        if (item->valuedouble < 0 || item->valuedouble > 65535.0) {
+    if (json_field_is(item, JSON_FIELD_NUMBER)) {
+        if (item->num < 0 || item->num > 65535.0) {
             return ESP_ERR_INVALID_ARG;
         }
-        v = (uint32_t)item->valueint;
-    } else if (cJSON_IsString(item) && item->valuestring != NULL) {
+        v = (uint32_t)json_field_int(item);
+    } else if (json_field_is(item, JSON_FIELD_STRING) && item->str != NULL) {
         char *endptr = NULL;
         errno = 0;
-        unsigned long parsed = strtoul(item->valuestring, &endptr, 0);
-        if (errno != 0 || endptr == item->valuestring || *endptr != '\0' || parsed > 0xFFFFUL) {
+        unsigned long parsed = strtoul(item->str, &endptr, 0);
+        if (errno != 0 || endptr == item->str || *endptr != '\0' || parsed > 0xFFFFUL) {
             return ESP_ERR_INVALID_ARG;
         }
         v = (uint32_t)parsed;
@@ -353,23 +781,24 @@ static esp_err_t json_read_u16_color(cJSON *root, const char *key, uint16_t *out
     return ESP_OK;
 }
 
-static void add_display_cfg_json(cJSON *root, const sntp_api_style_t *style, uint8_t brightness, bool sntp_ready)
+static void add_display_cfg_json(json_writer_t *w, const sntp_api_style_t *style, uint8_t brightness, bool sntp_ready)
 {
-    if (root == NULL || style == NULL) {
+    if (w == NULL || style == NULL) {
         return;
     }
 
-    cJSON_AddBoolToObject(root, "ok", true);
-    cJSON_AddBoolToObject(root, "sntp_ready", sntp_ready);
-    cJSON_AddNumberToObject(root, "brightness", brightness);
-    cJSON_AddNumberToObject(root, "bar_bg_color", style->bar_bg_color);
-    cJSON_AddNumberToObject(root, "bar_fg_color", style->bar_fg_color);
-    cJSON_AddNumberToObject(root, "text_scale", style->text_scale);
-    cJSON_AddNumberToObject(root, "date_scale", style->date_scale);
-    cJSON_AddNumberToObject(root, "time_scale", style->time_scale);
-    cJSON_AddNumberToObject(root, "line_gap_px", style->line_gap_px);
-    cJSON_AddNumberToObject(root, "date_char_spacing_px", style->date_char_spacing_px);
-    cJSON_AddNumberToObject(root, "time_char_spacing_px", style->time_char_spacing_px);
+    json_bool(w, "ok", true);
+    json_bool(w, "sntp_ready", sntp_ready);
+    json_int(w, "brightness", brightness);
+    json_int(w, "spi_clock_hz", display_get_spi_clock());
+    json_int(w, "bar_bg_color", style->bar_bg_color);
+    json_int(w, "bar_fg_color", style->bar_fg_color);
+    json_int(w, "text_scale", style->text_scale);
+    json_int(w, "date_scale", style->date_scale);
+    json_int(w, "time_scale", style->time_scale);
+    json_int(w, "line_gap_px", style->line_gap_px);
+    json_int(w, "date_char_spacing_px", style->date_char_spacing_px);
+    json_int(w, "time_char_spacing_px", style->time_char_spacing_px);
 }
 
 static esp_err_t apply_ap_config(void)
@@ -408,6 +837,227 @@ static esp_err_t apply_sta_config_and_optionally_connect(bool connect_now)
     return ESP_OK;
 }
 
+/* Event task: move driver results into the cache one record at a time. */
+static void scan_collect_results(const wifi_event_sta_scan_done_t *done)
+{
+    if (g_wifi.scan_lock == NULL) {
+        return;
+    }
+
+    const bool ok = (done == NULL || done->status == 0U);
+    wifi_ap_record_t rec;
+    xSemaphoreTake(g_wifi.scan_lock, portMAX_DELAY);
+    if (ok) {
+        uint16_t n = 0;
+        while (n < WIFI_HTTP_API_SCAN_MAX_APS && esp_wifi_scan_get_ap_record(&rec) == ESP_OK) {
+            wifi_http_api_scan_ap_t *ap = &g_wifi.scan.aps[n++];
+            snprintf(ap->ssid, sizeof(ap->ssid), "%s", (const char *)rec.ssid);
+            ap->rssi = rec.rssi;
+            ap->authmode = (uint8_t)rec.authmode;
+        }
+        g_wifi.scan.count = n;
+        g_wifi.scan.done_us = esp_timer_get_time();
+    }
+    g_wifi.scan.in_progress = false;
+    xSemaphoreGive(g_wifi.scan_lock);
+
+    (void)esp_wifi_clear_ap_list();
+    if (ok) {
+        ESP_LOGI(TAG, "scan done: %u APs cached", (unsigned)g_wifi.scan.count);
+    } else {
+        ESP_LOGW(TAG, "scan failed (status %" PRIu32 "); keeping previous results", done->status);
+    }
+}
+
+/* Start a background scan unless one is already running (requests coalesce). */
+static esp_err_t scan_start_async(void)
+{
+    wifi_mode_t mode = WIFI_MODE_NULL;
+    ESP_RETURN_ON_ERROR(esp_wifi_get_mode(&mode), TAG, "esp_wifi_get_mode failed");
+    if (mode != WIFI_MODE_STA && mode != WIFI_MODE_APSTA) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(g_wifi.scan_lock, portMAX_DELAY);
+    if (g_wifi.scan.in_progress) {
+        xSemaphoreGive(g_wifi.scan_lock);
+        return ESP_OK;
+    }
+    g_wifi.scan.in_progress = true;
+    xSemaphoreGive(g_wifi.scan_lock);
+
+    const wifi_scan_config_t scan_cfg = {0};
+    const esp_err_t err = esp_wifi_scan_start(&scan_cfg, false);
+    if (err != ESP_OK) {
+        xSemaphoreTake(g_wifi.scan_lock, portMAX_DELAY);
+        g_wifi.scan.in_progress = false;
+        xSemaphoreGive(g_wifi.scan_lock);
+    }
+    return err;
+}
+
+static esp_err_t send_scan_start_error(httpd_req_t *req, esp_err_t err)
+{
+    if (err == ESP_ERR_INVALID_STATE) {
+        return send_error_json(req, 409, "scan needs STA or APSTA mode");
+    }
+    ESP_LOGW(TAG, "esp_wifi_scan_start failed: %s", esp_err_to_name(err));
+    return send_error_json(req, 503, "scan could not start (STA busy)");
+}
+
+/* httpd task: run the keep-alive timer only while at least one stream is open. */
+static void events_clients_changed(void)
+{
+    bool any = false;
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_MAX_CLIENTS; i++) {
+        any = any || (g_wifi.events.client_fd[i] >= 0);
+    }
+    esp_timer_handle_t timer = g_wifi.events.keepalive_timer;
+    if (timer == NULL || any == esp_timer_is_active(timer)) {
+        return;
+    }
+    if (any) {
+        (void)esp_timer_start_periodic(timer, (uint64_t)WIFI_HTTP_API_EVENTS_KEEPALIVE_MS * 1000ULL);
+    } else {
+        (void)esp_timer_stop(timer);
+    }
+}
+
+/* httpd task: write one SSE frame to the clients in mask, dropping those that fail. */
+static void events_send(const char *frame, size_t len, uint8_t mask)
+{
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_MAX_CLIENTS; i++) {
+        const int fd = g_wifi.events.client_fd[i];
+        if (fd < 0 || (mask & (1U << i)) == 0U) {
+            continue;
+        }
+        if (httpd_socket_send(g_wifi.httpd, fd, frame, len, 0) < 0) {
+            g_wifi.events.client_fd[i] = -1;
+            (void)httpd_sess_trigger_close(g_wifi.httpd, fd);
+        }
+    }
+    events_clients_changed();
+}
+
+static size_t events_format(char *out, size_t out_len, const wifi_http_api_event_topic_t *topic)
+{
+    const int n = snprintf(out, out_len, "event: %s\ndata: %s\n\n", topic->name, topic->data);
+    return (n > 0 && (size_t)n < out_len) ? (size_t)n : 0U;
+}
+
+/* httpd work item: flush dirty topics and, every few ticks, a keep-alive comment. */
+static void events_work(void *arg)
+{
+    const bool keepalive = (arg != NULL);
+    char frame[WIFI_HTTP_API_EVENTS_NAME_MAX + WIFI_HTTP_API_EVENTS_DATA_MAX + 24U];
+
+    xSemaphoreTake(g_wifi.events.lock, portMAX_DELAY);
+    g_wifi.events.work_queued = false;
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_TOPICS; i++) {
+        wifi_http_api_event_topic_t *topic = &g_wifi.events.topics[i];
+        const uint8_t mask = topic->dirty;
+        if (mask == 0U) {
+            continue;
+        }
+        topic->dirty = 0U;
+        const size_t len = events_format(frame, sizeof(frame), topic);
+        xSemaphoreGive(g_wifi.events.lock);
+        if (len > 0U) {
+            events_send(frame, len, mask);
+        }
+        xSemaphoreTake(g_wifi.events.lock, portMAX_DELAY);
+    }
+    xSemaphoreGive(g_wifi.events.lock);
+
+    if (keepalive) {
+        events_send(":\n\n", 3U, WIFI_HTTP_API_EVENTS_ALL_CLIENTS);
+    }
+}
+
+/* Called with events.lock held. */
+static void events_kick_locked(void)
+{
+    if (!g_wifi.events.work_queued && g_wifi.httpd != NULL
+        && httpd_queue_work(g_wifi.httpd, events_work, NULL) == ESP_OK) {
+        g_wifi.events.work_queued = true;
+    }
+}
+
+esp_err_t wifi_http_api_events_publish(const char *event, const char *json)
+{
+    ESP_RETURN_ON_FALSE(event != NULL && json != NULL, ESP_ERR_INVALID_ARG, TAG, "event/json is null");
+    ESP_RETURN_ON_FALSE(strlen(event) < WIFI_HTTP_API_EVENTS_NAME_MAX && strlen(json) < WIFI_HTTP_API_EVENTS_DATA_MAX,
+                        ESP_ERR_INVALID_SIZE, TAG, "event payload too long");
+    if (g_wifi.events.lock == NULL) {
+        return ESP_ERR_INVALID_STATE; /* no server (yet): nothing to publish to, not an error worth a log */
+    }
+
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(g_wifi.events.lock, portMAX_DELAY);
+    wifi_http_api_event_topic_t *slot = NULL;
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_TOPICS; i++) {
+        wifi_http_api_event_topic_t *topic = &g_wifi.events.topics[i];
+        if (strcmp(topic->name, event) == 0) {
+            slot = topic;
+            break;
+        }
+        if (slot == NULL && topic->name[0] == '\0') {
+            slot = topic;
+        }
+    }
+
+    if (slot == NULL) {
+        err = ESP_ERR_NO_MEM;
+    } else if (slot->name[0] == '\0' || strcmp(slot->data, json) != 0) {
+        snprintf(slot->name, sizeof(slot->name), "%s", event);
+        snprintf(slot->data, sizeof(slot->data), "%s", json);
+        slot->dirty = WIFI_HTTP_API_EVENTS_ALL_CLIENTS;
+        events_kick_locked();
+    }
+    xSemaphoreGive(g_wifi.events.lock);
+    return err;
+}
+
+static void events_publish_sta(void)
+{
+    char json[48];
+    snprintf(json, sizeof(json), "{\"connected\":%s,\"ip\":\"%s\"}", g_wifi.sta_connected ? "true" : "false",
+             g_wifi.sta_ip);
+    (void)wifi_http_api_events_publish("sta", json);
+}
+
+void wifi_http_api_events_publish_sntp(void)
+{
+    sntp_api_sync_info_t sync = {0};
+    const bool have_sync = (sntp_api_get_sync_info(&sync) == ESP_OK);
+    char json[48];
+    snprintf(json, sizeof(json), "{\"valid\":%s,\"sync_count\":%" PRIu32 "}",
+             sntp_api_is_time_valid() ? "true" : "false", have_sync ? sync.sync_count : 0U);
+    (void)wifi_http_api_events_publish("sntp", json);
+}
+
+/* esp_timer task, only while a stream is open: idle streams need a keep-alive. */
+static void events_keepalive_cb(void *arg)
+{
+    (void)arg;
+    if (g_wifi.httpd != NULL) {
+        (void)httpd_queue_work(g_wifi.httpd, events_work, (void *)1);
+    }
+}
+
+/*
+ * Modem sleep only while a plain STA link is up: the SoftAP must answer
+ * clients at any time, and while (re)connecting full power shortens scans.
+ */
+static void apply_power_save(void)
+{
+    if (!g_wifi.sta_modem_sleep) {
+        return;
+    }
+    const bool sleep = g_wifi.sta_connected && (g_wifi.mode == WIFI_MODE_STA);
+    (void)esp_wifi_set_ps(sleep ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+}
+
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
     (void)arg;
@@ -419,12 +1069,16 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t e
 
     if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
         g_wifi.sta_connected = false;
+        apply_power_save();
         sta_ip_to_string();
+        events_publish_sta();
         ESP_LOGW(TAG, "STA disconnected");
     } else if (event_id == WIFI_EVENT_STA_CONNECTED) {
         ESP_LOGI(TAG, "STA connected to AP");
     } else if (event_id == WIFI_EVENT_AP_START) {
         ESP_LOGI(TAG, "AP started SSID=%s", g_wifi.ap_ssid);
+    } else if (event_id == WIFI_EVENT_SCAN_DONE) {
+        scan_collect_results((const wifi_event_sta_scan_done_t *)event_data);
     }
 }
 
@@ -435,220 +1089,232 @@ static void ip_event_handler(void *arg, esp_event_base_t event_base, int32_t eve
     if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *ev = (ip_event_got_ip_t *)event_data;
         g_wifi.sta_connected = true;
+        apply_power_save();
         snprintf(g_wifi.sta_ip, sizeof(g_wifi.sta_ip), IPSTR, IP2STR(&ev->ip_info.ip));
+        events_publish_sta();
         ESP_LOGI(TAG, "STA got IP: %s", g_wifi.sta_ip);
     }
 }
 
+/* Strong ETag: FNV-1a 64 over the compressed blob, so it changes with the UI. */
+static void web_ui_etag_init(void)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const uint8_t *p = s_web_ui_gz_start; p < s_web_ui_gz_end; p++) {
+        h = (h ^ *p) * 0x100000001b3ULL;
+    }
+    snprintf(g_wifi.ui_etag, sizeof(g_wifi.ui_etag), "\"%016" PRIx64 "\"", h);
+}
+
+static bool web_ui_etag_matches(httpd_req_t *req)
+{
+    char inm[WIFI_HTTP_API_MAX_IF_NONE_MATCH] = {0};
+    const size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (len == 0U || len >= sizeof(inm) || httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) != ESP_OK) {
+        return false;
+    }
+    return strcmp(inm, "*") == 0 || strstr(inm, g_wifi.ui_etag) != NULL;
+}
+
 static esp_err_t uri_root_get_handler(httpd_req_t *req)
 {
+    httpd_resp_set_hdr(req, "ETag", g_wifi.ui_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", WIFI_HTTP_API_UI_CACHE_CONTROL);
+    if (web_ui_etag_matches(req)) {
+        set_http_status(req, 304);
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    /* Every browser accepts gzip; keeping no plain copy saves the flash. */
     httpd_resp_set_type(req, "text/html");
-    return httpd_resp_sendstr(req, s_web_ui_html);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)s_web_ui_gz_start, (ssize_t)(s_web_ui_gz_end - s_web_ui_gz_start));
 }
 
 static esp_err_t uri_status_get_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON *ap = cJSON_CreateObject();
-    cJSON *sta = cJSON_CreateObject();
-    if (root == NULL || ap == NULL || sta == NULL) {
-        cJSON_Delete(root);
-        cJSON_Delete(ap);
-        cJSON_Delete(sta);
-        return send_error_json(req, 500, "no memory");
-    }
-
     wifi_mode_t mode = WIFI_MODE_NULL;
     (void)esp_wifi_get_mode(&mode);
-
-    cJSON_AddBoolToObject(root, "ok", true);
-    cJSON_AddStringToObject(root, "mode", mode_to_str(mode));
-
-    cJSON_AddStringToObject(ap, "ssid", g_wifi.ap_ssid);
-    cJSON_AddNumberToObject(ap, "channel", g_wifi.ap_channel);
-    cJSON_AddNumberToObject(ap, "max_connection", g_wifi.ap_max_connection);
-    cJSON_AddStringToObject(ap, "ip", "192.168.4.1");
-
     sta_ip_to_string();
-    cJSON_AddBoolToObject(sta, "connected", g_wifi.sta_connected);
-    cJSON_AddStringToObject(sta, "ssid", g_wifi.sta_ssid);
-    cJSON_AddStringToObject(sta, "ip", g_wifi.sta_ip);
 
-    cJSON_AddItemToObject(root, "ap", ap);
-    cJSON_AddItemToObject(root, "sta", sta);
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_str(&w, "mode", mode_to_str(mode));
+
+    json_obj_begin(&w, "ap");
+    json_str(&w, "ssid", g_wifi.ap_ssid);
+    json_int(&w, "channel", g_wifi.ap_channel);
+    json_int(&w, "max_connection", g_wifi.ap_max_connection);
+    json_str(&w, "ip", "192.168.4.1");
+    json_obj_end(&w);
+
+    json_obj_begin(&w, "sta");
+    json_bool(&w, "connected", g_wifi.sta_connected);
+    json_str(&w, "ssid", g_wifi.sta_ssid);
+    json_str(&w, "ip", g_wifi.sta_ip);
+    json_obj_end(&w);
+
+    sntp_api_sync_info_t sync = {0};
+    if (sntp_api_get_sync_info(&sync) == ESP_OK) {
+        json_obj_begin(&w, "time");
+        json_bool(&w, "valid", sntp_api_is_time_valid());
+        json_int(&w, "sync_count", sync.sync_count);
+        json_int(&w, "last_sync_unix", sync.last_sync_unix_us / 1000000LL);
+        json_int(&w, "last_offset_us", sync.last_offset_us);
+        json_int(&w, "slew_pending_us", sync.slew_pending_us);
+        if (sync.drift_valid) {
+            json_int(&w, "drift_ppb", (int64_t)(sync.drift_ppm * 1000.0f));
+        }
+        json_int(&w, "sync_interval_s", sync.sync_interval_ms / 1000U);
+        json_obj_end(&w);
+    }
 
-    esp_err_t err = send_json_response(req, 200, root);
-    cJSON_Delete(root);
-    return err;
+    return json_end(&w);
 }
 
 static esp_err_t uri_health_get_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        return send_error_json(req, 500, "no memory");
-    }
-
     sta_ip_to_string();
-    cJSON_AddBoolToObject(root, "ok", true);
-    cJSON_AddStringToObject(root, "service", "wifi_http_api");
-    cJSON_AddNumberToObject(root, "uptime_ms", (double)(esp_timer_get_time() / 1000LL));
-    cJSON_AddBoolToObject(root, "sta_connected", g_wifi.sta_connected);
-    cJSON_AddStringToObject(root, "sta_ip", g_wifi.sta_ip);
-    cJSON_AddBoolToObject(root, "time_valid", sntp_api_is_time_valid());
-
-    esp_err_t err = send_json_response(req, 200, root);
-    cJSON_Delete(root);
-    return err;
+
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_str(&w, "service", "wifi_http_api");
+    json_int(&w, "uptime_ms", esp_timer_get_time() / 1000LL);
+    json_bool(&w, "sta_connected", g_wifi.sta_connected);
+    json_str(&w, "sta_ip", g_wifi.sta_ip);
+    json_bool(&w, "time_valid", sntp_api_is_time_valid());
+    json_int(&w, "httpd_stack_free_min", g_wifi.httpd_stack_free_min);
+    return json_end(&w);
 }
 
+/* GET /api/scan?max_age=ms: cached table; refreshes in the background when older than max_age. */
 static esp_err_t uri_scan_get_handler(httpd_req_t *req)
 {
-    wifi_mode_t mode = WIFI_MODE_NULL;
-    esp_err_t err = esp_wifi_get_mode(&mode);
-    if (err != ESP_OK) {
-        return send_error_json(req, 500, "esp_wifi_get_mode failed");
-    }
-
-    if (mode == WIFI_MODE_AP) {
-        err = esp_wifi_set_mode(WIFI_MODE_APSTA);
-        if (err != ESP_OK) {
-            return send_error_json(req, 500, "failed to enable STA for scan");
+    char query[WIFI_HTTP_API_MAX_QUERY] = {0};
+    const char *q = (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) ? query : NULL;
+    uint32_t max_age_ms = 0;
+    bool bad = false;
+    const bool has_max_age = query_read_u32(q, "max_age", &max_age_ms, &bad);
+    if (bad) {
+        return send_error_json(req, 400, "invalid max_age");
+    }
+
+    /* Copy out so the socket writes below never hold the lock the event task needs. */
+    wifi_http_api_scan_cache_t snap;
+    xSemaphoreTake(g_wifi.scan_lock, portMAX_DELAY);
+    snap.done_us = g_wifi.scan.done_us;
+    snap.count = g_wifi.scan.count;
+    snap.in_progress = g_wifi.scan.in_progress;
+    memcpy(snap.aps, g_wifi.scan.aps, (size_t)snap.count * sizeof(snap.aps[0]));
+    xSemaphoreGive(g_wifi.scan_lock);
+
+    const int64_t age_ms = (snap.done_us != 0) ? (esp_timer_get_time() - snap.done_us) / 1000LL : -1;
+    if (has_max_age && !snap.in_progress && (age_ms < 0 || age_ms > (int64_t)max_age_ms)) {
+        const esp_err_t err = scan_start_async();
+        if (err != ESP_OK && snap.done_us == 0) {
+            return send_scan_start_error(req, err);
         }
-        mode = WIFI_MODE_APSTA;
-    }
-
-    wifi_scan_config_t scan_cfg = {0};
-    err = esp_wifi_scan_start(&scan_cfg, true);
-    if (err != ESP_OK) {
-        return send_error_json(req, 500, "esp_wifi_scan_start failed");
-    }
+        snap.in_progress = (err == ESP_OK);
+    }
+
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_bool(&w, "scanning", snap.in_progress);
+    json_int(&w, "age_ms", age_ms);
+    json_arr_begin(&w, "aps");
+    for (uint16_t i = 0; i < snap.count; i++) {
+        json_obj_begin(&w, NULL);
+        json_str(&w, "ssid", snap.aps[i].ssid);
+        json_int(&w, "rssi", snap.aps[i].rssi);
+        json_int(&w, "authmode", snap.aps[i].authmode);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    return json_end(&w);
+}
 
-    uint16_t ap_count = 0;
-    err = esp_wifi_scan_get_ap_num(&ap_count);
+static esp_err_t uri_scan_post_handler(httpd_req_t *req)
+{
+    const esp_err_t err = scan_start_async();
     if (err != ESP_OK) {
-        return send_error_json(req, 500, "esp_wifi_scan_get_ap_num failed");
+        return send_scan_start_error(req, err);
     }
 
-    wifi_ap_record_t *records = NULL;
-    if (ap_count > 0) {
-        records = calloc(ap_count, sizeof(wifi_ap_record_t));
-        if (records == NULL) {
-            return send_error_json(req, 500, "no memory");
-        }
-        err = esp_wifi_scan_get_ap_records(&ap_count, records);
-        if (err != ESP_OK) {
-            free(records);
-            return send_error_json(req, 500, "esp_wifi_scan_get_ap_records failed");
-        }
-    }
-
-    cJSON *root = cJSON_CreateObject();
-    cJSON *items = cJSON_CreateArray();
-    if (root == NULL || items == NULL) {
-        free(records);
-        cJSON_Delete(root);
-        cJSON_Delete(items);
-        return send_error_json(req, 500, "no memory");
-    }
-
-    cJSON_AddBoolToObject(root, "ok", true);
-    cJSON_AddItemToObject(root, "aps", items);
-
-    for (uint16_t i = 0; i < ap_count; i++) {
-        cJSON *entry = cJSON_CreateObject();
-        if (entry == NULL) {
-            continue;
-        }
-        cJSON_AddStringToObject(entry, "ssid", (const char *)records[i].ssid);
-        cJSON_AddNumberToObject(entry, "rssi", records[i].rssi);
-        cJSON_AddNumberToObject(entry, "authmode", records[i].authmode);
-        cJSON_AddItemToArray(items, entry);
-    }
-
-    free(records);
-    err = send_json_response(req, 200, root);
-    cJSON_Delete(root);
-    return err;
+    json_writer_t w;
+    json_begin(&w, req, 202);
+    json_bool(&w, "ok", true);
+    json_bool(&w, "scanning", true);
+    return json_end(&w);
 }
 
 static esp_err_t uri_mode_post_handler(httpd_req_t *req)
 {
-    char body[WIFI_HTTP_API_MAX_JSON_BODY + 1] = {0};
-    cJSON *root = NULL;
-    esp_err_t err = read_json_body(req, body, sizeof(body), &root);
+    json_body_t body;
+    esp_err_t err = read_json_body(req, &body);
     if (err != ESP_OK) {
         return send_error_json(req, 400, "invalid JSON body");
     }
 
-    cJSON *mode_item = cJSON_GetObjectItem(root, "mode");
+    const json_field_t *mode_item = json_body_get(&body, "mode");
     wifi_mode_t new_mode = WIFI_MODE_APSTA;
-    if (!cJSON_IsString(mode_item) || !mode_from_str(mode_item->valuestring, &new_mode)) {
-        cJSON_Delete(root);
+    if (!json_field_is(mode_item, JSON_FIELD_STRING) || !mode_from_str(mode_item->str, &new_mode)) {
         return send_error_json(req, 400, "mode must be AP, STA or APSTA");
     }
 
-    cJSON_Delete(root);
-
     err = esp_wifi_set_mode(new_mode);
     if (err != ESP_OK) {
         return send_error_json(req, 500, "esp_wifi_set_mode failed");
     }
 
     g_wifi.mode = new_mode;
+    apply_power_save();
     if ((new_mode == WIFI_MODE_STA || new_mode == WIFI_MODE_APSTA) && g_wifi.sta_ssid[0] != '\0') {
         (void)esp_wifi_connect();
     }
 
-    cJSON *resp = cJSON_CreateObject();
-    if (resp == NULL) {
-        return send_error_json(req, 500, "no memory");
-    }
-    cJSON_AddBoolToObject(resp, "ok", true);
-    cJSON_AddStringToObject(resp, "mode", mode_to_str(new_mode));
-    err = send_json_response(req, 200, resp);
-    cJSON_Delete(resp);
-    return err;
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_str(&w, "mode", mode_to_str(new_mode));
+    return json_end(&w);
 }
 
 static esp_err_t uri_ap_post_handler(httpd_req_t *req)
 {
-    char body[WIFI_HTTP_API_MAX_JSON_BODY + 1] = {0};
-    cJSON *root = NULL;
-    esp_err_t err = read_json_body(req, body, sizeof(body), &root);
+    json_body_t body;
+    esp_err_t err = read_json_body(req, &body);
     if (err != ESP_OK) {
         return send_error_json(req, 400, "invalid JSON body");
     }
 
-    cJSON *ssid_item = cJSON_GetObjectItem(root, "ssid");
-    cJSON *pass_item = cJSON_GetObjectItem(root, "password");
-    cJSON *chan_item = cJSON_GetObjectItem(root, "channel");
+    const json_field_t *ssid_item = json_body_get(&body, "ssid");
+    const json_field_t *pass_item = json_body_get(&body, "password");
+    const json_field_t *chan_item = json_body_get(&body, "channel");
 
-    if (!cJSON_IsString(ssid_item) || strlen(ssid_item->valuestring) == 0 || strlen(ssid_item->valuestring) > 32) {
-        cJSON_Delete(root);
+    if (!json_field_is(ssid_item, JSON_FIELD_STRING) || strlen(ssid_item->str) == 0 || strlen(ssid_item->str) > 32) {
         return send_error_json(req, 400, "invalid AP ssid");
     }
 
-    const char *new_pass = (cJSON_IsString(pass_item) && pass_item->valuestring != NULL) ? pass_item->valuestring : "";
+    const char *new_pass = (json_field_is(pass_item, JSON_FIELD_STRING) && pass_item->str != NULL) ? pass_item->str : "";
     if (!(strlen(new_pass) == 0 || strlen(new_pass) >= 8) || strlen(new_pass) > 64) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "AP password must be empty or >=8 chars");
     }
 
     uint8_t new_channel = g_wifi.ap_channel;
-    if (cJSON_IsNumber(chan_item)) {
-        int ch = chan_item->valueint;
+    if (json_field_is(chan_item, JSON_FIELD_NUMBER)) {
+        int ch = json_field_int(chan_item);
         if (ch < 1 || ch > 13) {
-            cJSON_Delete(root);
             return send_error_json(req, 400, "channel must be between 1 and 13");
         }
         new_channel = (uint8_t)ch;
     }
 
-    snprintf(g_wifi.ap_ssid, sizeof(g_wifi.ap_ssid), "%s", ssid_item->valuestring);
+    snprintf(g_wifi.ap_ssid, sizeof(g_wifi.ap_ssid), "%s", ssid_item->str);
     snprintf(g_wifi.ap_pass, sizeof(g_wifi.ap_pass), "%s", new_pass);
     g_wifi.ap_channel = new_channel;
-    cJSON_Delete(root);
 
     wifi_mode_t mode = WIFI_MODE_NULL;
     (void)esp_wifi_get_mode(&mode);
@@ -661,50 +1327,42 @@ static esp_err_t uri_ap_post_handler(httpd_req_t *req)
         return send_error_json(req, 500, "failed to apply AP config");
     }
 
-    cJSON *resp = cJSON_CreateObject();
-    if (resp == NULL) {
-        return send_error_json(req, 500, "no memory");
-    }
-    cJSON_AddBoolToObject(resp, "ok", true);
-    cJSON_AddStringToObject(resp, "ssid", g_wifi.ap_ssid);
-    cJSON_AddNumberToObject(resp, "channel", g_wifi.ap_channel);
-    err = send_json_response(req, 200, resp);
-    cJSON_Delete(resp);
-    return err;
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_str(&w, "ssid", g_wifi.ap_ssid);
+    json_int(&w, "channel", g_wifi.ap_channel);
+    return json_end(&w);
 }
 
 static esp_err_t uri_sta_post_handler(httpd_req_t *req)
 {
-    char body[WIFI_HTTP_API_MAX_JSON_BODY + 1] = {0};
-    cJSON *root = NULL;
-    esp_err_t err = read_json_body(req, body, sizeof(body), &root);
+    json_body_t body;
+    esp_err_t err = read_json_body(req, &body);
     if (err != ESP_OK) {
         return send_error_json(req, 400, "invalid JSON body");
     }
 
-    cJSON *ssid_item = cJSON_GetObjectItem(root, "ssid");
-    cJSON *pass_item = cJSON_GetObjectItem(root, "password");
-    cJSON *connect_item = cJSON_GetObjectItem(root, "connect");
+    const json_field_t *ssid_item = json_body_get(&body, "ssid");
+    const json_field_t *pass_item = json_body_get(&body, "password");
+    const json_field_t *connect_item = json_body_get(&body, "connect");
 
-    if (!cJSON_IsString(ssid_item) || strlen(ssid_item->valuestring) == 0 || strlen(ssid_item->valuestring) > 32) {
-        cJSON_Delete(root);
+    if (!json_field_is(ssid_item, JSON_FIELD_STRING) || strlen(ssid_item->str) == 0 || strlen(ssid_item->str) > 32) {
         return send_error_json(req, 400, "invalid STA ssid");
     }
 
-    const char *new_pass = (cJSON_IsString(pass_item) && pass_item->valuestring != NULL) ? pass_item->valuestring : "";
+    const char *new_pass = (json_field_is(pass_item, JSON_FIELD_STRING) && pass_item->str != NULL) ? pass_item->str : "";
     if (strlen(new_pass) > 64) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "invalid STA password");
     }
 
     bool connect_now = true;
-    if (cJSON_IsBool(connect_item)) {
-        connect_now = cJSON_IsTrue(connect_item);
+    if (json_field_is(connect_item, JSON_FIELD_BOOL)) {
+        connect_now = (connect_item->num != 0.0);
     }
 
-    snprintf(g_wifi.sta_ssid, sizeof(g_wifi.sta_ssid), "%s", ssid_item->valuestring);
+    snprintf(g_wifi.sta_ssid, sizeof(g_wifi.sta_ssid), "%s", ssid_item->str);
     snprintf(g_wifi.sta_pass, sizeof(g_wifi.sta_pass), "%s", new_pass);
-    cJSON_Delete(root);
 
     err = nvs_save_sta_credentials(g_wifi.sta_ssid, g_wifi.sta_pass);
     if (err != ESP_OK) {
@@ -724,16 +1382,12 @@ static esp_err_t uri_sta_post_handler(httpd_req_t *req)
         return send_error_json(req, 500, "failed to apply STA config");
     }
 
-    cJSON *resp = cJSON_CreateObject();
-    if (resp == NULL) {
-        return send_error_json(req, 500, "no memory");
-    }
-    cJSON_AddBoolToObject(resp, "ok", true);
-    cJSON_AddStringToObject(resp, "ssid", g_wifi.sta_ssid);
-    cJSON_AddBoolToObject(resp, "connecting", connect_now);
-    err = send_json_response(req, 200, resp);
-    cJSON_Delete(resp);
-    return err;
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    json_bool(&w, "ok", true);
+    json_str(&w, "ssid", g_wifi.sta_ssid);
+    json_bool(&w, "connecting", connect_now);
+    return json_end(&w);
 }
 
 static esp_err_t uri_sta_disconnect_post_handler(httpd_req_t *req)
@@ -742,14 +1396,7 @@ static esp_err_t uri_sta_disconnect_post_handler(httpd_req_t *req)
     g_wifi.sta_connected = false;
     sta_ip_to_string();
 
-    cJSON *resp = cJSON_CreateObject();
-    if (resp == NULL) {
-        return send_error_json(req, 500, "no memory");
-    }
-    cJSON_AddBoolToObject(resp, "ok", true);
-    esp_err_t err = send_json_response(req, 200, resp);
-    cJSON_Delete(resp);
-    return err;
+    return send_ok_json(req);
 }
 
 static esp_err_t uri_display_get_handler(httpd_req_t *req)
@@ -760,22 +1407,182 @@ static esp_err_t uri_display_get_handler(httpd_req_t *req)
         g_wifi.sntp_style_cache = style;
     }
 
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        return send_error_json(req, 500, "no memory");
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    add_display_cfg_json(&w, &style, g_wifi.display_brightness_pct, sntp_ready);
+    return json_end(&w);
+}
+
+static bool history_stream_flush(history_stream_t *st)
+{
+    if (st->len == 0U || st->err != ESP_OK) {
+        return st->err == ESP_OK;
     }
+    st->err = httpd_resp_send_chunk(st->req, st->buf, (ssize_t)st->len);
+    st->len = 0;
+    return st->err == ESP_OK;
+}
 
-    add_display_cfg_json(root, &style, g_wifi.display_brightness_pct, sntp_ready);
-    esp_err_t err = send_json_response(req, 200, root);
-    cJSON_Delete(root);
-    return err;
+static bool history_stream_row(uint32_t time_s, float temperature_c, float humidity_rh, void *row_ctx)
+{
+    history_stream_t *st = (history_stream_t *)row_ctx;
+
+    /* step: keep the first row of every step_s interval. */
+    if (st->any_row && time_s < st->next_s) {
+        return true;
+    }
+    st->any_row = true;
+    st->next_s = time_s + st->step_s;
+
+    if ((sizeof(st->buf) - st->len) < WIFI_HTTP_API_HISTORY_ROW_MAX && !history_stream_flush(st)) {
+        return false;
+    }
+
+    if (st->binary) {
+        /* 8-byte little-endian row: u32 time_s, i16 centi-degC, u16 centi-%RH. */
+        const int32_t t = (int32_t)(temperature_c * 100.0f + ((temperature_c < 0.0f) ? -0.5f : 0.5f));
+        const int32_t rh = (int32_t)(humidity_rh * 100.0f + 0.5f);
+        const uint8_t row[8] = {
+            (uint8_t)time_s, (uint8_t)(time_s >> 8), (uint8_t)(time_s >> 16), (uint8_t)(time_s >> 24),
+            (uint8_t)t, (uint8_t)((uint32_t)t >> 8), (uint8_t)rh, (uint8_t)((uint32_t)rh >> 8),
+        };
+        memcpy(&st->buf[st->len], row, sizeof(row));
+        st->len += sizeof(row);
+    } else {
+        const int n = snprintf(&st->buf[st->len], sizeof(st->buf) - st->len, "%" PRIu32 ",%.2f,%.2f\n",
+                               time_s, (double)temperature_c, (double)humidity_rh);
+        if (n <= 0 || (size_t)n >= (sizeof(st->buf) - st->len)) {
+            return true;
+        }
+        st->len += (size_t)n;
+    }
+    st->rows++;
+    return true;
+}
+
+static esp_err_t uri_history_get_handler(httpd_req_t *req)
+{
+    const wifi_http_api_history_fn_t history_fn = g_wifi.history_fn;
+    if (history_fn == NULL) {
+        return send_error_json(req, 503, "history unavailable");
+    }
+
+    char query[WIFI_HTTP_API_MAX_QUERY] = {0};
+    const bool has_query = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK;
+    const char *q = has_query ? query : NULL;
+
+    uint32_t from_s = 0;
+    uint32_t to_s = UINT32_MAX;
+    uint32_t step_s = 0;
+    bool bad = false;
+    (void)query_read_u32(q, "from", &from_s, &bad);
+    (void)query_read_u32(q, "to", &to_s, &bad);
+    (void)query_read_u32(q, "step", &step_s, &bad);
+    if (bad || from_s > to_s) {
+        return send_error_json(req, 400, "invalid from/to/step");
+    }
+
+    char format[8] = {0};
+    const bool binary = (q != NULL && httpd_query_key_value(q, "format", format, sizeof(format)) == ESP_OK
+                         && strcmp(format, "bin") == 0);
+
+    history_stream_t st = {
+        .req = req,
+        .err = ESP_OK,
+        .binary = binary,
+        .step_s = step_s,
+    };
+    set_http_status(req, 200);
+    if (binary) {
+        httpd_resp_set_type(req, "application/octet-stream");
+    } else {
+        httpd_resp_set_type(req, "text/csv");
+        st.len = (size_t)snprintf(st.buf, sizeof(st.buf), "time_s,temperature_c,humidity_rh\n");
+    }
+
+    const esp_err_t src_err = history_fn(from_s, to_s, history_stream_row, &st, g_wifi.history_ctx);
+    if (src_err != ESP_OK) {
+        ESP_LOGW(TAG, "history source failed: %s", esp_err_to_name(src_err));
+    }
+    if (!history_stream_flush(&st)) {
+        ESP_LOGW(TAG, "history stream aborted after %" PRIu32 " rows: %s", st.rows, esp_err_to_name(st.err));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/*
+ * GET /api/events: Server-Sent Events. The handler writes the response head
+ * itself and returns, leaving the socket open; frames are pushed later from
+ * httpd work items (events_work) on the same task.
+ */
+static esp_err_t uri_events_get_handler(httpd_req_t *req)
+{
+    size_t slot = WIFI_HTTP_API_EVENTS_MAX_CLIENTS;
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_MAX_CLIENTS; i++) {
+        if (g_wifi.events.client_fd[i] < 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == WIFI_HTTP_API_EVENTS_MAX_CLIENTS) {
+        return send_error_json(req, 503, "too many event clients");
+    }
+
+    static const char head[] = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/event-stream\r\n"
+                               "Cache-Control: no-cache\r\n"
+                               "Connection: keep-alive\r\n\r\n"
+                               "retry: 3000\n\n";
+    if (httpd_send(req, head, sizeof(head) - 1U) < 0) {
+        return ESP_FAIL;
+    }
+
+    /*
+     * Replay the current state so the client does not wait for the next change.
+     * The replayed value is the latest, so the slot's pending copy is dropped.
+     */
+    char frame[WIFI_HTTP_API_EVENTS_NAME_MAX + WIFI_HTTP_API_EVENTS_DATA_MAX + 24U];
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_TOPICS; i++) {
+        xSemaphoreTake(g_wifi.events.lock, portMAX_DELAY);
+        wifi_http_api_event_topic_t *topic = &g_wifi.events.topics[i];
+        const size_t len = (topic->name[0] != '\0') ? events_format(frame, sizeof(frame), topic) : 0U;
+        topic->dirty &= (uint8_t)~(1U << slot);
+        xSemaphoreGive(g_wifi.events.lock);
+        if (len > 0U && httpd_send(req, frame, len) < 0) {
+            return ESP_FAIL;
+        }
+    }
+
+    g_wifi.events.client_fd[slot] = httpd_req_to_sockfd(req);
+    events_clients_changed();
+    ESP_LOGI(TAG, "event stream client on fd %d", g_wifi.events.client_fd[slot]);
+    return ESP_OK;
+}
+
+/* Session close hook: forget event-stream clients, then close like the default. */
+static void http_sess_close_cb(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_MAX_CLIENTS; i++) {
+        if (g_wifi.events.client_fd[i] == sockfd) {
+            g_wifi.events.client_fd[i] = -1;
+        }
+    }
+    events_clients_changed();
+    close(sockfd);
+}
+
+static void status_bar_redraw_cb(void *arg)
+{
+    (void)arg;
+    sntp_api_status_bar_draw();
 }
 
 static esp_err_t uri_display_post_handler(httpd_req_t *req)
 {
-    char body[WIFI_HTTP_API_MAX_JSON_BODY + 1] = {0};
-    cJSON *root = NULL;
-    esp_err_t err = read_json_body(req, body, sizeof(body), &root);
+    json_body_t body;
+    esp_err_t err = read_json_body(req, &body);
     if (err != ESP_OK) {
         return send_error_json(req, 400, "invalid JSON body");
     }
@@ -785,86 +1592,78 @@ static esp_err_t uri_display_post_handler(httpd_req_t *req)
 
     bool has_brightness = false;
     uint8_t brightness = g_wifi.display_brightness_pct;
-    err = json_read_u8(root, "brightness", 0U, 100U, &brightness, &has_brightness);
+    err = json_read_u8(&body, "brightness", 0U, 100U, &brightness, &has_brightness);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "brightness must be 0..100");
     }
 
     bool has_bg = false;
     uint16_t bg = style.bar_bg_color;
-    err = json_read_u16_color(root, "bar_bg_color", &bg, &has_bg);
+    err = json_read_u16_color(&body, "bar_bg_color", &bg, &has_bg);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "bar_bg_color must be RGB565 (0..65535 or 0xNNNN)");
     }
 
     bool has_fg = false;
     uint16_t fg = style.bar_fg_color;
-    err = json_read_u16_color(root, "bar_fg_color", &fg, &has_fg);
+    err = json_read_u16_color(&body, "bar_fg_color", &fg, &has_fg);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "bar_fg_color must be RGB565 (0..65535 or 0xNNNN)");
     }
 
     bool has_text_scale = false;
     uint8_t text_scale = style.text_scale;
-    err = json_read_u8(root, "text_scale", 1U, WIFI_HTTP_API_MAX_TEXT_SCALE, &text_scale, &has_text_scale);
+    err = json_read_u8(&body, "text_scale", 1U, WIFI_HTTP_API_MAX_TEXT_SCALE, &text_scale, &has_text_scale);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "text_scale must be 1..16");
     }
 
     bool has_date_scale = false;
     uint8_t date_scale = style.date_scale;
-    err = json_read_u8(root, "date_scale", 0U, WIFI_HTTP_API_MAX_TEXT_SCALE, &date_scale, &has_date_scale);
+    err = json_read_u8(&body, "date_scale", 0U, WIFI_HTTP_API_MAX_TEXT_SCALE, &date_scale, &has_date_scale);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "date_scale must be 0..16");
     }
 
     bool has_time_scale = false;
     uint8_t time_scale = style.time_scale;
-    err = json_read_u8(root, "time_scale", 0U, WIFI_HTTP_API_MAX_TEXT_SCALE, &time_scale, &has_time_scale);
+    err = json_read_u8(&body, "time_scale", 0U, WIFI_HTTP_API_MAX_TEXT_SCALE, &time_scale, &has_time_scale);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "time_scale must be 0..16");
     }
 
     bool has_gap = false;
     uint8_t line_gap = style.line_gap_px;
-    err = json_read_u8(root, "line_gap_px", 0U, 120U, &line_gap, &has_gap);
+    err = json_read_u8(&body, "line_gap_px", 0U, 120U, &line_gap, &has_gap);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "line_gap_px must be 0..120");
     }
 
     bool has_date_sp = false;
     uint8_t date_spacing = style.date_char_spacing_px;
-    err = json_read_u8(root, "date_char_spacing_px", 0U, 20U, &date_spacing, &has_date_sp);
+    err = json_read_u8(&body, "date_char_spacing_px", 0U, 20U, &date_spacing, &has_date_sp);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "date_char_spacing_px must be 0..20");
     }
 
     bool has_time_sp = false;
     uint8_t time_spacing = style.time_char_spacing_px;
-    err = json_read_u8(root, "time_char_spacing_px", 0U, 20U, &time_spacing, &has_time_sp);
+    err = json_read_u8(&body, "time_char_spacing_px", 0U, 20U, &time_spacing, &has_time_sp);
     if (err != ESP_OK) {
-        cJSON_Delete(root);
         return send_error_json(req, 400, "time_char_spacing_px must be 0..20");
     }
 
     bool redraw = true;
-    cJSON *redraw_item = cJSON_GetObjectItem(root, "redraw");
-    if (cJSON_IsBool(redraw_item)) {
-        redraw = cJSON_IsTrue(redraw_item);
+    const json_field_t *redraw_item = json_body_get(&body, "redraw");
+    if (json_field_is(redraw_item, JSON_FIELD_BOOL)) {
+        redraw = (redraw_item->num != 0.0);
     }
-    cJSON_Delete(root);
 
     if (has_brightness) {
         g_wifi.display_brightness_pct = brightness;
-        display_backlight_set(g_wifi.display_brightness_pct);
+        if (!display_server_running() || display_server_post_backlight(brightness) != ESP_OK) {
+            display_backlight_set(g_wifi.display_brightness_pct);
+        }
     }
 
     const bool has_style_change = has_bg || has_fg || has_text_scale || has_date_scale
@@ -890,102 +1689,212 @@ static esp_err_t uri_display_post_handler(httpd_req_t *req)
     }
 
     if (redraw && sntp_ready) {
-        sntp_api_status_bar_draw();
+        /* The bar is drawn by its owner, never on the httpd stack: the render task, else sntp_api's timer or poll. */
+        if (!display_server_running() || display_server_post_call(status_bar_redraw_cb, NULL) != ESP_OK) {
+            sntp_api_status_bar_request_redraw();
+        }
     }
 
-    cJSON *resp = cJSON_CreateObject();
-    if (resp == NULL) {
-        return send_error_json(req, 500, "no memory");
+    json_writer_t w;
+    json_begin(&w, req, 200);
+    add_display_cfg_json(&w, &g_wifi.sntp_style_cache, g_wifi.display_brightness_pct, sntp_ready);
+    if (!sntp_ready) {
+        json_str(&w, "warning", "SNTP style not applied yet (SNTP not initialized)");
     }
+    return json_end(&w);
+}
 
-    add_display_cfg_json(resp, &g_wifi.sntp_style_cache, g_wifi.display_brightness_pct, sntp_ready);
-    if (!sntp_ready) {
-        cJSON_AddStringToObject(resp, "warning", "SNTP style not applied yet (SNTP not initialized)");
+/* Raw text sink (perf_api/bench_api renderers) on top of the JSON writer's chunk buffer. */
+static esp_err_t writer_put_raw(const char *text, size_t len, void *user_ctx)
+{
+    json_writer_t *w = (json_writer_t *)user_ctx;
+    json_put(w, text, len);
+    return w->err;
+}
+
+/* GET /api/metrics: Prometheus text format, streamed through the JSON writer's chunk buffer. */
+static esp_err_t uri_metrics_get_handler(httpd_req_t *req)
+{
+    json_writer_t w = {.req = req, .err = ESP_OK};
+    set_http_status(req, 200);
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    ESP_RETURN_ON_ERROR(perf_render_prometheus(writer_put_raw, &w), TAG, "metrics render failed");
+    return json_end(&w);
+}
+
+/* GET /api/bench: report of the last (or in-progress) benchmark run. */
+static esp_err_t uri_bench_get_handler(httpd_req_t *req)
+{
+    json_writer_t w = {.req = req, .err = ESP_OK};
+    set_http_status(req, 200);
+    httpd_resp_set_type(req, "application/json");
+    ESP_RETURN_ON_ERROR(bench_render_json(writer_put_raw, &w), TAG, "bench render failed");
+    return json_end(&w);
+}
+
+/* POST /api/bench?filter=display,http&reps=N&warmup=N: start a background run; poll GET for results. */
+static esp_err_t uri_bench_post_handler(httpd_req_t *req)
+{
+    char query[WIFI_HTTP_API_MAX_QUERY] = {0};
+    const char *q = (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) ? query : NULL;
+    char filter[WIFI_HTTP_API_BENCH_FILTER_MAX] = {0};
+    if (q != NULL && httpd_query_key_value(q, "filter", filter, sizeof(filter)) == ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return send_error_json(req, 400, "filter too long");
+    }
+
+    uint32_t reps = 0;
+    uint32_t warmup = 0;
+    bool bad = false;
+    (void)query_read_u32(q, "reps", &reps, &bad);
+    (void)query_read_u32(q, "warmup", &warmup, &bad);
+    if (bad || reps > BENCH_MAX_REPS || warmup > UINT16_MAX) {
+        return send_error_json(req, 400, "invalid reps/warmup");
+    }
+
+    const bench_run_cfg_t run_cfg = {
+        .filter = filter,
+        .reps = (uint16_t)reps,
+        .warmup = (uint16_t)warmup,
+    };
+    const esp_err_t err = bench_start(&run_cfg);
+    if (err == ESP_ERR_INVALID_STATE) {
+        return send_error_json(req, 409, "benchmark already running");
+    }
+    if (err == ESP_ERR_NOT_FOUND) {
+        return send_error_json(req, 400, "no benchmark matches filter");
+    }
+    if (err != ESP_OK) {
+        return send_error_json(req, 500, esp_err_to_name(err));
+    }
+
+    json_writer_t w;
+    json_begin(&w, req, 202);
+    json_bool(&w, "ok", true);
+    json_bool(&w, "running", true);
+    return json_end(&w);
+}
+
+/*
+ * Loopback request against our own server from the bench task: connect,
+ * send, half-close and read until the server closes. Covers the full
+ * socket + parse + handler + send path, not just the handler body.
+ */
+static esp_err_t http_bench_get(void *ctx)
+{
+    const char *path = (const char *)ctx;
+    char buf[128];
+    const int req_len = snprintf(buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", path);
+
+    const int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    ESP_RETURN_ON_FALSE(fd >= 0, ESP_FAIL, TAG, "bench socket failed: errno %d", errno);
+    const struct timeval tv = {.tv_sec = WIFI_HTTP_API_BENCH_TIMEOUT_S};
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    const struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(g_wifi.http_port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    esp_err_t err = ESP_FAIL;
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0 && send(fd, buf, (size_t)req_len, 0) == req_len) {
+        (void)shutdown(fd, SHUT_WR);
+        bool status_ok = false;
+        size_t total = 0;
+        int n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            if (total == 0U) {
+                status_ok = (n >= 12) && (memcmp(&buf[9], "200", 3) == 0);
+            }
+            total += (size_t)n;
+        }
+        err = (n == 0 && status_ok) ? ESP_OK : ESP_FAIL;
+    }
+    close(fd);
+    return err;
+}
+
+static const bench_case_t s_http_bench_cases[] = {
+    {.name = "http.status", .run = http_bench_get, .ctx = (void *)"/api/status", .warmup = 3, .reps = 50},
+    {.name = "http.metrics", .run = http_bench_get, .ctx = (void *)"/api/metrics", .warmup = 3, .reps = 50},
+};
+
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    perf_metric_t latency;
+} http_route_t;
+
+#define HTTP_ROUTE(uri_, method_, handler_, labels_)             \
+    {.uri = (uri_), .method = (method_), .handler = (handler_), \
+     .latency = PERF_HISTOGRAM_INIT("http_handler_us", "HTTP handler latency", labels_)}
+
+static http_route_t s_routes[] = {
+    HTTP_ROUTE("/", HTTP_GET, uri_root_get_handler, "uri=\"/\",method=\"GET\""),
+    HTTP_ROUTE("/api/status", HTTP_GET, uri_status_get_handler, "uri=\"/api/status\",method=\"GET\""),
+    HTTP_ROUTE("/api/health", HTTP_GET, uri_health_get_handler, "uri=\"/api/health\",method=\"GET\""),
+    HTTP_ROUTE("/api/scan", HTTP_GET, uri_scan_get_handler, "uri=\"/api/scan\",method=\"GET\""),
+    HTTP_ROUTE("/api/scan", HTTP_POST, uri_scan_post_handler, "uri=\"/api/scan\",method=\"POST\""),
+    HTTP_ROUTE("/api/mode", HTTP_POST, uri_mode_post_handler, "uri=\"/api/mode\",method=\"POST\""),
+    HTTP_ROUTE("/api/ap", HTTP_POST, uri_ap_post_handler, "uri=\"/api/ap\",method=\"POST\""),
+    HTTP_ROUTE("/api/sta", HTTP_POST, uri_sta_post_handler, "uri=\"/api/sta\",method=\"POST\""),
+    HTTP_ROUTE("/api/sta/disconnect", HTTP_POST, uri_sta_disconnect_post_handler,
+               "uri=\"/api/sta/disconnect\",method=\"POST\""),
+    HTTP_ROUTE("/api/display", HTTP_GET, uri_display_get_handler, "uri=\"/api/display\",method=\"GET\""),
+    HTTP_ROUTE("/api/display", HTTP_POST, uri_display_post_handler, "uri=\"/api/display\",method=\"POST\""),
+    HTTP_ROUTE("/api/history", HTTP_GET, uri_history_get_handler, "uri=\"/api/history\",method=\"GET\""),
+    HTTP_ROUTE("/api/events", HTTP_GET, uri_events_get_handler, "uri=\"/api/events\",method=\"GET\""),
+    HTTP_ROUTE("/api/metrics", HTTP_GET, uri_metrics_get_handler, "uri=\"/api/metrics\",method=\"GET\""),
+    HTTP_ROUTE("/api/bench", HTTP_GET, uri_bench_get_handler, "uri=\"/api/bench\",method=\"GET\""),
+    HTTP_ROUTE("/api/bench", HTTP_POST, uri_bench_post_handler, "uri=\"/api/bench\",method=\"POST\""),
+};
+
+/* Every route runs through here so handler latency is recorded per URI. */
+static esp_err_t uri_timed_handler(httpd_req_t *req)
+{
+    http_route_t *route = (http_route_t *)req->user_ctx;
+    const int64_t start_us = esp_timer_get_time();
+    const esp_err_t err = route->handler(req);
+    perf_observe_since(&route->latency, start_us);
+    /* Handlers only run on the httpd task, so this tracks its worst route; reported by /api/health. */
+    const uint32_t stack_free = (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+    if (stack_free < g_wifi.httpd_stack_free_min) {
+        g_wifi.httpd_stack_free_min = stack_free;
     }
-    err = send_json_response(req, 200, resp);
-    cJSON_Delete(resp);
     return err;
 }
 
 static esp_err_t start_http_server(void)
 {
     httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
-    cfg.max_uri_handlers = 16;
+    cfg.max_uri_handlers = 20;
     cfg.uri_match_fn = httpd_uri_match_wildcard;
+    cfg.close_fn = http_sess_close_cb;
+    cfg.stack_size = WIFI_HTTP_API_HTTPD_STACK;
+    g_wifi.httpd_stack_free_min = WIFI_HTTP_API_HTTPD_STACK;
 
+    web_ui_etag_init();
     ESP_RETURN_ON_ERROR(httpd_start(&g_wifi.httpd, &cfg), TAG, "httpd_start failed");
-
-    const httpd_uri_t root_uri = {
-        .uri = "/",
-        .method = HTTP_GET,
-        .handler = uri_root_get_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t status_uri = {
-        .uri = "/api/status",
-        .method = HTTP_GET,
-        .handler = uri_status_get_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t health_uri = {
-        .uri = "/api/health",
-        .method = HTTP_GET,
-        .handler = uri_health_get_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t scan_uri = {
-        .uri = "/api/scan",
-        .method = HTTP_GET,
-        .handler = uri_scan_get_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t mode_uri = {
-        .uri = "/api/mode",
-        .method = HTTP_POST,
-        .handler = uri_mode_post_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t ap_uri = {
-        .uri = "/api/ap",
-        .method = HTTP_POST,
-        .handler = uri_ap_post_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t sta_uri = {
-        .uri = "/api/sta",
-        .method = HTTP_POST,
-        .handler = uri_sta_post_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t sta_dis_uri = {
-        .uri = "/api/sta/disconnect",
-        .method = HTTP_POST,
-        .handler = uri_sta_disconnect_post_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t display_get_uri = {
-        .uri = "/api/display",
-        .method = HTTP_GET,
-        .handler = uri_display_get_handler,
-        .user_ctx = NULL,
-    };
-    const httpd_uri_t display_post_uri = {
-        .uri = "/api/display",
-        .method = HTTP_POST,
-        .handler = uri_display_post_handler,
-        .user_ctx = NULL,
-    };
-
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &root_uri), TAG, "register / failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &status_uri), TAG, "register /api/status failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &health_uri), TAG, "register /api/health failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &scan_uri), TAG, "register /api/scan failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &mode_uri), TAG, "register /api/mode failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &ap_uri), TAG, "register /api/ap failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &sta_uri), TAG, "register /api/sta failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &sta_dis_uri), TAG, "register /api/sta/disconnect failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &display_get_uri), TAG, "register /api/display GET failed");
-    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &display_post_uri), TAG, "register /api/display POST failed");
+    g_wifi.http_port = cfg.server_port;
+
+    for (size_t i = 0; i < sizeof(s_routes) / sizeof(s_routes[0]); i++) {
+        const httpd_uri_t uri = {
+            .uri = s_routes[i].uri,
+            .method = s_routes[i].method,
+            .handler = uri_timed_handler,
+            .user_ctx = &s_routes[i],
+        };
+        ESP_RETURN_ON_ERROR(httpd_register_uri_handler(g_wifi.httpd, &uri), TAG, "register %s failed", s_routes[i].uri);
+    }
+
+    static bool s_bench_registered = false;
+    if (!s_bench_registered) {
+        for (size_t i = 0; i < sizeof(s_http_bench_cases) / sizeof(s_http_bench_cases[0]); i++) {
+            (void)bench_register(&s_http_bench_cases[i]);
+        }
+        s_bench_registered = true;
+    }
 
     return ESP_OK;
 }
@@ -1010,6 +1919,7 @@ esp_err_t wifi_http_api_init(const wifi_http_api_cfg_t *cfg)
     g_wifi.ap_channel = (use_cfg->ap_channel >= 1 && use_cfg->ap_channel <= 13) ? use_cfg->ap_channel : defaults.ap_channel;
     g_wifi.ap_max_connection = (use_cfg->ap_max_connection > 0) ? use_cfg->ap_max_connection : defaults.ap_max_connection;
     g_wifi.mode = use_cfg->start_mode;
+    g_wifi.sta_modem_sleep = use_cfg->sta_modem_sleep;
     g_wifi.sta_ssid[0] = '\0';
     g_wifi.sta_pass[0] = '\0';
     strncpy(g_wifi.sta_ip, "0.0.0.0", sizeof(g_wifi.sta_ip));
@@ -1051,6 +1961,18 @@ esp_err_t wifi_http_api_init(const wifi_http_api_cfg_t *cfg)
         return err;
     }
 
+    if (g_wifi.scan_lock == NULL) {
+        g_wifi.scan_lock = xSemaphoreCreateMutex();
+        ESP_RETURN_ON_FALSE(g_wifi.scan_lock != NULL, ESP_ERR_NO_MEM, TAG, "scan lock alloc failed");
+    }
+    if (g_wifi.events.lock == NULL) {
+        g_wifi.events.lock = xSemaphoreCreateMutex();
+        ESP_RETURN_ON_FALSE(g_wifi.events.lock != NULL, ESP_ERR_NO_MEM, TAG, "events lock alloc failed");
+    }
+    for (size_t i = 0; i < WIFI_HTTP_API_EVENTS_MAX_CLIENTS; i++) {
+        g_wifi.events.client_fd[i] = -1;
+    }
+
     wifi_init_config_t wifi_init_cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_RETURN_ON_ERROR(esp_wifi_init(&wifi_init_cfg), TAG, "esp_wifi_init failed");
     ESP_RETURN_ON_ERROR(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, &g_wifi.wifi_evt_inst),
@@ -1077,6 +1999,18 @@ esp_err_t wifi_http_api_init(const wifi_http_api_cfg_t *cfg)
 
     ESP_RETURN_ON_ERROR(start_http_server(), TAG, "start_http_server failed");
 
+    /* Started by the first event-stream client, stopped after the last one (events_clients_changed). */
+    if (g_wifi.events.keepalive_timer == NULL) {
+        const esp_timer_create_args_t keepalive_args = {
+            .callback = events_keepalive_cb,
+            .name = "http_events",
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&keepalive_args, &g_wifi.events.keepalive_timer), TAG,
+                            "events timer create failed");
+    }
+    /* Seed the replayed state; later changes arrive through wifi_http_api_events_publish_sntp(). */
+    wifi_http_api_events_publish_sntp();
+
     g_wifi.initialized = true;
     ESP_LOGI(TAG, "Wi-Fi HTTP API ready");
     ESP_LOGI(TAG, "AP SSID=%s pass=%s", g_wifi.ap_ssid, (g_wifi.ap_pass[0] != '\0') ? g_wifi.ap_pass : "<open>");
@@ -1090,6 +2024,9 @@ void wifi_http_api_deinit(void)
         return;
     }
 
+    if (g_wifi.events.keepalive_timer != NULL) {
+        (void)esp_timer_stop(g_wifi.events.keepalive_timer);
+    }
     if (g_wifi.httpd != NULL) {
         httpd_stop(g_wifi.httpd);
         g_wifi.httpd = NULL;
@@ -1098,8 +2035,10 @@ void wifi_http_api_deinit(void)
     (void)esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, g_wifi.ip_evt_inst);
     (void)esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, g_wifi.wifi_evt_inst);
 
+    (void)esp_wifi_scan_stop();
     (void)esp_wifi_stop();
     (void)esp_wifi_deinit();
+    g_wifi.scan.in_progress = false;
 
     g_wifi.initialized = false;
     g_wifi.sta_connected = false;
@@ -1114,3 +2053,9 @@ const char *wifi_http_api_sta_ip(void)
 {
     return g_wifi.sta_ip;
 }
+
+void wifi_http_api_set_history_source(wifi_http_api_history_fn_t fn, void *user_ctx)
+{
+    g_wifi.history_ctx = user_ctx;
+    g_wifi.history_fn = fn;
+}
@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @file host_idf.h
+ * @brief Controls for the host stand-ins of ESP-IDF services (idf_stubs.c).
+ *
+ * The wall clock seen through time()/gettimeofday() is a fixed value the
+ * test sets, so rendered text and with it the transfer counts are the same
+ * on every run. The test binary is linked with --wrap=time,--wrap=gettimeofday.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Set the wall clock returned to the code under test. */
+void host_clock_set(time_t unix_s);
+/** @brief Move the wall clock forward by `seconds`. */
+void host_clock_advance(time_t seconds);
+
+#if HOST_NEED_STRLCPY
+/* Newlib and glibc >= 2.38 declare it; older host libcs do not. */
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
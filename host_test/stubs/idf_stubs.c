@@ -0,0 +1,511 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "host_idf.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "apps/esp_sntp.h"
+#include "driver/ledc.h"
+#include "driver/spi_master.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lcd_recorder.h"
+#include "nvs.h"
+
+#define HOST_NVS_MAX_KEYS 8U
+#define HOST_HEAP_BYTES (512U * 1024U)
+
+/* ---- log / errors ---- */
+
+void host_log(char level, const char *tag, const char *fmt, ...)
+{
+    static int verbose = -1;
+    if (verbose < 0) {
+        verbose = (getenv("HOST_TEST_VERBOSE") != NULL) ? 1 : 0;
+    }
+    if (level == 'I' && verbose == 0) {
+        return;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    default: return "ERROR";
+    }
+}
+
+#if HOST_NEED_STRLCPY
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    const size_t len = strlen(src);
+    if (size > 0) {
+        const size_t n = (len < size) ? len : (size - 1U);
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+/* ---- heap: plain malloc, every block is "DMA capable" ---- */
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_BYTES;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_BYTES;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_BYTES;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return HOST_HEAP_BYTES;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return HOST_HEAP_BYTES;
+}
+
+/* ---- clocks ---- */
+
+static time_t s_wall_s = 1767225600; /* 2026-01-01 00:00:00 UTC */
+
+void host_clock_set(time_t unix_s)
+{
+    s_wall_s = unix_s;
+}
+
+void host_clock_advance(time_t seconds)
+{
+    s_wall_s += seconds;
+}
+
+time_t __wrap_time(time_t *out);
+time_t __wrap_time(time_t *out)
+{
+    if (out != NULL) {
+        *out = s_wall_s;
+    }
+    return s_wall_s;
+}
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz);
+int __wrap_gettimeofday(struct timeval *tv, void *tz)
+{
+    (void)tz;
+    if (tv != NULL) {
+        tv->tv_sec = s_wall_s;
+        tv->tv_usec = 0;
+    }
+    return 0;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((int64_t)ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    bool active;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (args == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->args = *args;
+    *out_handle = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    (void)timeout_us;
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return esp_timer_start_once(timer, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL || !timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer != NULL && timer->active;
+}
+
+/* ---- FreeRTOS ---- */
+
+typedef enum {
+    SEM_BINARY,
+    SEM_MUTEX,
+    SEM_RECURSIVE,
+} sem_kind_t;
+
+struct host_semaphore {
+    sem_kind_t kind;
+    UBaseType_t count;
+};
+
+static SemaphoreHandle_t sem_new(sem_kind_t kind, UBaseType_t count)
+{
+    struct host_semaphore *s = calloc(1, sizeof(*s));
+    if (s != NULL) {
+        s->kind = kind;
+        s->count = count;
+    }
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return sem_new(SEM_BINARY, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return sem_new(SEM_MUTEX, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return sem_new(SEM_RECURSIVE, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+/* Nobody else can give it; waiting is where the panel finishes queued transfers. */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks;
+    if (sem == NULL) {
+        return pdFALSE;
+    }
+    while (sem->count == 0 && lcd_recorder_complete_one()) {
+    }
+    if (sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem == NULL || sem->count > 0) {
+        return pdFALSE;
+    }
+    sem->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken)
+{
+    if (higher_prio_woken != NULL) {
+        *higher_prio_woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+/* Single thread: every take succeeds, the count only checks pairing. */
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks;
+    if (sem == NULL) {
+        return pdFALSE;
+    }
+    sem->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    if (sem == NULL || sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+static TickType_t s_ticks;
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_ticks += ticks;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return s_ticks;
+}
+
+/* ---- NVS: per-process u32 table, namespaces are not separated ---- */
+
+static struct {
+    char key[16];
+    uint32_t value;
+    bool used;
+} s_nvs[HOST_NVS_MAX_KEYS];
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)name;
+    (void)open_mode;
+    if (out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_handle = 1U;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+static int nvs_find(const char *key)
+{
+    for (size_t i = 0; i < HOST_NVS_MAX_KEYS; i++) {
+        if (s_nvs[i].used && strcmp(s_nvs[i].key, key) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    (void)handle;
+    const int i = nvs_find(key);
+    if (i < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = s_nvs[i].value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    (void)handle;
+    int i = nvs_find(key);
+    for (size_t j = 0; i < 0 && j < HOST_NVS_MAX_KEYS; j++) {
+        if (!s_nvs[j].used) {
+            i = (int)j;
+        }
+    }
+    if (i < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    strlcpy(s_nvs[i].key, key, sizeof(s_nvs[i].key));
+    s_nvs[i].value = value;
+    s_nvs[i].used = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    (void)handle;
+    const int i = nvs_find(key);
+    if (i < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    s_nvs[i].used = false;
+    return ESP_OK;
+}
+
+/* ---- buses and backlight: accepted and ignored ---- */
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    (void)host_id;
+    (void)dma_chan;
+    return (bus_config != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+    (void)host_id;
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    return (timer_conf != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    return (ledc_conf != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)speed_mode;
+    (void)channel;
+    (void)duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+/* ---- network / SNTP: no client runs ---- */
+
+static bool s_sntp_enabled;
+static uint32_t s_sntp_interval_ms = 3600000U;
+static sntp_sync_mode_t s_sntp_mode;
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+bool esp_sntp_enabled(void)
+{
+    return s_sntp_enabled;
+}
+
+void esp_sntp_init(void)
+{
+    s_sntp_enabled = true;
+}
+
+void esp_sntp_stop(void)
+{
+    s_sntp_enabled = false;
+}
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t operating_mode)
+{
+    (void)operating_mode;
+}
+
+void esp_sntp_setservername(uint8_t idx, const char *server)
+{
+    (void)idx;
+    (void)server;
+}
+
+void esp_sntp_set_sync_interval(uint32_t interval_ms)
+{
+    s_sntp_interval_ms = interval_ms;
+}
+
+uint32_t sntp_get_sync_interval(void)
+{
+    return s_sntp_interval_ms;
+}
+
+void sntp_set_sync_mode(sntp_sync_mode_t sync_mode)
+{
+    s_sntp_mode = sync_mode;
+}
+
+sntp_sync_mode_t sntp_get_sync_mode(void)
+{
+    return s_sntp_mode;
+}
+
+void sntp_set_sync_status(sntp_sync_status_t sync_status)
+{
+    (void)sync_status;
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+/* Host stub of the ESP-IDF header of the same name; only what host_test compiles. */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct timeval;
+
+typedef enum {
+    ESP_SNTP_OPMODE_POLL,
+    ESP_SNTP_OPMODE_LISTENONLY,
+} esp_sntp_operatingmode_t;
+
+typedef enum {
+    SNTP_SYNC_MODE_IMMED,
+    SNTP_SYNC_MODE_SMOOTH,
+} sntp_sync_mode_t;
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+/* No network on the host: the client never starts and never syncs. */
+bool esp_sntp_enabled(void);
+void esp_sntp_init(void);
+void esp_sntp_stop(void);
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t operating_mode);
+void esp_sntp_setservername(uint8_t idx, const char *server);
+void esp_sntp_set_sync_interval(uint32_t interval_ms);
+uint32_t sntp_get_sync_interval(void);
+void sntp_set_sync_mode(sntp_sync_mode_t sync_mode);
+sntp_sync_mode_t sntp_get_sync_mode(void);
+void sntp_set_sync_status(sntp_sync_status_t sync_status);
+
+/* Weak in IDF; sntp_api supplies its own. */
+void sntp_sync_time(struct timeval *tv);
+
+#ifdef __cplusplus
+}
+#endif
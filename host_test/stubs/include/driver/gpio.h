@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+/* Host stub of the ESP-IDF header of the same name; only what host_test compiles. */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_1,
+    GPIO_NUM_2,
+    GPIO_NUM_3,
+    GPIO_NUM_4,
+    GPIO_NUM_5,
+    GPIO_NUM_6,
+    GPIO_NUM_7,
+    GPIO_NUM_8,
+    GPIO_NUM_9,
+    GPIO_NUM_10,
+    GPIO_NUM_11,
+} gpio_num_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+/* Host stub of the ESP-IDF header of the same name; only what host_test compiles. */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO 3
+#define SPICOMMON_BUSFLAG_MASTER (1U << 0)
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host_id);
+
+#ifdef __cplusplus
+}
+#endif
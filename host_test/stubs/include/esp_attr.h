@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+/* Host stub of the ESP-IDF header of the same name; only what host_test compiles. */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
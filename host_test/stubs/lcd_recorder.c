@@ -0,0 +1,324 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#include "lcd_recorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_lcd_panel_commands.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+
+#define RECORDER_MAX_QUEUE 32U
+
+typedef struct {
+    const void *data;
+    void *snapshot; /* what the caller handed over; compared on completion */
+    size_t len;
+} queued_trans_t;
+
+struct esp_lcd_panel_io_t {
+    esp_lcd_panel_io_color_trans_done_cb_t on_done;
+    void *user_ctx;
+    size_t depth;
+    queued_trans_t queue[RECORDER_MAX_QUEUE];
+    size_t head;
+    size_t count;
+    bool caset_seen; /* CASET sent, RASET completes the window */
+};
+
+struct esp_lcd_panel_t {
+    esp_lcd_panel_io_handle_t io;
+    int x_gap;
+    int y_gap;
+    uint8_t madctl;
+};
+
+static struct esp_lcd_panel_io_t *s_io;
+static lcd_recorder_stats_t s_stats;
+static uint16_t s_ram[LCD_RECORDER_RAM_ROWS][LCD_RECORDER_RAM_COLS];
+static struct {
+    int col0, col1, row0, row1;
+    int col, row;
+} s_win;
+
+void lcd_recorder_get_stats(lcd_recorder_stats_t *out)
+{
+    if (out != NULL) {
+        *out = s_stats;
+    }
+}
+
+uint16_t lcd_recorder_ram_pixel(int col, int row)
+{
+    if (col < 0 || row < 0 || col >= LCD_RECORDER_RAM_COLS || row >= LCD_RECORDER_RAM_ROWS) {
+        return 0;
+    }
+    return s_ram[row][col];
+}
+
+bool lcd_recorder_complete_one(void)
+{
+    struct esp_lcd_panel_io_t *io = s_io;
+    if (io == NULL || io->count == 0) {
+        return false;
+    }
+    queued_trans_t *t = &io->queue[io->head];
+    if (memcmp(t->data, t->snapshot, t->len) != 0) {
+        s_stats.reused_in_flight++;
+    }
+    free(t->snapshot);
+    t->snapshot = NULL;
+    io->head = (io->head + 1U) % RECORDER_MAX_QUEUE;
+    io->count--;
+    if (io->on_done != NULL) {
+        esp_lcd_panel_io_event_data_t edata = {0};
+        (void)io->on_done(io, &edata, io->user_ctx);
+    }
+    return true;
+}
+
+static void drain(void)
+{
+    while (lcd_recorder_complete_one()) {
+    }
+}
+
+static int be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/* RAMWR restarts at the window origin, RAMWRC continues; both wrap inside the window. */
+static void ram_write(int cmd, const uint16_t *px, size_t count)
+{
+    if (cmd == LCD_CMD_RAMWR) {
+        s_win.col = s_win.col0;
+        s_win.row = s_win.row0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (s_win.col >= 0 && s_win.row >= 0 && s_win.col < LCD_RECORDER_RAM_COLS && s_win.row < LCD_RECORDER_RAM_ROWS) {
+            s_ram[s_win.row][s_win.col] = px[i];
+        }
+        if (++s_win.col > s_win.col1) {
+            s_win.col = s_win.col0;
+            if (++s_win.row > s_win.row1) {
+                s_win.row = s_win.row0;
+            }
+        }
+    }
+}
+
+esp_err_t esp_lcd_new_panel_io_spi(esp_lcd_spi_bus_handle_t bus,
+                                   const esp_lcd_panel_io_spi_config_t *io_config,
+                                   esp_lcd_panel_io_handle_t *ret_io)
+{
+    (void)bus;
+    if (io_config == NULL || ret_io == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_io != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    struct esp_lcd_panel_io_t *io = calloc(1, sizeof(*io));
+    if (io == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    io->on_done = io_config->on_color_trans_done;
+    io->user_ctx = io_config->user_ctx;
+    io->depth = io_config->trans_queue_depth;
+    if (io->depth == 0 || io->depth > RECORDER_MAX_QUEUE) {
+        io->depth = RECORDER_MAX_QUEUE;
+    }
+    io->caset_seen = false;
+    s_io = io;
+    *ret_io = io;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io)
+{
+    if (io == NULL || io != s_io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    drain();
+    s_io = NULL;
+    free(io);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    if (io == NULL || io != s_io || (param_size > 0 && param == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Like the SPI IO: a command waits for the color data queued before it. */
+    drain();
+    s_stats.param_cmds++;
+
+    const uint8_t *p = param;
+    if ((lcd_cmd == LCD_CMD_CASET || lcd_cmd == LCD_CMD_RASET) && param_size == 4U) {
+        if (lcd_cmd == LCD_CMD_CASET) {
+            s_win.col0 = be16(&p[0]);
+            s_win.col1 = be16(&p[2]);
+            io->caset_seen = true;
+        } else {
+            s_win.row0 = be16(&p[0]);
+            s_win.row1 = be16(&p[2]);
+            if (io->caset_seen) {
+                s_stats.windows++;
+            }
+            io->caset_seen = false;
+        }
+        s_win.col = s_win.col0;
+        s_win.row = s_win.row0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    if (io == NULL || io != s_io || color == NULL || color_size == 0 || (color_size % sizeof(uint16_t)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (lcd_cmd != LCD_CMD_RAMWR && lcd_cmd != LCD_CMD_RAMWRC) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    while (io->count >= io->depth) {
+        (void)lcd_recorder_complete_one();
+    }
+    void *snapshot = malloc(color_size);
+    if (snapshot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(snapshot, color, color_size);
+    ram_write(lcd_cmd, snapshot, color_size / sizeof(uint16_t));
+
+    queued_trans_t *t = &io->queue[(io->head + io->count) % RECORDER_MAX_QUEUE];
+    t->data = color;
+    t->snapshot = snapshot;
+    t->len = color_size;
+    io->count++;
+    s_stats.color_trans++;
+    s_stats.color_bytes += (uint32_t)color_size;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_st7789(esp_lcd_panel_io_handle_t io,
+                                   const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                   esp_lcd_panel_handle_t *ret_panel)
+{
+    if (io == NULL || panel_dev_config == NULL || ret_panel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_lcd_panel_t *panel = calloc(1, sizeof(*panel));
+    if (panel == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    panel->io = io;
+    *ret_panel = panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    free(panel);
+    return ESP_OK;
+}
+
+static esp_err_t panel_cmd(esp_lcd_panel_handle_t panel, int cmd, const void *param, size_t len)
+{
+    if (panel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return esp_lcd_panel_io_tx_param(panel->io, cmd, param, len);
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    return panel_cmd(panel, LCD_CMD_SWRESET, NULL, 0);
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    const uint8_t colmod = 0x55;
+    esp_err_t err = panel_cmd(panel, LCD_CMD_SLPOUT, NULL, 0);
+    if (err == ESP_OK) {
+        err = panel_cmd(panel, LCD_CMD_MADCTL, &panel->madctl, 1);
+    }
+    if (err == ESP_OK) {
+        err = panel_cmd(panel, LCD_CMD_COLMOD, &colmod, 1);
+    }
+    return err;
+}
+
+/* Same bus sequence as the IDF ST7789 driver: CASET, RASET, RAMWR with the gap applied. */
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data)
+{
+    if (panel == NULL || color_data == NULL || x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const int xs = x_start + panel->x_gap;
+    const int xe = x_end - 1 + panel->x_gap;
+    const int ys = y_start + panel->y_gap;
+    const int ye = y_end - 1 + panel->y_gap;
+    const uint8_t caset[4] = {(uint8_t)(xs >> 8), (uint8_t)xs, (uint8_t)(xe >> 8), (uint8_t)xe};
+    const uint8_t raset[4] = {(uint8_t)(ys >> 8), (uint8_t)ys, (uint8_t)(ye >> 8), (uint8_t)ye};
+
+    esp_err_t err = panel_cmd(panel, LCD_CMD_CASET, caset, sizeof(caset));
+    if (err == ESP_OK) {
+        err = panel_cmd(panel, LCD_CMD_RASET, raset, sizeof(raset));
+    }
+    if (err == ESP_OK) {
+        const size_t bytes = (size_t)(x_end - x_start) * (size_t)(y_end - y_start) * sizeof(uint16_t);
+        err = esp_lcd_panel_io_tx_color(panel->io, LCD_CMD_RAMWR, color_data, bytes);
+    }
+    return err;
+}
+
+static esp_err_t madctl_apply(esp_lcd_panel_handle_t panel, uint8_t set, uint8_t mask)
+{
+    panel->madctl = (uint8_t)((panel->madctl & (uint8_t)~mask) | set);
+    return panel_cmd(panel, LCD_CMD_MADCTL, &panel->madctl, 1);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    if (panel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return madctl_apply(panel, (uint8_t)((mirror_x ? LCD_CMD_MX_BIT : 0) | (mirror_y ? LCD_CMD_MY_BIT : 0)),
+                        LCD_CMD_MX_BIT | LCD_CMD_MY_BIT);
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    if (panel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return madctl_apply(panel, swap_axes ? LCD_CMD_MV_BIT : 0, LCD_CMD_MV_BIT);
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    if (panel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    panel->x_gap = x_gap;
+    panel->y_gap = y_gap;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return panel_cmd(panel, invert_color_data ? LCD_CMD_INVON : LCD_CMD_INVOFF, NULL, 0);
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off)
+{
+    return panel_cmd(panel, on_off ? LCD_CMD_DISPON : LCD_CMD_DISPOFF, NULL, 0);
+}
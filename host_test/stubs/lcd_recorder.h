@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file lcd_recorder.h
+ * @brief Host esp_lcd panel IO + ST7789 stub that records bus traffic.
+ *
+ * Implements the esp_lcd_panel_io / esp_lcd_panel calls display_api uses.
+ * Color transfers are queued like the SPI driver does: tx_param drains the
+ * queue first, a full queue completes its oldest entry, and a task blocking
+ * on a semaphore lets one transfer finish (see lcd_recorder_complete_one()).
+ * Each completion calls on_color_trans_done. Written pixels land in a model
+ * of the panel RAM so tests can check what the panel would show.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ST7789 frame memory; addresses as sent in CASET/RASET, MADCTL not applied. */
+#define LCD_RECORDER_RAM_COLS 320
+#define LCD_RECORDER_RAM_ROWS 320
+
+typedef struct {
+    uint32_t color_trans;      /* RAMWR/RAMWRC transfers */
+    uint32_t color_bytes;      /* pixel bytes in them */
+    uint32_t windows;          /* CASET+RASET pairs */
+    uint32_t param_cmds;       /* every tx_param, window commands included */
+    uint32_t reused_in_flight; /* color buffers modified before their transfer completed */
+} lcd_recorder_stats_t;
+
+/** @brief Totals since start; take deltas around an operation. */
+void lcd_recorder_get_stats(lcd_recorder_stats_t *out);
+/** @brief Finish the oldest queued color transfer; false if none was queued. */
+bool lcd_recorder_complete_one(void);
+/** @brief Pixel last written to panel RAM at (col, row), 0 if never written or out of range. */
+uint16_t lcd_recorder_ram_pixel(int col, int row);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,324 @@
+/*
+ * SPDX-License-Identifier: 0BSD
+ */
+
+/*
+ * Panel bus traffic per drawing operation, against fixed budgets.
+ *
+ * Every case runs on the host against the recording esp_lcd stub and is
+ * compared per call with its budget: more transfers, bytes or address
+ * windows than budgeted fail the test; fewer are reported so the budget can
+ * be tightened in the same change. display_get_io_stats() must agree with
+ * what the stub saw, and no color buffer may change while it is in flight.
+ * Geometry and bar style match main/main.c.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "display_api.h"
+#include "display_image.h"
+#include "host_idf.h"
+#include "lcd_recorder.h"
+#include "sntp_api.h"
+
+#define TFT_WIDTH 170
+#define TFT_HEIGHT 320
+#define DISPLAY_X_OFFSET 35
+#define DISPLAY_Y_OFFSET 0
+#define BENCH_TEXT "12:34"
+#define BENCH_BITMAP_ROWS 20
+#define OBJ_W 40
+#define OBJ_H 30
+
+typedef struct {
+    uint32_t color_trans;
+    uint32_t color_bytes;
+    uint32_t windows;
+} io_budget_t;
+
+typedef struct {
+    const char *name;
+    void (*setup)(void *ctx);
+    void (*run)(void *ctx);
+    void *ctx;
+    uint32_t reps;
+    io_budget_t budget; /* per call */
+} io_case_t;
+
+static const int k_blit_rows[] = {1, 10};
+static const uint8_t k_text_scales[] = {1U, 2U, 3U, 4U};
+
+static display_image_t s_img;
+static uint16_t *s_bitmap;
+static uint16_t s_object[OBJ_W * OBJ_H];
+static uint32_t s_iter;
+static int s_failures;
+
+static void expect(bool ok, const char *what)
+{
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static esp_err_t gradient_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    (void)user_ctx;
+    for (int r = 0; r < rows; r++) {
+        const uint16_t base = (uint16_t)(((row + r) & 0x1F) << 11);
+        uint16_t *dst = &band[(size_t)r * (size_t)width];
+        for (int x = 0; x < width; x++) {
+            dst[x] = (uint16_t)(base | (uint16_t)((x & 0x3F) << 5));
+        }
+    }
+    return ESP_OK;
+}
+
+static void run_fill(void *ctx)
+{
+    static const uint16_t colors[] = {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F};
+    (void)ctx;
+    display_fill_color(colors[s_iter++ % (sizeof(colors) / sizeof(colors[0]))]);
+}
+
+static void run_rect(void *ctx)
+{
+    (void)ctx;
+    display_draw_rect(10, 40, OBJ_W, OBJ_H, 0xF800);
+}
+
+static void run_blit(void *ctx)
+{
+    expect(display_image_draw_streaming(&s_img, *(const int *)ctx, gradient_band, NULL) == ESP_OK, "blit");
+}
+
+static void setup_bitmap(void *ctx)
+{
+    (void)ctx;
+    if (s_bitmap == NULL) {
+        s_bitmap = malloc((size_t)TFT_WIDTH * BENCH_BITMAP_ROWS * sizeof(uint16_t));
+        expect(s_bitmap != NULL, "bitmap alloc");
+    }
+    if (s_bitmap != NULL) {
+        (void)gradient_band(s_bitmap, 0, BENCH_BITMAP_ROWS, TFT_WIDTH, NULL);
+    }
+}
+
+static void run_bitmap(void *ctx)
+{
+    (void)ctx;
+    expect(display_draw_bitmap(0, 0, TFT_WIDTH, BENCH_BITMAP_ROWS, s_bitmap) == ESP_OK, "bitmap");
+    expect(display_wait_idle() == ESP_OK, "bitmap wait_idle");
+}
+
+static void setup_object(void *ctx)
+{
+    (void)ctx;
+    (void)gradient_band(s_object, 0, OBJ_H, OBJ_W, NULL);
+}
+
+static void run_oriented(void *ctx)
+{
+    (void)ctx;
+    expect(display_image_draw_rect_oriented(&s_img, 20, 60, OBJ_W, OBJ_H, s_object, OBJ_W * OBJ_H,
+                                            DISPLAY_IMAGE_ORIENT_90) == ESP_OK,
+           "oriented draw");
+}
+
+static void run_text(void *ctx)
+{
+    display_draw_text_run(0, 64, BENCH_TEXT, 0xFFFF, 0x0000, *(const uint8_t *)ctx, 0U);
+}
+
+/* ctx != NULL: full repaint each call; NULL: the steady state, where the text did not change. */
+static void run_status_bar(void *ctx)
+{
+    if (ctx != NULL) {
+        sntp_api_status_bar_invalidate();
+    }
+    sntp_api_status_bar_draw();
+}
+
+/* Polled mode: a request from another task overrides the update period. */
+static void run_status_bar_requested(void *ctx)
+{
+    (void)ctx;
+    sntp_api_status_bar_invalidate();
+    sntp_api_status_bar_request_redraw();
+    sntp_api_status_bar_update_if_due(60U * 60U * 1000U);
+}
+
+/* Each call lands on the next minute, so only the changed digits are redrawn. */
+static void run_status_bar_minute(void *ctx)
+{
+    (void)ctx;
+    host_clock_advance(60);
+    sntp_api_status_bar_draw();
+}
+
+static io_case_t s_cases[] = {
+    {.name = "display.fill", .run = run_fill, .reps = 5,
+     .budget = {8, 108800, 1}},
+    {.name = "display.rect", .run = run_rect, .reps = 10,
+     .budget = {1, 2400, 1}},
+    {.name = "display.blit.rows_1", .run = run_blit, .ctx = (void *)&k_blit_rows[0], .reps = 2,
+     .budget = {320, 108800, 1}},
+    {.name = "display.blit.rows_10", .run = run_blit, .ctx = (void *)&k_blit_rows[1], .reps = 2,
+     .budget = {32, 108800, 1}},
+    {.name = "display.bitmap", .setup = setup_bitmap, .run = run_bitmap, .reps = 5,
+     .budget = {1, 6800, 1}},
+    {.name = "image.oriented_90", .setup = setup_object, .run = run_oriented, .reps = 5,
+     .budget = {1, 2400, 1}},
+    {.name = "text.scale_1", .run = run_text, .ctx = (void *)&k_text_scales[0], .reps = 10,
+     .budget = {1, 420, 1}},
+    {.name = "text.scale_2", .run = run_text, .ctx = (void *)&k_text_scales[1], .reps = 10,
+     .budget = {1, 1680, 1}},
+    {.name = "text.scale_3", .run = run_text, .ctx = (void *)&k_text_scales[2], .reps = 10,
+     .budget = {1, 3780, 1}},
+    {.name = "text.scale_4", .run = run_text, .ctx = (void *)&k_text_scales[3], .reps = 10,
+     .budget = {1, 6720, 1}},
+    {.name = "sntp.status_bar.redraw", .run = run_status_bar, .ctx = (void *)1, .reps = 5,
+     .budget = {3, 16390, 1}},
+    {.name = "sntp.status_bar.requested", .run = run_status_bar_requested, .reps = 5,
+     .budget = {3, 16390, 1}},
+    {.name = "sntp.status_bar.unchanged", .run = run_status_bar, .reps = 5,
+     .budget = {0, 0, 0}},
+    {.name = "sntp.status_bar.minute", .run = run_status_bar_minute, .reps = 5,
+     .budget = {1, 960, 1}},
+};
+
+static bool check_metric(const char *name, const char *metric, uint32_t total, uint32_t reps, uint32_t budget)
+{
+    if (total > budget * reps) {
+        fprintf(stderr, "FAIL: %s %s %.2f per call, budget %" PRIu32 "\n", name, metric, (double)total / reps, budget);
+        return false;
+    }
+    if (total < budget * reps) {
+        printf("note: %s %s %.2f per call, budget %" PRIu32 " can be tightened\n", name, metric,
+               (double)total / reps, budget);
+    }
+    return true;
+}
+
+static void run_case(const io_case_t *c)
+{
+    if (c->setup != NULL) {
+        c->setup(c->ctx);
+    }
+    /* One untimed call first: glyph cache, bar layout and framebuffer settle. */
+    c->run(c->ctx);
+
+    lcd_recorder_stats_t rec0;
+    lcd_recorder_stats_t rec1;
+    display_io_stats_t io0;
+    display_io_stats_t io1;
+    lcd_recorder_get_stats(&rec0);
+    display_get_io_stats(&io0);
+    for (uint32_t i = 0; i < c->reps; i++) {
+        c->run(c->ctx);
+    }
+    expect(display_wait_idle() == ESP_OK, "wait_idle");
+    lcd_recorder_get_stats(&rec1);
+    display_get_io_stats(&io1);
+
+    const uint32_t trans = rec1.color_trans - rec0.color_trans;
+    const uint32_t bytes = rec1.color_bytes - rec0.color_bytes;
+    const uint32_t windows = rec1.windows - rec0.windows;
+    printf("%-28s trans %8.2f  bytes %10.2f  windows %6.2f\n", c->name, (double)trans / c->reps,
+           (double)bytes / c->reps, (double)windows / c->reps);
+
+    bool ok = check_metric(c->name, "color_trans", trans, c->reps, c->budget.color_trans);
+    ok &= check_metric(c->name, "color_bytes", bytes, c->reps, c->budget.color_bytes);
+    ok &= check_metric(c->name, "windows", windows, c->reps, c->budget.windows);
+    if (!ok) {
+        s_failures++;
+    }
+    if (io1.color_trans - io0.color_trans != trans || io1.color_bytes - io0.color_bytes != bytes
+        || io1.windows - io0.windows != windows) {
+        fprintf(stderr, "FAIL: %s display_get_io_stats disagrees with the bus\n", c->name);
+        s_failures++;
+    }
+    if (rec1.reused_in_flight != rec0.reused_in_flight) {
+        fprintf(stderr, "FAIL: %s modified a color buffer still in flight\n", c->name);
+        s_failures++;
+    }
+}
+
+/* What the panel shows after a fill: every active pixel, nothing in the gap columns. */
+static void check_fill_pixels(void)
+{
+    display_fill_color(0x07E0);
+    expect(display_wait_idle() == ESP_OK, "fill wait_idle");
+    bool ok = true;
+    for (int y = 0; y < TFT_HEIGHT && ok; y++) {
+        for (int x = 0; x < TFT_WIDTH && ok; x++) {
+            ok = lcd_recorder_ram_pixel(x + DISPLAY_X_OFFSET, y + DISPLAY_Y_OFFSET) == 0x07E0;
+        }
+    }
+    expect(ok, "fill reached every active pixel");
+    expect(lcd_recorder_ram_pixel(DISPLAY_X_OFFSET - 1, 0) == 0 && lcd_recorder_ram_pixel(DISPLAY_X_OFFSET + TFT_WIDTH, 0) == 0,
+           "fill stayed inside the active area");
+}
+
+int main(void)
+{
+    const display_pins_t pins = {
+        .sck = GPIO_NUM_2,
+        .mosi = GPIO_NUM_3,
+        .cs = GPIO_NUM_10,
+        .dc = GPIO_NUM_11,
+        .reset = GPIO_NUM_4,
+        .backlight = GPIO_NUM_5,
+    };
+    const display_cfg_t cfg = {
+        .width = TFT_WIDTH,
+        .height = TFT_HEIGHT,
+        .x_offset = DISPLAY_X_OFFSET,
+        .y_offset = DISPLAY_Y_OFFSET,
+        .spi_clock_hz = 26 * 1000 * 1000,
+    };
+    const sntp_api_cfg_t sntp_cfg = {
+        .server_name = SNTP_API_DEFAULT_SERVER,
+        .sync_interval_ms = 60U * 60U * 1000U,
+        .bar_bg_color = 0x0000,
+        .bar_fg_color = 0xFFFF,
+        .text_scale = 4U,
+        .date_scale = 3U,
+        .time_scale = 4U,
+        .line_gap_px = 20U,
+        .date_char_spacing_px = 3U,
+        .time_char_spacing_px = 5U,
+        .use_framebuffer = true,
+    };
+
+    if (display_init(&pins, &cfg) != ESP_OK) {
+        fprintf(stderr, "FAIL: display_init\n");
+        return 1;
+    }
+    if (sntp_api_init(&sntp_cfg) != ESP_OK) {
+        fprintf(stderr, "FAIL: sntp_api_init\n");
+        return 1;
+    }
+    display_image_init(&s_img, display_get_panel_handle(), (uint16_t)display_get_width(),
+                       (uint16_t)display_get_height());
+
+    check_fill_pixels();
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        run_case(&s_cases[i]);
+    }
+
+    sntp_api_deinit();
+    free(s_bitmap);
+    if (s_failures > 0) {
+        fprintf(stderr, "%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("all transfer budgets met\n");
+    return 0;
+}
@@ -6,22 +6,32 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
+#include "bench_api.h"
 #include "dht20_api.h"
+#include "dht20_flashlog.h"
+#include "dht20_history.h"
 #include "display_api.h"
 #include "display_image.h"
+#include "display_server.h"
+#include "display_widget.h"
 #include "knob_api.h"
+#include "perf_api.h"
+#include "rgb_led_api.h"
 #include "sntp_api.h"
 #include "wifi_http_api.h"
-#include "driver/i2c.h"
-#include "driver/rmt_encoder.h"
-#include "driver/rmt_tx.h"
 #include "esp_check.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_pm.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 #include "freertos/task.h"
+#include "nvs_flash.h"
+#include "sdkconfig.h"
 
 #define APP_ENABLE_DHT20 1
 #define APP_ENABLE_DISPLAY 1
@@ -29,7 +39,27 @@
 #define APP_ENABLE_RGB_LED 0
 #define APP_ENABLE_SNTP 1
 #define APP_ENABLE_WIFI_HTTP 1
-#define APP_RUN_DISPLAY_BENCHMARK 0
+/* Run the bench_api suite once before the main loop and print its JSON report on the console. */
+#define APP_BENCH_AT_BOOT 0
+/* Comma-separated case-name prefixes for the boot run, e.g. "display.blit,text" ("" = all). */
+#define APP_BENCH_FILTER ""
+#define APP_LOOP_PERIOD_MS 10U
+/*
+ * Auto light sleep: esp_pm DFS + tickless idle, and the loop blocks until its next deadline
+ * or a knob edge instead of waking every APP_LOOP_PERIOD_MS. Needs CONFIG_PM_ENABLE and
+ * CONFIG_FREERTOS_USE_TICKLESS_IDLE (sdkconfig.defaults.powersave); the USB-Serial-JTAG
+ * console drops out while asleep.
+ */
+#define APP_POWER_SAVE 0
+#define APP_PM_MAX_FREQ_MHZ 160
+#define APP_PM_MIN_FREQ_MHZ 40
+/* Upper bound for one idle wait, so a missed notification costs at most this much latency. */
+#define APP_IDLE_MAX_WAIT_MS 5000U
+/* Keep polling at APP_LOOP_PERIOD_MS this long after knob activity (PCNT only counts while awake). */
+#define APP_KNOB_ACTIVE_MS 1000U
+/* Run the Wi-Fi, sensor and display inits on their own tasks instead of one after another. */
+#define APP_BOOT_PARALLEL 1
+#define APP_BOOT_STEP_STACK 4096U
 
 #if (APP_ENABLE_DHT20 != 0) && (APP_ENABLE_DHT20 != 1)
 #error "APP_ENABLE_DHT20 must be 0 or 1"
@@ -55,18 +85,41 @@
 #error "APP_ENABLE_WIFI_HTTP must be 0 or 1"
 #endif
 
-#if (APP_RUN_DISPLAY_BENCHMARK != 0) && (APP_RUN_DISPLAY_BENCHMARK != 1)
-#error "APP_RUN_DISPLAY_BENCHMARK must be 0 or 1"
+#if (APP_POWER_SAVE != 0) && (APP_POWER_SAVE != 1)
+#error "APP_POWER_SAVE must be 0 or 1"
+#endif
+
+#if APP_POWER_SAVE && !(defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE))
+#error "APP_POWER_SAVE needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE (sdkconfig.defaults.powersave)"
+#endif
+
+#if (APP_BENCH_AT_BOOT != 0) && (APP_BENCH_AT_BOOT != 1)
+#error "APP_BENCH_AT_BOOT must be 0 or 1"
+#endif
+
+#if (APP_BOOT_PARALLEL != 0) && (APP_BOOT_PARALLEL != 1)
+#error "APP_BOOT_PARALLEL must be 0 or 1"
 #endif
 
-#define DHT20_I2C_PORT I2C_NUM_0
-#define DHT20_I2C_SDA_GPIO GPIO_NUM_6
-#define DHT20_I2C_SCL_GPIO GPIO_NUM_7
-#define DHT20_I2C_FREQ_HZ 400000
+/* Shared sensor bus; each device on it sets its own clock and timeout. */
+#define APP_I2C_PORT I2C_NUM_0
+#define APP_I2C_SDA_GPIO GPIO_NUM_6
+#define APP_I2C_SCL_GPIO GPIO_NUM_7
+
+#define DHT20_I2C_FREQ_HZ 400000U
 
 #define DHT20_I2C_TIMEOUT_MS 20
 #define DHT20_READY_TIMEOUT_MS 120
 #define DHT20_POLL_INTERVAL_MS 2
+/* Acquire from an esp_timer state machine with the bus work queued to the i2c_bus worker. */
+#define DHT20_USE_ASYNC 1
+/* Every conversion wakes the chip twice (trigger, read), so sample slower when sleeping. */
+#define DHT20_SAMPLE_PERIOD_MS (APP_POWER_SAVE ? 1000U : 100U)
+/* Window reported on UART/display: index into DHT20_HISTORY_DEFAULT_WINDOWS_MS (0 = 10 s). */
+#define DHT20_STATS_WINDOW 0U
+/* Append one window mean to the "history" flash partition every period (needs a valid wall clock). */
+#define DHT20_LOG_TO_FLASH 1
+#define DHT20_LOG_PERIOD_S 10U
 #define DHT20_PRINT_PERIOD_MS 2000
 #define DHT20_DISABLED_PRINT_PERIOD_MS 30000
 
@@ -78,6 +131,21 @@
 #define DISPLAY_X_OFFSET 35
 #define DISPLAY_Y_OFFSET 0
 #define DISPLAY_SPI_CLOCK_HZ (26 * 1000 * 1000)
+/* Start from the clock a previous calibration stored in NVS (falls back to DISPLAY_SPI_CLOCK_HZ). */
+#define DISPLAY_SPI_CLOCK_FROM_NVS 1
+/* Color flashes and the streaming test pattern (~1 s) before the first frame. */
+#define DISPLAY_BOOT_SELF_TEST 0
+/*
+ * Step the SPI clock up at boot from DISPLAY_SPI_CLOCK_HZ, showing a test pattern per step:
+ * click the knob within DISPLAY_SPI_CAL_CONFIRM_MS if it looks clean. Needs APP_ENABLE_KNOB.
+ */
+#define DISPLAY_SPI_CALIBRATE 0
+#define DISPLAY_SPI_CAL_MAX_HZ (80 * 1000 * 1000)
+#define DISPLAY_SPI_CAL_MARGIN_STEPS 0U
+#define DISPLAY_SPI_CAL_CONFIRM_MS 5000U
+#if DISPLAY_SPI_CALIBRATE && !APP_ENABLE_KNOB
+#error "DISPLAY_SPI_CALIBRATE needs APP_ENABLE_KNOB for the operator check"
+#endif
 #define DISPLAY_ROTATION DISPLAY_ROTATION_0
 #define DISPLAY_TEXT_SCALE 2
 /*
@@ -87,10 +155,24 @@
  */
 #define DISPLAY_TEXT_COLOR 0xFFFF
 #define DISPLAY_TEXT_LINE_GAP (8 * DISPLAY_TEXT_SCALE)
+/* Compose the readout widgets in RAM and send only changed pixels. */
+#define DISPLAY_TEXT_USE_FRAMEBUFFER 1
+/* Sparkline of the raw DHT20 temperature samples under the readout. */
+#define DISPLAY_SPARK_HEIGHT_PX 32
+#define DISPLAY_SPARK_MARGIN_PX 8
+#define DISPLAY_SPARK_COLOR 0x07E0
+#define DISPLAY_SPARK_MIN_SPAN_C 0.5f
+/* Hand draws to the display render task so the main loop never waits on SPI. */
+#define DISPLAY_USE_RENDER_TASK 1
+#define DISPLAY_RENDER_FRAME_MS 20U
 
 #define SNTP_SERVER_NAME SNTP_API_DEFAULT_SERVER
 #define SNTP_GMT_OFFSET_HOURS 0
 #define SNTP_SYNC_INTERVAL_MS (60U * 60U * 1000U)
+/* Slew small corrections so the clock never jumps; stretch polls up to a day while drift allows. */
+#define SNTP_SMOOTH_SYNC true
+#define SNTP_MAX_SYNC_INTERVAL_MS (24U * 60U * 60U * 1000U)
+#define SNTP_MAX_ERROR_MS 1000U
 #define SNTP_STATUS_REFRESH_MS 1000U
 #define SNTP_BAR_BG_COLOR 0x0000
 #define SNTP_BAR_FG_COLOR 0xFFFF
@@ -103,6 +185,9 @@
 /* extra pixels between characters */
 #define SNTP_DATE_CHAR_SPACING_PX 3U
 #define SNTP_TIME_CHAR_SPACING_PX 5U
+#define SNTP_BAR_USE_FRAMEBUFFER true
+/* Redraw the bar from an esp_timer at minute edges instead of polling it from the loop. */
+#define SNTP_BAR_EVENT_DRIVEN 1
 
 #define WIFI_HTTP_AP_SSID WIFI_HTTP_API_DEFAULT_AP_SSID
 #define WIFI_HTTP_AP_PASS WIFI_HTTP_API_DEFAULT_AP_PASS
@@ -121,11 +206,15 @@
 #define KNOB_PIN_DT GPIO_NUM_9
 #define KNOB_PIN_SW GPIO_NUM_20
 #define KNOB_DELTA_POS_STEP 5
+/* PCNT counts steps in hardware, so fast spins are not lost between loop iterations. */
+#define KNOB_BACKEND KNOB_BACKEND_PCNT
 
 /* Onboard/addressable RGB LED (WS2812-style single data pin). */
 #define RGB_LED_PIN GPIO_NUM_8
 #define RGB_LOG_THROTTLE_MS 100
-#define RGB_RMT_RESOLUTION_HZ 10000000
+/* Channel-select feedback: the LED blinks the selected primary, then returns to the mix. */
+#define RGB_SELECT_BLINK_PERIOD_MS 200U
+#define RGB_SELECT_BLINK_COUNT 2U
 
 static const char *TAG = "dht20_app";
 
@@ -133,35 +222,101 @@ static const char *TAG = "dht20_app";
 #define UART_PRINT_WARN(fmt, ...) ESP_LOGW(TAG, fmt, ##__VA_ARGS__)
 #define UART_PRINT_ERR(fmt, ...) ESP_LOGE(TAG, fmt, ##__VA_ARGS__)
 
+/* Main loop task; knob edges, SNTP syncs and finished bench runs notify it out of an idle wait. */
+static TaskHandle_t s_app_task = NULL;
+static perf_metric_t s_perf_loop_jitter = PERF_HISTOGRAM_INIT("app_loop_jitter_us", "Main loop period deviation", NULL);
+
+#if APP_ENABLE_DHT20
+static i2c_bus_t s_i2c_bus;
+/* Written only by the acquisition path; display and HTTP read it without locking. */
+static dht20_history_t s_dht20_history;
+#if DHT20_LOG_TO_FLASH
+/* Appended from the main loop only. */
+static dht20_flashlog_t s_dht20_flashlog;
+static bool s_dht20_flashlog_ready;
+#endif
+
+static void dht20_record(const dht20_sample_t *sample, esp_err_t status)
+{
+    dht20_sample_t adjusted = *sample;
+    if (status == ESP_OK
+        && dht20_sample_apply_offset(&adjusted, DHT20_TEMP_OFFSET_C, DHT20_HUM_OFFSET_RH) == ESP_OK) {
+        dht20_history_push(&s_dht20_history, &adjusted);
+    } else {
+        dht20_history_push_error(&s_dht20_history);
+    }
+}
+
+#if DHT20_LOG_TO_FLASH
+static void dht20_flashlog_tick(void)
+{
+#if APP_ENABLE_SNTP
+    dht20_window_stats_t stats = {0};
+    if (!s_dht20_flashlog_ready || !sntp_api_is_time_valid()
+        || dht20_history_get_stats(&s_dht20_history, 0, &stats) != ESP_OK || stats.temperature_c.count == 0U) {
+        return;
+    }
+
+    const esp_err_t err = dht20_flashlog_append(&s_dht20_flashlog, (uint32_t)time(NULL), stats.temperature_c.mean,
+                                                stats.humidity_rh.mean);
+    if (err != ESP_OK) {
+        UART_PRINT_WARN("flash log append failed: %s", esp_err_to_name(err));
+    }
+#endif
+}
+
+#if APP_ENABLE_WIFI_HTTP
+/* GET /api/history: rows stream straight out of the mapped log partition. */
+static esp_err_t dht20_history_source(uint32_t from_s,
+                                      uint32_t to_s,
+                                      wifi_http_api_history_row_fn_t row_fn,
+                                      void *row_ctx,
+                                      void *user_ctx)
+{
+    (void)user_ctx;
+    return dht20_flashlog_query(&s_dht20_flashlog, from_s, to_s, row_fn, row_ctx);
+}
+#endif
+#endif
+
+#if DHT20_USE_ASYNC
+/* i2c_bus worker task: the history ring never blocks acquisition. */
+static void dht20_on_sample(const dht20_sample_t *sample, esp_err_t status, void *user_ctx)
+{
+    (void)user_ctx;
+    dht20_record(sample, status);
+}
+#endif
+#endif
+
 #if APP_ENABLE_KNOB
 typedef struct {
-    rmt_channel_handle_t channel;
-    rmt_encoder_handle_t encoder;
     uint8_t rgb[3];
     uint8_t selected_channel;
     TickType_t last_log_tick;
 } rgb_ctrl_t;
 
+/* Posts to the rgb_led_api engine task; the RMT work happens there, off the main loop. */
 static esp_err_t rgb_ctrl_apply(const rgb_ctrl_t *ctrl)
 {
     ESP_RETURN_ON_FALSE(ctrl != NULL, ESP_ERR_INVALID_ARG, TAG, "ctrl is null");
-    ESP_RETURN_ON_FALSE(ctrl->channel != NULL, ESP_ERR_INVALID_STATE, TAG, "channel is null");
-    ESP_RETURN_ON_FALSE(ctrl->encoder != NULL, ESP_ERR_INVALID_STATE, TAG, "encoder is null");
-
-    const uint8_t grb[3] = {ctrl->rgb[1], ctrl->rgb[0], ctrl->rgb[2]};
-    const rmt_transmit_config_t tx_cfg = {
-        .loop_count = 0,
-        .flags = {
-            .eot_level = 0,
+    return rgb_led_set_color(ctrl->rgb[0], ctrl->rgb[1], ctrl->rgb[2]);
+}
+
+static void rgb_ctrl_blink_selected(const rgb_ctrl_t *ctrl)
+{
+    const rgb_led_effect_t blink = {
+        .kind = RGB_LED_EFFECT_BLINK,
+        .color = {
+            .r = (ctrl->selected_channel == 0U) ? 255U : 0U,
+            .g = (ctrl->selected_channel == 1U) ? 255U : 0U,
+            .b = (ctrl->selected_channel == 2U) ? 255U : 0U,
         },
+        .duration_ms = RGB_SELECT_BLINK_PERIOD_MS,
+        .on_ms = RGB_SELECT_BLINK_PERIOD_MS / 2U,
+        .repeat = RGB_SELECT_BLINK_COUNT,
     };
-
-    esp_err_t err = rmt_transmit(ctrl->channel, ctrl->encoder, grb, sizeof(grb), &tx_cfg);
-    if ((err == ESP_ERR_TIMEOUT) || (err == ESP_ERR_INVALID_STATE)) {
-        return ESP_OK;
-    }
-    ESP_RETURN_ON_ERROR(err, TAG, "rmt_transmit failed");
-    return ESP_OK;
+    (void)rgb_led_post(&blink);
 }
 
 static char rgb_channel_name(const uint8_t channel)
@@ -170,14 +325,23 @@ static char rgb_channel_name(const uint8_t channel)
     return (channel < 3U) ? names[channel] : '?';
 }
 
-static void knob_process(knob_t *knob, rgb_ctrl_t *rgb_ctrl)
+/* Returns true when the knob moved or the button changed state. */
+static bool knob_process(knob_t *knob, rgb_ctrl_t *rgb_ctrl)
 {
     knob_event_t event = {0};
     if (knob_poll(knob, &event) != ESP_OK) {
-        return;
+        return false;
     }
 
-    if ((event.delta != 0) && (rgb_ctrl != NULL) && (rgb_ctrl->channel != NULL)) {
+#if APP_ENABLE_WIFI_HTTP
+    if (event.delta != 0) {
+        char event_json[24];
+        snprintf(event_json, sizeof(event_json), "{\"pos\":%" PRId32 "}", event.position);
+        (void)wifi_http_api_events_publish("knob", event_json);
+    }
+#endif
+
+    if ((event.delta != 0) && (rgb_ctrl != NULL)) {
         int32_t value = (int32_t)rgb_ctrl->rgb[rgb_ctrl->selected_channel] + (event.delta * KNOB_DELTA_POS_STEP);
         if (value < 0) {
             value = 0;
@@ -204,229 +368,704 @@ static void knob_process(knob_t *knob, rgb_ctrl_t *rgb_ctrl)
     if (event.clicked && (rgb_ctrl != NULL)) {
         rgb_ctrl->selected_channel = (uint8_t)((rgb_ctrl->selected_channel + 1U) % 3U);
         (void)knob_set_position(knob, rgb_ctrl->rgb[rgb_ctrl->selected_channel]);
+        rgb_ctrl_blink_selected(rgb_ctrl);
         UART_PRINT_INFO("Selected channel: %c", rgb_channel_name(rgb_ctrl->selected_channel));
     }
+
+    return (event.delta != 0) || event.pressed || event.released;
 }
 #endif
 
 #if APP_ENABLE_DISPLAY
-static int display_text_width_px(const char *s)
-{
-    if (s == NULL) {
-        return 0;
-    }
-    return (int)strlen(s) * 6 * DISPLAY_TEXT_SCALE;
-}
+/*
+ * Sensor readout as retained widgets: two centered lines and, with the DHT20,
+ * a sparkline of the raw sample ring below them. Only changed widgets are
+ * redrawn, composed in one framebuffer when DISPLAY_TEXT_USE_FRAMEBUFFER.
+ */
+static display_screen_t s_dash;
+static display_widget_t s_dash_temp;
+static display_widget_t s_dash_rh;
+#if APP_ENABLE_DHT20
+static display_widget_t s_dash_spark;
+static dht20_sample_t s_dash_samples[DISPLAY_WIDGET_SPARK_MAX];
+static float s_dash_series[DISPLAY_WIDGET_SPARK_MAX];
+#endif
 
-static void display_draw_two_lines_centered(const char *line1, const char *line2)
+static void app_dashboard_init(void)
 {
-    /* 5x7 font, scaled by DISPLAY_TEXT_SCALE, centered as a two-line block. */
     const int display_w = display_get_width();
     const int display_h = display_get_height();
-    const int line_h = 7 * DISPLAY_TEXT_SCALE;
+    const int line_h = display_get_text_height(DISPLAY_TEXT_SCALE);
     const int block_h = (2 * line_h) + DISPLAY_TEXT_LINE_GAP;
     const int line1_y = (display_h - block_h) / 2;
     const int line2_y = line1_y + line_h + DISPLAY_TEXT_LINE_GAP;
-    const int x1 = (display_w - display_text_width_px(line1)) / 2;
-    const int x2 = (display_w - display_text_width_px(line2)) / 2;
+    /* One scale step of margin above and below each line. */
+    const display_rect_t temp_box = {0, line1_y - DISPLAY_TEXT_SCALE, display_w, line_h + (2 * DISPLAY_TEXT_SCALE)};
+    const display_rect_t rh_box = {0, line2_y - DISPLAY_TEXT_SCALE, display_w, line_h + (2 * DISPLAY_TEXT_SCALE)};
+    int area_bottom = rh_box.y + rh_box.h;
 
-    display_draw_rect(0, line1_y - DISPLAY_TEXT_SCALE, display_w, block_h + (2 * DISPLAY_TEXT_SCALE), 0x0000);
-    display_draw_text_minimal_scaled(x1 > 0 ? x1 : 0, line1_y, line1, DISPLAY_TEXT_COLOR, DISPLAY_TEXT_SCALE);
-    display_draw_text_minimal_scaled(x2 > 0 ? x2 : 0, line2_y, line2, DISPLAY_TEXT_COLOR, DISPLAY_TEXT_SCALE);
+    display_fb_t *fb = NULL;
+#if APP_ENABLE_DHT20
+    const display_rect_t spark_box = {
+        DISPLAY_SPARK_MARGIN_PX,
+        area_bottom + DISPLAY_TEXT_LINE_GAP,
+        display_w - (2 * DISPLAY_SPARK_MARGIN_PX),
+        DISPLAY_SPARK_HEIGHT_PX,
+    };
+    if ((spark_box.y + spark_box.h) <= display_h) {
+        area_bottom = spark_box.y + spark_box.h;
+    }
+#endif
+#if DISPLAY_TEXT_USE_FRAMEBUFFER
+    static display_fb_t dash_fb = {0};
+    if (display_fb_init(&dash_fb, 0, temp_box.y, display_w, area_bottom - temp_box.y) == ESP_OK) {
+        fb = &dash_fb;
+    }
+#endif
+    display_screen_init(&s_dash, fb);
+    display_widget_number_init(&s_dash_temp, &temp_box, DISPLAY_TEXT_COLOR, 0x0000, DISPLAY_TEXT_SCALE, true, "TEMP: %.1f C");
+    display_widget_number_init(&s_dash_rh, &rh_box, DISPLAY_TEXT_COLOR, 0x0000, DISPLAY_TEXT_SCALE, true, "RH: %.1f %%");
+    display_widget_set_text(&s_dash_temp, "TEMP: --.- C");
+    display_widget_set_text(&s_dash_rh, "RH: --.- %");
+    (void)display_screen_add(&s_dash, &s_dash_temp);
+    (void)display_screen_add(&s_dash, &s_dash_rh);
+#if APP_ENABLE_DHT20
+    if ((spark_box.y + spark_box.h) <= display_h) {
+        display_widget_sparkline_init(&s_dash_spark, &spark_box, DISPLAY_SPARK_COLOR, 0x0000, DISPLAY_SPARK_MIN_SPAN_C);
+        (void)display_screen_add(&s_dash, &s_dash_spark);
+    }
+#endif
 }
 
-#if APP_ENABLE_DHT20
-static void display_show_avg(float temp_c, float rh)
+static void app_dashboard_render(void *arg)
 {
-    static bool has_last = false;
-    static char last_line1[32];
-    static char last_line2[32];
-    char line1[32];
-    char line2[32];
+    (void)arg;
+    (void)display_screen_render(&s_dash, NULL);
+}
 
-    snprintf(line1, sizeof(line1), "TEMP: %.1f C", temp_c);
-    snprintf(line2, sizeof(line2), "RH: %.1f %%", rh);
+/* One pass on the render task when it runs, on the caller otherwise. */
+static void app_dashboard_refresh(void)
+{
+    if (!display_server_running() || display_server_post_call(app_dashboard_render, NULL) != ESP_OK) {
+        app_dashboard_render(NULL);
+    }
+}
 
-    if (has_last && strcmp(line1, last_line1) == 0 && strcmp(line2, last_line2) == 0) {
-        return;
+#if DISPLAY_SPI_CALIBRATE
+/* Operator verdict for one calibration step: a knob click inside the window means the pattern is clean. */
+static bool display_spi_cal_check(int spi_clock_hz, void *user_ctx)
+{
+    knob_t *knob = (knob_t *)user_ctx;
+    UART_PRINT_INFO("SPI clock %d Hz: click the knob within %u ms if the pattern looks clean", spi_clock_hz,
+                    (unsigned)DISPLAY_SPI_CAL_CONFIRM_MS);
+
+    const TickType_t start_tick = xTaskGetTickCount();
+    while ((xTaskGetTickCount() - start_tick) < pdMS_TO_TICKS(DISPLAY_SPI_CAL_CONFIRM_MS)) {
+        knob_event_t event = {0};
+        if (knob_poll(knob, &event) == ESP_OK && event.clicked) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(APP_LOOP_PERIOD_MS));
     }
+    return false;
+}
+#endif
+
+#if APP_ENABLE_SNTP
+static void display_sntp_bar_refresh(void *arg)
+{
+    (void)arg;
+    sntp_api_status_bar_update_if_due(SNTP_STATUS_REFRESH_MS);
+}
 
-    strncpy(last_line1, line1, sizeof(last_line1));
-    last_line1[sizeof(last_line1) - 1] = '\0';
-    strncpy(last_line2, line2, sizeof(last_line2));
-    last_line2[sizeof(last_line2) - 1] = '\0';
-    has_last = true;
+static void display_sntp_bar_draw(void *arg)
+{
+    (void)arg;
+    sntp_api_status_bar_draw();
+}
 
-    display_draw_two_lines_centered(line1, line2);
+/* Event-driven redraw hook (esp_timer task): hand the draw to the render task. */
+static void display_sntp_bar_post_redraw(void *user_ctx)
+{
+    (void)user_ctx;
+    if (display_server_post_call(display_sntp_bar_draw, NULL) != ESP_OK) {
+        sntp_api_status_bar_draw();
+    }
 }
 #endif
 
-typedef struct {
-    const char *name;
-    uint32_t elapsed_ms;
-    uint32_t ops;
-} display_bench_result_t;
-
-static display_bench_result_t display_bench_full_fill(const uint16_t *colors, size_t color_count)
-{
-    const uint32_t frames = 24U;
-    const int64_t t0 = esp_timer_get_time();
-    for (uint32_t i = 0; i < frames; i++) {
-        display_fill_color(colors[i % color_count]);
-    }
-    const int64_t dt_us = esp_timer_get_time() - t0;
-    return (display_bench_result_t){
-        .name = "FILL",
-        .elapsed_ms = (uint32_t)(dt_us / 1000LL),
-        .ops = frames,
+#if APP_ENABLE_DHT20
+static void display_show_avg(float temp_c, float rh)
+{
+    display_widget_set_value(&s_dash_temp, temp_c);
+    display_widget_set_value(&s_dash_rh, rh);
+    if (s_dash_spark.screen != NULL) {
+        const size_t n = dht20_history_read_latest(&s_dht20_history, s_dash_samples, (size_t)s_dash_spark.box.w);
+        for (size_t i = 0; i < n; i++) {
+            s_dash_series[i] = s_dash_samples[i].temperature_c;
+        }
+        display_widget_set_series(&s_dash_spark, s_dash_series, n);
+    }
+    app_dashboard_refresh();
+}
+#endif
+#endif
+
+#if APP_ENABLE_DHT20
+static esp_err_t app_i2c_bus_init(void)
+{
+    const i2c_bus_cfg_t i2c_cfg = {
+        .port = APP_I2C_PORT,
+        .sda_gpio = APP_I2C_SDA_GPIO,
+        .scl_gpio = APP_I2C_SCL_GPIO,
+        .internal_pullup = true,
     };
+    return i2c_bus_init(&s_i2c_bus, &i2c_cfg);
 }
+#endif
 
-static display_bench_result_t display_bench_rects(const uint16_t *colors, size_t color_count)
+static bool app_check_and_log(const char *step, const esp_err_t err)
 {
+    if (err == ESP_OK) {
+        return true;
+    }
+    UART_PRINT_ERR("%s failed: %s (0x%" PRIx32 ")", step, esp_err_to_name(err), (uint32_t)err);
+    return false;
+}
+
+/*
+ * Benchmark cases (bench_api). They run on the bench task (POST /api/bench)
+ * or, with APP_BENCH_AT_BOOT, on the main task right before the loop starts.
+ */
+#if APP_ENABLE_DISPLAY
+#define BENCH_TEXT "12:34"
+#define BENCH_DMA_ROWS 20
+
+static const uint16_t k_bench_colors[] = {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0xFFE0, 0xF81F};
+static const int k_bench_blit_rows[] = {1, 2, 5, 10, 20};
+static const uint8_t k_bench_text_scales[] = {1U, 2U, 3U, 4U};
+
+typedef struct {
+    display_image_t img;
+    uint16_t *dma_buf; /* BENCH_DMA_ROWS full-width rows + 1 pixel for the unaligned case */
+    uint32_t iter;
+    bool registered;
+} app_bench_display_t;
+
+static app_bench_display_t s_bench_disp;
+static bool s_bench_repaint; /* set by the runner, consumed by the main loop */
+
+static esp_err_t bench_display_fill(void *ctx)
+{
+    (void)ctx;
+    display_fill_color(k_bench_colors[s_bench_disp.iter++ % (sizeof(k_bench_colors) / sizeof(k_bench_colors[0]))]);
+    return ESP_OK;
+}
+
+static esp_err_t bench_display_rect(void *ctx)
+{
+    (void)ctx;
     const int w = display_get_width();
     const int h = display_get_height();
-    const int max_rw = (w > 20) ? (w / 2) : 10;
-    const int max_rh = (h > 20) ? (h / 2) : 10;
-    const uint32_t draws = 150U;
+    const uint32_t i = s_bench_disp.iter++;
+    const int rw = 8 + (int)((i * 11U) % (uint32_t)((w > 20) ? (w / 2) : 10));
+    const int rh = 8 + (int)((i * 7U) % (uint32_t)((h > 20) ? (h / 2) : 10));
+    const int x = (int)((i * 13U) % (uint32_t)((w - rw) > 0 ? (w - rw) : 1));
+    const int y = (int)((i * 9U) % (uint32_t)((h - rh) > 0 ? (h - rh) : 1));
+    display_draw_rect(x, y, rw, rh, k_bench_colors[i % (sizeof(k_bench_colors) / sizeof(k_bench_colors[0]))]);
+    return ESP_OK;
+}
 
-    display_fill_color(0x0000);
-    const int64_t t0 = esp_timer_get_time();
-    for (uint32_t i = 0; i < draws; i++) {
-        int rw = 8 + (int)((i * 11U) % (uint32_t)max_rw);
-        int rh = 8 + (int)((i * 7U) % (uint32_t)max_rh);
-        if (rw > w) {
-            rw = w;
-        }
-        if (rh > h) {
-            rh = h;
+static esp_err_t bench_gradient_band(uint16_t *band, int row, int rows, int width, void *user_ctx)
+{
+    (void)user_ctx;
+    for (int r = 0; r < rows; r++) {
+        const uint16_t base = (uint16_t)(((row + r) & 0x1F) << 11);
+        uint16_t *dst = &band[(size_t)r * (size_t)width];
+        for (int x = 0; x < width; x++) {
+            dst[x] = (uint16_t)(base | (uint16_t)((x & 0x3F) << 5));
         }
-        const int x = (int)((i * 13U) % (uint32_t)((w - rw) > 0 ? (w - rw) : 1));
-        const int y = (int)((i * 9U) % (uint32_t)((h - rh) > 0 ? (h - rh) : 1));
-        display_draw_rect(x, y, rw, rh, colors[i % color_count]);
-    }
-    const int64_t dt_us = esp_timer_get_time() - t0;
-    return (display_bench_result_t){
-        .name = "RECT",
-        .elapsed_ms = (uint32_t)(dt_us / 1000LL),
-        .ops = draws,
-    };
+    }
+    return ESP_OK;
 }
 
-static display_bench_result_t display_bench_text(void)
+static esp_err_t bench_display_blit(void *ctx)
 {
-    const int w = display_get_width();
-    const int h = display_get_height();
-    const uint32_t draws = 120U;
-    char line[24];
+    return display_image_draw_streaming(&s_bench_disp.img, *(const int *)ctx, bench_gradient_band, NULL);
+}
 
-    display_fill_color(0x0000);
-    const int64_t t0 = esp_timer_get_time();
-    for (uint32_t i = 0; i < draws; i++) {
-        const int y = (int)((i * 10U) % (uint32_t)((h > 10) ? (h - 10) : 1));
-        const int x = (int)((i * 17U) % (uint32_t)((w > 42) ? (w - 42) : 1));
-        const uint16_t color = (uint16_t)(0x001F + ((i * 97U) & 0xFFE0U));
-        snprintf(line, sizeof(line), "T%03" PRIu32, i);
-        display_draw_text_minimal(x, y, line, color);
-    }
-    const int64_t dt_us = esp_timer_get_time() - t0;
-    return (display_bench_result_t){
-        .name = "TEXT",
-        .elapsed_ms = (uint32_t)(dt_us / 1000LL),
-        .ops = draws,
-    };
+static esp_err_t bench_display_dma_setup(void *ctx)
+{
+    (void)ctx;
+    const size_t pixels = (size_t)display_get_width() * BENCH_DMA_ROWS;
+    s_bench_disp.dma_buf = heap_caps_malloc((pixels + 1U) * sizeof(uint16_t), MALLOC_CAP_DMA);
+    ESP_RETURN_ON_FALSE(s_bench_disp.dma_buf != NULL, ESP_ERR_NO_MEM, TAG, "bench DMA buffer alloc failed");
+    return bench_gradient_band(s_bench_disp.dma_buf, 0, BENCH_DMA_ROWS, display_get_width(), NULL);
 }
 
-static void display_bench_plot_results(const display_bench_result_t *results, size_t count)
+/* ctx = pixel offset into the buffer: 0 goes out zero-copy, 1 breaks 4-byte alignment so the SPI driver bounces it. */
+static esp_err_t bench_display_dma(void *ctx)
 {
-    const int w = display_get_width();
-    const int h = display_get_height();
-    const int chart_x = 64;
-    const int chart_y = 24;
-    const int row_h = 32;
-    const int bar_h = 18;
-    const int bar_max_w = (w - chart_x - 10 > 10) ? (w - chart_x - 10) : 10;
-    uint32_t max_ms = 1;
-    char line[32];
+    const size_t offset = (size_t)(uintptr_t)ctx;
+    ESP_RETURN_ON_ERROR(display_draw_bitmap(0, 0, display_get_width(), BENCH_DMA_ROWS, s_bench_disp.dma_buf + offset),
+                        TAG, "bench bitmap failed");
+    return display_wait_idle();
+}
 
-    for (size_t i = 0; i < count; i++) {
-        if (results[i].elapsed_ms > max_ms) {
-            max_ms = results[i].elapsed_ms;
+static esp_err_t bench_display_dma_teardown(void *ctx)
+{
+    (void)ctx;
+    heap_caps_free(s_bench_disp.dma_buf);
+    s_bench_disp.dma_buf = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t bench_display_text(void *ctx)
+{
+    const uint8_t scale = *(const uint8_t *)ctx;
+    display_draw_text_run(0, 64, BENCH_TEXT, DISPLAY_TEXT_COLOR, 0x0000, scale, 0U);
+    return ESP_OK;
+}
+
+/* SNTP starts after the display step registered the cases; skip until it is up. */
+static esp_err_t bench_status_bar_setup(void *ctx)
+{
+    (void)ctx;
+    sntp_api_sync_info_t info;
+    return sntp_api_get_sync_info(&info);
+}
+
+/* ctx != NULL: full repaint each call; NULL: the steady state, where the text did not change. */
+static esp_err_t bench_status_bar(void *ctx)
+{
+    if (ctx != NULL) {
+        sntp_api_status_bar_invalidate();
+    }
+    sntp_api_status_bar_draw();
+    return ESP_OK;
+}
+
+static const char *const k_bench_io_probes[] = {"color_trans", "color_bytes", "windows"};
+
+static void bench_io_probe(uint32_t *values, void *user_ctx)
+{
+    (void)user_ctx;
+    display_io_stats_t io;
+    display_get_io_stats(&io);
+    values[0] = io.color_trans;
+    values[1] = io.color_bytes;
+    values[2] = io.windows;
+}
+
+static bench_case_t s_bench_display_cases[] = {
+    {.name = "display.fill", .run = bench_display_fill, .warmup = 2, .reps = 10, .unit = "px"},
+    {.name = "display.rect", .run = bench_display_rect, .reps = 100},
+    {.name = "display.blit.rows_1", .run = bench_display_blit, .ctx = (void *)&k_bench_blit_rows[0], .reps = 10, .unit = "px"},
+    {.name = "display.blit.rows_2", .run = bench_display_blit, .ctx = (void *)&k_bench_blit_rows[1], .reps = 10, .unit = "px"},
+    {.name = "display.blit.rows_5", .run = bench_display_blit, .ctx = (void *)&k_bench_blit_rows[2], .reps = 10, .unit = "px"},
+    {.name = "display.blit.rows_10", .run = bench_display_blit, .ctx = (void *)&k_bench_blit_rows[3], .reps = 10, .unit = "px"},
+    {.name = "display.blit.rows_20", .run = bench_display_blit, .ctx = (void *)&k_bench_blit_rows[4], .reps = 10, .unit = "px"},
+    {.name = "display.dma.aligned", .setup = bench_display_dma_setup, .run = bench_display_dma,
+     .teardown = bench_display_dma_teardown, .ctx = (void *)0, .reps = 50, .unit = "px"},
+    {.name = "display.dma.unaligned", .setup = bench_display_dma_setup, .run = bench_display_dma,
+     .teardown = bench_display_dma_teardown, .ctx = (void *)1, .reps = 50, .unit = "px"},
+    {.name = "text.scale_1", .run = bench_display_text, .ctx = (void *)&k_bench_text_scales[0], .reps = 100, .unit = "px"},
+    {.name = "text.scale_2", .run = bench_display_text, .ctx = (void *)&k_bench_text_scales[1], .reps = 100, .unit = "px"},
+    {.name = "text.scale_3", .run = bench_display_text, .ctx = (void *)&k_bench_text_scales[2], .reps = 100, .unit = "px"},
+    {.name = "text.scale_4", .run = bench_display_text, .ctx = (void *)&k_bench_text_scales[3], .reps = 100, .unit = "px"},
+    {.name = "sntp.status_bar.redraw", .setup = bench_status_bar_setup, .run = bench_status_bar, .ctx = (void *)1,
+     .reps = 50},
+    {.name = "sntp.status_bar.unchanged", .setup = bench_status_bar_setup, .run = bench_status_bar, .reps = 50},
+};
+
+static void app_bench_register_display(void)
+{
+    const uint32_t w = (uint32_t)display_get_width();
+    const uint32_t frame_px = w * (uint32_t)display_get_height();
+
+    display_image_init(&s_bench_disp.img, display_get_panel_handle(), (uint16_t)w, (uint16_t)display_get_height());
+    for (size_t i = 0; i < sizeof(s_bench_display_cases) / sizeof(s_bench_display_cases[0]); i++) {
+        bench_case_t *c = &s_bench_display_cases[i];
+        if (c->run == bench_display_fill || c->run == bench_display_blit) {
+            c->work = frame_px;
+        } else if (c->run == bench_display_dma) {
+            c->work = w * BENCH_DMA_ROWS;
+        } else if (c->run == bench_display_text) {
+            const uint8_t scale = *(const uint8_t *)c->ctx;
+            c->work = (uint32_t)display_get_text_width(BENCH_TEXT, scale, 0U) * 7U * scale;
         }
+        (void)bench_register(c);
     }
+    (void)bench_set_tag("spi_clock_hz", display_get_spi_clock());
+    (void)bench_set_tag("display_rotation", DISPLAY_ROTATION);
+    (void)bench_set_probe(k_bench_io_probes, sizeof(k_bench_io_probes) / sizeof(k_bench_io_probes[0]), bench_io_probe,
+                          NULL);
+    s_bench_disp.registered = true;
+}
 
+/* Main loop, after a run: the cases drew over the whole panel. */
+static void display_repaint_after_bench(void)
+{
     display_fill_color(0x0000);
-    display_draw_text_minimal(6, 6, "DISPLAY BENCH", 0xFFFF);
-    for (size_t i = 0; i < count; i++) {
-        const int y = chart_y + ((int)i * row_h);
-        int bar_w = (int)(((uint64_t)results[i].elapsed_ms * (uint64_t)bar_max_w) / (uint64_t)max_ms);
-        if (bar_w < 1) {
-            bar_w = 1;
-        }
-        if (bar_w > bar_max_w) {
-            bar_w = bar_max_w;
-        }
+    display_screen_invalidate(&s_dash);
+    app_dashboard_refresh();
+#if APP_ENABLE_SNTP
+    sntp_api_status_bar_invalidate();
+    if (!display_server_running() || display_server_post_call(display_sntp_bar_draw, NULL) != ESP_OK) {
+        sntp_api_status_bar_draw();
+    }
+#endif
+}
+#endif
+
+#if APP_ENABLE_DHT20 && DHT20_USE_ASYNC
+typedef struct {
+    dht20_t *dev;
+    dht20_async_t *async;
+} app_bench_dht20_t;
+
+static app_bench_dht20_t s_bench_dht20;
+
+/* Take the bus from the async sampler for the duration of the case. */
+static esp_err_t bench_dht20_setup(void *ctx)
+{
+    app_bench_dht20_t *b = (app_bench_dht20_t *)ctx;
+    dht20_async_stop(b->async);
+    vTaskDelay(pdMS_TO_TICKS(DHT20_READY_TIMEOUT_MS)); /* let an in-flight conversion finish */
+    return ESP_OK;
+}
+
+static esp_err_t bench_dht20_oneshot(void *ctx)
+{
+    app_bench_dht20_t *b = (app_bench_dht20_t *)ctx;
+    dht20_sample_t sample = {0};
+    return dht20_read_oneshot(b->dev, &sample, DHT20_READY_TIMEOUT_MS, DHT20_POLL_INTERVAL_MS);
+}
+
+static esp_err_t bench_dht20_teardown(void *ctx)
+{
+    app_bench_dht20_t *b = (app_bench_dht20_t *)ctx;
+    return dht20_async_start(b->async, b->dev, DHT20_SAMPLE_PERIOD_MS, dht20_on_sample, NULL);
+}
+
+static const bench_case_t s_bench_dht20_case = {
+    .name = "dht20.oneshot",
+    .setup = bench_dht20_setup,
+    .run = bench_dht20_oneshot,
+    .teardown = bench_dht20_teardown,
+    .ctx = &s_bench_dht20,
+    .warmup = 1,
+    .reps = 10,
+};
+#endif
+
+#if APP_ENABLE_KNOB
+/* Polls a copy so the main loop's knob keeps every event. */
+static esp_err_t bench_knob_poll(void *ctx)
+{
+    knob_t scratch = *(const knob_t *)ctx;
+    knob_event_t event;
+    return knob_poll(&scratch, &event);
+}
 
-        display_draw_text_minimal(6, y + 4, results[i].name, 0xFFFF);
-        display_draw_rect(chart_x, y, bar_max_w, bar_h, 0x2104);
-        display_draw_rect(chart_x, y, bar_w, bar_h, (i == 0) ? 0x07E0 : ((i == 1) ? 0xFFE0 : 0xF81F));
-        snprintf(line, sizeof(line), "%" PRIu32 "ms", results[i].elapsed_ms);
-        display_draw_text_minimal(chart_x + 4, y + 4, line, 0x0000);
+static bench_case_t s_bench_knob_case = {
+    .name = "knob.poll",
+    .run = bench_knob_poll,
+    .reps = 100,
+    .batch = 100,
+};
+#endif
+
+#if APP_POWER_SAVE
+/* Shrink *wait_ticks so the loop is awake again `period` after `since` (tick time). */
+static void app_wait_limit_ticks(TickType_t *wait_ticks, TickType_t since, TickType_t period)
+{
+    const TickType_t elapsed = xTaskGetTickCount() - since;
+    const TickType_t remaining = (elapsed >= period) ? 0 : (period - elapsed);
+    if (remaining < *wait_ticks) {
+        *wait_ticks = remaining;
     }
+}
 
-    if (h >= 158) {
-        display_draw_text_minimal(6, h - 12, "Lower ms is better", 0xFFFF);
+/* Same for an esp_timer deadline; rounds up so the deadline has passed on wake. */
+static void app_wait_limit_us(TickType_t *wait_ticks, int64_t deadline_us)
+{
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000LL;
+    const int64_t remaining_us = deadline_us - esp_timer_get_time();
+    const TickType_t remaining = (remaining_us <= 0) ? 0 : (TickType_t)((remaining_us + tick_us - 1) / tick_us);
+    if (remaining < *wait_ticks) {
+        *wait_ticks = remaining;
     }
 }
+#endif
+
+#if APP_ENABLE_SNTP
+static bool s_sntp_synced; /* set on the tcpip task, consumed by the main loop */
 
-static void display_run_benchmark(void)
+/* lwIP tcpip task: only flag the sync, the main loop logs it and redraws. */
+static void app_sntp_synced(const sntp_api_sync_info_t *info, void *user_ctx)
 {
-    static const uint16_t k_colors[] = {
-        0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0xFFE0, 0xF81F
-    };
-    display_bench_result_t results[3];
+    (void)info;
+    (void)user_ctx;
+    __atomic_store_n(&s_sntp_synced, true, __ATOMIC_RELEASE);
+    if (s_app_task != NULL) {
+        (void)xTaskNotifyGive(s_app_task);
+    }
+#if APP_ENABLE_WIFI_HTTP
+    wifi_http_api_events_publish_sntp();
+#endif
+}
 
-    results[0] = display_bench_full_fill(k_colors, sizeof(k_colors) / sizeof(k_colors[0]));
-    results[1] = display_bench_rects(k_colors, sizeof(k_colors) / sizeof(k_colors[0]));
-    results[2] = display_bench_text();
-    display_bench_plot_results(results, sizeof(results) / sizeof(results[0]));
+static void app_sntp_log_sync(void)
+{
+    sntp_api_sync_info_t info = {0};
+    if (sntp_api_get_sync_info(&info) != ESP_OK) {
+        return;
+    }
+    if (info.drift_valid) {
+        UART_PRINT_INFO("SNTP sync #%" PRIu32 ": offset %" PRId64 " ms, drift %.2f ppm, next in %" PRIu32 " s",
+                        info.sync_count, info.last_offset_us / 1000, (double)info.drift_ppm,
+                        info.sync_interval_ms / 1000U);
+    } else {
+        UART_PRINT_INFO("SNTP sync #%" PRIu32 ": offset %" PRId64 " ms, next in %" PRIu32 " s", info.sync_count,
+                        info.last_offset_us / 1000, info.sync_interval_ms / 1000U);
+    }
+}
+#endif
 
-    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
-        uint32_t ops_per_s = 0;
-        if (results[i].elapsed_ms > 0U) {
-            ops_per_s = (results[i].ops * 1000U) / results[i].elapsed_ms;
-        }
-        UART_PRINT_INFO("display bench %-4s -> %" PRIu32 " ms | ops=%" PRIu32 " | ~%" PRIu32 " ops/s",
-                        results[i].name, results[i].elapsed_ms, results[i].ops, ops_per_s);
+static void app_bench_done(void *user_ctx)
+{
+    (void)user_ctx;
+#if APP_ENABLE_DISPLAY
+    if (s_bench_disp.registered) {
+        __atomic_store_n(&s_bench_repaint, true, __ATOMIC_RELEASE);
+        (void)xTaskNotifyGive(s_app_task);
+    }
+#endif
+}
+
+#if APP_BENCH_AT_BOOT
+static esp_err_t app_bench_print(const char *text, size_t len, void *user_ctx)
+{
+    (void)user_ctx;
+    return (fwrite(text, 1, len, stdout) == len) ? ESP_OK : ESP_FAIL;
+}
+#endif
+
+/* NVS before any boot step: Wi-Fi credentials and the display clock both live there. */
+static esp_err_t app_nvs_init(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_RETURN_ON_ERROR(nvs_flash_erase(), TAG, "nvs_flash_erase failed");
+        err = nvs_flash_init();
+    }
+    return err;
+}
+
+/* Written by the boot steps, read by app_main once every step has joined. */
+typedef struct {
+#if APP_ENABLE_KNOB
+    knob_t *knob;
+    bool knob_ready;
+#endif
+#if APP_ENABLE_DHT20
+    dht20_t *dht20;
+#if DHT20_USE_ASYNC
+    dht20_async_t *dht20_async;
+#endif
+    bool dht20_ready;
+#endif
+#if APP_ENABLE_DISPLAY
+    bool display_ready;
+#endif
+} app_boot_t;
+
+typedef struct {
+    const char *name;
+    void (*fn)(app_boot_t *boot);
+    perf_metric_t *metric;
+} app_boot_step_t;
+
+static perf_metric_t s_perf_boot_first_frame =
+    PERF_HISTOGRAM_INIT("app_boot_first_frame_us", "esp_timer start to the first sensor screen", NULL);
+static perf_metric_t s_perf_boot_ready = PERF_HISTOGRAM_INIT("app_boot_ready_us", "esp_timer start to the main loop", NULL);
+
+#if APP_ENABLE_WIFI_HTTP
+static perf_metric_t s_perf_boot_wifi = PERF_HISTOGRAM_INIT("app_boot_step_us", "Boot step duration", "step=\"wifi\"");
+
+static void app_boot_wifi(app_boot_t *boot)
+{
+    (void)boot;
+    const wifi_http_api_cfg_t wifi_http_cfg = {
+        .ap_ssid = WIFI_HTTP_AP_SSID,
+        .ap_password = WIFI_HTTP_AP_PASS,
+        .ap_channel = WIFI_HTTP_AP_CHANNEL,
+        .ap_max_connection = 4,
+        .start_mode = WIFI_MODE_APSTA,
+        .sta_modem_sleep = APP_POWER_SAVE,
+    };
+    if (!app_check_and_log("wifi_http_api_init", wifi_http_api_init(&wifi_http_cfg))) {
+        UART_PRINT_WARN("Wi-Fi HTTP API disabled due to initialization error");
     }
 }
 #endif
 
 #if APP_ENABLE_DHT20
-static esp_err_t i2c_bus_init(void)
-{
-    const i2c_config_t i2c_cfg = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = DHT20_I2C_SDA_GPIO,
-        .scl_io_num = DHT20_I2C_SCL_GPIO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = DHT20_I2C_FREQ_HZ,
-        .clk_flags = 0,
+static perf_metric_t s_perf_boot_dht20 = PERF_HISTOGRAM_INIT("app_boot_step_us", "Boot step duration", "step=\"dht20\"");
+
+/* Mostly the sensor's power-on and reset delays, which now overlap the other steps. */
+static void app_boot_dht20(app_boot_t *boot)
+{
+    (void)dht20_history_init(&s_dht20_history, NULL);
+#if DHT20_LOG_TO_FLASH
+    s_dht20_flashlog_ready = app_check_and_log("dht20_flashlog_init", dht20_flashlog_init(&s_dht20_flashlog, NULL));
+#endif
+#if DHT20_USE_ASYNC
+    if (app_check_and_log("i2c_bus_init", app_i2c_bus_init())
+        && app_check_and_log("dht20_init", dht20_init(boot->dht20, &s_i2c_bus, DHT20_I2C_ADDR_DEFAULT, DHT20_I2C_FREQ_HZ,
+                                                      DHT20_I2C_TIMEOUT_MS))
+        && app_check_and_log("dht20_async_start",
+                             dht20_async_start(boot->dht20_async, boot->dht20, DHT20_SAMPLE_PERIOD_MS, dht20_on_sample, NULL))) {
+#else
+    if (app_check_and_log("i2c_bus_init", app_i2c_bus_init())
+        && app_check_and_log("dht20_init", dht20_init(boot->dht20, &s_i2c_bus, DHT20_I2C_ADDR_DEFAULT, DHT20_I2C_FREQ_HZ,
+                                                      DHT20_I2C_TIMEOUT_MS))
+        && app_check_and_log("dht20_start_measurement", dht20_start_measurement(boot->dht20))) {
+#endif
+        boot->dht20_ready = true;
+#if DHT20_USE_ASYNC
+        s_bench_dht20 = (app_bench_dht20_t){.dev = boot->dht20, .async = boot->dht20_async};
+        (void)bench_register(&s_bench_dht20_case);
+#endif
+    } else {
+        UART_PRINT_WARN("DHT20 acquisition disabled; remaining peripherals will keep running");
+    }
+}
+#endif
+
+#if APP_ENABLE_DISPLAY
+static perf_metric_t s_perf_boot_display = PERF_HISTOGRAM_INIT("app_boot_step_us", "Boot step duration", "step=\"display\"");
+
+/* Panel reset and sleep-out delays overlap Wi-Fi bring-up; ends once the sensor screen is up. */
+static void app_boot_display(app_boot_t *boot)
+{
+    const display_pins_t display_pins = {
+        .sck = TFT_PIN_SCK,
+        .mosi = TFT_PIN_MOSI,
+        .cs = TFT_PIN_CS,
+        .dc = TFT_PIN_DC,
+        .reset = TFT_PIN_RST,
+        .backlight = TFT_PIN_BLK,
+    };
+
+    const display_cfg_t display_cfg = {
+        .width = TFT_WIDTH,
+        .height = TFT_HEIGHT,
+        .x_offset = DISPLAY_X_OFFSET,
+        .y_offset = DISPLAY_Y_OFFSET,
+        .spi_clock_hz = DISPLAY_SPI_CLOCK_HZ,
+        .spi_clock_from_nvs = DISPLAY_SPI_CLOCK_FROM_NVS,
+        .backlight_in_light_sleep = APP_POWER_SAVE,
     };
 
-    ESP_RETURN_ON_ERROR(i2c_param_config(DHT20_I2C_PORT, &i2c_cfg), TAG, "i2c_param_config failed");
-    return i2c_driver_install(DHT20_I2C_PORT, i2c_cfg.mode, 0, 0, 0);
+    if (!app_check_and_log("display_init", display_init(&display_pins, &display_cfg))) {
+        UART_PRINT_WARN("Display disabled due to initialization error");
+        return;
+    }
+    boot->display_ready = true;
+    display_set_rotation(DISPLAY_ROTATION);
+    display_backlight_set(90);
+#if DISPLAY_SPI_CALIBRATE
+    if (boot->knob_ready) {
+        const display_clock_cal_cfg_t cal_cfg = {
+            .max_hz = DISPLAY_SPI_CAL_MAX_HZ,
+            .margin_steps = DISPLAY_SPI_CAL_MARGIN_STEPS,
+            .check = display_spi_cal_check,
+            .user_ctx = boot->knob,
+            .persist = true,
+        };
+        (void)app_check_and_log("display_calibrate_spi_clock", display_calibrate_spi_clock(&cal_cfg, NULL));
+    }
+#endif
+#if DISPLAY_BOOT_SELF_TEST
+    display_self_test();
+    display_image_t img = {0};
+    display_image_init(&img, display_get_panel_handle(), (uint16_t)display_get_width(), (uint16_t)display_get_height());
+    (void)app_check_and_log("display_image_draw_test_pattern_streaming", display_image_draw_test_pattern_streaming(&img, 20));
+#endif
+    display_fill_color(0x0000);
+    /* Readings arrive with the first window; the placeholder is already the working screen. */
+    app_dashboard_init();
+    app_dashboard_render(NULL);
+    perf_observe_since(&s_perf_boot_first_frame, 0);
+    UART_PRINT_INFO("boot: first frame at %" PRId64 " ms", esp_timer_get_time() / 1000);
+    app_bench_register_display();
+#if DISPLAY_USE_RENDER_TASK
+    const display_server_cfg_t server_cfg = {
+        .frame_period_ms = DISPLAY_RENDER_FRAME_MS,
+    };
+    (void)app_check_and_log("display_server_start", display_server_start(&server_cfg));
+#endif
 }
 #endif
 
-static bool app_check_and_log(const char *step, const esp_err_t err)
+static void app_boot_run_step(const app_boot_step_t *step, app_boot_t *boot)
 {
-    if (err == ESP_OK) {
-        return true;
+    const int64_t start_us = esp_timer_get_time();
+    step->fn(boot);
+    perf_observe_since(step->metric, start_us);
+    UART_PRINT_INFO("boot: %s took %" PRId64 " ms", step->name, (esp_timer_get_time() - start_us) / 1000);
+}
+
+#if APP_BOOT_PARALLEL
+typedef struct {
+    const app_boot_step_t *step;
+    app_boot_t *boot;
+    EventGroupHandle_t done;
+    EventBits_t bit;
+} app_boot_job_t;
+
+static void app_boot_task(void *arg)
+{
+    const app_boot_job_t *job = (const app_boot_job_t *)arg;
+    app_boot_run_step(job->step, job->boot);
+    (void)xEventGroupSetBits(job->done, job->bit);
+    vTaskDelete(NULL);
+}
+#endif
+
+/*
+ * Steps must not depend on each other: each owns its peripheral, NVS is up
+ * before they start, and anything needing two of them runs after the join.
+ * A step whose task cannot be created runs inline instead.
+ */
+static void app_boot_run(const app_boot_step_t *steps, size_t count, app_boot_t *boot)
+{
+#if APP_BOOT_PARALLEL
+    app_boot_job_t jobs[3];
+    EventGroupHandle_t done = (count <= (sizeof(jobs) / sizeof(jobs[0]))) ? xEventGroupCreate() : NULL;
+    if (done != NULL) {
+        EventBits_t wait_bits = 0;
+        for (size_t i = 0; i < count; i++) {
+            jobs[i] = (app_boot_job_t){.step = &steps[i], .boot = boot, .done = done, .bit = (EventBits_t)1U << i};
+            if (xTaskCreate(app_boot_task, steps[i].name, APP_BOOT_STEP_STACK, &jobs[i], uxTaskPriorityGet(NULL), NULL)
+                == pdPASS) {
+                wait_bits |= jobs[i].bit;
+            } else {
+                app_boot_run_step(&steps[i], boot);
+            }
+        }
+        if (wait_bits != 0) {
+            (void)xEventGroupWaitBits(done, wait_bits, pdFALSE, pdTRUE, portMAX_DELAY);
+        }
+        vEventGroupDelete(done);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++) {
+        app_boot_run_step(&steps[i], boot);
     }
-    UART_PRINT_ERR("%s failed: %s (0x%" PRIx32 ")", step, esp_err_to_name(err), (uint32_t)err);
-    return false;
 }
 
 void app_main(void)
@@ -446,52 +1085,51 @@ void app_main(void)
 
 #if APP_ENABLE_DHT20
     dht20_t dht20 = {0};
-    dht20_sample_t sample = {0};
     bool dht20_ready = false;
+#if DHT20_USE_ASYNC
+    static dht20_async_t dht20_async = {0};
+#else
+    dht20_sample_t sample = {0};
+#endif
     int64_t window_start_us = esp_timer_get_time();
-    float temperature_sum = 0.0f;
-    float humidity_sum = 0.0f;
-    uint32_t valid_samples = 0;
-    uint32_t error_samples = 0;
+    uint32_t last_error_total = 0;
+#if DHT20_LOG_TO_FLASH
+    int64_t log_start_us = window_start_us;
+#endif
 #endif
     TickType_t last_idle_log_tick = xTaskGetTickCount();
+#if APP_POWER_SAVE
+#if APP_ENABLE_KNOB
+    TickType_t knob_active_tick = xTaskGetTickCount();
+#endif
+#else
     TickType_t loop_wake_tick = xTaskGetTickCount();
+    int64_t loop_wake_us = esp_timer_get_time();
+#endif
+#if APP_ENABLE_DISPLAY && APP_ENABLE_SNTP
+    TickType_t last_bar_post_tick = 0;
+    bool sntp_bar_event_driven = false;
+#endif
+
+    s_app_task = xTaskGetCurrentTaskHandle();
+    bench_set_done_cb(app_bench_done, NULL);
+#if APP_POWER_SAVE
+    const esp_pm_config_t pm_cfg = {
+        .max_freq_mhz = APP_PM_MAX_FREQ_MHZ,
+        .min_freq_mhz = APP_PM_MIN_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+    (void)app_check_and_log("esp_pm_configure", esp_pm_configure(&pm_cfg));
+#endif
 
 #if APP_ENABLE_KNOB
 
 #if APP_ENABLE_RGB_LED
-    rmt_tx_channel_config_t tx_chan_cfg = {
-        .gpio_num = RGB_LED_PIN,
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .resolution_hz = RGB_RMT_RESOLUTION_HZ,
-        .mem_block_symbols = 64,
-        .trans_queue_depth = 4,
-        .flags = {
-            .invert_out = false,
-            .with_dma = false,
-        },
-    };
-    rmt_bytes_encoder_config_t bytes_enc_cfg = {
-        .bit0 = {
-            .level0 = 1,
-            .duration0 = 4, /* 0.4 us @ 10 MHz */
-            .level1 = 0,
-            .duration1 = 8, /* 0.8 us @ 10 MHz */
-        },
-        .bit1 = {
-            .level0 = 1,
-            .duration0 = 8, /* 0.8 us @ 10 MHz */
-            .level1 = 0,
-            .duration1 = 4, /* 0.4 us @ 10 MHz */
-        },
-        .flags = {
-            .msb_first = 1,
-        },
+    const rgb_led_cfg_t rgb_led_cfg = {
+        .gpio = RGB_LED_PIN,
     };
 
-    if (app_check_and_log("rmt_new_tx_channel", rmt_new_tx_channel(&tx_chan_cfg, &rgb_ctrl.channel))
-        && app_check_and_log("rmt_new_bytes_encoder", rmt_new_bytes_encoder(&bytes_enc_cfg, &rgb_ctrl.encoder))
-        && app_check_and_log("rmt_enable", rmt_enable(rgb_ctrl.channel))) {
+    if (app_check_and_log("rgb_led_init", rgb_led_init(&rgb_led_cfg))) {
         rgb_ctrl.rgb[0] = 0;  /* RED */
         rgb_ctrl.rgb[1] = 0;  /* GREEN */
         rgb_ctrl.rgb[2] = 0;  /* BLUE */
@@ -514,8 +1152,16 @@ void app_main(void)
         .enable_pullup = true,
         .button_active_low = true,
         .button_debounce_ms = 30U,
+        .backend = KNOB_BACKEND,
     };
     knob_ready = app_check_and_log("knob_init", knob_init(&knob, &knob_pins, &knob_cfg));
+    if (knob_ready) {
+        s_bench_knob_case.ctx = &knob;
+        (void)bench_register(&s_bench_knob_case);
+#if APP_POWER_SAVE
+        (void)app_check_and_log("knob_enable_wake", knob_enable_wake(&knob, s_app_task));
+#endif
+    }
 #if APP_ENABLE_RGB_LED
     if (knob_ready && rgb_ready) {
         (void)app_check_and_log("knob_set_position", knob_set_position(&knob, rgb_ctrl.rgb[rgb_ctrl.selected_channel]));
@@ -523,76 +1169,51 @@ void app_main(void)
 #endif
 #endif
 
+    (void)app_check_and_log("nvs_flash_init", app_nvs_init());
+
+    app_boot_t boot = {0};
+#if APP_ENABLE_KNOB
+    boot.knob = &knob;
+    boot.knob_ready = knob_ready;
+#endif
+#if APP_ENABLE_DHT20
+    boot.dht20 = &dht20;
+#if DHT20_USE_ASYNC
+    boot.dht20_async = &dht20_async;
+#endif
+#endif
+    /* Display first: with APP_BOOT_PARALLEL=0 it still reaches the first frame soonest. */
+    const app_boot_step_t boot_steps[] = {
+#if APP_ENABLE_DISPLAY
+        {.name = "boot_display", .fn = app_boot_display, .metric = &s_perf_boot_display},
+#endif
+#if APP_ENABLE_DHT20
+        {.name = "boot_dht20", .fn = app_boot_dht20, .metric = &s_perf_boot_dht20},
+#endif
 #if APP_ENABLE_WIFI_HTTP
-    const wifi_http_api_cfg_t wifi_http_cfg = {
-        .ap_ssid = WIFI_HTTP_AP_SSID,
-        .ap_password = WIFI_HTTP_AP_PASS,
-        .ap_channel = WIFI_HTTP_AP_CHANNEL,
-        .ap_max_connection = 4,
-        .start_mode = WIFI_MODE_APSTA,
-    };
-    if (!app_check_and_log("wifi_http_api_init", wifi_http_api_init(&wifi_http_cfg))) {
-        UART_PRINT_WARN("Wi-Fi HTTP API disabled due to initialization error");
-    }
+        {.name = "boot_wifi", .fn = app_boot_wifi, .metric = &s_perf_boot_wifi},
 #endif
+    };
+    app_boot_run(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0]), &boot);
 
 #if APP_ENABLE_DHT20
-    if (app_check_and_log("i2c_bus_init", i2c_bus_init())
-        && app_check_and_log("dht20_init", dht20_init(&dht20, DHT20_I2C_PORT, DHT20_I2C_ADDR_DEFAULT, DHT20_I2C_TIMEOUT_MS))
-        && app_check_and_log("dht20_start_measurement", dht20_start_measurement(&dht20))) {
-        dht20_ready = true;
-    } else {
-        UART_PRINT_WARN("DHT20 acquisition disabled; remaining peripherals will keep running");
+    dht20_ready = boot.dht20_ready;
+#if DHT20_LOG_TO_FLASH && APP_ENABLE_WIFI_HTTP
+    if (s_dht20_flashlog_ready) {
+        wifi_http_api_set_history_source(dht20_history_source, NULL);
     }
+#endif
 #else
     UART_PRINT_WARN("DHT20 disabled by APP_ENABLE_DHT20=0");
 #endif
 
 #if APP_ENABLE_DISPLAY
-    const display_pins_t display_pins = {
-        .sck = TFT_PIN_SCK,
-        .mosi = TFT_PIN_MOSI,
-        .cs = TFT_PIN_CS,
-        .dc = TFT_PIN_DC,
-        .reset = TFT_PIN_RST,
-        .backlight = TFT_PIN_BLK,
-    };
-
-    const display_cfg_t display_cfg = {
-        .width = TFT_WIDTH,
-        .height = TFT_HEIGHT,
-        .x_offset = DISPLAY_X_OFFSET,
-        .y_offset = DISPLAY_Y_OFFSET,
-        .spi_clock_hz = DISPLAY_SPI_CLOCK_HZ,
-    };
-
-    if (app_check_and_log("display_init", display_init(&display_pins, &display_cfg))) {
-#if APP_ENABLE_DHT20
-        display_ready = true;
-#endif
-        display_set_rotation(DISPLAY_ROTATION);
-        display_backlight_set(90);
-        display_self_test();
-        display_image_t img = {0};
-        display_image_init(&img, display_get_panel_handle(), (uint16_t)display_get_width(), (uint16_t)display_get_height());
-        (void)app_check_and_log("display_image_draw_test_pattern_streaming", display_image_draw_test_pattern_streaming(&img, 20));
-#if APP_RUN_DISPLAY_BENCHMARK
-        display_run_benchmark();
-#else
-        display_fill_color(0x0000);
-#endif
 #if APP_ENABLE_DHT20
-        if (dht20_ready) {
-            display_show_avg(0.0f, 0.0f);
-        } else if (!APP_RUN_DISPLAY_BENCHMARK) {
-            display_draw_two_lines_centered("TEMP: --.- C", "RH: --.- %");
-        }
-#else
-        if (!APP_RUN_DISPLAY_BENCHMARK) {
-            display_draw_two_lines_centered("TEMP: --.- C", "RH: --.- %");
-        }
+    display_ready = boot.display_ready;
 #endif
 #if APP_ENABLE_SNTP
+    /* After the join: SNTP needs the network stack the Wi-Fi step brought up. */
+    if (boot.display_ready) {
         const sntp_api_cfg_t sntp_cfg = {
             .server_name = SNTP_SERVER_NAME,
             .gmt_offset_hours = SNTP_GMT_OFFSET_HOURS,
@@ -605,67 +1226,101 @@ void app_main(void)
             .line_gap_px = SNTP_LINE_GAP_PX,
             .date_char_spacing_px = SNTP_DATE_CHAR_SPACING_PX,
             .time_char_spacing_px = SNTP_TIME_CHAR_SPACING_PX,
+            .use_framebuffer = SNTP_BAR_USE_FRAMEBUFFER,
+            .smooth_sync = SNTP_SMOOTH_SYNC,
+            .max_sync_interval_ms = SNTP_MAX_SYNC_INTERVAL_MS,
+            .max_error_ms = SNTP_MAX_ERROR_MS,
         };
+        sntp_api_set_sync_cb(app_sntp_synced, NULL);
         if (app_check_and_log("sntp_api_init", sntp_api_init(&sntp_cfg))) {
-            sntp_api_status_bar_draw();
+#if SNTP_BAR_EVENT_DRIVEN
+            sntp_bar_event_driven = app_check_and_log(
+                "sntp_api_status_bar_start_auto",
+                sntp_api_status_bar_start_auto(display_server_running() ? display_sntp_bar_post_redraw : NULL, NULL));
+#endif
+            if (!sntp_bar_event_driven) {
+                sntp_api_status_bar_draw();
+            }
         } else {
             UART_PRINT_WARN("SNTP status bar disabled due to initialization error");
         }
-#endif
-    } else {
-        UART_PRINT_WARN("Display disabled due to initialization error");
     }
+#endif
 #else
     UART_PRINT_WARN("Display disabled by APP_ENABLE_DISPLAY=0");
 #endif
 
+#if APP_BENCH_AT_BOOT
+    const bench_run_cfg_t bench_cfg = {
+        .filter = APP_BENCH_FILTER,
+    };
+    if (app_check_and_log("bench_run", bench_run(&bench_cfg))) {
+        (void)bench_render_json(app_bench_print, NULL);
+        printf("\n");
+    }
+#endif
+    perf_observe_since(&s_perf_boot_ready, 0);
+    UART_PRINT_INFO("boot: ready at %" PRId64 " ms", esp_timer_get_time() / 1000);
+
     while (true) {
+#if APP_ENABLE_DISPLAY
+        if (__atomic_exchange_n(&s_bench_repaint, false, __ATOMIC_ACQ_REL)) {
+            display_repaint_after_bench();
+        }
+#endif
+#if APP_ENABLE_SNTP
+        if (__atomic_exchange_n(&s_sntp_synced, false, __ATOMIC_ACQ_REL)) {
+            app_sntp_log_sync();
+        }
+#endif
 #if APP_ENABLE_DHT20
         if (dht20_ready) {
+#if !DHT20_USE_ASYNC
         esp_err_t err = dht20_read_measurement_wait(&dht20, &sample, DHT20_READY_TIMEOUT_MS, DHT20_POLL_INTERVAL_MS);
-
-        if (err == ESP_OK) {
-                if (app_check_and_log("dht20_sample_apply_offset",
-                                      dht20_sample_apply_offset(&sample, DHT20_TEMP_OFFSET_C, DHT20_HUM_OFFSET_RH))) {
-                    temperature_sum += sample.temperature_c;
-                    humidity_sum += sample.humidity_rh;
-                    valid_samples++;
-                } else {
-                    error_samples++;
-                }
-        } else {
-            error_samples++;
-        }
+        dht20_record(&sample, err);
 
         err = dht20_start_measurement(&dht20);
         if (err != ESP_OK) {
             UART_PRINT_ERR("start measurement failed: %s", esp_err_to_name(err));
                 dht20_ready = false;
         }
+#endif
 
         const int64_t now_us = esp_timer_get_time();
         if ((now_us - window_start_us) >= ((int64_t)DHT20_PRINT_PERIOD_MS * 1000LL)) {
-            if (valid_samples > 0) {
-                const float avg_temp_c = temperature_sum / (float)valid_samples;
-                const float avg_humidity_rh = humidity_sum / (float)valid_samples;
-
-                UART_PRINT_INFO("2s avg -> T=%.2f C | RH=%.2f %% | valid=%" PRIu32 " | errors=%" PRIu32,
-                                avg_temp_c, avg_humidity_rh, valid_samples, error_samples);
+            dht20_window_stats_t stats = {0};
+            const uint32_t error_total = dht20_history_get_errors(&s_dht20_history);
+            const uint32_t errors = error_total - last_error_total;
+            last_error_total = error_total;
+
+            if (dht20_history_get_stats(&s_dht20_history, DHT20_STATS_WINDOW, &stats) == ESP_OK
+                && stats.temperature_c.count > 0U) {
+                UART_PRINT_INFO("%" PRIu32 "s avg -> T=%.2f C (sd %.2f) | RH=%.2f %% (sd %.2f) | n=%" PRIu32 " | errors=%" PRIu32,
+                                stats.span_ms / 1000U, stats.temperature_c.mean, stats.temperature_c.stddev,
+                                stats.humidity_rh.mean, stats.humidity_rh.stddev, stats.temperature_c.count, errors);
 #if APP_ENABLE_DISPLAY
                     if (display_ready) {
-                        display_show_avg(avg_temp_c, avg_humidity_rh);
+                        display_show_avg(stats.temperature_c.mean, stats.humidity_rh.mean);
                     }
+#endif
+#if APP_ENABLE_WIFI_HTTP
+                    char event_json[40];
+                    snprintf(event_json, sizeof(event_json), "{\"t\":%.2f,\"rh\":%.2f}",
+                             (double)stats.temperature_c.mean, (double)stats.humidity_rh.mean);
+                    (void)wifi_http_api_events_publish("sensor", event_json);
 #endif
             } else {
-                UART_PRINT_WARN("2s avg -> no valid sample | errors=%" PRIu32, error_samples);
+                UART_PRINT_WARN("avg -> no valid sample | errors=%" PRIu32, errors);
             }
 
             window_start_us = now_us;
-            temperature_sum = 0.0f;
-            humidity_sum = 0.0f;
-            valid_samples = 0;
-            error_samples = 0;
         }
+#if DHT20_LOG_TO_FLASH
+        if ((now_us - log_start_us) >= ((int64_t)DHT20_LOG_PERIOD_S * 1000000LL)) {
+            dht20_flashlog_tick();
+            log_start_us = now_us;
+        }
+#endif
         } else {
             const TickType_t now_tick = xTaskGetTickCount();
             if ((now_tick - last_idle_log_tick) >= pdMS_TO_TICKS(DHT20_PRINT_PERIOD_MS)) {
@@ -683,18 +1338,72 @@ void app_main(void)
 
 #if APP_ENABLE_KNOB
         if (knob_ready) {
-            knob_process(&knob,
+            const bool knob_active = knob_process(&knob,
 #if APP_ENABLE_RGB_LED
-                         rgb_ready ? &rgb_ctrl : NULL
+                                                  rgb_ready ? &rgb_ctrl : NULL
 #else
-                         NULL
+                                                  NULL
 #endif
             );
+#if APP_POWER_SAVE
+            if (knob_active) {
+                knob_active_tick = xTaskGetTickCount();
+            }
+#else
+            (void)knob_active;
+#endif
         }
 #endif
 #if APP_ENABLE_DISPLAY && APP_ENABLE_SNTP
-        sntp_api_status_bar_update_if_due(SNTP_STATUS_REFRESH_MS);
+        if (sntp_bar_event_driven) {
+            /* Redraws come from the minute-edge timer. */
+        } else if (display_server_running()) {
+            const TickType_t bar_tick = xTaskGetTickCount();
+            if ((bar_tick - last_bar_post_tick) >= pdMS_TO_TICKS(SNTP_STATUS_REFRESH_MS)) {
+                (void)display_server_post_call(display_sntp_bar_refresh, NULL);
+                last_bar_post_tick = bar_tick;
+            }
+        } else {
+            sntp_api_status_bar_update_if_due(SNTP_STATUS_REFRESH_MS);
+        }
+#endif
+#if APP_POWER_SAVE
+        /* Block until the nearest deadline; knob edges, SNTP syncs and bench completion notify earlier. */
+        TickType_t wait_ticks = pdMS_TO_TICKS(APP_IDLE_MAX_WAIT_MS);
+#if APP_ENABLE_DHT20
+        if (dht20_ready) {
+#if !DHT20_USE_ASYNC
+            app_wait_limit_ticks(&wait_ticks, xTaskGetTickCount(), pdMS_TO_TICKS(APP_LOOP_PERIOD_MS));
+#endif
+            app_wait_limit_us(&wait_ticks, window_start_us + ((int64_t)DHT20_PRINT_PERIOD_MS * 1000LL));
+#if DHT20_LOG_TO_FLASH
+            app_wait_limit_us(&wait_ticks, log_start_us + ((int64_t)DHT20_LOG_PERIOD_S * 1000000LL));
+#endif
+        } else {
+            app_wait_limit_ticks(&wait_ticks, last_idle_log_tick, pdMS_TO_TICKS(DHT20_PRINT_PERIOD_MS));
+        }
+#else
+        app_wait_limit_ticks(&wait_ticks, last_idle_log_tick, pdMS_TO_TICKS(DHT20_DISABLED_PRINT_PERIOD_MS));
+#endif
+#if APP_ENABLE_KNOB
+        if (knob_ready && ((xTaskGetTickCount() - knob_active_tick) < pdMS_TO_TICKS(APP_KNOB_ACTIVE_MS))) {
+            app_wait_limit_ticks(&wait_ticks, xTaskGetTickCount(), pdMS_TO_TICKS(APP_LOOP_PERIOD_MS));
+        }
+#endif
+#if APP_ENABLE_DISPLAY && APP_ENABLE_SNTP
+        if (!sntp_bar_event_driven) {
+            const TickType_t bar_since = display_server_running() ? last_bar_post_tick : xTaskGetTickCount();
+            app_wait_limit_ticks(&wait_ticks, bar_since, pdMS_TO_TICKS(SNTP_STATUS_REFRESH_MS));
+        }
+#endif
+        (void)ulTaskNotifyTake(pdTRUE, wait_ticks);
+#else
+        vTaskDelayUntil(&loop_wake_tick, pdMS_TO_TICKS(APP_LOOP_PERIOD_MS));
+
+        const int64_t wake_us = esp_timer_get_time();
+        const int64_t deviation_us = (wake_us - loop_wake_us) - ((int64_t)APP_LOOP_PERIOD_MS * 1000LL);
+        perf_observe_us(&s_perf_loop_jitter, (uint32_t)((deviation_us < 0) ? -deviation_us : deviation_us));
+        loop_wake_us = wake_us;
 #endif
-        vTaskDelayUntil(&loop_wake_tick, pdMS_TO_TICKS(10));
     }
 }